@@ -0,0 +1,132 @@
+#ifndef APU_H
+
+#define APU_H
+
+#include "./common.h"
+#include "./memory.h"
+#include "./scheduler.h"
+#include "./ring_buffer.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NR10_REGISTER 0xFF10
+#define NR11_REGISTER 0xFF11
+#define NR12_REGISTER 0xFF12
+#define NR13_REGISTER 0xFF13
+#define NR14_REGISTER 0xFF14
+#define NR21_REGISTER 0xFF16
+#define NR22_REGISTER 0xFF17
+#define NR23_REGISTER 0xFF18
+#define NR24_REGISTER 0xFF19
+#define NR30_REGISTER 0xFF1A
+#define NR31_REGISTER 0xFF1B
+#define NR32_REGISTER 0xFF1C
+#define NR33_REGISTER 0xFF1D
+#define NR34_REGISTER 0xFF1E
+#define NR41_REGISTER 0xFF20
+#define NR42_REGISTER 0xFF21
+#define NR43_REGISTER 0xFF22
+#define NR44_REGISTER 0xFF23
+#define NR50_REGISTER 0xFF24
+#define NR51_REGISTER 0xFF25
+#define NR52_REGISTER 0xFF26
+#define APU_REGISTERS_END 0xFF2F
+#define WAVE_RAM_START 0xFF30
+#define WAVE_RAM_END 0xFF3F
+
+#define NR52_POWER 0x80
+#define NRX4_TRIGGER 0x80
+#define NRX4_LENGTH_ENABLE 0x40
+
+#define APU_CHANNEL_COUNT 4
+#define APU_CHANNEL_SQUARE1 0
+#define APU_CHANNEL_SQUARE2 1
+#define APU_CHANNEL_WAVE 2
+#define APU_CHANNEL_NOISE 3
+
+#define APU_MAX_FREQUENCY 2047
+#define APU_WAVE_SAMPLES 32
+/* Longest waveform step: noise divisor 112 at the largest running shift */
+#define APU_MAX_PERIOD (112 << 13)
+#define APU_SAMPLE_RATE 48000
+/* Length, sweep and envelope are clocked by a 512 Hz frame sequencer */
+#define APU_SEQUENCER_CYCLES (CPU_FREQUENCY / 512)
+
+/* Band-limited steps: taps per step and sub-sample positions */
+#define APU_BLIP_WIDTH 16
+#define APU_BLIP_PHASES 32
+/* Output samples held between emits; one sequencer step makes under 94 */
+#define APU_BUFFER_SIZE 256
+
+typedef struct apu apu_t;
+
+typedef struct apu_channel {
+	bool enabled;
+	int length;
+	int volume;
+	int envelope_timer;
+	/* Cycles until the waveform next steps, and where it is */
+	int timer;
+	int position;
+	/* Output level 0-15 the synthesis buffer was last told about */
+	int level;
+} apu_channel_t;
+
+/* One stereo sample, the unit written to the output ring */
+typedef struct apu_frame {
+	int16_t left;
+	int16_t right;
+} apu_frame_t;
+
+/*
+ * The channels are never ticked per cycle. They are run forward in one
+ * batch at each frame sequencer step and whenever a register is accessed;
+ * every level change is added to the output as a band-limited step at its
+ * exact sub-sample position, which resamples to APU_SAMPLE_RATE without
+ * aliasing. Headless, or with no output ring, nothing is synthesized and
+ * the sequencer only catches up when the CPU reads NR52.
+ */
+struct apu {
+	memory_system_t *mem_sys;
+	scheduler_t *scheduler;
+
+	apu_channel_t channels[APU_CHANNEL_COUNT];
+	/* Channel 1 frequency sweep */
+	bool sweep_enabled;
+	int sweep_timer;
+	int sweep_shadow;
+	/* Channel 4 noise generator */
+	uint16_t lfsr;
+
+	/* Frame sequencer step clocked next, and the cycle it happens */
+	int step;
+	uint64_t next_step;
+	/* Cycle the channels have been run to */
+	uint64_t clock;
+
+	bool headless;
+	ring_buffer_t *output;
+	/* Stereo samples produced, and those lost to a full ring */
+	uint64_t samples;
+	uint64_t dropped;
+
+	/* Level to output scale of each channel, left then right */
+	int gains[2][APU_CHANNEL_COUNT];
+	int32_t kernel[APU_BLIP_PHASES][APU_BLIP_WIDTH];
+	int64_t buffer[2][APU_BUFFER_SIZE + APU_BLIP_WIDTH];
+	/* buffer[0] starts buffer_offset (32.32 samples) before buffer_clock */
+	uint64_t buffer_clock;
+	uint64_t buffer_offset;
+	int64_t integrator[2];
+	int64_t highpass[2];
+};
+
+bool apu_init(apu_t *apu, memory_system_t *mem_sys, scheduler_t *scheduler);
+void apu_reset(apu_t *apu);
+void apu_sync(apu_t *apu);
+void apu_reschedule(apu_t *apu);
+void apu_set_headless(apu_t *apu, bool headless);
+void apu_set_output(apu_t *apu, ring_buffer_t *output);
+
+#endif
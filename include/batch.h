@@ -0,0 +1,42 @@
+#ifndef BATCH_H
+
+#define BATCH_H
+
+#include "./common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Cycle budget for list entries that do not give one: 60 emulated seconds */
+#define BATCH_DEFAULT_CYCLES ((uint64_t)CPU_FREQUENCY * 60)
+#define BATCH_MAX_THREADS 256
+
+typedef struct batch_job {
+	char *rom_path;
+	uint64_t cycles;
+} batch_job_t;
+
+typedef struct batch_result {
+	bool ok;
+	uint64_t cycles;
+	double wall_seconds;
+	uint64_t framebuffer_hash;
+} batch_result_t;
+
+typedef struct batch_options {
+	int threads;
+	bool headless;
+	bool use_block_cache;
+	bool use_jit;
+} batch_options_t;
+
+bool batch_read_list(const char *path, batch_job_t **jobs, int *count);
+void batch_free_list(batch_job_t *jobs, int count);
+
+bool batch_run(const batch_job_t *jobs, batch_result_t *results, int count,
+	       const batch_options_t *options);
+bool batch_write_csv(const char *path, const batch_job_t *jobs,
+		     const batch_result_t *results, int count);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef BLOCK_CACHE_H
+
+#define BLOCK_CACHE_H
+
+#include "./common.h"
+#include "./cpu.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BLOCK_CACHE_MAX_INSTRUCTIONS 32
+#define BLOCK_CACHE_BLOCK_COUNT 4096
+/* Power of two, at least twice the block count */
+#define BLOCK_CACHE_TABLE_SIZE 8192
+#define BLOCK_CACHE_LINK_COUNT 2
+
+typedef struct block block_t;
+typedef struct block_cache block_cache_t;
+
+/*
+ * A straight run of decoded instructions inside one page. Blocks are keyed
+ * by the host address of their first opcode, which already tells ROM banks
+ * apart, and RAM blocks remember the code version of their page.
+ */
+struct block {
+	const byte *key;
+	int page;
+	uint32_t version;
+	int count;
+	cpu_instruction_t instructions[BLOCK_CACHE_MAX_INSTRUCTIONS];
+
+	/* Blocks seen following this one, checked before the hash table */
+	const byte *link_keys[BLOCK_CACHE_LINK_COUNT];
+	block_t *links[BLOCK_CACHE_LINK_COUNT];
+	int next_link;
+};
+
+struct block_cache {
+	block_t *blocks;
+	int block_count;
+	block_t *table[BLOCK_CACHE_TABLE_SIZE];
+	/* Block the previous run ended in, so chaining survives between runs */
+	block_t *last;
+
+	uint64_t blocks_compiled;
+	uint64_t flushes;
+};
+
+bool block_cache_init(block_cache_t *cache);
+void block_cache_cleanup(block_cache_t *cache);
+void block_cache_flush(block_cache_t *cache);
+
+uint64_t block_cache_run(block_cache_t *cache, cpu_t *cpu, uint64_t cycles);
+
+#endif
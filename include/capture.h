@@ -0,0 +1,82 @@
+#ifndef CAPTURE_H
+
+#define CAPTURE_H
+
+#include "./common.h"
+#include "./gameboy.h"
+#include "./ring_buffer.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CAPTURE_VIDEO 0
+#define CAPTURE_AUDIO 1
+#define CAPTURE_STREAM_COUNT 2
+
+/* One frame is one byte per pixel, 0xFF (white) to 0x00 (black) */
+#define CAPTURE_FRAME_SIZE (SCREEN_WIDTH * SCREEN_HEIGHT)
+/* Four frames, or 23040 stereo samples; always whole frames of either */
+#define CAPTURE_BLOCK_SIZE (4 * CAPTURE_FRAME_SIZE)
+/* About 1.5 s of video, or 2.8 MiB */
+#define CAPTURE_DEFAULT_BLOCKS 32
+/* Most blocks handed to one writev() */
+#define CAPTURE_BATCH_BLOCKS 16
+/* Room for far more audio than one frame makes */
+#define CAPTURE_AUDIO_RING_SIZE (APU_SAMPLE_RATE / 4 * sizeof(apu_frame_t))
+#define CAPTURE_WAV_HEADER_SIZE 44
+
+typedef struct capture_block {
+	int stream;
+	size_t size;
+	byte data[CAPTURE_BLOCK_SIZE];
+} capture_block_t;
+
+typedef struct capture_stream {
+	int fd;
+	bool wav;
+	/* Block being filled by the emulation thread, or NULL */
+	capture_block_t *block;
+	/* Video frames or audio samples taken, and those dropped for lack of a block */
+	uint64_t captured;
+	uint64_t dropped;
+	/* Bytes on disk, kept by the writer thread */
+	uint64_t written;
+} capture_stream_t;
+
+/*
+ * Records finished frames and audio to disk from the emulation thread
+ * without ever waiting on the disk. Blocks from a fixed pool are filled by
+ * the emulation thread and queued for a writer thread, which writes them
+ * out in batches and hands them back. Both queues are lock-free rings of
+ * block pointers; when no free block is left the frame or the samples are
+ * dropped and counted instead.
+ */
+typedef struct capture {
+	capture_stream_t streams[CAPTURE_STREAM_COUNT];
+	capture_block_t *blocks;
+	int block_count;
+	/* Blocks for the emulation thread to fill, returned by the writer */
+	ring_buffer_t free_blocks;
+	/* Filled blocks for the writer, in the order they were filled */
+	ring_buffer_t full_blocks;
+	/* The APU's output while audio is captured */
+	ring_buffer_t audio;
+	uint64_t apu_dropped;
+
+	pthread_t writer;
+	/* Only guards sleeping and waking the writer, never any I/O */
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	bool stopping;
+	atomic_bool failed;
+} capture_t;
+
+bool capture_open(capture_t *capture, gameboy_t *gb, const char *video_path,
+		  const char *audio_path, int blocks);
+void capture_frame(capture_t *capture, gameboy_t *gb);
+bool capture_close(capture_t *capture, gameboy_t *gb);
+
+#endif
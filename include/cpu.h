@@ -3,11 +3,89 @@
 #define CPU_H
 
 #include "./common.h"
+#include "./memory.h"
 
 #include <stdint.h>
 #include <stdbool.h>
 
+#define CPU_FLAG_Z 0x80
+#define CPU_FLAG_N 0x40
+#define CPU_FLAG_H 0x20
+#define CPU_FLAG_C 0x10
 
+#define CPU_ENTRY_POINT 0x0100
 
+/* Decoded instruction properties, see cpu_decode() */
+#define CPU_INSTRUCTION_ENDS_BLOCK 0x01
+#define CPU_INSTRUCTION_WRITES 0x02
+
+typedef struct cpu cpu_t;
+
+typedef void (*cpu_handler_t)(cpu_t *cpu);
+
+/*
+ * A pre-decoded instruction. The handler expects pc to point just past the
+ * opcode (and CB prefix) and reads its immediates from there.
+ */
+typedef struct cpu_instruction {
+	cpu_handler_t handler;
+	word pc;
+	byte opcode_length;
+	byte length;
+	byte cycles;
+	byte flags;
+} cpu_instruction_t;
+
+struct cpu {
+	byte a, f;
+	byte b, c;
+	byte d, e;
+	byte h, l;
+	word sp;
+	word pc;
+
+	bool ime;
+	bool ime_pending;
+	bool halted;
+	bool halt_bug;
+	bool stopped;
+	/* Set by the illegal opcodes, which hang the real CPU */
+	bool locked;
+
+	/* T-cycles executed since reset */
+	uint64_t cycles;
+
+	memory_system_t *mem_sys;
+};
+
+bool cpu_init(cpu_t *cpu, memory_system_t *mem_sys);
+void cpu_reset(cpu_t *cpu);
+
+int cpu_step(cpu_t *cpu);
+uint64_t cpu_run(cpu_t *cpu, uint64_t cycles);
+bool cpu_skip_halt(cpu_t *cpu, uint64_t target);
+
+word cpu_get_af(const cpu_t *cpu);
+word cpu_get_bc(const cpu_t *cpu);
+word cpu_get_de(const cpu_t *cpu);
+word cpu_get_hl(const cpu_t *cpu);
+
+void cpu_decode(cpu_t *cpu, address pc, cpu_instruction_t *instruction);
+bool cpu_interrupt_pending(const cpu_t *cpu);
+
+/*
+ * True when the next step is not a plain instruction (interrupt entry,
+ * HALT, the EI delay, the HALT bug), which translated code leaves to
+ * cpu_step()
+ */
+static inline bool cpu_must_step(const cpu_t *cpu)
+{
+	return cpu->halted || cpu->stopped || cpu->locked ||
+	       cpu->ime_pending || cpu->halt_bug ||
+	       (cpu->ime && cpu_interrupt_pending(cpu));
+}
+
+byte cpu_get_opcode_cycles(byte opcode);
+byte cpu_get_cb_opcode_cycles(byte opcode);
 
 #endif
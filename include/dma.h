@@ -0,0 +1,49 @@
+#ifndef DMA_H
+
+#define DMA_H
+
+#include "./common.h"
+#include "./memory.h"
+#include "./scheduler.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DMA_REGISTER 0xFF46
+
+/* One byte per M-cycle after a one M-cycle startup delay */
+#define DMA_LENGTH OAM_SIZE
+#define DMA_STARTUP_CYCLES 4
+#define DMA_CYCLES_PER_BYTE 4
+#define DMA_TRANSFER_CYCLES (DMA_LENGTH * DMA_CYCLES_PER_BYTE)
+
+typedef struct dma dma_t;
+
+/*
+ * OAM DMA copies lazily: bytes the transfer has reached are only moved into
+ * OAM when something needs them, normally in one block when it ends. While
+ * it runs, the bus it reads from is locked, so the CPU cannot change the
+ * source and sees the byte in flight instead, and OAM reads 0xFF.
+ */
+struct dma {
+	memory_system_t *mem_sys;
+	scheduler_t *scheduler;
+
+	bool active;
+	/* Set once the startup delay is over and the bus is taken */
+	bool locked;
+	address source;
+	/* Cycle the first byte starts moving */
+	uint64_t start;
+	/* Bytes already in OAM */
+	int copied;
+};
+
+bool dma_init(dma_t *dma, memory_system_t *mem_sys, scheduler_t *scheduler);
+void dma_reset(dma_t *dma);
+void dma_sync(dma_t *dma);
+void dma_reschedule(dma_t *dma);
+uint16_t dma_remaining(const dma_t *dma);
+void dma_restore(dma_t *dma, uint16_t remaining);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef GAMEBOY_H
+
+#define GAMEBOY_H
+
+#include "./common.h"
+#include "./memory.h"
+#include "./cpu.h"
+#include "./ppu.h"
+#include "./scheduler.h"
+#include "./timer.h"
+#include "./dma.h"
+#include "./apu.h"
+#include "./joypad.h"
+#include "./serial.h"
+#include "./block_cache.h"
+#include "./jit.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GAMEBOY_BREAKPOINT_MAX 16
+
+typedef struct gameboy gameboy_t;
+typedef struct gameboy_snapshot gameboy_snapshot_t;
+typedef struct gameboy_state gameboy_state_t;
+
+/* One emulated machine; instances share nothing */
+struct gameboy {
+	memory_system_t memory;
+	cpu_t cpu;
+	ppu_t ppu;
+	gb_timer_t timer;
+	dma_t dma;
+	apu_t apu;
+	joypad_t joypad;
+	serial_t serial;
+	block_cache_t block_cache;
+	jit_t jit;
+	/* Subsystem events, timed on cpu.cycles */
+	scheduler_t scheduler;
+
+	/* Run code through the block cache rather than cpu_run() */
+	bool use_block_cache;
+	/* Run code through the JIT, ahead of the block cache */
+	bool use_jit;
+
+	/*
+	 * Execution breakpoints, with how many fall in each page so most
+	 * instructions are let through on one lookup. While any breakpoint
+	 * or watchpoint is set the machine runs one instruction at a time.
+	 */
+	address breakpoints[GAMEBOY_BREAKPOINT_MAX];
+	int breakpoint_count;
+	byte breakpoint_pages[MEMORY_PAGE_COUNT];
+	/* The last run stopped before executing the instruction at cpu.pc */
+	bool at_breakpoint;
+};
+
+bool gameboy_init(gameboy_t *gb);
+void gameboy_cleanup(gameboy_t *gb);
+void gameboy_reset(gameboy_t *gb);
+
+bool gameboy_load_rom(gameboy_t *gb, const char *filename);
+bool gameboy_load_rom_data(gameboy_t *gb, const byte *data, size_t size);
+void gameboy_set_headless(gameboy_t *gb, bool headless);
+
+/*
+ * A machine frozen for forking. Forks keep their own reference to the
+ * memory snapshot, so this can be freed while they are still running.
+ */
+struct gameboy_snapshot {
+	memory_snapshot_t *memory;
+	cpu_t cpu;
+	ppu_t ppu;
+	gb_timer_t timer;
+	dma_t dma;
+	apu_t apu;
+	serial_t serial;
+};
+
+gameboy_snapshot_t *gameboy_snapshot(gameboy_t *gb);
+void gameboy_snapshot_free(gameboy_snapshot_t *snapshot);
+bool gameboy_fork(gameboy_t *gb, const gameboy_snapshot_t *snapshot);
+
+/*
+ * A machine's whole state as plain copies, for going back and forth many
+ * times a second as run-ahead does. Saving and restoring are a handful of
+ * bulk copies with no allocation and nothing decoded again; a state only
+ * fits the machine it was made for. The framebuffer is left out, so a
+ * restored machine still shows the last frame it drew.
+ */
+struct gameboy_state {
+	memory_state_t memory;
+	cpu_t cpu;
+	scheduler_t scheduler;
+	ppu_t ppu;
+	gb_timer_t timer;
+	dma_t dma;
+	apu_t apu;
+	serial_t serial;
+};
+
+bool gameboy_state_init(gameboy_state_t *state, const gameboy_t *gb);
+void gameboy_state_cleanup(gameboy_state_t *state);
+void gameboy_save_state(gameboy_t *gb, gameboy_state_t *state);
+void gameboy_restore_state(gameboy_t *gb, const gameboy_state_t *state);
+
+uint64_t gameboy_run(gameboy_t *gb, uint64_t cycles);
+uint64_t gameboy_run_frame(gameboy_t *gb);
+uint64_t gameboy_framebuffer_hash(const gameboy_t *gb);
+
+bool gameboy_add_breakpoint(gameboy_t *gb, address addr);
+bool gameboy_remove_breakpoint(gameboy_t *gb, address addr);
+bool gameboy_stopped(const gameboy_t *gb);
+
+#endif
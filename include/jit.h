@@ -0,0 +1,88 @@
+#ifndef JIT_H
+
+#define JIT_H
+
+#include "./common.h"
+#include "./cpu.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * The only backend so far emits x86-64 for the System V ABI. Translated
+ * code bypasses the bus hooks, so tracing builds interpret instead.
+ */
+#if defined(__x86_64__) && defined(__linux__) && !defined(MEMORY_TRACE)
+#define JIT_SUPPORTED 1
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+#define JIT_CODE_SIZE (8 * 1024 * 1024)
+#define JIT_BLOCK_COUNT 8192
+/* Power of two, at least twice the block count */
+#define JIT_TABLE_SIZE 16384
+#define JIT_HEAT_SIZE 4096
+/* Times an address is dispatched to before it is translated */
+#define JIT_HOT_THRESHOLD 8
+#define JIT_MAX_INSTRUCTIONS 128
+/* LAHF results mapped to Z, N, H and C for each kind of flag update */
+#define JIT_FLAG_TABLES 6
+
+typedef struct jit_block jit_block_t;
+typedef struct jit jit_t;
+
+/* Runs from the cpu's pc until the block ends or cycles reaches target */
+typedef void (*jit_code_t)(cpu_t *cpu, uint64_t target);
+
+/*
+ * Native code for a run of ROM instructions inside one page. Blocks are
+ * keyed by the host address of their first opcode like the block cache's,
+ * plus the guest address, since one bank can show up at two addresses.
+ * code is NULL for a start address that cannot be translated.
+ */
+struct jit_block {
+	const byte *key;
+	address pc;
+	jit_code_t code;
+
+	/* Block seen following this one, checked before the hash table */
+	const byte *next_key;
+	address next_pc;
+	jit_block_t *next;
+};
+
+/*
+ * Translates hot basic blocks of cartridge ROM into x86-64. Guest
+ * registers stay in cpu_t; the cycle counter lives in a host register
+ * while a block runs. Loads and stores to direct-mapped pages are inlined
+ * through the memory system's page tables, everything else calls the
+ * page's handler and leaves the block afterwards, so an IO write that
+ * raises an interrupt or switches banks is seen at once. Code outside ROM
+ * (WRAM, HRAM, and so all self-modifying code) is never translated and
+ * runs in the interpreter, as do instructions around interrupts and HALT.
+ */
+struct jit {
+	/* false where there is no backend or no executable memory */
+	bool available;
+
+	byte *code;
+	size_t code_used;
+	jit_block_t *blocks;
+	int block_count;
+	jit_block_t *table[JIT_TABLE_SIZE];
+	byte heat[JIT_HEAT_SIZE];
+	byte flag_tables[JIT_FLAG_TABLES][256];
+
+	uint64_t blocks_compiled;
+	uint64_t flushes;
+};
+
+bool jit_init(jit_t *jit);
+void jit_cleanup(jit_t *jit);
+void jit_flush(jit_t *jit);
+
+uint64_t jit_run(jit_t *jit, cpu_t *cpu, uint64_t cycles);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef JOYPAD_H
+
+#define JOYPAD_H
+
+#include "./common.h"
+#include "./memory.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JOYP_REGISTER 0xFF00
+
+/* P1 lines 4 and 5 select directions and buttons when written as 0 */
+#define JOYP_SELECT_DIRECTIONS 0x10
+#define JOYP_SELECT_BUTTONS 0x20
+
+/* Bits of joypad_set_buttons(), set while the key is held */
+#define JOYPAD_RIGHT 0x01
+#define JOYPAD_LEFT 0x02
+#define JOYPAD_UP 0x04
+#define JOYPAD_DOWN 0x08
+#define JOYPAD_A 0x10
+#define JOYPAD_B 0x20
+#define JOYPAD_SELECT 0x40
+#define JOYPAD_START 0x80
+
+typedef struct joypad joypad_t;
+
+/*
+ * Keys held by the player. They are input from outside the machine, so
+ * save states, forks and run-ahead all leave them as they are; only the
+ * select lines in P1 are machine state.
+ */
+struct joypad {
+	memory_system_t *mem_sys;
+	byte buttons;
+};
+
+bool joypad_init(joypad_t *joypad, memory_system_t *mem_sys);
+void joypad_reset(joypad_t *joypad);
+void joypad_set_buttons(joypad_t *joypad, byte buttons);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef LINK_H
+
+#define LINK_H
+
+#include "./common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* The peer has run up to time */
+#define LINK_MESSAGE_TIME 0
+/* The peer started clocking out value at time */
+#define LINK_MESSAGE_START 1
+/* value was in the peer's SB when the transfer ending at time finished */
+#define LINK_MESSAGE_REPLY 2
+
+/* Type, value and a 64-bit time, little-endian */
+#define LINK_MESSAGE_SIZE 10
+#define LINK_BATCH_MESSAGES 64
+
+typedef struct link_message {
+	uint64_t time;
+	byte type;
+	byte value;
+} link_message_t;
+
+/*
+ * One end of a link cable: a stream socket to another instance, in this
+ * process or another one. Messages are queued and only written out by
+ * link_flush(), so one exchange carries everything that piled up since the
+ * last. Once the peer goes away the link stays disconnected.
+ */
+typedef struct link {
+	int fd;
+	bool connected;
+
+	byte out[LINK_BATCH_MESSAGES * LINK_MESSAGE_SIZE];
+	size_t out_size;
+	byte in[LINK_BATCH_MESSAGES * LINK_MESSAGE_SIZE];
+	size_t in_size;
+	size_t in_offset;
+
+	/* Times link_receive() had to wait for the peer */
+	uint64_t waits;
+} link_t;
+
+bool link_pair(link_t *a, link_t *b);
+bool link_listen(link_t *link, const char *path);
+bool link_connect(link_t *link, const char *path);
+void link_close(link_t *link);
+
+bool link_send(link_t *link, const link_message_t *message);
+bool link_flush(link_t *link);
+bool link_receive(link_t *link, link_message_t *message, bool wait);
+
+#endif
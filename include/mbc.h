@@ -0,0 +1,59 @@
+#ifndef MBC_H
+
+#define MBC_H
+
+#include "common.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CARTRIDGE_TYPE_ADDRESS 0x0147
+#define CARTRIDGE_ROM_SIZE_ADDRESS 0x0148
+#define CARTRIDGE_RAM_SIZE_ADDRESS 0x0149
+#define CARTRIDGE_HEADER_END 0x014F
+
+#define ROM_BANK_SIZE 0x4000
+#define RAM_BANK_SIZE 0x2000
+#define MBC_RTC_REGISTER_COUNT 5
+
+typedef struct memory_system memory_system_t;
+
+typedef enum mbc_type {
+	MBC_NONE,
+	MBC_1,
+	MBC_3,
+	MBC_5,
+} mbc_type_t;
+
+typedef struct mbc mbc_t;
+
+struct mbc {
+	mbc_type_t type;
+	bool has_ram;
+	bool has_battery;
+	bool has_rtc;
+
+	size_t rom_bank_count;
+	size_t ram_bank_count;
+
+	bool ram_enabled;
+	word rom_bank;
+	/* MBC1: RAM bank or upper ROM bits. MBC3: RAM bank or RTC register */
+	byte ram_bank;
+	byte banking_mode;
+
+	byte rtc[MBC_RTC_REGISTER_COUNT];
+	byte rtc_latched[MBC_RTC_REGISTER_COUNT];
+	byte rtc_latch;
+};
+
+bool mbc_init(mbc_t *mbc, byte cartridge_type, size_t rom_size,
+	      size_t ram_size);
+size_t mbc_ram_size(byte ram_size_code);
+
+void mbc_write(memory_system_t *mem_sys, address addr, byte value);
+void mbc_update_mapping(memory_system_t *mem_sys);
+
+const char *mbc_get_type_name(mbc_type_t type);
+
+#endif
@@ -3,48 +3,345 @@
 #define MEMORY_H
 
 #include "common.h"
+#include "mbc.h"
+#include <assert.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define ROM_START 0x0000
 #define ROM_END 0x7FFF
 #define VRAM_START 0x8000
 #define VRAM_END 0x9FFF
+#define ERAM_START 0xA000
+#define ERAM_END 0xBFFF
 #define WRAM_START 0xC000
 #define WRAM_END 0xDFFF
+#define ECHO_RAM_START 0xE000
+#define ECHO_RAM_END 0xFDFF
+#define OAM_START 0xFE00
+#define OAM_END 0xFE9F
+#define UNUSABLE_START 0xFEA0
+#define UNUSABLE_END 0xFEFF
 #define IO_REGISTERS_START 0xFF00
 #define IO_REGISTERS_END 0xFF7F
 #define HRAM_START 0xFF80
 #define HRAM_END 0xFFFE
+#define IE_REGISTER 0xFFFF
+#define IF_REGISTER 0xFF0F
+
+#define INTERRUPT_VBLANK 0x01
+#define INTERRUPT_LCD_STAT 0x02
+#define INTERRUPT_TIMER 0x04
+#define INTERRUPT_SERIAL 0x08
+#define INTERRUPT_JOYPAD 0x10
 
 #define ROM_SIZE (ROM_END - ROM_START + 1)
 #define VRAM_SIZE (VRAM_END - VRAM_START + 1)
+#define ERAM_SIZE (ERAM_END - ERAM_START + 1)
 #define WRAM_SIZE (WRAM_END - WRAM_START + 1)
+#define OAM_SIZE (OAM_END - OAM_START + 1)
 #define IO_REGISTERS_SIZE (IO_REGISTERS_END - IO_REGISTERS_START + 1)
 #define HRAM_SIZE (HRAM_END - HRAM_START + 1)
 
+#define VRAM_TILE_DATA_END 0x97FF
+#define VRAM_TILE_SIZE 16
+#define VRAM_TILE_COUNT ((VRAM_TILE_DATA_END - VRAM_START + 1) / VRAM_TILE_SIZE)
+
+#define MEMORY_PAGE_SIZE 0x100
+#define MEMORY_PAGE_COUNT (MEMORY_SIZE / MEMORY_PAGE_SIZE)
+#define MEMORY_PAGE(addr) ((addr) >> 8)
+#define MEMORY_PAGE_OFFSET(addr) ((addr) & (MEMORY_PAGE_SIZE - 1))
+
+/* Reasons for diverting a page's writes through the trap slow path */
+#define MEMORY_TRAP_CODE 0x01
+#define MEMORY_TRAP_COW 0x02
+#define MEMORY_TRAP_LOCK 0x04
+#define MEMORY_TRAP_WATCH 0x08
+/* Traps that divert the page's reads as well */
+#define MEMORY_TRAP_READS (MEMORY_TRAP_LOCK | MEMORY_TRAP_WATCH)
+
+/* Accesses a watchpoint stops on */
+#define MEMORY_WATCH_READ 0x01
+#define MEMORY_WATCH_WRITE 0x02
+#define MEMORY_WATCH_MAX 16
+
+#define MEMORY_WRAM_PAGES (WRAM_SIZE / MEMORY_PAGE_SIZE)
+
 typedef struct memory_system memory_system_t;
+typedef struct memory_snapshot memory_snapshot_t;
+typedef struct memory_state memory_state_t;
+
+/*
+ * Building with -DMEMORY_TRACE counts every access made through the bus
+ * (memory_read_byte(), memory_write_byte() and the block functions) by
+ * address; per-region totals and the hottest addresses are worked out
+ * from that when exported. Without it the hooks expand to nothing.
+ */
+#ifdef MEMORY_TRACE
+#define MEMORY_TRACE_HOT_ADDRESSES 32
+
+typedef struct memory_trace {
+	uint64_t reads[MEMORY_SIZE];
+	uint64_t writes[MEMORY_SIZE];
+} memory_trace_t;
+
+#define MEMORY_TRACE_READ(mem_sys, addr) ((mem_sys)->trace.reads[(addr)]++)
+#define MEMORY_TRACE_WRITE(mem_sys, addr) ((mem_sys)->trace.writes[(addr)]++)
+#else
+#define MEMORY_TRACE_READ(mem_sys, addr) ((void)0)
+#define MEMORY_TRACE_WRITE(mem_sys, addr) ((void)0)
+#endif
+
+typedef byte (*memory_read_handler_t)(memory_system_t *mem_sys, address addr);
+typedef void (*memory_write_handler_t)(memory_system_t *mem_sys, address addr,
+				       byte value);
 
+/*
+ * IO registers are plain storage in high_page unless a register installs a
+ * handler, so only side-effecting registers pay for a call.
+ */
+typedef byte (*memory_io_read_t)(memory_system_t *mem_sys, void *context,
+				 address addr);
+typedef void (*memory_io_write_t)(memory_system_t *mem_sys, void *context,
+				  address addr, byte value);
+
+typedef struct memory_io_handler {
+	memory_io_read_t read;
+	memory_io_write_t write;
+	void *context;
+} memory_io_handler_t;
+
+typedef struct memory_watch {
+	address start;
+	address end;
+	byte kinds;
+} memory_watch_t;
+
+/* The first access to hit a watchpoint; value is the byte read or written */
+typedef struct memory_watch_hit {
+	address addr;
+	byte kind;
+	byte value;
+} memory_watch_hit_t;
+
+/*
+ * A frozen copy of a memory system that any number of forks can share. It
+ * never changes after creation, so forks may run on different threads; the
+ * reference count is the only shared mutable state.
+ */
+struct memory_snapshot {
+	atomic_int references;
+
+	/* The ROM belongs to the snapshot, or to rom_owner if that is set */
+	byte *rom;
+	size_t rom_size;
+	bool rom_mapped;
+	uint64_t rom_hash;
+	memory_snapshot_t *rom_owner;
+
+	mbc_t mbc;
+	byte vram[VRAM_SIZE];
+	byte wram[WRAM_SIZE];
+	byte oam[OAM_SIZE];
+	byte high_page[MEMORY_PAGE_SIZE];
+	byte *eram;
+	size_t eram_size;
+};
+
+/*
+ * Everything in a memory system the running machine can change, kept as
+ * plain copies for memory_save_state() / memory_restore_state(). Only the
+ * cartridge RAM copy is allocated, once, by memory_state_init().
+ */
+struct memory_state {
+	mbc_t mbc;
+	byte vram[VRAM_SIZE];
+	bool vram_tile_dirty[VRAM_TILE_COUNT];
+	byte wram[WRAM_SIZE];
+	byte oam[OAM_SIZE];
+	byte high_page[MEMORY_PAGE_SIZE];
+	byte *eram;
+	size_t eram_size;
+};
+
+/*
+ * Every 256-byte page of the address space either points straight at its
+ * backing storage or, when the pointer is NULL, is serviced by a handler.
+ * The maps point into the struct itself, so a memory system must not be
+ * copied by value.
+ */
 struct memory_system {
-	byte rom[ROM_SIZE];
+	byte *read_map[MEMORY_PAGE_COUNT];
+	byte *write_map[MEMORY_PAGE_COUNT];
+	memory_read_handler_t read_handlers[MEMORY_PAGE_COUNT];
+	memory_write_handler_t write_handlers[MEMORY_PAGE_COUNT];
+
+	/*
+	 * A trapped page has its real write target parked in trap_write_map /
+	 * trap_write_handlers so every write takes the slow path until the
+	 * last trap is removed.
+	 */
+	byte page_traps[MEMORY_PAGE_COUNT];
+	byte *trap_write_map[MEMORY_PAGE_COUNT];
+	memory_write_handler_t trap_write_handlers[MEMORY_PAGE_COUNT];
+	/* Bumped by writes to pages protected with memory_protect_code() */
+	uint32_t code_versions[MEMORY_PAGE_COUNT];
+	/* Bumped whenever the MBC maps ROM banks, so ROM code can tell */
+	uint32_t rom_mapping_version;
+
+	/*
+	 * Pages with a MEMORY_TRAP_READS trap have their real read target
+	 * parked in trap_read_map / trap_read_handlers the same way. Pages
+	 * locked by a DMA transfer drop writes and serve reads from
+	 * lock_handler until they are unlocked.
+	 */
+	byte *trap_read_map[MEMORY_PAGE_COUNT];
+	memory_read_handler_t trap_read_handlers[MEMORY_PAGE_COUNT];
+	memory_io_handler_t lock_handler;
+
+	/*
+	 * Pages any watchpoint covers carry MEMORY_TRAP_WATCH, so only their
+	 * accesses are checked against the list. The first hit is kept until
+	 * watch_hit_pending is cleared.
+	 */
+	memory_watch_t watches[MEMORY_WATCH_MAX];
+	int watch_count;
+	bool watch_hit_pending;
+	memory_watch_hit_t watch_hit;
+
+	/*
+	 * Set when the ROM is borrowed from a snapshot. A fork also reads the
+	 * WRAM and cartridge RAM pages still marked in cow_shared (WRAM pages
+	 * first, then cartridge RAM pages) from the snapshot; the first write
+	 * to such a page copies it into wram/eram.
+	 */
+	memory_snapshot_t *snapshot;
+	bool *cow_shared;
+
+	/* Whole cartridge image and cartridge RAM, both sized from the header */
+	byte *rom;
+	size_t rom_size;
+	bool rom_mapped;
+	/* 0 until memory_rom_hash() first needs it */
+	uint64_t rom_hash;
+	byte *eram;
+	size_t eram_size;
+	mbc_t mbc;
+
 	byte vram[VRAM_SIZE];
+	/* Set by writes to a tile's 16 bytes, cleared by whoever decodes it */
+	bool vram_tile_dirty[VRAM_TILE_COUNT];
 	byte wram[WRAM_SIZE];
+	byte oam[OAM_SIZE];
+	/* 0xFF00-0xFFFF: IO registers, HRAM and the IE register */
+	byte high_page[MEMORY_PAGE_SIZE];
+	memory_io_handler_t io_handlers[MEMORY_PAGE_SIZE];
 	bool rom_loaded;
+#ifdef MEMORY_TRACE
+	memory_trace_t trace;
+#endif
 };
 
 bool memory_init(memory_system_t *mem_sys);
 void memory_cleanup(memory_system_t *mem_sys);
 
-byte memory_read_byte(memory_system_t *mem_sys, address addr);
-void memory_write_byte(memory_system_t *mem_sys, address addr, byte value);
+/* The bus fast path is inline so the CPU core does not pay a call per access */
+static inline byte memory_read_byte(memory_system_t *mem_sys, address addr)
+{
+	assert(mem_sys != NULL);
+	MEMORY_TRACE_READ(mem_sys, addr);
+
+	const byte *page = mem_sys->read_map[MEMORY_PAGE(addr)];
+	if (page != NULL) {
+		return page[MEMORY_PAGE_OFFSET(addr)];
+	}
+
+	return mem_sys->read_handlers[MEMORY_PAGE(addr)](mem_sys, addr);
+}
+
+static inline void memory_write_byte(memory_system_t *mem_sys, address addr,
+				     byte value)
+{
+	assert(mem_sys != NULL);
+	MEMORY_TRACE_WRITE(mem_sys, addr);
+
+	byte *page = mem_sys->write_map[MEMORY_PAGE(addr)];
+	if (page != NULL) {
+		page[MEMORY_PAGE_OFFSET(addr)] = value;
+		return;
+	}
+
+	mem_sys->write_handlers[MEMORY_PAGE(addr)](mem_sys, addr, value);
+}
+
+static inline void memory_request_interrupt(memory_system_t *mem_sys,
+					    byte interrupt)
+{
+	mem_sys->high_page[MEMORY_PAGE_OFFSET(IF_REGISTER)] |= interrupt;
+}
 
 word memory_read_word(memory_system_t *mem_sys, address addr);
 void memory_write_word(memory_system_t *mem_sys, address addr, word value);
+void memory_read_block(memory_system_t *mem_sys, address start, byte *out,
+		       size_t size);
+void memory_write_block(memory_system_t *mem_sys, address start,
+			const byte *data, size_t size);
+
+void memory_map_direct(memory_system_t *mem_sys, address start, address end,
+		       byte *read, byte *write);
+void memory_map_handlers(memory_system_t *mem_sys, address start, address end,
+			 memory_read_handler_t read_handler,
+			 memory_write_handler_t write_handler);
+void memory_trap_page(memory_system_t *mem_sys, int page, byte trap);
+void memory_untrap_page(memory_system_t *mem_sys, int page, byte trap);
+void memory_protect_code(memory_system_t *mem_sys, address addr);
+void memory_lock_pages(memory_system_t *mem_sys, address start, address end,
+		       memory_io_read_t read, void *context);
+void memory_unlock_pages(memory_system_t *mem_sys, address start, address end);
+const byte *memory_unlocked_page(const memory_system_t *mem_sys, int page);
+byte memory_read_unlocked(memory_system_t *mem_sys, address addr);
+void memory_unshare(memory_system_t *mem_sys);
+const byte *memory_backing_page(const memory_system_t *mem_sys,
+				const byte *page);
+void memory_read_backing(const memory_system_t *mem_sys, const byte *backing,
+			 byte *out, size_t size);
+void memory_register_io(memory_system_t *mem_sys, address addr,
+			memory_io_read_t read, memory_io_write_t write,
+			void *context);
+byte *memory_plain_io(memory_system_t *mem_sys, address addr, bool write);
 
 bool memory_is_valid_address(address addr);
 const char *memory_get_region_name(address addr);
 void memory_dump_region(memory_system_t *mem_sys, address start, address end);
 
+bool memory_add_watch(memory_system_t *mem_sys, address start, address end,
+		      byte kinds);
+bool memory_remove_watch(memory_system_t *mem_sys, address start,
+			 address end);
+void memory_clear_watches(memory_system_t *mem_sys);
+void memory_watch_pages(memory_system_t *mem_sys);
+void memory_watch_check(memory_system_t *mem_sys, address addr, byte kind,
+			byte value);
+
+void memory_trace_reset(memory_system_t *mem_sys);
+bool memory_trace_export(const memory_system_t *mem_sys, const char *path);
+
 bool memory_load_rom(memory_system_t *mem_sys, const char *filename);
+bool memory_load_rom_data(memory_system_t *mem_sys, const byte *data,
+			  size_t size);
+bool memory_load_rom_mapped(memory_system_t *mem_sys, const char *filename);
+uint64_t memory_rom_hash(memory_system_t *mem_sys);
+
+bool memory_state_init(memory_state_t *state, const memory_system_t *mem_sys);
+void memory_state_cleanup(memory_state_t *state);
+void memory_save_state(memory_system_t *mem_sys, memory_state_t *state);
+void memory_restore_state(memory_system_t *mem_sys,
+			  const memory_state_t *state);
+
+memory_snapshot_t *memory_snapshot_create(memory_system_t *mem_sys);
+void memory_snapshot_release(memory_snapshot_t *snapshot);
+bool memory_fork(memory_system_t *mem_sys, memory_snapshot_t *snapshot);
 
 #endif
@@ -0,0 +1,111 @@
+#ifndef PPU_H
+
+#define PPU_H
+
+#include "./common.h"
+#include "./memory.h"
+#include "./scheduler.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LCDC_REGISTER 0xFF40
+#define STAT_REGISTER 0xFF41
+#define SCY_REGISTER 0xFF42
+#define SCX_REGISTER 0xFF43
+#define LY_REGISTER 0xFF44
+#define LYC_REGISTER 0xFF45
+#define BGP_REGISTER 0xFF47
+#define OBP0_REGISTER 0xFF48
+#define OBP1_REGISTER 0xFF49
+#define WY_REGISTER 0xFF4A
+#define WX_REGISTER 0xFF4B
+
+#define LCDC_BG_ENABLE 0x01
+#define LCDC_OBJ_ENABLE 0x02
+#define LCDC_OBJ_TALL 0x04
+#define LCDC_BG_MAP 0x08
+#define LCDC_TILE_DATA 0x10
+#define LCDC_WINDOW_ENABLE 0x20
+#define LCDC_WINDOW_MAP 0x40
+#define LCDC_ENABLE 0x80
+
+#define STAT_MODE_MASK 0x03
+#define STAT_COINCIDENCE 0x04
+#define STAT_HBLANK_INTERRUPT 0x08
+#define STAT_VBLANK_INTERRUPT 0x10
+#define STAT_OAM_INTERRUPT 0x20
+#define STAT_LYC_INTERRUPT 0x40
+
+#define OAM_ATTR_PALETTE 0x10
+#define OAM_ATTR_FLIP_X 0x20
+#define OAM_ATTR_FLIP_Y 0x40
+#define OAM_ATTR_BEHIND_BG 0x80
+
+#define PPU_MODE_HBLANK 0
+#define PPU_MODE_VBLANK 1
+#define PPU_MODE_OAM_SCAN 2
+#define PPU_MODE_TRANSFER 3
+
+#define PPU_DOTS_PER_LINE 456
+#define PPU_OAM_SCAN_DOTS 80
+#define PPU_TRANSFER_DOTS 172
+#define PPU_LINES_PER_FRAME 154
+#define PPU_CYCLES_PER_FRAME (PPU_DOTS_PER_LINE * PPU_LINES_PER_FRAME)
+
+#define PPU_SPRITE_COUNT 40
+#define PPU_SPRITES_PER_LINE 10
+
+typedef struct ppu ppu_t;
+
+struct ppu {
+	memory_system_t *mem_sys;
+
+	int mode;
+	/* Dots into the current line */
+	int dot;
+	byte ly;
+	/* Line of the window to draw next; only advances on lines showing it */
+	int window_line;
+	/* Level of the combined STAT interrupt line, which fires on rising edges */
+	bool stat_line;
+
+	/*
+	 * Keeps all CPU-visible timing (LY, STAT, interrupts) but never draws,
+	 * leaving the framebuffer untouched
+	 */
+	bool headless;
+
+	/*
+	 * With a scheduler attached the PPU only runs at its events and when
+	 * its registers are accessed; clock is the cycle it has reached
+	 */
+	scheduler_t *scheduler;
+	uint64_t clock;
+	/* Cycle the current mode ends; LY and STAT hold until then */
+	uint64_t next_mode_change;
+
+	/* Set at the start of VBlank; consumers clear it */
+	bool frame_ready;
+	uint64_t frames;
+
+	/*
+	 * Tile data expanded to one color index per pixel. A tile is decoded
+	 * again only after memory marks it in vram_tile_dirty.
+	 */
+	byte tiles[VRAM_TILE_COUNT][8][8];
+
+	/* Shades 0 (white) to 3 (black) */
+	byte framebuffer[SCREEN_HEIGHT][SCREEN_WIDTH];
+};
+
+bool ppu_init(ppu_t *ppu, memory_system_t *mem_sys);
+void ppu_reset(ppu_t *ppu);
+void ppu_step(ppu_t *ppu, int cycles);
+int ppu_cycles_until_event(const ppu_t *ppu);
+void ppu_attach_scheduler(ppu_t *ppu, scheduler_t *scheduler);
+void ppu_sync(ppu_t *ppu);
+void ppu_reschedule(ppu_t *ppu);
+void ppu_render_line(ppu_t *ppu, int line);
+
+#endif
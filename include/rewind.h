@@ -0,0 +1,58 @@
+#ifndef REWIND_H
+
+#define REWIND_H
+
+#include "./common.h"
+#include "./gameboy.h"
+#include "./savestate.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Ten minutes at 60 frames per second */
+#define REWIND_DEFAULT_FRAMES (60 * 60 * 10)
+#define REWIND_DEFAULT_CAPACITY (48u * 1024 * 1024)
+
+typedef struct rewind_entry {
+	size_t offset;
+	size_t size;
+} rewind_entry_t;
+
+/*
+ * History of captured states, newest kept whole and every older one stored
+ * as the run-length encoded XOR against the state after it. Deltas live in
+ * one byte ring; once it or the entry ring is full the oldest are dropped.
+ */
+typedef struct rewind {
+	size_t state_size;
+	bool has_state;
+	/* Newest state, updated in place as each capture is diffed against it */
+	byte *current;
+	byte *delta;
+	byte machine[SAVESTATE_MACHINE_SIZE];
+	savestate_region_t regions[SAVESTATE_MAX_REGIONS];
+
+	byte *data;
+	size_t capacity;
+	/* Where the next delta goes */
+	size_t head;
+	size_t used;
+
+	rewind_entry_t *entries;
+	int max_entries;
+	int first;
+	int count;
+} rewind_t;
+
+bool rewind_init(rewind_t *rewind, const gameboy_t *gb, size_t capacity,
+		 int max_frames);
+void rewind_cleanup(rewind_t *rewind);
+void rewind_clear(rewind_t *rewind);
+
+bool rewind_capture(rewind_t *rewind, gameboy_t *gb);
+bool rewind_step_back(rewind_t *rewind, gameboy_t *gb);
+int rewind_frames(const rewind_t *rewind);
+size_t rewind_memory_used(const rewind_t *rewind);
+
+#endif
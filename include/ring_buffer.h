@@ -0,0 +1,38 @@
+#ifndef RING_BUFFER_H
+
+#define RING_BUFFER_H
+
+#include "./common.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct ring_buffer ring_buffer_t;
+
+/*
+ * Lock-free byte queue for exactly one producer thread and one consumer
+ * thread. head and tail only ever grow and are reduced modulo the
+ * power-of-two capacity on access; each side owns one of them and only
+ * reads the other, so neither side ever waits.
+ */
+struct ring_buffer {
+	byte *data;
+	size_t capacity;
+	/* Bytes ever written, advanced by the producer */
+	atomic_size_t head;
+	/* Bytes ever read, advanced by the consumer */
+	atomic_size_t tail;
+};
+
+bool ring_buffer_init(ring_buffer_t *ring, size_t capacity);
+void ring_buffer_cleanup(ring_buffer_t *ring);
+void ring_buffer_clear(ring_buffer_t *ring);
+
+size_t ring_buffer_space(const ring_buffer_t *ring);
+size_t ring_buffer_available(const ring_buffer_t *ring);
+size_t ring_buffer_write(ring_buffer_t *ring, const void *data, size_t size);
+size_t ring_buffer_read(ring_buffer_t *ring, void *out, size_t size);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef RUNAHEAD_H
+
+#define RUNAHEAD_H
+
+#include "./common.h"
+#include "./gameboy.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* More than a few frames only hides lag games do not have */
+#define RUNAHEAD_MAX_FRAMES 8
+
+/*
+ * Shows each frame as it will look frames later with the input held now,
+ * hiding that many frames of the game's own input lag. Every frame is run
+ * for real, saved, run ahead with only the last frame drawn, and put back.
+ */
+typedef struct runahead {
+	int frames;
+	gameboy_state_t state;
+} runahead_t;
+
+bool runahead_init(runahead_t *runahead, const gameboy_t *gb, int frames);
+void runahead_cleanup(runahead_t *runahead);
+uint64_t runahead_run_frame(runahead_t *runahead, gameboy_t *gb);
+
+#endif
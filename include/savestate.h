@@ -0,0 +1,38 @@
+#ifndef SAVESTATE_H
+
+#define SAVESTATE_H
+
+#include "./common.h"
+#include "./gameboy.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* "GBSS" read as a little-endian word */
+#define SAVESTATE_MAGIC 0x53534247
+/* Bump whenever the layout changes; older states are rejected */
+#define SAVESTATE_VERSION 6
+#define SAVESTATE_HEADER_SIZE 24
+/* Header and registers, padded so the memory that follows is word aligned */
+#define SAVESTATE_MACHINE_SIZE 144
+/* Largest cartridge RAM, 16 banks */
+#define SAVESTATE_MAX_ERAM_SIZE (16 * RAM_BANK_SIZE)
+#define SAVESTATE_MAX_REGIONS \
+	(5 + MEMORY_WRAM_PAGES + SAVESTATE_MAX_ERAM_SIZE / MEMORY_PAGE_SIZE)
+
+typedef struct savestate_region {
+	const byte *data;
+	size_t size;
+} savestate_region_t;
+
+size_t savestate_size(const gameboy_t *gb);
+size_t savestate_save(gameboy_t *gb, byte *buffer, size_t size);
+int savestate_regions(gameboy_t *gb, byte *machine,
+		      savestate_region_t *regions);
+bool savestate_load(gameboy_t *gb, const byte *buffer, size_t size);
+
+bool savestate_save_file(gameboy_t *gb, const char *filename);
+bool savestate_load_file(gameboy_t *gb, const char *filename);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef SCHEDULER_H
+
+#define SCHEDULER_H
+
+#include "./common.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Event types, one pending event each; equal deadlines run in this order */
+#define SCHEDULER_EVENT_PPU 0
+#define SCHEDULER_EVENT_TIMER 1
+#define SCHEDULER_EVENT_DMA 2
+#define SCHEDULER_EVENT_APU 3
+#define SCHEDULER_EVENT_SERIAL 4
+#define SCHEDULER_EVENT_COUNT 5
+
+#define SCHEDULER_NEVER UINT64_MAX
+
+typedef struct scheduler scheduler_t;
+
+/* deadline is the cycle the event was due, which may be before now */
+typedef void (*scheduler_callback_t)(void *context, uint64_t deadline);
+
+typedef struct scheduler_event {
+	uint64_t deadline;
+	/* Index in the heap, or -1 when not scheduled */
+	int position;
+	scheduler_callback_t callback;
+	void *context;
+} scheduler_event_t;
+
+/*
+ * Deadlines are absolute T-cycle counts on the clock the scheduler was
+ * given, normally the CPU's cycle counter. Pending events are kept in a
+ * binary min-heap, so the next one is always at heap[0].
+ */
+struct scheduler {
+	const uint64_t *clock;
+	int heap[SCHEDULER_EVENT_COUNT];
+	int size;
+	scheduler_event_t events[SCHEDULER_EVENT_COUNT];
+};
+
+bool scheduler_init(scheduler_t *scheduler, const uint64_t *clock);
+void scheduler_register(scheduler_t *scheduler, int type,
+			scheduler_callback_t callback, void *context);
+
+void scheduler_schedule(scheduler_t *scheduler, int type, uint64_t deadline);
+void scheduler_cancel(scheduler_t *scheduler, int type);
+void scheduler_cancel_all(scheduler_t *scheduler);
+void scheduler_dispatch(scheduler_t *scheduler);
+
+static inline uint64_t scheduler_now(const scheduler_t *scheduler)
+{
+	return *scheduler->clock;
+}
+
+/* Deadline of the given event, or SCHEDULER_NEVER */
+static inline uint64_t scheduler_deadline(const scheduler_t *scheduler,
+					  int type)
+{
+	const scheduler_event_t *event = &scheduler->events[type];
+
+	return event->position < 0 ? SCHEDULER_NEVER : event->deadline;
+}
+
+/* Deadline of the earliest pending event, or SCHEDULER_NEVER */
+static inline uint64_t scheduler_next_deadline(const scheduler_t *scheduler)
+{
+	if (scheduler->size == 0) {
+		return SCHEDULER_NEVER;
+	}
+
+	return scheduler->events[scheduler->heap[0]].deadline;
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef SERIAL_H
+
+#define SERIAL_H
+
+#include "./common.h"
+#include "./memory.h"
+#include "./scheduler.h"
+#include "./link.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SB_REGISTER 0xFF01
+#define SC_REGISTER 0xFF02
+
+#define SC_TRANSFER 0x80
+#define SC_INTERNAL_CLOCK 0x01
+
+/* Eight bits at 8192 Hz */
+#define SERIAL_TRANSFER_CYCLES 4096
+
+typedef struct serial serial_t;
+
+/*
+ * The serial port, unplugged or on a link cable to another instance. Linked
+ * machines run freely and only synchronize at serial events: a byte
+ * clocked out at cycle t lands at t + SERIAL_TRANSFER_CYCLES, so each side
+ * may run that far past the last time the other reported without missing
+ * anything. Reports go out twice per transfer time, batched with whatever
+ * transfers started since, and a side only waits when it catches up with
+ * its horizon or needs the byte a transfer it clocked brings back.
+ */
+struct serial {
+	memory_system_t *mem_sys;
+	scheduler_t *scheduler;
+
+	/* Cable to the other machine, or NULL when unplugged */
+	link_t *link;
+	/* Cycle both machines call time 0 on the link */
+	uint64_t base;
+
+	/* Cycle the transfer this side clocks completes, or SCHEDULER_NEVER */
+	uint64_t end;
+	/* The byte the peer's transfer brought back, once it has arrived */
+	byte reply;
+	bool reply_ready;
+
+	/* Cycle the byte the peer clocks out lands, or SCHEDULER_NEVER */
+	uint64_t incoming_end;
+	byte incoming;
+
+	/* Cycle the peer has reported running to, and when to report next */
+	uint64_t peer_time;
+	uint64_t next_report;
+
+	/* Bytes exchanged over the link either way */
+	uint64_t transfers;
+};
+
+bool serial_init(serial_t *serial, memory_system_t *mem_sys,
+		 scheduler_t *scheduler);
+void serial_reset(serial_t *serial);
+void serial_attach(serial_t *serial, link_t *link);
+void serial_detach(serial_t *serial);
+void serial_reschedule(serial_t *serial);
+uint16_t serial_remaining(const serial_t *serial);
+void serial_restore(serial_t *serial, uint16_t remaining);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TIMER_H
+
+#define TIMER_H
+
+#include "./common.h"
+#include "./memory.h"
+#include "./scheduler.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DIV_REGISTER 0xFF04
+#define TIMA_REGISTER 0xFF05
+#define TMA_REGISTER 0xFF06
+#define TAC_REGISTER 0xFF07
+
+#define TAC_CLOCK_MASK 0x03
+#define TAC_ENABLE 0x04
+
+/* Not timer_t, which POSIX <time.h> already defines */
+typedef struct gb_timer gb_timer_t;
+
+/*
+ * DIV is the top byte of a 16-bit counter running at the CPU clock, and
+ * TIMA counts falling edges of one of its bits. Neither is ticked: both are
+ * worked out from the cycles elapsed since clock whenever they are accessed,
+ * and the only scheduled event is the next TIMA overflow.
+ */
+struct gb_timer {
+	memory_system_t *mem_sys;
+	scheduler_t *scheduler;
+
+	uint16_t counter;
+	/* Cycle counter and TIMA were last brought up to */
+	uint64_t clock;
+};
+
+bool timer_init(gb_timer_t *timer, memory_system_t *mem_sys,
+		scheduler_t *scheduler);
+void timer_reset(gb_timer_t *timer);
+void timer_sync(gb_timer_t *timer);
+void timer_reschedule(gb_timer_t *timer);
+
+#endif
@@ -0,0 +1,752 @@
+#include "../include/apu.h"
+#include "../include/ring_buffer.h"
+#include "../include/scheduler.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#define APU_REGISTER(apu, reg) ((apu)->mem_sys->high_page[MEMORY_PAGE_OFFSET(reg)])
+
+/* NRx0 of each channel; NRx1-NRx4 follow it */
+#define APU_CHANNEL_BASE(channel) (NR10_REGISTER + 5 * (channel))
+
+/* Output positions advanced per T-cycle, 32.32 fixed point */
+#define APU_SAMPLE_STEP (((uint64_t)APU_SAMPLE_RATE << 32) / CPU_FREQUENCY)
+#define APU_PHASE_SHIFT (32 - 5)
+static_assert(APU_BLIP_PHASES == 1 << 5, "phase shift assumes 32 phases");
+
+#define APU_PI 3.14159265358979323846
+
+/* Kernel taps sum to 1 << APU_KERNEL_BITS */
+#define APU_KERNEL_BITS 15
+/* Just under Nyquist, leaving the window room to roll off */
+#define APU_KERNEL_CUTOFF 0.9
+/* Four channels at level 15 and master volume 8 stay inside 16 bits */
+#define APU_LEVEL_SCALE 64
+/* DC blocker pole, about 15 Hz at 48 kHz */
+#define APU_HIGHPASS_SHIFT 9
+
+/* Duty cycle waveforms, bit n is step n */
+static const byte apu_duty_patterns[4] = { 0x01, 0x81, 0x87, 0x7E };
+
+static const int apu_noise_divisors[8] = { 8, 16, 32, 48, 64, 80, 96, 112 };
+
+/* Bits that read back as 1, 0xFF10 to 0xFF2F */
+static const byte apu_read_masks[APU_REGISTERS_END - NR10_REGISTER + 1] = {
+	0x80, 0x3F, 0x00, 0xFF, 0xBF, 0xFF, 0x3F, 0x00,
+	0xFF, 0xBF, 0x7F, 0xFF, 0x9F, 0xFF, 0xBF, 0xFF,
+	0xFF, 0x00, 0x00, 0xBF, 0x00, 0x00, 0x70, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+/* DMG register state after the boot ROM, 0xFF10 to 0xFF26 */
+static const byte apu_boot_registers[NR52_REGISTER - NR10_REGISTER + 1] = {
+	0x80, 0xBF, 0xF3, 0xFF, 0xBF, 0xFF, 0x3F, 0x00,
+	0xFF, 0xBF, 0x7F, 0xFF, 0x9F, 0xFF, 0xBF, 0xFF,
+	0xFF, 0x00, 0x00, 0xBF, 0x77, 0xF3, 0xF1,
+};
+
+static inline byte apu_channel_register(const apu_t *apu, int channel,
+					int index)
+{
+	return APU_REGISTER(apu, APU_CHANNEL_BASE(channel) + index);
+}
+
+static inline bool apu_powered(const apu_t *apu)
+{
+	return (APU_REGISTER(apu, NR52_REGISTER) & NR52_POWER) != 0;
+}
+
+static inline bool apu_synthesizing(const apu_t *apu)
+{
+	return !apu->headless && apu->output != NULL;
+}
+
+static bool apu_dac_enabled(const apu_t *apu, int channel)
+{
+	if (channel == APU_CHANNEL_WAVE) {
+		return (APU_REGISTER(apu, NR30_REGISTER) & 0x80) != 0;
+	}
+
+	return (apu_channel_register(apu, channel, 2) & 0xF8) != 0;
+}
+
+static int apu_frequency(const apu_t *apu, int channel)
+{
+	return apu_channel_register(apu, channel, 3) |
+	       ((apu_channel_register(apu, channel, 4) & 0x07) << 8);
+}
+
+/* T-cycles between waveform steps, or 0 when the channel never steps */
+static int apu_period(const apu_t *apu, int channel)
+{
+	switch (channel) {
+	case APU_CHANNEL_WAVE:
+		return (2048 - apu_frequency(apu, channel)) * 2;
+	case APU_CHANNEL_NOISE: {
+		byte nr43 = APU_REGISTER(apu, NR43_REGISTER);
+		int shift = nr43 >> 4;
+
+		return shift >= 14 ? 0 : apu_noise_divisors[nr43 & 0x07] << shift;
+	}
+	default:
+		return (2048 - apu_frequency(apu, channel)) * 4;
+	}
+}
+
+static int apu_output(const apu_t *apu, int channel)
+{
+	const apu_channel_t *ch = &apu->channels[channel];
+
+	if (!ch->enabled) {
+		return 0;
+	}
+
+	switch (channel) {
+	case APU_CHANNEL_WAVE: {
+		byte code = (APU_REGISTER(apu, NR32_REGISTER) >> 5) & 0x03;
+		byte sample = APU_REGISTER(apu, WAVE_RAM_START + ch->position / 2);
+
+		sample = ch->position & 1 ? sample & 0x0F : sample >> 4;
+		return code != 0 ? sample >> (code - 1) : 0;
+	}
+	case APU_CHANNEL_NOISE:
+		return apu->lfsr & 1 ? 0 : ch->volume;
+	default: {
+		byte duty = apu_channel_register(apu, channel, 1) >> 6;
+
+		return (apu_duty_patterns[duty] >> ch->position) & 1 ? ch->volume : 0;
+	}
+	}
+}
+
+/* Position of a cycle in the synthesis buffer, 32.32 fixed point */
+static inline uint64_t apu_buffer_position(const apu_t *apu, uint64_t clock)
+{
+	return apu->buffer_offset + (clock - apu->buffer_clock) * APU_SAMPLE_STEP;
+}
+
+static void apu_add_step(apu_t *apu, int side, uint64_t clock, int64_t delta)
+{
+	uint64_t position = apu_buffer_position(apu, clock);
+	size_t index = (size_t)(position >> 32);
+	const int32_t *kernel =
+		apu->kernel[(position >> APU_PHASE_SHIFT) & (APU_BLIP_PHASES - 1)];
+	int64_t *out = apu->buffer[side] + index;
+
+	assert(index < APU_BUFFER_SIZE);
+	for (int i = 0; i < APU_BLIP_WIDTH; i++) {
+		out[i] += delta * kernel[i];
+	}
+}
+
+static void apu_set_level(apu_t *apu, int channel, int level, uint64_t clock)
+{
+	apu_channel_t *ch = &apu->channels[channel];
+	int delta = level - ch->level;
+
+	if (delta == 0) {
+		return;
+	}
+
+	ch->level = level;
+	for (int side = 0; side < 2; side++) {
+		if (apu->gains[side][channel] != 0) {
+			apu_add_step(apu, side, clock,
+				     (int64_t)delta * apu->gains[side][channel]);
+		}
+	}
+}
+
+/* Tells the synthesis about levels changed by registers or the sequencer */
+static void apu_update_levels(apu_t *apu)
+{
+	if (!apu_synthesizing(apu)) {
+		return;
+	}
+
+	for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+		apu_set_level(apu, channel, apu_output(apu, channel), apu->clock);
+	}
+}
+
+static void apu_update_gains(apu_t *apu)
+{
+	byte nr50 = APU_REGISTER(apu, NR50_REGISTER);
+	byte nr51 = APU_REGISTER(apu, NR51_REGISTER);
+	int volumes[2] = { ((nr50 >> 4) & 0x07) + 1, (nr50 & 0x07) + 1 };
+
+	for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+		/* NR51 has the left enables in its high nibble */
+		bool enabled[2] = { (nr51 >> (channel + 4)) & 1, (nr51 >> channel) & 1 };
+
+		for (int side = 0; side < 2; side++) {
+			int gain = enabled[side] ? volumes[side] * APU_LEVEL_SCALE : 0;
+			int level = apu->channels[channel].level;
+
+			if (apu_synthesizing(apu) && level != 0 &&
+			    gain != apu->gains[side][channel]) {
+				apu_add_step(apu, side, apu->clock,
+					     (int64_t)level * (gain - apu->gains[side][channel]));
+			}
+			apu->gains[side][channel] = gain;
+		}
+	}
+}
+
+static void apu_step_waveform(apu_t *apu, int channel)
+{
+	apu_channel_t *ch = &apu->channels[channel];
+
+	switch (channel) {
+	case APU_CHANNEL_WAVE:
+		ch->position = (ch->position + 1) & (APU_WAVE_SAMPLES - 1);
+		break;
+	case APU_CHANNEL_NOISE: {
+		uint16_t bit = (apu->lfsr ^ (apu->lfsr >> 1)) & 1;
+
+		apu->lfsr = (uint16_t)((apu->lfsr >> 1) | (bit << 14));
+		if (APU_REGISTER(apu, NR43_REGISTER) & 0x08) {
+			apu->lfsr = (uint16_t)((apu->lfsr & ~0x40) | (bit << 6));
+		}
+		break;
+	}
+	default:
+		ch->position = (ch->position + 1) & 7;
+		break;
+	}
+}
+
+/* Steps one channel's waveform through a stretch where no register changes */
+static void apu_run_channel(apu_t *apu, int channel, uint64_t from,
+			    uint64_t to)
+{
+	apu_channel_t *ch = &apu->channels[channel];
+	int period = apu_period(apu, channel);
+
+	if (!ch->enabled || period == 0) {
+		return;
+	}
+
+	uint64_t clock = from + (uint64_t)ch->timer;
+	while (clock <= to) {
+		apu_step_waveform(apu, channel);
+		apu_set_level(apu, channel, apu_output(apu, channel), clock);
+		clock += (uint64_t)period;
+	}
+	ch->timer = (int)(clock - to);
+}
+
+/* Hands every finished sample to the output ring */
+static void apu_emit(apu_t *apu, uint64_t clock)
+{
+	apu_frame_t frames[APU_BUFFER_SIZE];
+	uint64_t position = apu_buffer_position(apu, clock);
+	size_t count = (size_t)(position >> 32);
+
+	assert(count <= APU_BUFFER_SIZE);
+	for (int side = 0; side < 2; side++) {
+		int64_t *buffer = apu->buffer[side];
+
+		for (size_t i = 0; i < count; i++) {
+			apu->integrator[side] += buffer[i];
+
+			int64_t sample = apu->integrator[side] >> APU_KERNEL_BITS;
+			apu->highpass[side] += (sample * 65536 - apu->highpass[side]) >>
+					       APU_HIGHPASS_SHIFT;
+			sample -= apu->highpass[side] >> 16;
+			sample = MAX(MIN(sample, INT16_MAX), INT16_MIN);
+
+			if (side == 0) {
+				frames[i].left = (int16_t)sample;
+			} else {
+				frames[i].right = (int16_t)sample;
+			}
+		}
+
+		/* Steps still ringing into later samples move to the front */
+		memmove(buffer, buffer + count, APU_BLIP_WIDTH * sizeof(int64_t));
+		memset(buffer + APU_BLIP_WIDTH, 0, count * sizeof(int64_t));
+	}
+
+	/* Emulation never waits for the consumer; a full ring drops samples */
+	size_t space = ring_buffer_space(apu->output) / sizeof(apu_frame_t);
+	size_t written = MIN(count, space);
+
+	ring_buffer_write(apu->output, frames, written * sizeof(apu_frame_t));
+	apu->samples += count;
+	apu->dropped += count - written;
+
+	apu->buffer_offset = position - ((uint64_t)count << 32);
+	apu->buffer_clock = clock;
+}
+
+static void apu_run(apu_t *apu, uint64_t clock)
+{
+	if (apu_synthesizing(apu)) {
+		for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+			apu_run_channel(apu, channel, apu->clock, clock);
+		}
+		apu_emit(apu, clock);
+	}
+
+	apu->clock = clock;
+}
+
+static void apu_disable(apu_t *apu, int channel)
+{
+	apu->channels[channel].enabled = false;
+}
+
+/* Frequency the sweep moves to next; disables channel 1 past the top */
+static int apu_sweep_target(apu_t *apu)
+{
+	byte nr10 = APU_REGISTER(apu, NR10_REGISTER);
+	int delta = apu->sweep_shadow >> (nr10 & 0x07);
+	int target = nr10 & 0x08 ? apu->sweep_shadow - delta :
+				   apu->sweep_shadow + delta;
+
+	if (target > APU_MAX_FREQUENCY) {
+		apu_disable(apu, APU_CHANNEL_SQUARE1);
+	}
+
+	return target;
+}
+
+static void apu_clock_sweep(apu_t *apu)
+{
+	byte nr10 = APU_REGISTER(apu, NR10_REGISTER);
+	int period = (nr10 >> 4) & 0x07;
+
+	if (--apu->sweep_timer > 0) {
+		return;
+	}
+
+	apu->sweep_timer = period != 0 ? period : 8;
+	if (!apu->sweep_enabled || period == 0) {
+		return;
+	}
+
+	int target = apu_sweep_target(apu);
+	if (target <= APU_MAX_FREQUENCY && (nr10 & 0x07) != 0) {
+		apu->sweep_shadow = target;
+		APU_REGISTER(apu, NR13_REGISTER) = (byte)target;
+		APU_REGISTER(apu, NR14_REGISTER) =
+			(byte)((APU_REGISTER(apu, NR14_REGISTER) & ~0x07) |
+			       (target >> 8));
+		apu_sweep_target(apu);
+	}
+}
+
+static void apu_clock_lengths(apu_t *apu)
+{
+	for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+		apu_channel_t *ch = &apu->channels[channel];
+
+		if ((apu_channel_register(apu, channel, 4) & NRX4_LENGTH_ENABLE) &&
+		    ch->length > 0 && --ch->length == 0) {
+			apu_disable(apu, channel);
+		}
+	}
+}
+
+static void apu_clock_envelopes(apu_t *apu)
+{
+	for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+		apu_channel_t *ch = &apu->channels[channel];
+		byte envelope = apu_channel_register(apu, channel, 2);
+		int period = envelope & 0x07;
+
+		if (channel == APU_CHANNEL_WAVE || period == 0 ||
+		    --ch->envelope_timer > 0) {
+			continue;
+		}
+
+		ch->envelope_timer = period;
+		if ((envelope & 0x08) && ch->volume < 15) {
+			ch->volume++;
+		} else if (!(envelope & 0x08) && ch->volume > 0) {
+			ch->volume--;
+		}
+	}
+}
+
+static void apu_clock_sequencer(apu_t *apu)
+{
+	if (apu_powered(apu)) {
+		if ((apu->step & 1) == 0) {
+			apu_clock_lengths(apu);
+		}
+		if (apu->step == 2 || apu->step == 6) {
+			apu_clock_sweep(apu);
+		}
+		if (apu->step == 7) {
+			apu_clock_envelopes(apu);
+		}
+	}
+
+	apu->step = (apu->step + 1) & 7;
+	apu->next_step += APU_SEQUENCER_CYCLES;
+}
+
+static bool apu_any_enabled(const apu_t *apu)
+{
+	for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+		if (apu->channels[channel].enabled) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void apu_advance(apu_t *apu, uint64_t clock)
+{
+	if (clock <= apu->clock) {
+		return;
+	}
+
+	/* Steps with nothing playing and nothing to synthesize change nothing */
+	if (!apu_synthesizing(apu) && !apu_any_enabled(apu) &&
+	    apu->next_step <= clock) {
+		uint64_t steps = (clock - apu->next_step) / APU_SEQUENCER_CYCLES + 1;
+
+		apu->step = (int)((apu->step + steps) & 7);
+		apu->next_step += steps * APU_SEQUENCER_CYCLES;
+	}
+
+	while (apu->next_step <= clock) {
+		apu_run(apu, apu->next_step);
+		apu_clock_sequencer(apu);
+		apu_update_levels(apu);
+	}
+
+	apu_run(apu, clock);
+}
+
+static void apu_schedule(apu_t *apu)
+{
+	/* Without synthesis nothing needs to happen on time */
+	if (!apu_synthesizing(apu)) {
+		scheduler_cancel(apu->scheduler, SCHEDULER_EVENT_APU);
+		return;
+	}
+
+	scheduler_schedule(apu->scheduler, SCHEDULER_EVENT_APU, apu->next_step);
+}
+
+static void apu_event(void *context, uint64_t deadline)
+{
+	apu_t *apu = context;
+
+	apu_advance(apu, deadline);
+	apu_schedule(apu);
+}
+
+/**
+ * @brief Runs the channels up to the scheduler's clock
+ *
+ * Every sample finished by then is in the output ring afterwards.
+ *
+ * @param apu apu to update
+ */
+void apu_sync(apu_t *apu)
+{
+	assert(apu != NULL);
+
+	apu_advance(apu, scheduler_now(apu->scheduler));
+}
+
+/* Starts the synthesis over from silence at the current cycle */
+static void apu_restart_output(apu_t *apu)
+{
+	memset(apu->buffer, 0, sizeof(apu->buffer));
+	memset(apu->integrator, 0, sizeof(apu->integrator));
+	memset(apu->highpass, 0, sizeof(apu->highpass));
+	apu->buffer_clock = apu->clock;
+	apu->buffer_offset = 0;
+
+	for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+		apu->channels[channel].level = 0;
+	}
+	apu_update_gains(apu);
+	apu_update_levels(apu);
+}
+
+/**
+ * @brief Restarts the APU's timeline at the scheduler's current cycle
+ *
+ * Needed whenever the APU state or the clock was replaced wholesale, as by
+ * a reset, a loaded state or a fork. next_step must lie within one
+ * sequencer step of the current cycle.
+ *
+ * @param apu apu to restart
+ */
+void apu_reschedule(apu_t *apu)
+{
+	assert(apu != NULL);
+
+	apu->clock = scheduler_now(apu->scheduler);
+	apu_restart_output(apu);
+	apu_schedule(apu);
+}
+
+/**
+ * @brief Turns synthesis off or back on
+ *
+ * Headless, register and channel state is kept up to date, but no
+ * waveform is stepped, no sample made and no event scheduled.
+ *
+ * @param apu apu to configure
+ * @param headless true to skip synthesis
+ */
+void apu_set_headless(apu_t *apu, bool headless)
+{
+	assert(apu != NULL);
+
+	apu_sync(apu);
+	apu->headless = headless;
+	apu_reschedule(apu);
+}
+
+/**
+ * @brief Selects where samples go
+ *
+ * The emulation thread is the ring's producer; any one other thread may
+ * drain it.
+ *
+ * @param apu apu to configure
+ * @param output ring of apu_frame_t, or NULL to stop synthesizing
+ */
+void apu_set_output(apu_t *apu, ring_buffer_t *output)
+{
+	assert(apu != NULL);
+
+	apu_sync(apu);
+	apu->output = output;
+	apu_reschedule(apu);
+}
+
+static void apu_trigger(apu_t *apu, int channel)
+{
+	apu_channel_t *ch = &apu->channels[channel];
+	byte envelope = apu_channel_register(apu, channel, 2);
+
+	ch->enabled = apu_dac_enabled(apu, channel);
+	if (ch->length == 0) {
+		ch->length = channel == APU_CHANNEL_WAVE ? 256 : 64;
+	}
+	ch->timer = MAX(apu_period(apu, channel), 1);
+	ch->volume = envelope >> 4;
+	ch->envelope_timer = envelope & 0x07;
+
+	if (channel == APU_CHANNEL_WAVE) {
+		ch->position = 0;
+	} else if (channel == APU_CHANNEL_NOISE) {
+		apu->lfsr = 0x7FFF;
+	} else if (channel == APU_CHANNEL_SQUARE1) {
+		byte nr10 = APU_REGISTER(apu, NR10_REGISTER);
+		int period = (nr10 >> 4) & 0x07;
+
+		apu->sweep_shadow = apu_frequency(apu, channel);
+		apu->sweep_timer = period != 0 ? period : 8;
+		apu->sweep_enabled = period != 0 || (nr10 & 0x07) != 0;
+		if (nr10 & 0x07) {
+			apu_sweep_target(apu);
+		}
+	}
+}
+
+static void apu_power(apu_t *apu, bool on)
+{
+	if (on == apu_powered(apu)) {
+		return;
+	}
+
+	if (on) {
+		/* The sequencer starts over from step 0 */
+		apu->step = 0;
+		apu->next_step = apu->clock + APU_SEQUENCER_CYCLES;
+		apu_schedule(apu);
+		return;
+	}
+
+	memset(&APU_REGISTER(apu, NR10_REGISTER), 0,
+	       NR52_REGISTER - NR10_REGISTER);
+	for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+		apu_disable(apu, channel);
+	}
+}
+
+static byte apu_register_read(memory_system_t *mem_sys, void *context,
+			      address addr)
+{
+	apu_t *apu = context;
+	byte value = mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)];
+
+	if (addr == NR52_REGISTER) {
+		/* Length counters may have run out since the last sync */
+		apu_sync(apu);
+		value &= NR52_POWER;
+		for (int channel = 0; channel < APU_CHANNEL_COUNT; channel++) {
+			value |= apu->channels[channel].enabled << channel;
+		}
+	}
+
+	return value | apu_read_masks[addr - NR10_REGISTER];
+}
+
+static void apu_register_write(memory_system_t *mem_sys, void *context,
+			       address addr, byte value)
+{
+	apu_t *apu = context;
+	byte *reg = &mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)];
+
+	/* Everything up to this cycle still plays with the old value */
+	apu_sync(apu);
+
+	if (addr == NR52_REGISTER) {
+		apu_power(apu, (value & NR52_POWER) != 0);
+		*reg = value & NR52_POWER;
+		apu_update_gains(apu);
+		apu_update_levels(apu);
+		return;
+	}
+
+	/* Registers are frozen while powered off; wave RAM is not */
+	if (addr <= APU_REGISTERS_END && !apu_powered(apu)) {
+		return;
+	}
+
+	*reg = value;
+	switch (addr) {
+	case NR11_REGISTER:
+	case NR21_REGISTER:
+	case NR41_REGISTER:
+		apu->channels[(addr - NR10_REGISTER) / 5].length = 64 - (value & 0x3F);
+		break;
+	case NR31_REGISTER:
+		apu->channels[APU_CHANNEL_WAVE].length = 256 - value;
+		break;
+	case NR12_REGISTER:
+	case NR22_REGISTER:
+	case NR42_REGISTER:
+		if ((value & 0xF8) == 0) {
+			apu_disable(apu, (addr - NR10_REGISTER) / 5);
+		}
+		break;
+	case NR30_REGISTER:
+		if (!(value & 0x80)) {
+			apu_disable(apu, APU_CHANNEL_WAVE);
+		}
+		break;
+	case NR14_REGISTER:
+	case NR24_REGISTER:
+	case NR34_REGISTER:
+	case NR44_REGISTER:
+		if (value & NRX4_TRIGGER) {
+			apu_trigger(apu, (addr - NR10_REGISTER) / 5);
+		}
+		break;
+	case NR50_REGISTER:
+	case NR51_REGISTER:
+		apu_update_gains(apu);
+		break;
+	default:
+		break;
+	}
+
+	apu_update_levels(apu);
+}
+
+/* Windowed sinc impulse for every sub-sample phase, each summing to one */
+static void apu_build_kernel(apu_t *apu)
+{
+	const double half = APU_BLIP_WIDTH / 2.0;
+
+	for (int phase = 0; phase < APU_BLIP_PHASES; phase++) {
+		double taps[APU_BLIP_WIDTH];
+		double sum = 0.0;
+
+		for (int i = 0; i < APU_BLIP_WIDTH; i++) {
+			double x = i - (half - 1.0) - (double)phase / APU_BLIP_PHASES;
+			double sinc = x == 0.0 ? 1.0 :
+						 sin(APU_PI * APU_KERNEL_CUTOFF * x) /
+							 (APU_PI * APU_KERNEL_CUTOFF * x);
+			double window = fabs(x) >= half ?
+						0.0 :
+						0.42 + 0.5 * cos(APU_PI * x / half) +
+							0.08 * cos(2.0 * APU_PI * x / half);
+
+			taps[i] = sinc * window;
+			sum += taps[i];
+		}
+
+		int32_t total = 0;
+		int largest = 0;
+		for (int i = 0; i < APU_BLIP_WIDTH; i++) {
+			apu->kernel[phase][i] =
+				(int32_t)lround(taps[i] / sum * (1 << APU_KERNEL_BITS));
+			total += apu->kernel[phase][i];
+			if (apu->kernel[phase][i] > apu->kernel[phase][largest]) {
+				largest = i;
+			}
+		}
+
+		/* Rounding must not leave a DC error behind every step */
+		apu->kernel[phase][largest] += (1 << APU_KERNEL_BITS) - total;
+	}
+}
+
+bool apu_init(apu_t *apu, memory_system_t *mem_sys, scheduler_t *scheduler)
+{
+	if (apu == NULL || mem_sys == NULL || scheduler == NULL) {
+		printf("Cannot initialize APU without memory system and scheduler\n");
+		return false;
+	}
+
+	apu->mem_sys = mem_sys;
+	apu->scheduler = scheduler;
+	apu->headless = false;
+	apu->output = NULL;
+	apu_build_kernel(apu);
+
+	scheduler_register(scheduler, SCHEDULER_EVENT_APU, apu_event, apu);
+	for (address addr = NR10_REGISTER; addr <= APU_REGISTERS_END; addr++) {
+		memory_register_io(mem_sys, addr, apu_register_read,
+				   apu_register_write, apu);
+	}
+	for (address addr = WAVE_RAM_START; addr <= WAVE_RAM_END; addr++) {
+		memory_register_io(mem_sys, addr, NULL, apu_register_write, apu);
+	}
+	apu_reset(apu);
+
+	return true;
+}
+
+void apu_reset(apu_t *apu)
+{
+	assert(apu != NULL);
+
+	memcpy(&APU_REGISTER(apu, NR10_REGISTER), apu_boot_registers,
+	       sizeof(apu_boot_registers));
+	memset(apu->channels, 0, sizeof(apu->channels));
+	/* The boot chime has faded out but channel 1 still reports on */
+	apu->channels[APU_CHANNEL_SQUARE1].enabled = true;
+	apu->sweep_enabled = false;
+	apu->sweep_timer = 8;
+	apu->sweep_shadow = 0;
+	apu->lfsr = 0x7FFF;
+
+	apu->step = 0;
+	apu->next_step = scheduler_now(apu->scheduler) + APU_SEQUENCER_CYCLES;
+	apu->samples = 0;
+	apu->dropped = 0;
+	apu_reschedule(apu);
+}
@@ -0,0 +1,417 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/batch.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Each worker owns a deque of job indices. It takes work from the back of
+ * its own deque and, once that is empty, steals from the front of the
+ * others'. Jobs never spawn jobs, so a worker that finds every deque empty
+ * is done.
+ */
+typedef struct batch_deque {
+	pthread_mutex_t lock;
+	int *items;
+	int head;
+	int tail;
+} batch_deque_t;
+
+typedef struct batch_pool batch_pool_t;
+
+typedef struct batch_worker {
+	batch_pool_t *pool;
+	int index;
+	pthread_t thread;
+} batch_worker_t;
+
+struct batch_pool {
+	const batch_job_t *jobs;
+	batch_result_t *results;
+	const batch_options_t *options;
+	batch_deque_t *deques;
+	batch_worker_t *workers;
+	int threads;
+};
+
+static double batch_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool batch_pop(batch_deque_t *deque, int *job)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&deque->lock);
+	if (deque->tail > deque->head) {
+		*job = deque->items[--deque->tail];
+		found = true;
+	}
+	pthread_mutex_unlock(&deque->lock);
+
+	return found;
+}
+
+static bool batch_steal(batch_deque_t *deque, int *job)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&deque->lock);
+	if (deque->tail > deque->head) {
+		*job = deque->items[deque->head++];
+		found = true;
+	}
+	pthread_mutex_unlock(&deque->lock);
+
+	return found;
+}
+
+static bool batch_next_job(batch_worker_t *worker, int *job)
+{
+	batch_pool_t *pool = worker->pool;
+
+	if (batch_pop(&pool->deques[worker->index], job)) {
+		return true;
+	}
+
+	for (int i = 1; i < pool->threads; i++) {
+		int victim = (worker->index + i) % pool->threads;
+
+		if (batch_steal(&pool->deques[victim], job)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void batch_run_job(const batch_job_t *job, batch_result_t *result,
+			  const batch_options_t *options)
+{
+	double begin = batch_now();
+	gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+	memset(result, 0, sizeof(*result));
+
+	if (gb == NULL || !gameboy_init(gb)) {
+		free(gb);
+		result->wall_seconds = batch_now() - begin;
+		return;
+	}
+
+	if (gameboy_load_rom(gb, job->rom_path)) {
+		gb->use_block_cache = options->use_block_cache;
+		gb->use_jit = options->use_jit;
+		gameboy_set_headless(gb, options->headless);
+
+		result->cycles = gameboy_run(gb, job->cycles);
+		result->framebuffer_hash = gameboy_framebuffer_hash(gb);
+		result->ok = true;
+	}
+
+	gameboy_cleanup(gb);
+	free(gb);
+	result->wall_seconds = batch_now() - begin;
+}
+
+static void *batch_worker_main(void *argument)
+{
+	batch_worker_t *worker = argument;
+	batch_pool_t *pool = worker->pool;
+	int job;
+
+	while (batch_next_job(worker, &job)) {
+		batch_run_job(&pool->jobs[job], &pool->results[job],
+			      pool->options);
+	}
+
+	return NULL;
+}
+
+static void batch_free_pool(batch_pool_t *pool, int deque_count)
+{
+	for (int i = 0; i < deque_count; i++) {
+		pthread_mutex_destroy(&pool->deques[i].lock);
+		free(pool->deques[i].items);
+	}
+	free(pool->deques);
+	free(pool->workers);
+}
+
+/**
+ * @brief Runs every job on its own emulator instance across a thread pool
+ *
+ * Results land at the same index as their job. A job whose ROM cannot be
+ * loaded gets ok = false; that does not fail the batch.
+ *
+ * @param jobs ROMs and cycle budgets
+ * @param results receives one result per job
+ * @param count number of jobs
+ * @param options thread count (clamped to 1..BATCH_MAX_THREADS and the
+ *                job count) and per-instance settings
+ * @return false if the pool could not be started
+ */
+bool batch_run(const batch_job_t *jobs, batch_result_t *results, int count,
+	       const batch_options_t *options)
+{
+	assert(jobs != NULL && results != NULL && options != NULL);
+
+	if (count <= 0) {
+		return true;
+	}
+
+	batch_pool_t pool;
+	pool.jobs = jobs;
+	pool.results = results;
+	pool.options = options;
+	pool.threads = MIN(MAX(options->threads, 1), MIN(count, BATCH_MAX_THREADS));
+	pool.deques = calloc(pool.threads, sizeof(batch_deque_t));
+	pool.workers = calloc(pool.threads, sizeof(batch_worker_t));
+
+	if (pool.deques == NULL || pool.workers == NULL) {
+		printf("ERROR: COULD NOT ALLOCATE BATCH POOL\n");
+		batch_free_pool(&pool, 0);
+		return false;
+	}
+
+	/* Deal jobs out round-robin; stealing evens out uneven ROMs */
+	for (int i = 0; i < pool.threads; i++) {
+		batch_deque_t *deque = &pool.deques[i];
+
+		deque->items = malloc(sizeof(int) * (count / pool.threads + 1));
+		if (deque->items == NULL) {
+			printf("ERROR: COULD NOT ALLOCATE BATCH POOL\n");
+			batch_free_pool(&pool, i);
+			return false;
+		}
+		pthread_mutex_init(&deque->lock, NULL);
+	}
+	for (int job = 0; job < count; job++) {
+		batch_deque_t *deque = &pool.deques[job % pool.threads];
+
+		deque->items[deque->tail++] = job;
+	}
+
+	int started = 0;
+	for (; started < pool.threads; started++) {
+		batch_worker_t *worker = &pool.workers[started];
+
+		worker->pool = &pool;
+		worker->index = started;
+		if (pthread_create(&worker->thread, NULL, batch_worker_main,
+				   worker) != 0) {
+			printf("ERROR: COULD NOT START BATCH THREAD\n");
+			break;
+		}
+	}
+
+	/* Threads that did not start leave their jobs to be stolen */
+	if (started == 0) {
+		batch_free_pool(&pool, pool.threads);
+		return false;
+	}
+
+	for (int i = 0; i < started; i++) {
+		pthread_join(pool.workers[i].thread, NULL);
+	}
+
+	batch_free_pool(&pool, pool.threads);
+	return true;
+}
+
+/*
+ * Splits one "ROM [CYCLES]" entry in place. CYCLES must be a positive
+ * decimal number that fits; anything else, including a sign or a third
+ * field, makes the entry malformed.
+ */
+static bool batch_parse_entry(char *text, char **rom,
+			      unsigned long long *cycles)
+{
+	char *end = text;
+
+	while (*end != '\0' && !isspace((unsigned char)*end)) {
+		end++;
+	}
+	if (*end != '\0') {
+		*end++ = '\0';
+	}
+	*rom = text;
+
+	while (isspace((unsigned char)*end)) {
+		end++;
+	}
+	if (*end == '\0') {
+		*cycles = BATCH_DEFAULT_CYCLES;
+		return true;
+	}
+	if (!isdigit((unsigned char)*end)) {
+		return false;
+	}
+
+	errno = 0;
+	*cycles = strtoull(end, &end, 10);
+	if (errno == ERANGE || *cycles == 0) {
+		return false;
+	}
+
+	while (isspace((unsigned char)*end)) {
+		end++;
+	}
+	return *end == '\0';
+}
+
+/**
+ * @brief Reads a batch list: one "ROM [CYCLES]" entry per line
+ *
+ * Blank lines and lines starting with '#' are skipped. Paths cannot
+ * contain whitespace.
+ *
+ * @param path list file
+ * @param jobs receives a newly allocated array, free with batch_free_list()
+ * @param count receives the number of entries
+ * @return false if the file cannot be read or a line is malformed
+ */
+bool batch_read_list(const char *path, batch_job_t **jobs, int *count)
+{
+	assert(path != NULL && jobs != NULL && count != NULL);
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		printf("ERROR: COULD NOT READ BATCH LIST '%s'\n", path);
+		return false;
+	}
+
+	batch_job_t *list = NULL;
+	int size = 0;
+	int capacity = 0;
+	char *line = NULL;
+	size_t line_capacity = 0;
+	int line_number = 0;
+	bool ok = true;
+
+	while (getline(&line, &line_capacity, file) != -1) {
+		char *rom;
+		unsigned long long cycles;
+		char *text = line;
+
+		line_number++;
+		while (isspace((unsigned char)*text)) {
+			text++;
+		}
+		if (*text == '\0' || *text == '#') {
+			continue;
+		}
+
+		if (!batch_parse_entry(text, &rom, &cycles)) {
+			printf("ERROR: BAD BATCH LIST ENTRY AT LINE %d\n",
+			       line_number);
+			ok = false;
+			break;
+		}
+
+		if (size == capacity) {
+			int new_capacity = capacity == 0 ? 16 : capacity * 2;
+			batch_job_t *grown = realloc(list, sizeof(batch_job_t) *
+							     new_capacity);
+			if (grown == NULL) {
+				ok = false;
+				break;
+			}
+			list = grown;
+			capacity = new_capacity;
+		}
+
+		list[size].rom_path = strdup(rom);
+		list[size].cycles = cycles;
+		if (list[size].rom_path == NULL) {
+			ok = false;
+			break;
+		}
+		size++;
+	}
+
+	free(line);
+	fclose(file);
+
+	if (!ok) {
+		batch_free_list(list, size);
+		return false;
+	}
+
+	*jobs = list;
+	*count = size;
+	return true;
+}
+
+void batch_free_list(batch_job_t *jobs, int count)
+{
+	for (int i = 0; i < count; i++) {
+		free(jobs[i].rom_path);
+	}
+	free(jobs);
+}
+
+/* Writes text as a quoted CSV field, doubling embedded quotes (RFC 4180) */
+static void batch_write_csv_field(FILE *file, const char *text)
+{
+	fputc('"', file);
+	for (; *text != '\0'; text++) {
+		if (*text == '"') {
+			fputc('"', file);
+		}
+		fputc(*text, file);
+	}
+	fputc('"', file);
+}
+
+/**
+ * @brief Writes one CSV row per job, in job order
+ *
+ * Columns: rom, status, cycles, wall_seconds, framebuffer_hash. The rom
+ * column is always quoted, so paths may contain commas and quotes.
+ *
+ * @return false if the file cannot be written
+ */
+bool batch_write_csv(const char *path, const batch_job_t *jobs,
+		     const batch_result_t *results, int count)
+{
+	assert(path != NULL && jobs != NULL && results != NULL);
+
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		printf("ERROR: COULD NOT WRITE '%s'\n", path);
+		return false;
+	}
+
+	fprintf(file, "rom,status,cycles,wall_seconds,framebuffer_hash\n");
+	for (int i = 0; i < count; i++) {
+		const batch_result_t *result = &results[i];
+
+		batch_write_csv_field(file, jobs[i].rom_path);
+		fprintf(file, ",%s,%llu,%.6f,%016llx\n",
+			result->ok ? "ok" : "error",
+			(unsigned long long)result->cycles, result->wall_seconds,
+			(unsigned long long)result->framebuffer_hash);
+	}
+
+	bool ok = ferror(file) == 0;
+	if (fclose(file) != 0) {
+		ok = false;
+	}
+
+	return ok;
+}
@@ -0,0 +1,277 @@
+#include "../include/block_cache.h"
+#include "../include/cpu.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define BLOCK_CACHE_NO_PAGE -1
+
+bool block_cache_init(block_cache_t *cache)
+{
+	if (cache == NULL) {
+		printf("Cannot initialize NULL block cache\n");
+		return false;
+	}
+
+	cache->blocks = malloc(sizeof(block_t) * BLOCK_CACHE_BLOCK_COUNT);
+	if (cache->blocks == NULL) {
+		printf("ERROR: FAILED TO ALLOCATE BLOCK CACHE\n");
+		return false;
+	}
+
+	cache->blocks_compiled = 0;
+	cache->flushes = 0;
+	block_cache_flush(cache);
+
+	return true;
+}
+
+void block_cache_cleanup(block_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	free(cache->blocks);
+	cache->blocks = NULL;
+	cache->block_count = 0;
+}
+
+/**
+ * @brief Drops every cached block
+ *
+ * Must be called whenever the memory system behind the cache is
+ * re-initialized or gets a new ROM, since blocks are keyed by host address.
+ *
+ * @param cache cache to empty
+ */
+void block_cache_flush(block_cache_t *cache)
+{
+	assert(cache != NULL);
+
+	cache->block_count = 0;
+	cache->last = NULL;
+	memset(cache->table, 0, sizeof(cache->table));
+	cache->flushes++;
+}
+
+/*
+ * Host address of the opcode at pc, or NULL when pc is outside the regions
+ * worth caching (ROM, WRAM and HRAM). Echo RAM is left to the interpreter.
+ */
+static const byte *block_cache_host_address(const memory_system_t *mem_sys,
+					    address pc)
+{
+	int page = MEMORY_PAGE(pc);
+
+	if (pc <= ROM_END || (pc >= WRAM_START && pc <= WRAM_END)) {
+		const byte *base = mem_sys->read_map[page];
+
+		return base != NULL ? base + MEMORY_PAGE_OFFSET(pc) : NULL;
+	}
+
+	if (pc >= HRAM_START && pc <= HRAM_END) {
+		return &mem_sys->high_page[MEMORY_PAGE_OFFSET(pc)];
+	}
+
+	return NULL;
+}
+
+static size_t block_cache_hash(const byte *key)
+{
+	uint64_t value = (uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull;
+
+	return (size_t)(value >> 32) & (BLOCK_CACHE_TABLE_SIZE - 1);
+}
+
+static block_t **block_cache_slot(block_cache_t *cache, const byte *key)
+{
+	size_t index = block_cache_hash(key);
+
+	while (cache->table[index] != NULL && cache->table[index]->key != key) {
+		index = (index + 1) & (BLOCK_CACHE_TABLE_SIZE - 1);
+	}
+
+	return &cache->table[index];
+}
+
+static void block_cache_compile(block_t *block, cpu_t *cpu, address pc)
+{
+	memory_system_t *mem_sys = cpu->mem_sys;
+	int page = MEMORY_PAGE(pc);
+
+	block->count = 0;
+	block->next_link = 0;
+	memset(block->links, 0, sizeof(block->links));
+	memset(block->link_keys, 0, sizeof(block->link_keys));
+
+	/* ROM can only change through a reload, which flushes the cache */
+	block->page = BLOCK_CACHE_NO_PAGE;
+	if (pc > ROM_END) {
+		memory_protect_code(mem_sys, pc);
+		block->page = page;
+		block->version = mem_sys->code_versions[page];
+	}
+
+	while (block->count < BLOCK_CACHE_MAX_INSTRUCTIONS) {
+		cpu_instruction_t *instruction = &block->instructions[block->count];
+
+		cpu_decode(cpu, pc, instruction);
+
+		/* Stay inside the page so one version covers the whole block */
+		if (MEMORY_PAGE_OFFSET(pc) + instruction->length >
+		    MEMORY_PAGE_SIZE) {
+			break;
+		}
+
+		block->count++;
+		pc += instruction->length;
+
+		if ((instruction->flags & CPU_INSTRUCTION_ENDS_BLOCK) ||
+		    MEMORY_PAGE(pc) != page) {
+			break;
+		}
+	}
+}
+
+static block_t *block_cache_lookup(block_cache_t *cache, cpu_t *cpu,
+				   const byte *key)
+{
+	const memory_system_t *mem_sys = cpu->mem_sys;
+	block_t **slot = block_cache_slot(cache, key);
+	block_t *block = *slot;
+
+	if (block == NULL) {
+		if (cache->block_count == BLOCK_CACHE_BLOCK_COUNT) {
+			block_cache_flush(cache);
+			slot = block_cache_slot(cache, key);
+		}
+
+		block = &cache->blocks[cache->block_count++];
+		block->key = key;
+		*slot = block;
+	} else if (block->page == BLOCK_CACHE_NO_PAGE ||
+		   block->version == mem_sys->code_versions[block->page]) {
+		return block;
+	}
+
+	/* New, or its page was written since it was decoded */
+	block_cache_compile(block, cpu, cpu->pc);
+	cache->blocks_compiled++;
+
+	return block;
+}
+
+static block_t *block_cache_follow(block_cache_t *cache, cpu_t *cpu,
+				   block_t *previous, const byte *key)
+{
+	if (previous != NULL) {
+		for (int i = 0; i < BLOCK_CACHE_LINK_COUNT; i++) {
+			block_t *next = previous->links[i];
+
+			if (previous->link_keys[i] == key &&
+			    (next->page == BLOCK_CACHE_NO_PAGE ||
+			     next->version ==
+				     cpu->mem_sys->code_versions[next->page])) {
+				return next;
+			}
+		}
+	}
+
+	uint64_t flushes = cache->flushes;
+	block_t *block = block_cache_lookup(cache, cpu, key);
+
+	/* A flush inside the lookup may have recycled previous */
+	if (previous != NULL && flushes == cache->flushes) {
+		previous->link_keys[previous->next_link] = key;
+		previous->links[previous->next_link] = block;
+		previous->next_link = (previous->next_link + 1) %
+				      BLOCK_CACHE_LINK_COUNT;
+	}
+
+	return block;
+}
+
+/**
+ * @brief Runs the cpu through cached blocks for at least the given cycles
+ *
+ * Produces the same machine state as cpu_run(). Anything the blocks do not
+ * cover (interrupt entry, HALT, the EI delay, code outside ROM/WRAM/HRAM) is
+ * handed to cpu_step().
+ *
+ * @param cache block cache belonging to the cpu's memory system
+ * @param cpu cpu to advance
+ * @param cycles T-cycle budget
+ * @return T-cycles actually executed, which may overshoot by one instruction
+ */
+uint64_t block_cache_run(block_cache_t *cache, cpu_t *cpu, uint64_t cycles)
+{
+	assert(cache != NULL && cpu != NULL);
+
+	const uint32_t *code_versions = cpu->mem_sys->code_versions;
+	uint64_t start = cpu->cycles;
+	uint64_t target = start + cycles;
+	block_t *previous = cache->last;
+
+	while (cpu->cycles < target) {
+		const byte *key = block_cache_host_address(cpu->mem_sys,
+							   cpu->pc);
+
+		if (key == NULL || cpu_must_step(cpu)) {
+			if (!cpu_skip_halt(cpu, target)) {
+				cpu_step(cpu);
+			}
+			previous = NULL;
+			continue;
+		}
+
+		block_t *block = block_cache_follow(cache, cpu, previous, key);
+		if (block->count == 0) {
+			cpu_step(cpu);
+			previous = NULL;
+			continue;
+		}
+
+		/* A bank switch pulls the rest of a ROM block out from under it */
+		uint32_t rom_mapping = cpu->mem_sys->rom_mapping_version;
+
+		for (int i = 0; i < block->count; i++) {
+			const cpu_instruction_t *instruction =
+				&block->instructions[i];
+
+			cpu->pc = instruction->pc + instruction->opcode_length;
+			cpu->cycles += instruction->cycles;
+			instruction->handler(cpu);
+
+			if (cpu->cycles >= target) {
+				break;
+			}
+
+			if (instruction->flags & CPU_INSTRUCTION_WRITES) {
+				if (block->page != BLOCK_CACHE_NO_PAGE &&
+				    block->version != code_versions[block->page]) {
+					break;
+				}
+				if (block->page == BLOCK_CACHE_NO_PAGE &&
+				    rom_mapping !=
+					    cpu->mem_sys->rom_mapping_version) {
+					break;
+				}
+				if (cpu->ime && cpu_interrupt_pending(cpu)) {
+					break;
+				}
+			}
+		}
+
+		previous = block;
+	}
+
+	cache->last = previous;
+	return cpu->cycles - start;
+}
@@ -0,0 +1,432 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/capture.h"
+#include "../include/ring_buffer.h"
+#include "../include/gameboy.h"
+#include "../include/apu.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+static_assert(CAPTURE_BLOCK_SIZE % sizeof(apu_frame_t) == 0,
+	      "blocks must hold whole audio frames");
+
+/* Gray levels for shades 0 (white) to 3 (black) */
+static const byte capture_gray[4] = { 0xFF, 0xAA, 0x55, 0x00 };
+
+static void capture_put_u16(byte *out, uint16_t value)
+{
+	out[0] = (byte)value;
+	out[1] = (byte)(value >> 8);
+}
+
+static void capture_put_u32(byte *out, uint32_t value)
+{
+	capture_put_u16(out, (uint16_t)value);
+	capture_put_u16(out + 2, (uint16_t)(value >> 16));
+}
+
+/* 16-bit stereo PCM; sizes past 4 GiB are clamped */
+static void capture_wav_header(byte *out, uint64_t data_size)
+{
+	uint32_t size = (uint32_t)MIN(data_size,
+				      UINT32_MAX - CAPTURE_WAV_HEADER_SIZE);
+
+	memcpy(out, "RIFF", 4);
+	capture_put_u32(out + 4, size + CAPTURE_WAV_HEADER_SIZE - 8);
+	memcpy(out + 8, "WAVEfmt ", 8);
+	capture_put_u32(out + 16, 16);
+	capture_put_u16(out + 20, 1);
+	capture_put_u16(out + 22, 2);
+	capture_put_u32(out + 24, APU_SAMPLE_RATE);
+	capture_put_u32(out + 28, APU_SAMPLE_RATE * sizeof(apu_frame_t));
+	capture_put_u16(out + 32, sizeof(apu_frame_t));
+	capture_put_u16(out + 34, 16);
+	memcpy(out + 36, "data", 4);
+	capture_put_u32(out + 40, size);
+}
+
+/* Writes every byte of iov, however many calls that takes */
+static bool capture_write_all(int fd, struct iovec *iov, int count)
+{
+	while (count > 0) {
+		ssize_t written = writev(fd, iov, count);
+
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+
+		while (count > 0 && (size_t)written >= iov->iov_len) {
+			written -= (ssize_t)iov->iov_len;
+			iov++;
+			count--;
+		}
+		if (count > 0) {
+			iov->iov_base = (byte *)iov->iov_base + written;
+			iov->iov_len -= (size_t)written;
+		}
+	}
+
+	return true;
+}
+
+/* Writes each run of blocks for the same stream with one writev() */
+static void capture_write_batch(capture_t *capture, capture_block_t **batch,
+				size_t count)
+{
+	struct iovec iov[CAPTURE_BATCH_BLOCKS];
+	size_t first = 0;
+
+	while (first < count) {
+		int stream = batch[first]->stream;
+		size_t last = first;
+		int parts = 0;
+
+		while (last < count && batch[last]->stream == stream) {
+			capture_block_t *block = batch[last++];
+
+			/* Shades become gray levels here, off the emulation thread */
+			if (stream == CAPTURE_VIDEO) {
+				for (size_t i = 0; i < block->size; i++) {
+					block->data[i] = capture_gray[block->data[i] & 0x03];
+				}
+			}
+
+			iov[parts].iov_base = block->data;
+			iov[parts].iov_len = block->size;
+			parts++;
+		}
+
+		capture_stream_t *out = &capture->streams[stream];
+		if (!atomic_load(&capture->failed)) {
+			if (capture_write_all(out->fd, iov, parts)) {
+				for (size_t i = first; i < last; i++) {
+					out->written += batch[i]->size;
+				}
+			} else {
+				printf("ERROR: CAPTURE WRITE FAILED: %s\n", strerror(errno));
+				atomic_store(&capture->failed, true);
+			}
+		}
+		first = last;
+	}
+}
+
+static void *capture_writer(void *argument)
+{
+	capture_t *capture = argument;
+	capture_block_t *batch[CAPTURE_BATCH_BLOCKS];
+
+	for (;;) {
+		size_t count = ring_buffer_read(&capture->full_blocks, batch,
+						sizeof(batch)) / sizeof(batch[0]);
+
+		if (count > 0) {
+			capture_write_batch(capture, batch, count);
+			ring_buffer_write(&capture->free_blocks, batch,
+					  count * sizeof(batch[0]));
+			continue;
+		}
+
+		pthread_mutex_lock(&capture->lock);
+		while (ring_buffer_available(&capture->full_blocks) == 0 &&
+		       !capture->stopping) {
+			pthread_cond_wait(&capture->wake, &capture->lock);
+		}
+		bool done = ring_buffer_available(&capture->full_blocks) == 0;
+		pthread_mutex_unlock(&capture->lock);
+
+		if (done) {
+			return NULL;
+		}
+	}
+}
+
+/* Block the stream is filling, taking a free one if needed; NULL if none */
+static capture_block_t *capture_block(capture_t *capture, int stream)
+{
+	capture_stream_t *out = &capture->streams[stream];
+
+	if (out->block == NULL &&
+	    ring_buffer_read(&capture->free_blocks, &out->block,
+			     sizeof(out->block)) == sizeof(out->block)) {
+		out->block->stream = stream;
+		out->block->size = 0;
+	}
+
+	return out->block;
+}
+
+static void capture_submit(capture_t *capture, int stream)
+{
+	capture_stream_t *out = &capture->streams[stream];
+
+	/* There is room for every block, so this always succeeds */
+	ring_buffer_write(&capture->full_blocks, &out->block, sizeof(out->block));
+	out->block = NULL;
+
+	pthread_mutex_lock(&capture->lock);
+	pthread_cond_signal(&capture->wake);
+	pthread_mutex_unlock(&capture->lock);
+}
+
+static void capture_video(capture_t *capture, const gameboy_t *gb)
+{
+	capture_stream_t *out = &capture->streams[CAPTURE_VIDEO];
+	capture_block_t *block = capture_block(capture, CAPTURE_VIDEO);
+
+	if (block == NULL) {
+		out->dropped++;
+		return;
+	}
+
+	memcpy(block->data + block->size, gb->ppu.framebuffer,
+	       CAPTURE_FRAME_SIZE);
+	block->size += CAPTURE_FRAME_SIZE;
+	out->captured++;
+
+	if (block->size == CAPTURE_BLOCK_SIZE) {
+		capture_submit(capture, CAPTURE_VIDEO);
+	}
+}
+
+static void capture_audio(capture_t *capture)
+{
+	capture_stream_t *out = &capture->streams[CAPTURE_AUDIO];
+
+	while (ring_buffer_available(&capture->audio) > 0) {
+		capture_block_t *block = capture_block(capture, CAPTURE_AUDIO);
+
+		if (block == NULL) {
+			/* The APU writes from this thread too, so clearing is safe */
+			out->dropped += ring_buffer_available(&capture->audio) /
+					sizeof(apu_frame_t);
+			ring_buffer_clear(&capture->audio);
+			return;
+		}
+
+		size_t size = ring_buffer_read(&capture->audio,
+					       block->data + block->size,
+					       CAPTURE_BLOCK_SIZE - block->size);
+		block->size += size;
+		out->captured += size / sizeof(apu_frame_t);
+
+		if (block->size == CAPTURE_BLOCK_SIZE) {
+			capture_submit(capture, CAPTURE_AUDIO);
+		}
+	}
+}
+
+static bool capture_open_stream(capture_t *capture, int stream,
+				const char *path)
+{
+	capture_stream_t *out = &capture->streams[stream];
+	size_t length = strlen(path);
+
+	out->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (out->fd < 0) {
+		printf("ERROR: COULD NOT OPEN CAPTURE FILE %s: %s\n", path,
+		       strerror(errno));
+		return false;
+	}
+
+	/* Audio is raw 16-bit stereo unless the name asks for a WAV file */
+	out->wav = stream == CAPTURE_AUDIO && length >= 4 &&
+		   strcmp(path + length - 4, ".wav") == 0;
+	if (out->wav) {
+		byte header[CAPTURE_WAV_HEADER_SIZE];
+		struct iovec iov = { header, sizeof(header) };
+
+		capture_wav_header(header, 0);
+		if (!capture_write_all(out->fd, &iov, 1)) {
+			printf("ERROR: COULD NOT WRITE WAV HEADER\n");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Frees whatever capture_open() got to */
+static void capture_release(capture_t *capture)
+{
+	for (int stream = 0; stream < CAPTURE_STREAM_COUNT; stream++) {
+		if (capture->streams[stream].fd >= 0) {
+			close(capture->streams[stream].fd);
+			capture->streams[stream].fd = -1;
+		}
+	}
+
+	ring_buffer_cleanup(&capture->free_blocks);
+	ring_buffer_cleanup(&capture->full_blocks);
+	ring_buffer_cleanup(&capture->audio);
+	free(capture->blocks);
+	capture->blocks = NULL;
+}
+
+/**
+ * @brief Starts recording a machine's frames and audio
+ *
+ * Video is a raw stream of CAPTURE_FRAME_SIZE-byte grayscale frames, one
+ * per capture_frame(). Audio is 48 kHz 16-bit stereo, as a WAV file when
+ * audio_path ends in ".wav" and raw samples otherwise. Nothing is made in
+ * headless mode, so the machine has to be rendering.
+ *
+ * @param capture capture to initialize
+ * @param gb machine to record; its audio output is taken over
+ * @param video_path where frames go, or NULL
+ * @param audio_path where samples go, or NULL
+ * @param blocks size of the block pool, or 0 for CAPTURE_DEFAULT_BLOCKS
+ * @return false if the files or buffers cannot be set up
+ */
+bool capture_open(capture_t *capture, gameboy_t *gb, const char *video_path,
+		  const char *audio_path, int blocks)
+{
+	if (capture == NULL || gb == NULL || blocks < 0) {
+		printf("Cannot open capture\n");
+		return false;
+	}
+
+	memset(capture, 0, sizeof(*capture));
+	capture->streams[CAPTURE_VIDEO].fd = -1;
+	capture->streams[CAPTURE_AUDIO].fd = -1;
+	capture->block_count = blocks > 0 ? blocks : CAPTURE_DEFAULT_BLOCKS;
+
+	size_t pointers = (size_t)capture->block_count * sizeof(capture_block_t *);
+	capture->blocks = malloc((size_t)capture->block_count *
+				 sizeof(capture_block_t));
+	if (capture->blocks == NULL ||
+	    !ring_buffer_init(&capture->free_blocks, pointers) ||
+	    !ring_buffer_init(&capture->full_blocks, pointers) ||
+	    !ring_buffer_init(&capture->audio, CAPTURE_AUDIO_RING_SIZE)) {
+		printf("ERROR: COULD NOT ALLOCATE CAPTURE BUFFERS\n");
+		capture_release(capture);
+		return false;
+	}
+
+	for (int i = 0; i < capture->block_count; i++) {
+		capture_block_t *block = &capture->blocks[i];
+
+		ring_buffer_write(&capture->free_blocks, &block, sizeof(block));
+	}
+
+	if ((video_path != NULL &&
+	     !capture_open_stream(capture, CAPTURE_VIDEO, video_path)) ||
+	    (audio_path != NULL &&
+	     !capture_open_stream(capture, CAPTURE_AUDIO, audio_path))) {
+		capture_release(capture);
+		return false;
+	}
+
+	atomic_init(&capture->failed, false);
+	pthread_mutex_init(&capture->lock, NULL);
+	pthread_cond_init(&capture->wake, NULL);
+	if (pthread_create(&capture->writer, NULL, capture_writer, capture) != 0) {
+		printf("ERROR: COULD NOT START CAPTURE WRITER\n");
+		pthread_cond_destroy(&capture->wake);
+		pthread_mutex_destroy(&capture->lock);
+		capture_release(capture);
+		return false;
+	}
+
+	if (audio_path != NULL) {
+		capture->apu_dropped = gb->apu.dropped;
+		apu_set_output(&gb->apu, &capture->audio);
+	}
+	return true;
+}
+
+/**
+ * @brief Records the frame just finished and the audio made with it
+ *
+ * Call once after each gameboy_run_frame(). Never waits for the disk.
+ *
+ * @param capture open capture
+ * @param gb the machine given to capture_open()
+ */
+void capture_frame(capture_t *capture, gameboy_t *gb)
+{
+	assert(capture != NULL && gb != NULL);
+
+	if (capture->streams[CAPTURE_VIDEO].fd >= 0) {
+		capture_video(capture, gb);
+	}
+	if (capture->streams[CAPTURE_AUDIO].fd >= 0) {
+		capture_audio(capture);
+	}
+}
+
+/**
+ * @brief Writes out everything captured and closes the files
+ *
+ * Waits for the writer to finish. The counts in the streams stay readable
+ * afterwards; audio dropped by a full APU output ring is counted as well.
+ *
+ * @param capture open capture
+ * @param gb the machine given to capture_open(), whose audio output is
+ *           detached
+ * @return false if anything failed to be written
+ */
+bool capture_close(capture_t *capture, gameboy_t *gb)
+{
+	assert(capture != NULL && gb != NULL);
+
+	capture_stream_t *audio = &capture->streams[CAPTURE_AUDIO];
+	if (audio->fd >= 0) {
+		apu_sync(&gb->apu);
+		capture_audio(capture);
+		apu_set_output(&gb->apu, NULL);
+		audio->dropped += gb->apu.dropped - capture->apu_dropped;
+	}
+
+	for (int stream = 0; stream < CAPTURE_STREAM_COUNT; stream++) {
+		capture_block_t *block = capture->streams[stream].block;
+
+		if (block != NULL && block->size > 0) {
+			capture_submit(capture, stream);
+		}
+	}
+
+	pthread_mutex_lock(&capture->lock);
+	capture->stopping = true;
+	pthread_cond_signal(&capture->wake);
+	pthread_mutex_unlock(&capture->lock);
+	pthread_join(capture->writer, NULL);
+	pthread_cond_destroy(&capture->wake);
+	pthread_mutex_destroy(&capture->lock);
+
+	bool ok = !atomic_load(&capture->failed);
+	if (ok && audio->fd >= 0 && audio->wav) {
+		byte header[CAPTURE_WAV_HEADER_SIZE];
+
+		capture_wav_header(header, audio->written);
+		ok = pwrite(audio->fd, header, sizeof(header), 0) ==
+		     (ssize_t)sizeof(header);
+	}
+
+	for (int stream = 0; stream < CAPTURE_STREAM_COUNT; stream++) {
+		int fd = capture->streams[stream].fd;
+
+		if (fd >= 0 && close(fd) != 0) {
+			ok = false;
+		}
+		capture->streams[stream].fd = -1;
+		capture->streams[stream].block = NULL;
+	}
+
+	capture_release(capture);
+	return ok;
+}
@@ -0,0 +1,1184 @@
+#include "../include/cpu.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define CPU_INTERRUPT_MASK 0x1F
+#define CPU_INTERRUPT_CYCLES 20
+#define CPU_INTERRUPT_VECTOR 0x0040
+
+/* Extra T-cycles spent when a conditional branch is taken */
+#define CPU_JR_TAKEN_CYCLES 4
+#define CPU_JP_TAKEN_CYCLES 4
+#define CPU_CALL_TAKEN_CYCLES 12
+#define CPU_RET_TAKEN_CYCLES 12
+
+/*
+ * Base T-cycles per opcode; conditional branches are listed as not taken.
+ * 0xCB is zero because the prefixed table accounts for the whole instruction.
+ */
+static const byte cpu_opcode_cycles[256] = {
+	/*       0   1   2   3   4   5   6   7   8   9   A   B   C   D   E   F */
+	/* 0 */  4, 12,  8,  8,  4,  4,  8,  4, 20,  8,  8,  8,  4,  4,  8,  4,
+	/* 1 */  4, 12,  8,  8,  4,  4,  8,  4, 12,  8,  8,  8,  4,  4,  8,  4,
+	/* 2 */  8, 12,  8,  8,  4,  4,  8,  4,  8,  8,  8,  8,  4,  4,  8,  4,
+	/* 3 */  8, 12,  8,  8, 12, 12, 12,  4,  8,  8,  8,  8,  4,  4,  8,  4,
+	/* 4 */  4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	/* 5 */  4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	/* 6 */  4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	/* 7 */  8,  8,  8,  8,  8,  8,  4,  8,  4,  4,  4,  4,  4,  4,  8,  4,
+	/* 8 */  4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	/* 9 */  4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	/* A */  4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	/* B */  4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4,
+	/* C */  8, 12, 12, 16, 12, 16,  8, 16,  8, 16, 12,  0, 12, 24,  8, 16,
+	/* D */  8, 12, 12,  4, 12, 16,  8, 16,  8, 16, 12,  4, 12,  4,  8, 16,
+	/* E */ 12, 12,  8,  4,  4, 16,  8, 16, 16,  4, 16,  4,  4,  4,  8, 16,
+	/* F */ 12, 12,  8,  4,  4, 16,  8, 16, 12,  8, 16,  4,  4,  4,  8, 16,
+};
+
+/* Total T-cycles of each CB-prefixed instruction, prefix included */
+static const byte cpu_cb_opcode_cycles[256] = {
+	/*       0   1   2   3   4   5   6   7   8   9   A   B   C   D   E   F */
+	/* 0 */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* 1 */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* 2 */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* 3 */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* 4 */  8,  8,  8,  8,  8,  8, 12,  8,  8,  8,  8,  8,  8,  8, 12,  8,
+	/* 5 */  8,  8,  8,  8,  8,  8, 12,  8,  8,  8,  8,  8,  8,  8, 12,  8,
+	/* 6 */  8,  8,  8,  8,  8,  8, 12,  8,  8,  8,  8,  8,  8,  8, 12,  8,
+	/* 7 */  8,  8,  8,  8,  8,  8, 12,  8,  8,  8,  8,  8,  8,  8, 12,  8,
+	/* 8 */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* 9 */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* A */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* B */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* C */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* D */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* E */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+	/* F */  8,  8,  8,  8,  8,  8, 16,  8,  8,  8,  8,  8,  8,  8, 16,  8,
+};
+
+/* Instruction lengths in bytes, opcode included */
+static const byte cpu_opcode_lengths[256] = {
+	/*       0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+	/* 0 */  1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
+	/* 1 */  2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+	/* 2 */  2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+	/* 3 */  2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+	/* 4 */  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 5 */  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 6 */  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 7 */  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 8 */  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 9 */  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* A */  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* B */  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* C */  1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,
+	/* D */  1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,
+	/* E */  2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+	/* F */  2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+};
+
+/* Register pairs */
+
+word cpu_get_af(const cpu_t *cpu)
+{
+	return (word)((cpu->a << 8) | cpu->f);
+}
+
+word cpu_get_bc(const cpu_t *cpu)
+{
+	return (word)((cpu->b << 8) | cpu->c);
+}
+
+word cpu_get_de(const cpu_t *cpu)
+{
+	return (word)((cpu->d << 8) | cpu->e);
+}
+
+word cpu_get_hl(const cpu_t *cpu)
+{
+	return (word)((cpu->h << 8) | cpu->l);
+}
+
+static inline void cpu_set_af(cpu_t *cpu, word value)
+{
+	cpu->a = value >> 8;
+	cpu->f = value & 0xF0;
+}
+
+static inline void cpu_set_bc(cpu_t *cpu, word value)
+{
+	cpu->b = value >> 8;
+	cpu->c = value & 0xFF;
+}
+
+static inline void cpu_set_de(cpu_t *cpu, word value)
+{
+	cpu->d = value >> 8;
+	cpu->e = value & 0xFF;
+}
+
+static inline void cpu_set_hl(cpu_t *cpu, word value)
+{
+	cpu->h = value >> 8;
+	cpu->l = value & 0xFF;
+}
+
+/* Bus access */
+
+static inline byte cpu_read(cpu_t *cpu, address addr)
+{
+	return memory_read_byte(cpu->mem_sys, addr);
+}
+
+static inline void cpu_write(cpu_t *cpu, address addr, byte value)
+{
+	memory_write_byte(cpu->mem_sys, addr, value);
+}
+
+static inline byte cpu_fetch(cpu_t *cpu)
+{
+	return cpu_read(cpu, cpu->pc++);
+}
+
+static inline word cpu_fetch_word(cpu_t *cpu)
+{
+	byte low_byte = cpu_fetch(cpu);
+	byte high_byte = cpu_fetch(cpu);
+
+	return (word)(low_byte | (high_byte << 8));
+}
+
+static inline void cpu_push(cpu_t *cpu, word value)
+{
+	cpu_write(cpu, --cpu->sp, value >> 8);
+	cpu_write(cpu, --cpu->sp, value & 0xFF);
+}
+
+static inline word cpu_pop(cpu_t *cpu)
+{
+	byte low_byte = cpu_read(cpu, cpu->sp++);
+	byte high_byte = cpu_read(cpu, cpu->sp++);
+
+	return (word)(low_byte | (high_byte << 8));
+}
+
+/* ALU */
+
+static inline byte cpu_flags(bool z, bool n, bool h, bool c)
+{
+	return (z ? CPU_FLAG_Z : 0) | (n ? CPU_FLAG_N : 0) |
+	       (h ? CPU_FLAG_H : 0) | (c ? CPU_FLAG_C : 0);
+}
+
+#define CPU_CARRY(cpu) (((cpu)->f & CPU_FLAG_C) ? 1 : 0)
+
+static inline void cpu_add8(cpu_t *cpu, byte value, byte carry)
+{
+	unsigned int result = cpu->a + value + carry;
+
+	cpu->f = cpu_flags((result & 0xFF) == 0, false,
+			   (cpu->a & 0x0F) + (value & 0x0F) + carry > 0x0F,
+			   result > 0xFF);
+	cpu->a = (byte)result;
+}
+
+static inline byte cpu_sub8(cpu_t *cpu, byte value, byte carry)
+{
+	int result = cpu->a - value - carry;
+
+	cpu->f = cpu_flags((result & 0xFF) == 0, true,
+			   (cpu->a & 0x0F) - (value & 0x0F) - carry < 0,
+			   result < 0);
+	return (byte)result;
+}
+
+static inline void cpu_alu_add(cpu_t *cpu, byte value)
+{
+	cpu_add8(cpu, value, 0);
+}
+
+static inline void cpu_alu_adc(cpu_t *cpu, byte value)
+{
+	cpu_add8(cpu, value, CPU_CARRY(cpu));
+}
+
+static inline void cpu_alu_sub(cpu_t *cpu, byte value)
+{
+	cpu->a = cpu_sub8(cpu, value, 0);
+}
+
+static inline void cpu_alu_sbc(cpu_t *cpu, byte value)
+{
+	cpu->a = cpu_sub8(cpu, value, CPU_CARRY(cpu));
+}
+
+static inline void cpu_alu_and(cpu_t *cpu, byte value)
+{
+	cpu->a &= value;
+	cpu->f = cpu_flags(cpu->a == 0, false, true, false);
+}
+
+static inline void cpu_alu_xor(cpu_t *cpu, byte value)
+{
+	cpu->a ^= value;
+	cpu->f = cpu_flags(cpu->a == 0, false, false, false);
+}
+
+static inline void cpu_alu_or(cpu_t *cpu, byte value)
+{
+	cpu->a |= value;
+	cpu->f = cpu_flags(cpu->a == 0, false, false, false);
+}
+
+static inline void cpu_alu_cp(cpu_t *cpu, byte value)
+{
+	cpu_sub8(cpu, value, 0);
+}
+
+static inline byte cpu_inc8(cpu_t *cpu, byte value)
+{
+	byte result = value + 1;
+
+	cpu->f = (cpu->f & CPU_FLAG_C) |
+		 cpu_flags(result == 0, false, (value & 0x0F) == 0x0F, false);
+	return result;
+}
+
+static inline byte cpu_dec8(cpu_t *cpu, byte value)
+{
+	byte result = value - 1;
+
+	cpu->f = (cpu->f & CPU_FLAG_C) |
+		 cpu_flags(result == 0, true, (value & 0x0F) == 0x00, false);
+	return result;
+}
+
+static inline void cpu_add_hl(cpu_t *cpu, word value)
+{
+	word hl = cpu_get_hl(cpu);
+	unsigned int result = hl + value;
+
+	cpu->f = (cpu->f & CPU_FLAG_Z) |
+		 cpu_flags(false, false, (hl & 0x0FFF) + (value & 0x0FFF) > 0x0FFF,
+			   result > 0xFFFF);
+	cpu_set_hl(cpu, (word)result);
+}
+
+static inline word cpu_add_sp_offset(cpu_t *cpu, byte offset)
+{
+	word sp = cpu->sp;
+
+	cpu->f = cpu_flags(false, false, (sp & 0x0F) + (offset & 0x0F) > 0x0F,
+			   (sp & 0xFF) + offset > 0xFF);
+	return (word)(sp + (int8_t)offset);
+}
+
+/* CB-prefixed rotates, shifts and bit operations */
+
+static inline byte cpu_rlc(cpu_t *cpu, byte value)
+{
+	byte result = (byte)((value << 1) | (value >> 7));
+
+	cpu->f = cpu_flags(result == 0, false, false, value & 0x80);
+	return result;
+}
+
+static inline byte cpu_rrc(cpu_t *cpu, byte value)
+{
+	byte result = (byte)((value >> 1) | (value << 7));
+
+	cpu->f = cpu_flags(result == 0, false, false, value & 0x01);
+	return result;
+}
+
+static inline byte cpu_rl(cpu_t *cpu, byte value)
+{
+	byte result = (byte)((value << 1) | CPU_CARRY(cpu));
+
+	cpu->f = cpu_flags(result == 0, false, false, value & 0x80);
+	return result;
+}
+
+static inline byte cpu_rr(cpu_t *cpu, byte value)
+{
+	byte result = (byte)((value >> 1) | (CPU_CARRY(cpu) << 7));
+
+	cpu->f = cpu_flags(result == 0, false, false, value & 0x01);
+	return result;
+}
+
+static inline byte cpu_sla(cpu_t *cpu, byte value)
+{
+	byte result = (byte)(value << 1);
+
+	cpu->f = cpu_flags(result == 0, false, false, value & 0x80);
+	return result;
+}
+
+static inline byte cpu_sra(cpu_t *cpu, byte value)
+{
+	byte result = (byte)((value >> 1) | (value & 0x80));
+
+	cpu->f = cpu_flags(result == 0, false, false, value & 0x01);
+	return result;
+}
+
+static inline byte cpu_swap(cpu_t *cpu, byte value)
+{
+	byte result = (byte)((value << 4) | (value >> 4));
+
+	cpu->f = cpu_flags(result == 0, false, false, false);
+	return result;
+}
+
+static inline byte cpu_srl(cpu_t *cpu, byte value)
+{
+	byte result = value >> 1;
+
+	cpu->f = cpu_flags(result == 0, false, false, value & 0x01);
+	return result;
+}
+
+static inline void cpu_bit(cpu_t *cpu, int bit, byte value)
+{
+	cpu->f = (cpu->f & CPU_FLAG_C) |
+		 cpu_flags(!(value & (1 << bit)), false, true, false);
+}
+
+/*
+ * Operand accessors used by the opcode generators below. "hlm" is the byte
+ * at (HL) and "n" the immediate byte following the opcode.
+ */
+#define GET_b() (cpu->b)
+#define GET_c() (cpu->c)
+#define GET_d() (cpu->d)
+#define GET_e() (cpu->e)
+#define GET_h() (cpu->h)
+#define GET_l() (cpu->l)
+#define GET_a() (cpu->a)
+#define GET_hlm() cpu_read(cpu, cpu_get_hl(cpu))
+#define GET_n() cpu_fetch(cpu)
+
+#define SET_b(v) (cpu->b = (v))
+#define SET_c(v) (cpu->c = (v))
+#define SET_d(v) (cpu->d = (v))
+#define SET_e(v) (cpu->e = (v))
+#define SET_h(v) (cpu->h = (v))
+#define SET_l(v) (cpu->l = (v))
+#define SET_a(v) (cpu->a = (v))
+#define SET_hlm(v) cpu_write(cpu, cpu_get_hl(cpu), (v))
+
+#define GET16_bc() cpu_get_bc(cpu)
+#define GET16_de() cpu_get_de(cpu)
+#define GET16_hl() cpu_get_hl(cpu)
+#define GET16_af() cpu_get_af(cpu)
+#define GET16_sp() (cpu->sp)
+
+#define SET16_bc(v) cpu_set_bc(cpu, (v))
+#define SET16_de(v) cpu_set_de(cpu, (v))
+#define SET16_hl(v) cpu_set_hl(cpu, (v))
+#define SET16_af(v) cpu_set_af(cpu, (v))
+#define SET16_sp(v) (cpu->sp = (v))
+
+#define COND_nz (!(cpu->f & CPU_FLAG_Z))
+#define COND_z (cpu->f & CPU_FLAG_Z)
+#define COND_nc (!(cpu->f & CPU_FLAG_C))
+#define COND_c (cpu->f & CPU_FLAG_C)
+
+/* Expands M(x, r) for every 8-bit operand in opcode column order */
+#define FOR_EACH_R8(M, x)                                                  \
+	M(x, b) M(x, c) M(x, d) M(x, e) M(x, h) M(x, l) M(x, hlm) M(x, a)
+
+/* Handler names for one 8-entry opcode row, in the same column order */
+#define R8_ROW(prefix)                                                     \
+	prefix##_b, prefix##_c, prefix##_d, prefix##_e, prefix##_h,        \
+		prefix##_l, prefix##_hlm, prefix##_a
+
+/* 8-bit loads */
+
+#define DEFINE_LD(dst, src)                                                \
+	static void op_ld_##dst##_##src(cpu_t *cpu)                        \
+	{                                                                  \
+		SET_##dst(GET_##src());                                    \
+	}
+
+FOR_EACH_R8(DEFINE_LD, b)
+FOR_EACH_R8(DEFINE_LD, c)
+FOR_EACH_R8(DEFINE_LD, d)
+FOR_EACH_R8(DEFINE_LD, e)
+FOR_EACH_R8(DEFINE_LD, h)
+FOR_EACH_R8(DEFINE_LD, l)
+FOR_EACH_R8(DEFINE_LD, a)
+DEFINE_LD(hlm, b)
+DEFINE_LD(hlm, c)
+DEFINE_LD(hlm, d)
+DEFINE_LD(hlm, e)
+DEFINE_LD(hlm, h)
+DEFINE_LD(hlm, l)
+DEFINE_LD(hlm, a)
+
+DEFINE_LD(b, n)
+DEFINE_LD(c, n)
+DEFINE_LD(d, n)
+DEFINE_LD(e, n)
+DEFINE_LD(h, n)
+DEFINE_LD(l, n)
+DEFINE_LD(hlm, n)
+DEFINE_LD(a, n)
+
+static void op_ld_bcm_a(cpu_t *cpu)
+{
+	cpu_write(cpu, cpu_get_bc(cpu), cpu->a);
+}
+
+static void op_ld_dem_a(cpu_t *cpu)
+{
+	cpu_write(cpu, cpu_get_de(cpu), cpu->a);
+}
+
+static void op_ld_hlim_a(cpu_t *cpu)
+{
+	word hl = cpu_get_hl(cpu);
+
+	cpu_write(cpu, hl, cpu->a);
+	cpu_set_hl(cpu, hl + 1);
+}
+
+static void op_ld_hldm_a(cpu_t *cpu)
+{
+	word hl = cpu_get_hl(cpu);
+
+	cpu_write(cpu, hl, cpu->a);
+	cpu_set_hl(cpu, hl - 1);
+}
+
+static void op_ld_a_bcm(cpu_t *cpu)
+{
+	cpu->a = cpu_read(cpu, cpu_get_bc(cpu));
+}
+
+static void op_ld_a_dem(cpu_t *cpu)
+{
+	cpu->a = cpu_read(cpu, cpu_get_de(cpu));
+}
+
+static void op_ld_a_hlim(cpu_t *cpu)
+{
+	word hl = cpu_get_hl(cpu);
+
+	cpu->a = cpu_read(cpu, hl);
+	cpu_set_hl(cpu, hl + 1);
+}
+
+static void op_ld_a_hldm(cpu_t *cpu)
+{
+	word hl = cpu_get_hl(cpu);
+
+	cpu->a = cpu_read(cpu, hl);
+	cpu_set_hl(cpu, hl - 1);
+}
+
+static void op_ldh_nm_a(cpu_t *cpu)
+{
+	cpu_write(cpu, 0xFF00 | cpu_fetch(cpu), cpu->a);
+}
+
+static void op_ldh_a_nm(cpu_t *cpu)
+{
+	cpu->a = cpu_read(cpu, 0xFF00 | cpu_fetch(cpu));
+}
+
+static void op_ld_cm_a(cpu_t *cpu)
+{
+	cpu_write(cpu, 0xFF00 | cpu->c, cpu->a);
+}
+
+static void op_ld_a_cm(cpu_t *cpu)
+{
+	cpu->a = cpu_read(cpu, 0xFF00 | cpu->c);
+}
+
+static void op_ld_nnm_a(cpu_t *cpu)
+{
+	cpu_write(cpu, cpu_fetch_word(cpu), cpu->a);
+}
+
+static void op_ld_a_nnm(cpu_t *cpu)
+{
+	cpu->a = cpu_read(cpu, cpu_fetch_word(cpu));
+}
+
+/* 16-bit loads and stack */
+
+#define DEFINE_LD16(rr)                                                    \
+	static void op_ld_##rr##_nn(cpu_t *cpu)                            \
+	{                                                                  \
+		SET16_##rr(cpu_fetch_word(cpu));                           \
+	}
+
+#define DEFINE_PUSH_POP(rr)                                                \
+	static void op_push_##rr(cpu_t *cpu)                               \
+	{                                                                  \
+		cpu_push(cpu, GET16_##rr());                               \
+	}                                                                  \
+	static void op_pop_##rr(cpu_t *cpu)                                \
+	{                                                                  \
+		SET16_##rr(cpu_pop(cpu));                                  \
+	}
+
+DEFINE_LD16(bc)
+DEFINE_LD16(de)
+DEFINE_LD16(hl)
+DEFINE_LD16(sp)
+
+DEFINE_PUSH_POP(bc)
+DEFINE_PUSH_POP(de)
+DEFINE_PUSH_POP(hl)
+DEFINE_PUSH_POP(af)
+
+static void op_ld_nnm_sp(cpu_t *cpu)
+{
+	word addr = cpu_fetch_word(cpu);
+
+	cpu_write(cpu, addr, cpu->sp & 0xFF);
+	cpu_write(cpu, addr + 1, cpu->sp >> 8);
+}
+
+static void op_ld_sp_hl(cpu_t *cpu)
+{
+	cpu->sp = cpu_get_hl(cpu);
+}
+
+static void op_ld_hl_sp_e(cpu_t *cpu)
+{
+	cpu_set_hl(cpu, cpu_add_sp_offset(cpu, cpu_fetch(cpu)));
+}
+
+static void op_add_sp_e(cpu_t *cpu)
+{
+	cpu->sp = cpu_add_sp_offset(cpu, cpu_fetch(cpu));
+}
+
+/* 8-bit arithmetic */
+
+#define DEFINE_ALU(op, src)                                                \
+	static void op_##op##_##src(cpu_t *cpu)                            \
+	{                                                                  \
+		cpu_alu_##op(cpu, GET_##src());                            \
+	}
+
+FOR_EACH_R8(DEFINE_ALU, add)
+FOR_EACH_R8(DEFINE_ALU, adc)
+FOR_EACH_R8(DEFINE_ALU, sub)
+FOR_EACH_R8(DEFINE_ALU, sbc)
+FOR_EACH_R8(DEFINE_ALU, and)
+FOR_EACH_R8(DEFINE_ALU, xor)
+FOR_EACH_R8(DEFINE_ALU, or)
+FOR_EACH_R8(DEFINE_ALU, cp)
+DEFINE_ALU(add, n)
+DEFINE_ALU(adc, n)
+DEFINE_ALU(sub, n)
+DEFINE_ALU(sbc, n)
+DEFINE_ALU(and, n)
+DEFINE_ALU(xor, n)
+DEFINE_ALU(or, n)
+DEFINE_ALU(cp, n)
+
+#define DEFINE_INC_DEC(unused, r)                                          \
+	static void op_inc_##r(cpu_t *cpu)                                 \
+	{                                                                  \
+		SET_##r(cpu_inc8(cpu, GET_##r()));                         \
+	}                                                                  \
+	static void op_dec_##r(cpu_t *cpu)                                 \
+	{                                                                  \
+		SET_##r(cpu_dec8(cpu, GET_##r()));                         \
+	}
+
+FOR_EACH_R8(DEFINE_INC_DEC, _)
+
+static void op_daa(cpu_t *cpu)
+{
+	byte adjust = 0;
+	bool carry = cpu->f & CPU_FLAG_C;
+
+	if (!(cpu->f & CPU_FLAG_N)) {
+		if (carry || cpu->a > 0x99) {
+			adjust |= 0x60;
+			carry = true;
+		}
+		if ((cpu->f & CPU_FLAG_H) || (cpu->a & 0x0F) > 0x09) {
+			adjust |= 0x06;
+		}
+		cpu->a += adjust;
+	} else {
+		if (carry) {
+			adjust |= 0x60;
+		}
+		if (cpu->f & CPU_FLAG_H) {
+			adjust |= 0x06;
+		}
+		cpu->a -= adjust;
+	}
+
+	cpu->f = (cpu->f & CPU_FLAG_N) | cpu_flags(cpu->a == 0, false, false, carry);
+}
+
+static void op_cpl(cpu_t *cpu)
+{
+	cpu->a = ~cpu->a;
+	cpu->f |= CPU_FLAG_N | CPU_FLAG_H;
+}
+
+static void op_scf(cpu_t *cpu)
+{
+	cpu->f = (cpu->f & CPU_FLAG_Z) | CPU_FLAG_C;
+}
+
+static void op_ccf(cpu_t *cpu)
+{
+	cpu->f = (cpu->f & (CPU_FLAG_Z | CPU_FLAG_C)) ^ CPU_FLAG_C;
+}
+
+/* 16-bit arithmetic */
+
+#define DEFINE_ARITH16(rr)                                                 \
+	static void op_inc_##rr(cpu_t *cpu)                                \
+	{                                                                  \
+		SET16_##rr(GET16_##rr() + 1);                              \
+	}                                                                  \
+	static void op_dec_##rr(cpu_t *cpu)                                \
+	{                                                                  \
+		SET16_##rr(GET16_##rr() - 1);                              \
+	}                                                                  \
+	static void op_add_hl_##rr(cpu_t *cpu)                             \
+	{                                                                  \
+		cpu_add_hl(cpu, GET16_##rr());                             \
+	}
+
+DEFINE_ARITH16(bc)
+DEFINE_ARITH16(de)
+DEFINE_ARITH16(hl)
+DEFINE_ARITH16(sp)
+
+/* Accumulator rotates always clear Z */
+
+static void op_rlca(cpu_t *cpu)
+{
+	cpu->a = cpu_rlc(cpu, cpu->a);
+	cpu->f &= ~CPU_FLAG_Z;
+}
+
+static void op_rrca(cpu_t *cpu)
+{
+	cpu->a = cpu_rrc(cpu, cpu->a);
+	cpu->f &= ~CPU_FLAG_Z;
+}
+
+static void op_rla(cpu_t *cpu)
+{
+	cpu->a = cpu_rl(cpu, cpu->a);
+	cpu->f &= ~CPU_FLAG_Z;
+}
+
+static void op_rra(cpu_t *cpu)
+{
+	cpu->a = cpu_rr(cpu, cpu->a);
+	cpu->f &= ~CPU_FLAG_Z;
+}
+
+/* Control flow */
+
+static void op_jr(cpu_t *cpu)
+{
+	int8_t offset = (int8_t)cpu_fetch(cpu);
+
+	cpu->pc += offset;
+}
+
+static void op_jp(cpu_t *cpu)
+{
+	cpu->pc = cpu_fetch_word(cpu);
+}
+
+static void op_jp_hl(cpu_t *cpu)
+{
+	cpu->pc = cpu_get_hl(cpu);
+}
+
+static void op_call(cpu_t *cpu)
+{
+	word target = cpu_fetch_word(cpu);
+
+	cpu_push(cpu, cpu->pc);
+	cpu->pc = target;
+}
+
+static void op_ret(cpu_t *cpu)
+{
+	cpu->pc = cpu_pop(cpu);
+}
+
+static void op_reti(cpu_t *cpu)
+{
+	cpu->pc = cpu_pop(cpu);
+	cpu->ime = true;
+}
+
+#define DEFINE_CONDITIONAL(cc)                                             \
+	static void op_jr_##cc(cpu_t *cpu)                                 \
+	{                                                                  \
+		int8_t offset = (int8_t)cpu_fetch(cpu);                    \
+		if (COND_##cc) {                                           \
+			cpu->pc += offset;                                 \
+			cpu->cycles += CPU_JR_TAKEN_CYCLES;                \
+		}                                                          \
+	}                                                                  \
+	static void op_jp_##cc(cpu_t *cpu)                                 \
+	{                                                                  \
+		word target = cpu_fetch_word(cpu);                         \
+		if (COND_##cc) {                                           \
+			cpu->pc = target;                                  \
+			cpu->cycles += CPU_JP_TAKEN_CYCLES;                \
+		}                                                          \
+	}                                                                  \
+	static void op_call_##cc(cpu_t *cpu)                               \
+	{                                                                  \
+		word target = cpu_fetch_word(cpu);                         \
+		if (COND_##cc) {                                           \
+			cpu_push(cpu, cpu->pc);                            \
+			cpu->pc = target;                                  \
+			cpu->cycles += CPU_CALL_TAKEN_CYCLES;              \
+		}                                                          \
+	}                                                                  \
+	static void op_ret_##cc(cpu_t *cpu)                                \
+	{                                                                  \
+		if (COND_##cc) {                                           \
+			cpu->pc = cpu_pop(cpu);                            \
+			cpu->cycles += CPU_RET_TAKEN_CYCLES;               \
+		}                                                          \
+	}
+
+DEFINE_CONDITIONAL(nz)
+DEFINE_CONDITIONAL(z)
+DEFINE_CONDITIONAL(nc)
+DEFINE_CONDITIONAL(c)
+
+#define DEFINE_RST(vector)                                                 \
+	static void op_rst_##vector(cpu_t *cpu)                            \
+	{                                                                  \
+		cpu_push(cpu, cpu->pc);                                    \
+		cpu->pc = 0x##vector;                                      \
+	}
+
+DEFINE_RST(00)
+DEFINE_RST(08)
+DEFINE_RST(10)
+DEFINE_RST(18)
+DEFINE_RST(20)
+DEFINE_RST(28)
+DEFINE_RST(30)
+DEFINE_RST(38)
+
+/* Miscellaneous */
+
+static void op_nop(cpu_t *cpu)
+{
+	UNUSED(cpu);
+}
+
+static void op_stop(cpu_t *cpu)
+{
+	cpu_fetch(cpu);
+	cpu->stopped = true;
+}
+
+static void op_halt(cpu_t *cpu)
+{
+	const byte *high_page = cpu->mem_sys->high_page;
+	byte pending = high_page[MEMORY_PAGE_OFFSET(IE_REGISTER)] &
+		       high_page[MEMORY_PAGE_OFFSET(IF_REGISTER)] &
+		       CPU_INTERRUPT_MASK;
+
+	/* With IME off and an interrupt already pending HALT exits at once
+	 * and the following byte is fetched twice */
+	if (!cpu->ime && pending) {
+		cpu->halt_bug = true;
+		return;
+	}
+
+	cpu->halted = true;
+}
+
+static void op_di(cpu_t *cpu)
+{
+	cpu->ime = false;
+	cpu->ime_pending = false;
+}
+
+static void op_ei(cpu_t *cpu)
+{
+	cpu->ime_pending = true;
+}
+
+static void op_illegal(cpu_t *cpu)
+{
+	cpu->pc--;
+	cpu->locked = true;
+}
+
+/* CB-prefixed instructions */
+
+#define DEFINE_CB_SHIFT(op, r)                                             \
+	static void cb_##op##_##r(cpu_t *cpu)                              \
+	{                                                                  \
+		SET_##r(cpu_##op(cpu, GET_##r()));                         \
+	}
+
+#define DEFINE_CB_BIT(n, r)                                                \
+	static void cb_bit##n##_##r(cpu_t *cpu)                            \
+	{                                                                  \
+		cpu_bit(cpu, n, GET_##r());                                \
+	}                                                                  \
+	static void cb_res##n##_##r(cpu_t *cpu)                            \
+	{                                                                  \
+		SET_##r(GET_##r() & (byte) ~(1 << n));                     \
+	}                                                                  \
+	static void cb_set##n##_##r(cpu_t *cpu)                            \
+	{                                                                  \
+		SET_##r(GET_##r() | (byte)(1 << n));                       \
+	}
+
+FOR_EACH_R8(DEFINE_CB_SHIFT, rlc)
+FOR_EACH_R8(DEFINE_CB_SHIFT, rrc)
+FOR_EACH_R8(DEFINE_CB_SHIFT, rl)
+FOR_EACH_R8(DEFINE_CB_SHIFT, rr)
+FOR_EACH_R8(DEFINE_CB_SHIFT, sla)
+FOR_EACH_R8(DEFINE_CB_SHIFT, sra)
+FOR_EACH_R8(DEFINE_CB_SHIFT, swap)
+FOR_EACH_R8(DEFINE_CB_SHIFT, srl)
+FOR_EACH_R8(DEFINE_CB_BIT, 0)
+FOR_EACH_R8(DEFINE_CB_BIT, 1)
+FOR_EACH_R8(DEFINE_CB_BIT, 2)
+FOR_EACH_R8(DEFINE_CB_BIT, 3)
+FOR_EACH_R8(DEFINE_CB_BIT, 4)
+FOR_EACH_R8(DEFINE_CB_BIT, 5)
+FOR_EACH_R8(DEFINE_CB_BIT, 6)
+FOR_EACH_R8(DEFINE_CB_BIT, 7)
+
+static const cpu_handler_t cpu_cb_opcodes[256] = {
+	/* 0x00 */ R8_ROW(cb_rlc),   R8_ROW(cb_rrc),
+	/* 0x10 */ R8_ROW(cb_rl),    R8_ROW(cb_rr),
+	/* 0x20 */ R8_ROW(cb_sla),   R8_ROW(cb_sra),
+	/* 0x30 */ R8_ROW(cb_swap),  R8_ROW(cb_srl),
+	/* 0x40 */ R8_ROW(cb_bit0),  R8_ROW(cb_bit1),
+	/* 0x50 */ R8_ROW(cb_bit2),  R8_ROW(cb_bit3),
+	/* 0x60 */ R8_ROW(cb_bit4),  R8_ROW(cb_bit5),
+	/* 0x70 */ R8_ROW(cb_bit6),  R8_ROW(cb_bit7),
+	/* 0x80 */ R8_ROW(cb_res0),  R8_ROW(cb_res1),
+	/* 0x90 */ R8_ROW(cb_res2),  R8_ROW(cb_res3),
+	/* 0xA0 */ R8_ROW(cb_res4),  R8_ROW(cb_res5),
+	/* 0xB0 */ R8_ROW(cb_res6),  R8_ROW(cb_res7),
+	/* 0xC0 */ R8_ROW(cb_set0),  R8_ROW(cb_set1),
+	/* 0xD0 */ R8_ROW(cb_set2),  R8_ROW(cb_set3),
+	/* 0xE0 */ R8_ROW(cb_set4),  R8_ROW(cb_set5),
+	/* 0xF0 */ R8_ROW(cb_set6),  R8_ROW(cb_set7),
+};
+
+static void op_cb(cpu_t *cpu)
+{
+	byte opcode = cpu_fetch(cpu);
+
+	cpu->cycles += cpu_cb_opcode_cycles[opcode];
+	cpu_cb_opcodes[opcode](cpu);
+}
+
+static const cpu_handler_t cpu_opcodes[256] = {
+	/* 0x00 */
+	op_nop, op_ld_bc_nn, op_ld_bcm_a, op_inc_bc,
+	op_inc_b, op_dec_b, op_ld_b_n, op_rlca,
+	op_ld_nnm_sp, op_add_hl_bc, op_ld_a_bcm, op_dec_bc,
+	op_inc_c, op_dec_c, op_ld_c_n, op_rrca,
+	/* 0x10 */
+	op_stop, op_ld_de_nn, op_ld_dem_a, op_inc_de,
+	op_inc_d, op_dec_d, op_ld_d_n, op_rla,
+	op_jr, op_add_hl_de, op_ld_a_dem, op_dec_de,
+	op_inc_e, op_dec_e, op_ld_e_n, op_rra,
+	/* 0x20 */
+	op_jr_nz, op_ld_hl_nn, op_ld_hlim_a, op_inc_hl,
+	op_inc_h, op_dec_h, op_ld_h_n, op_daa,
+	op_jr_z, op_add_hl_hl, op_ld_a_hlim, op_dec_hl,
+	op_inc_l, op_dec_l, op_ld_l_n, op_cpl,
+	/* 0x30 */
+	op_jr_nc, op_ld_sp_nn, op_ld_hldm_a, op_inc_sp,
+	op_inc_hlm, op_dec_hlm, op_ld_hlm_n, op_scf,
+	op_jr_c, op_add_hl_sp, op_ld_a_hldm, op_dec_sp,
+	op_inc_a, op_dec_a, op_ld_a_n, op_ccf,
+	/* 0x40 */ R8_ROW(op_ld_b), R8_ROW(op_ld_c),
+	/* 0x50 */ R8_ROW(op_ld_d), R8_ROW(op_ld_e),
+	/* 0x60 */ R8_ROW(op_ld_h), R8_ROW(op_ld_l),
+	/* 0x70 */
+	op_ld_hlm_b, op_ld_hlm_c, op_ld_hlm_d, op_ld_hlm_e,
+	op_ld_hlm_h, op_ld_hlm_l, op_halt, op_ld_hlm_a,
+	R8_ROW(op_ld_a),
+	/* 0x80 */ R8_ROW(op_add), R8_ROW(op_adc),
+	/* 0x90 */ R8_ROW(op_sub), R8_ROW(op_sbc),
+	/* 0xA0 */ R8_ROW(op_and), R8_ROW(op_xor),
+	/* 0xB0 */ R8_ROW(op_or), R8_ROW(op_cp),
+	/* 0xC0 */
+	op_ret_nz, op_pop_bc, op_jp_nz, op_jp,
+	op_call_nz, op_push_bc, op_add_n, op_rst_00,
+	op_ret_z, op_ret, op_jp_z, op_cb,
+	op_call_z, op_call, op_adc_n, op_rst_08,
+	/* 0xD0 */
+	op_ret_nc, op_pop_de, op_jp_nc, op_illegal,
+	op_call_nc, op_push_de, op_sub_n, op_rst_10,
+	op_ret_c, op_reti, op_jp_c, op_illegal,
+	op_call_c, op_illegal, op_sbc_n, op_rst_18,
+	/* 0xE0 */
+	op_ldh_nm_a, op_pop_hl, op_ld_cm_a, op_illegal,
+	op_illegal, op_push_hl, op_and_n, op_rst_20,
+	op_add_sp_e, op_jp_hl, op_ld_nnm_a, op_illegal,
+	op_illegal, op_illegal, op_xor_n, op_rst_28,
+	/* 0xF0 */
+	op_ldh_a_nm, op_pop_af, op_ld_a_cm, op_di,
+	op_illegal, op_push_af, op_or_n, op_rst_30,
+	op_ld_hl_sp_e, op_ld_sp_hl, op_ld_a_nnm, op_ei,
+	op_illegal, op_illegal, op_cp_n, op_rst_38,
+};
+
+static byte cpu_opcode_flags(byte opcode)
+{
+	switch (opcode) {
+	/* Control flow and anything that changes the interrupt state */
+	case 0x10: case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+	case 0x76: case 0xC0: case 0xC2: case 0xC3: case 0xC4: case 0xC7:
+	case 0xC8: case 0xC9: case 0xCA: case 0xCC: case 0xCD: case 0xCF:
+	case 0xD0: case 0xD2: case 0xD3: case 0xD4: case 0xD7: case 0xD8:
+	case 0xD9: case 0xDA: case 0xDB: case 0xDC: case 0xDD: case 0xDF:
+	case 0xE3: case 0xE4: case 0xE7: case 0xE9: case 0xEB: case 0xEC:
+	case 0xED: case 0xEF: case 0xF3: case 0xF4: case 0xFB: case 0xFC:
+	case 0xFD: case 0xFF:
+		return CPU_INSTRUCTION_ENDS_BLOCK;
+	/* Memory stores */
+	case 0x02: case 0x08: case 0x12: case 0x22: case 0x32: case 0x34:
+	case 0x35: case 0x36: case 0x70: case 0x71: case 0x72: case 0x73:
+	case 0x74: case 0x75: case 0x77: case 0xC5: case 0xD5: case 0xE0:
+	case 0xE2: case 0xE5: case 0xEA: case 0xF5:
+		return CPU_INSTRUCTION_WRITES;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief Decodes the instruction at pc without executing it
+ *
+ * @param cpu cpu whose memory the instruction is read from
+ * @param pc address of the opcode
+ * @param instruction receives the handler, length, base cycles and flags
+ */
+void cpu_decode(cpu_t *cpu, address pc, cpu_instruction_t *instruction)
+{
+	assert(cpu != NULL && instruction != NULL);
+
+	byte opcode = cpu_read(cpu, pc);
+
+	instruction->pc = pc;
+	instruction->length = cpu_opcode_lengths[opcode];
+
+	if (opcode == 0xCB) {
+		byte cb_opcode = cpu_read(cpu, pc + 1);
+		bool hl_operand = (cb_opcode & 0x07) == 0x06;
+		bool bit_test = cb_opcode >= 0x40 && cb_opcode < 0x80;
+
+		instruction->handler = cpu_cb_opcodes[cb_opcode];
+		instruction->opcode_length = 2;
+		instruction->cycles = cpu_cb_opcode_cycles[cb_opcode];
+		instruction->flags = hl_operand && !bit_test ?
+					     CPU_INSTRUCTION_WRITES : 0;
+		return;
+	}
+
+	instruction->handler = cpu_opcodes[opcode];
+	instruction->opcode_length = 1;
+	instruction->cycles = cpu_opcode_cycles[opcode];
+	instruction->flags = cpu_opcode_flags(opcode);
+}
+
+bool cpu_init(cpu_t *cpu, memory_system_t *mem_sys)
+{
+	if (cpu == NULL || mem_sys == NULL) {
+		printf("ERROR: CANNOT INITIALIZE CPU WITHOUT MEMORY SYSTEM\n");
+		return false;
+	}
+
+	cpu->mem_sys = mem_sys;
+	cpu_reset(cpu);
+
+	return true;
+}
+
+void cpu_reset(cpu_t *cpu)
+{
+	assert(cpu != NULL);
+
+	/* DMG register state after the boot ROM hands over to the cartridge */
+	cpu_set_af(cpu, 0x01B0);
+	cpu_set_bc(cpu, 0x0013);
+	cpu_set_de(cpu, 0x00D8);
+	cpu_set_hl(cpu, 0x014D);
+	cpu->sp = 0xFFFE;
+	cpu->pc = CPU_ENTRY_POINT;
+
+	cpu->ime = false;
+	cpu->ime_pending = false;
+	cpu->halted = false;
+	cpu->halt_bug = false;
+	cpu->stopped = false;
+	cpu->locked = false;
+	cpu->cycles = 0;
+}
+
+bool cpu_interrupt_pending(const cpu_t *cpu)
+{
+	const byte *high_page = cpu->mem_sys->high_page;
+
+	return (high_page[MEMORY_PAGE_OFFSET(IE_REGISTER)] &
+		high_page[MEMORY_PAGE_OFFSET(IF_REGISTER)] &
+		CPU_INTERRUPT_MASK) != 0;
+}
+
+static bool cpu_service_interrupts(cpu_t *cpu)
+{
+	byte *high_page = cpu->mem_sys->high_page;
+	byte pending = high_page[MEMORY_PAGE_OFFSET(IE_REGISTER)] &
+		       high_page[MEMORY_PAGE_OFFSET(IF_REGISTER)] &
+		       CPU_INTERRUPT_MASK;
+
+	if (pending == 0) {
+		return false;
+	}
+
+	cpu->halted = false;
+	if (!cpu->ime) {
+		return false;
+	}
+
+	int index = 0;
+	while (!(pending & (1 << index))) {
+		index++;
+	}
+
+	cpu->ime = false;
+	cpu->ime_pending = false;
+	high_page[MEMORY_PAGE_OFFSET(IF_REGISTER)] &= (byte) ~(1 << index);
+	cpu_push(cpu, cpu->pc);
+	cpu->pc = CPU_INTERRUPT_VECTOR + 8 * index;
+	cpu->cycles += CPU_INTERRUPT_CYCLES;
+
+	return true;
+}
+
+/**
+ * @brief Fast-forwards a halted cpu that nothing can wake before target
+ *
+ * Interrupts are only raised between runs, so a halted cpu without one
+ * pending would spend the rest of the run in 4-cycle HALT steps. This takes
+ * them all at once and lands on the same cycle.
+ *
+ * @param cpu cpu to advance
+ * @param target cycle the current run stops at
+ * @return true if the cpu was idle and has been fast-forwarded
+ */
+bool cpu_skip_halt(cpu_t *cpu, uint64_t target)
+{
+	if (!cpu->halted || cpu->cycles >= target || cpu_interrupt_pending(cpu)) {
+		return false;
+	}
+
+	cpu->cycles += (target - cpu->cycles + 3) / 4 * 4;
+	return true;
+}
+
+/**
+ * @brief Executes one instruction, or services one interrupt
+ *
+ * @param cpu cpu to advance
+ * @return T-cycles consumed
+ */
+int cpu_step(cpu_t *cpu)
+{
+	assert(cpu != NULL);
+
+	uint64_t start = cpu->cycles;
+
+	if (cpu_service_interrupts(cpu)) {
+		return (int)(cpu->cycles - start);
+	}
+
+	if (cpu->halted || cpu->stopped || cpu->locked) {
+		if (cpu->stopped &&
+		    (cpu->mem_sys->high_page[MEMORY_PAGE_OFFSET(IF_REGISTER)] &
+		     INTERRUPT_JOYPAD)) {
+			cpu->stopped = false;
+		}
+		cpu->cycles += 4;
+		return 4;
+	}
+
+	/* EI takes effect after the instruction that follows it */
+	bool enable_interrupts = cpu->ime_pending;
+
+	byte opcode = cpu_fetch(cpu);
+	if (cpu->halt_bug) {
+		cpu->halt_bug = false;
+		cpu->pc--;
+	}
+
+	cpu->cycles += cpu_opcode_cycles[opcode];
+	cpu_opcodes[opcode](cpu);
+
+	if (enable_interrupts && cpu->ime_pending) {
+		cpu->ime = true;
+		cpu->ime_pending = false;
+	}
+
+	return (int)(cpu->cycles - start);
+}
+
+/**
+ * @brief Runs whole instructions until at least the given cycles have passed
+ *
+ * @param cpu cpu to advance
+ * @param cycles T-cycle budget
+ * @return T-cycles actually executed, which may overshoot by one instruction
+ */
+uint64_t cpu_run(cpu_t *cpu, uint64_t cycles)
+{
+	assert(cpu != NULL);
+
+	uint64_t start = cpu->cycles;
+	uint64_t target = start + cycles;
+
+	while (cpu->cycles < target && !cpu_skip_halt(cpu, target)) {
+		cpu_step(cpu);
+	}
+
+	return cpu->cycles - start;
+}
+
+byte cpu_get_opcode_cycles(byte opcode)
+{
+	return cpu_opcode_cycles[opcode];
+}
+
+byte cpu_get_cb_opcode_cycles(byte opcode)
+{
+	return cpu_cb_opcode_cycles[opcode];
+}
@@ -0,0 +1,240 @@
+#include "../include/dma.h"
+#include "../include/scheduler.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+/* Sources from 0xE000 up read WRAM, as the DMA has no echo RAM decoding */
+#define DMA_ECHO_OFFSET (ECHO_RAM_START - WRAM_START)
+
+static inline bool dma_on_video_bus(address addr)
+{
+	return addr >= VRAM_START && addr <= VRAM_END;
+}
+
+/* Bytes the transfer has reached by the given cycle */
+static int dma_progress(const dma_t *dma, uint64_t clock)
+{
+	if (clock <= dma->start) {
+		return 0;
+	}
+
+	uint64_t bytes = (clock - dma->start) / DMA_CYCLES_PER_BYTE;
+
+	return bytes < DMA_LENGTH ? (int)bytes : DMA_LENGTH;
+}
+
+/* Moves everything transferred up to clock into OAM in one go */
+static void dma_advance(dma_t *dma, uint64_t clock)
+{
+	if (!dma->active) {
+		return;
+	}
+
+	int target = dma_progress(dma, clock);
+	if (target <= dma->copied) {
+		return;
+	}
+
+	memory_system_t *mem_sys = dma->mem_sys;
+	const byte *page = memory_unlocked_page(mem_sys, MEMORY_PAGE(dma->source));
+
+	/* The 160 bytes never cross a page, so one lookup covers them */
+	if (page != NULL) {
+		memcpy(mem_sys->oam + dma->copied,
+		       page + MEMORY_PAGE_OFFSET(dma->source) + dma->copied,
+		       (size_t)(target - dma->copied));
+	} else {
+		for (int i = dma->copied; i < target; i++) {
+			mem_sys->oam[i] = memory_read_unlocked(mem_sys,
+							       dma->source + i);
+		}
+	}
+
+	dma->copied = target;
+}
+
+/*
+ * Reads colliding with the transfer get the byte it is moving; OAM is busy
+ * being written and reads 0xFF
+ */
+static byte dma_conflict_read(memory_system_t *mem_sys, void *context,
+			      address addr)
+{
+	const dma_t *dma = context;
+
+	if (addr >= OAM_START) {
+		return 0xFF;
+	}
+
+	int index = dma_progress(dma, scheduler_now(dma->scheduler));
+
+	return memory_read_unlocked(mem_sys,
+				    dma->source + MIN(index, DMA_LENGTH - 1));
+}
+
+static void dma_lock(dma_t *dma)
+{
+	memory_system_t *mem_sys = dma->mem_sys;
+
+	if (dma_on_video_bus(dma->source)) {
+		memory_lock_pages(mem_sys, VRAM_START, VRAM_END,
+				  dma_conflict_read, dma);
+	} else {
+		memory_lock_pages(mem_sys, ROM_START, ROM_END,
+				  dma_conflict_read, dma);
+		memory_lock_pages(mem_sys, ERAM_START, ECHO_RAM_END,
+				  dma_conflict_read, dma);
+	}
+	memory_lock_pages(mem_sys, OAM_START, UNUSABLE_END, dma_conflict_read,
+			  dma);
+
+	dma->locked = true;
+}
+
+static void dma_unlock(dma_t *dma)
+{
+	memory_unlock_pages(dma->mem_sys, ROM_START, UNUSABLE_END);
+	dma->locked = false;
+}
+
+static void dma_event(void *context, uint64_t deadline)
+{
+	dma_t *dma = context;
+
+	if (!dma->locked) {
+		dma_lock(dma);
+		scheduler_schedule(dma->scheduler, SCHEDULER_EVENT_DMA,
+				   dma->start + DMA_TRANSFER_CYCLES);
+		return;
+	}
+
+	dma_advance(dma, deadline);
+	dma_unlock(dma);
+	dma->active = false;
+}
+
+/**
+ * @brief Moves the bytes transferred so far into OAM
+ *
+ * @param dma dma to update
+ */
+void dma_sync(dma_t *dma)
+{
+	assert(dma != NULL);
+
+	dma_advance(dma, scheduler_now(dma->scheduler));
+}
+
+/**
+ * @brief Restarts a transfer at the scheduler's current cycle
+ *
+ * Needed whenever the transfer state, the memory map or the clock were
+ * replaced wholesale, as by a loaded state or a fork. OAM is taken to hold
+ * every byte the transfer has reached.
+ *
+ * @param dma dma to restart
+ */
+void dma_reschedule(dma_t *dma)
+{
+	assert(dma != NULL);
+
+	uint64_t now = scheduler_now(dma->scheduler);
+
+	dma_unlock(dma);
+	scheduler_cancel(dma->scheduler, SCHEDULER_EVENT_DMA);
+	if (!dma->active) {
+		return;
+	}
+
+	dma->copied = dma_progress(dma, now);
+	if (now < dma->start) {
+		scheduler_schedule(dma->scheduler, SCHEDULER_EVENT_DMA, dma->start);
+		return;
+	}
+
+	dma_lock(dma);
+	scheduler_schedule(dma->scheduler, SCHEDULER_EVENT_DMA,
+			   dma->start + DMA_TRANSFER_CYCLES);
+}
+
+/* Cycles until the transfer completes, 0 when idle; all a save state needs */
+uint16_t dma_remaining(const dma_t *dma)
+{
+	assert(dma != NULL);
+
+	if (!dma->active) {
+		return 0;
+	}
+
+	return (uint16_t)(dma->start + DMA_TRANSFER_CYCLES -
+			  scheduler_now(dma->scheduler));
+}
+
+/**
+ * @brief Resumes a transfer saved with dma_remaining()
+ *
+ * The source is taken from the DMA register.
+ *
+ * @param dma dma to restore
+ * @param remaining cycles until the transfer completes, 0 when idle
+ */
+void dma_restore(dma_t *dma, uint16_t remaining)
+{
+	assert(dma != NULL);
+
+	byte value = dma->mem_sys->high_page[MEMORY_PAGE_OFFSET(DMA_REGISTER)];
+
+	dma->active = remaining > 0;
+	dma->source = (address)(value << 8);
+	if (dma->source >= ECHO_RAM_START) {
+		dma->source -= DMA_ECHO_OFFSET;
+	}
+	dma->start = scheduler_now(dma->scheduler) + remaining -
+		     DMA_TRANSFER_CYCLES;
+	dma_reschedule(dma);
+}
+
+static void dma_register_write(memory_system_t *mem_sys, void *context,
+			       address addr, byte value)
+{
+	dma_t *dma = context;
+
+	/* A new transfer cuts short the one in progress */
+	dma_sync(dma);
+	mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)] = value;
+	dma_restore(dma, DMA_STARTUP_CYCLES + DMA_TRANSFER_CYCLES);
+}
+
+bool dma_init(dma_t *dma, memory_system_t *mem_sys, scheduler_t *scheduler)
+{
+	if (dma == NULL || mem_sys == NULL || scheduler == NULL) {
+		printf("Cannot initialize DMA without memory system and scheduler\n");
+		return false;
+	}
+
+	dma->mem_sys = mem_sys;
+	dma->scheduler = scheduler;
+	dma->active = false;
+	dma->locked = false;
+	scheduler_register(scheduler, SCHEDULER_EVENT_DMA, dma_event, dma);
+	memory_register_io(mem_sys, DMA_REGISTER, NULL, dma_register_write, dma);
+	dma_reset(dma);
+
+	return true;
+}
+
+void dma_reset(dma_t *dma)
+{
+	assert(dma != NULL);
+
+	/* DMG register state after the boot ROM */
+	dma->mem_sys->high_page[MEMORY_PAGE_OFFSET(DMA_REGISTER)] = 0xFF;
+	dma->copied = 0;
+	dma_restore(dma, 0);
+}
@@ -0,0 +1,517 @@
+#include "../include/gameboy.h"
+#include "../include/block_cache.h"
+#include "../include/jit.h"
+#include "../include/memory.h"
+#include "../include/cpu.h"
+#include "../include/ppu.h"
+#include "../include/scheduler.h"
+#include "../include/timer.h"
+#include "../include/dma.h"
+#include "../include/apu.h"
+#include "../include/joypad.h"
+#include "../include/serial.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+bool gameboy_init(gameboy_t *gb)
+{
+	if (gb == NULL) {
+		printf("Cannot initialize NULL gameboy\n");
+		return false;
+	}
+
+	if (!memory_init(&gb->memory) || !cpu_init(&gb->cpu, &gb->memory) ||
+	    !scheduler_init(&gb->scheduler, &gb->cpu.cycles) ||
+	    !ppu_init(&gb->ppu, &gb->memory) ||
+	    !timer_init(&gb->timer, &gb->memory, &gb->scheduler) ||
+	    !dma_init(&gb->dma, &gb->memory, &gb->scheduler) ||
+	    !apu_init(&gb->apu, &gb->memory, &gb->scheduler) ||
+	    !joypad_init(&gb->joypad, &gb->memory) ||
+	    !serial_init(&gb->serial, &gb->memory, &gb->scheduler) ||
+	    !block_cache_init(&gb->block_cache) || !jit_init(&gb->jit)) {
+		return false;
+	}
+
+	ppu_attach_scheduler(&gb->ppu, &gb->scheduler);
+
+	gb->use_block_cache = true;
+	gb->use_jit = false;
+	gb->breakpoint_count = 0;
+	memset(gb->breakpoint_pages, 0, sizeof(gb->breakpoint_pages));
+	gb->at_breakpoint = false;
+	return true;
+}
+
+void gameboy_cleanup(gameboy_t *gb)
+{
+	if (gb == NULL) {
+		return;
+	}
+
+	block_cache_cleanup(&gb->block_cache);
+	jit_cleanup(&gb->jit);
+	memory_cleanup(&gb->memory);
+}
+
+/**
+ * @brief Puts the machine back into its post-boot state, keeping the cartridge
+ *
+ * @param gb machine to reset
+ */
+void gameboy_reset(gameboy_t *gb)
+{
+	assert(gb != NULL);
+
+	cpu_reset(&gb->cpu);
+	ppu_reset(&gb->ppu);
+	timer_reset(&gb->timer);
+	dma_reset(&gb->dma);
+	apu_reset(&gb->apu);
+	joypad_reset(&gb->joypad);
+	serial_reset(&gb->serial);
+	block_cache_flush(&gb->block_cache);
+	jit_flush(&gb->jit);
+}
+
+bool gameboy_load_rom(gameboy_t *gb, const char *filename)
+{
+	assert(gb != NULL);
+
+	if (!memory_load_rom_mapped(&gb->memory, filename)) {
+		return false;
+	}
+
+	gameboy_reset(gb);
+	return true;
+}
+
+bool gameboy_load_rom_data(gameboy_t *gb, const byte *data, size_t size)
+{
+	assert(gb != NULL);
+
+	if (!memory_load_rom_data(&gb->memory, data, size)) {
+		return false;
+	}
+
+	gameboy_reset(gb);
+	return true;
+}
+
+/**
+ * @brief Freezes the machine's current state for gameboy_fork()
+ *
+ * @param gb machine with a cartridge loaded; it keeps running unaffected
+ * @return snapshot to free with gameboy_snapshot_free(), or NULL
+ */
+gameboy_snapshot_t *gameboy_snapshot(gameboy_t *gb)
+{
+	assert(gb != NULL);
+
+	gameboy_snapshot_t *snapshot = malloc(sizeof(gameboy_snapshot_t));
+	if (snapshot == NULL) {
+		return NULL;
+	}
+
+	/* Forks take OAM to hold everything the transfer has reached */
+	dma_sync(&gb->dma);
+	apu_sync(&gb->apu);
+	snapshot->memory = memory_snapshot_create(&gb->memory);
+	if (snapshot->memory == NULL) {
+		free(snapshot);
+		return NULL;
+	}
+
+	snapshot->cpu = gb->cpu;
+	snapshot->ppu = gb->ppu;
+	snapshot->timer = gb->timer;
+	snapshot->dma = gb->dma;
+	snapshot->apu = gb->apu;
+	snapshot->serial = gb->serial;
+	return snapshot;
+}
+
+void gameboy_snapshot_free(gameboy_snapshot_t *snapshot)
+{
+	if (snapshot == NULL) {
+		return;
+	}
+
+	memory_snapshot_release(snapshot->memory);
+	free(snapshot);
+}
+
+/**
+ * @brief Makes an initialized machine continue from a snapshot
+ *
+ * The fork shares ROM, WRAM and cartridge RAM with the snapshot until it
+ * writes to them, so forking is cheap and many forks fit in memory. Forks
+ * are independent and may be made and run on different threads. The
+ * framebuffer is not carried over; the next frame redraws it.
+ *
+ * @param gb initialized machine, whose cartridge is replaced
+ * @param snapshot state to continue from
+ * @return false if the fork cannot be set up
+ */
+bool gameboy_fork(gameboy_t *gb, const gameboy_snapshot_t *snapshot)
+{
+	assert(gb != NULL && snapshot != NULL);
+
+	if (!memory_fork(&gb->memory, snapshot->memory)) {
+		return false;
+	}
+
+	gb->cpu = snapshot->cpu;
+	gb->cpu.mem_sys = &gb->memory;
+
+	gb->ppu.mode = snapshot->ppu.mode;
+	gb->ppu.dot = snapshot->ppu.dot;
+	gb->ppu.ly = snapshot->ppu.ly;
+	gb->ppu.window_line = snapshot->ppu.window_line;
+	gb->ppu.stat_line = snapshot->ppu.stat_line;
+	gb->ppu.frame_ready = snapshot->ppu.frame_ready;
+	gb->ppu.frames = snapshot->ppu.frames;
+	ppu_reschedule(&gb->ppu);
+	gb->timer.counter = snapshot->timer.counter;
+	timer_reschedule(&gb->timer);
+	gb->dma.active = snapshot->dma.active;
+	gb->dma.source = snapshot->dma.source;
+	gb->dma.start = snapshot->dma.start;
+	dma_reschedule(&gb->dma);
+	memcpy(gb->apu.channels, snapshot->apu.channels,
+	       sizeof(gb->apu.channels));
+	gb->apu.sweep_enabled = snapshot->apu.sweep_enabled;
+	gb->apu.sweep_timer = snapshot->apu.sweep_timer;
+	gb->apu.sweep_shadow = snapshot->apu.sweep_shadow;
+	gb->apu.lfsr = snapshot->apu.lfsr;
+	gb->apu.step = snapshot->apu.step;
+	gb->apu.next_step = snapshot->apu.next_step;
+	apu_reschedule(&gb->apu);
+	/* Forks are unplugged; only a transfer this side clocks carries on */
+	gb->serial.end = snapshot->serial.end;
+	gb->serial.reply_ready = false;
+	gb->serial.incoming_end = SCHEDULER_NEVER;
+	serial_reschedule(&gb->serial);
+
+	block_cache_flush(&gb->block_cache);
+	jit_flush(&gb->jit);
+	return true;
+}
+
+/**
+ * @brief Selects headless mode, which skips all pixel generation
+ *
+ * Everything the CPU can observe (LY, STAT, interrupts, NR52) runs exactly
+ * as when rendering; only the framebuffer and the audio stop being made.
+ *
+ * @param gb machine to configure
+ * @param headless true to stop drawing
+ */
+void gameboy_set_headless(gameboy_t *gb, bool headless)
+{
+	assert(gb != NULL);
+
+	ppu_sync(&gb->ppu);
+	gb->ppu.headless = headless;
+	ppu_reschedule(&gb->ppu);
+	apu_set_headless(&gb->apu, headless);
+}
+
+/* The framebuffer is the last member, so everything before it is copied */
+static_assert(offsetof(ppu_t, framebuffer) + sizeof(((ppu_t *)NULL)->framebuffer) ==
+		      sizeof(ppu_t),
+	      "framebuffer must end the PPU state");
+
+static void gameboy_copy_ppu(ppu_t *to, const ppu_t *from)
+{
+	memcpy(to, from, offsetof(ppu_t, framebuffer));
+}
+
+/**
+ * @brief Prepares a state for gameboy_save_state()
+ *
+ * @param state state to initialize
+ * @param gb machine with its cartridge loaded; a new cartridge needs a new
+ *           state
+ * @return false if the state cannot be allocated
+ */
+bool gameboy_state_init(gameboy_state_t *state, const gameboy_t *gb)
+{
+	if (state == NULL || gb == NULL) {
+		printf("Cannot initialize NULL gameboy state\n");
+		return false;
+	}
+
+	return memory_state_init(&state->memory, &gb->memory);
+}
+
+void gameboy_state_cleanup(gameboy_state_t *state)
+{
+	if (state == NULL) {
+		return;
+	}
+
+	memory_state_cleanup(&state->memory);
+}
+
+/**
+ * @brief Copies the machine's state out, with no allocation
+ *
+ * @param gb machine to save
+ * @param state state made by gameboy_state_init() for this machine
+ */
+void gameboy_save_state(gameboy_t *gb, gameboy_state_t *state)
+{
+	assert(gb != NULL && state != NULL);
+
+	/* OAM has to hold everything the transfer has reached */
+	dma_sync(&gb->dma);
+	memory_save_state(&gb->memory, &state->memory);
+
+	state->cpu = gb->cpu;
+	state->scheduler = gb->scheduler;
+	gameboy_copy_ppu(&state->ppu, &gb->ppu);
+	state->timer = gb->timer;
+	state->dma = gb->dma;
+	state->apu = gb->apu;
+	state->serial = gb->serial;
+}
+
+/**
+ * @brief Puts the machine back to a state saved from it
+ *
+ * Every module comes back exactly as it was, pending events and audio
+ * synthesis included, so nothing is restarted. Only block translations of
+ * code the state changes are dropped.
+ *
+ * @param gb machine the state was saved from
+ * @param state state to restore
+ */
+void gameboy_restore_state(gameboy_t *gb, const gameboy_state_t *state)
+{
+	assert(gb != NULL && state != NULL);
+
+	memory_restore_state(&gb->memory, &state->memory);
+
+	gb->cpu = state->cpu;
+	gb->scheduler = state->scheduler;
+	gameboy_copy_ppu(&gb->ppu, &state->ppu);
+	gb->timer = state->timer;
+	gb->apu = state->apu;
+
+	/* The cable stays plugged in; the scheduler copy already has its event */
+	link_t *link = gb->serial.link;
+	gb->serial = state->serial;
+	gb->serial.link = link;
+
+	/* The DMA's bus locks live in the page tables, which were kept */
+	gb->dma.active = state->dma.active;
+	gb->dma.source = state->dma.source;
+	gb->dma.start = state->dma.start;
+	dma_reschedule(&gb->dma);
+}
+
+static bool gameboy_debugging(const gameboy_t *gb)
+{
+	return gb->breakpoint_count > 0 || gb->memory.watch_count > 0;
+}
+
+static bool gameboy_is_breakpoint(const gameboy_t *gb, address addr)
+{
+	if (gb->breakpoint_pages[MEMORY_PAGE(addr)] == 0) {
+		return false;
+	}
+
+	for (int i = 0; i < gb->breakpoint_count; i++) {
+		if (gb->breakpoints[i] == addr) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * The interpreter one instruction at a time, stopping before breakpoints
+ * and after any instruction that hits a watchpoint. resuming lets the
+ * instruction a previous run stopped at go first.
+ */
+static void gameboy_run_checked(gameboy_t *gb, uint64_t cycles, bool *resuming)
+{
+	cpu_t *cpu = &gb->cpu;
+	uint64_t target = cpu->cycles + cycles;
+
+	while (cpu->cycles < target && !cpu_skip_halt(cpu, target)) {
+		if (!*resuming && !cpu->halted && gameboy_is_breakpoint(gb, cpu->pc)) {
+			gb->at_breakpoint = true;
+			return;
+		}
+
+		*resuming = false;
+		cpu_step(cpu);
+		if (gb->memory.watch_hit_pending) {
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Stops the machine before the instruction at an address
+ *
+ * gameboy_run() stops before executing it, with at_breakpoint set.
+ *
+ * @param gb machine to debug
+ * @param addr address of the instruction
+ * @return false if already set or GAMEBOY_BREAKPOINT_MAX are set
+ */
+bool gameboy_add_breakpoint(gameboy_t *gb, address addr)
+{
+	assert(gb != NULL);
+
+	if (gameboy_is_breakpoint(gb, addr)) {
+		return false;
+	}
+	if (gb->breakpoint_count == GAMEBOY_BREAKPOINT_MAX) {
+		printf("ERROR: NO MORE THAN %d BREAKPOINTS\n", GAMEBOY_BREAKPOINT_MAX);
+		return false;
+	}
+
+	gb->breakpoints[gb->breakpoint_count++] = addr;
+	gb->breakpoint_pages[MEMORY_PAGE(addr)]++;
+	return true;
+}
+
+bool gameboy_remove_breakpoint(gameboy_t *gb, address addr)
+{
+	assert(gb != NULL);
+
+	for (int i = 0; i < gb->breakpoint_count; i++) {
+		if (gb->breakpoints[i] == addr) {
+			gb->breakpoints[i] = gb->breakpoints[--gb->breakpoint_count];
+			gb->breakpoint_pages[MEMORY_PAGE(addr)]--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Tells whether the last run ended early on a breakpoint or watchpoint
+ *
+ * A watchpoint hit is described by memory.watch_hit; the machine has
+ * finished the instruction that made the access.
+ *
+ * @param gb machine to inspect
+ * @return true if at_breakpoint or memory.watch_hit_pending is set
+ */
+bool gameboy_stopped(const gameboy_t *gb)
+{
+	assert(gb != NULL);
+
+	return gb->at_breakpoint || gb->memory.watch_hit_pending;
+}
+
+/**
+ * @brief Runs the machine for at least the given number of T-cycles
+ *
+ * The CPU runs uninterrupted up to the next scheduled event at a time, so
+ * whatever the event raises is seen by the next instruction just as when
+ * stepping. With breakpoints or watchpoints set, the run ends early when
+ * one of them is hit; see gameboy_stopped().
+ *
+ * @param gb machine to run
+ * @param cycles T-cycle budget
+ * @return T-cycles actually executed, which may overshoot by one instruction
+ */
+uint64_t gameboy_run(gameboy_t *gb, uint64_t cycles)
+{
+	assert(gb != NULL);
+
+	scheduler_t *scheduler = &gb->scheduler;
+	uint64_t start = gb->cpu.cycles;
+	uint64_t target = start + cycles;
+	bool resuming = gb->at_breakpoint;
+
+	gb->at_breakpoint = false;
+	gb->memory.watch_hit_pending = false;
+
+	while (gb->cpu.cycles < target && !gameboy_stopped(gb)) {
+		uint64_t deadline = MIN(scheduler_next_deadline(scheduler), target);
+		uint64_t slice = deadline > gb->cpu.cycles ?
+					 deadline - gb->cpu.cycles :
+					 0;
+
+		if (gameboy_debugging(gb)) {
+			gameboy_run_checked(gb, slice, &resuming);
+		} else if (gb->use_jit) {
+			jit_run(&gb->jit, &gb->cpu, slice);
+		} else if (gb->use_block_cache) {
+			block_cache_run(&gb->block_cache, &gb->cpu, slice);
+		} else {
+			cpu_run(&gb->cpu, slice);
+		}
+
+		scheduler_dispatch(scheduler);
+	}
+
+	/* Leave registers, OAM and audio output current for whoever looks next */
+	ppu_sync(&gb->ppu);
+	timer_sync(&gb->timer);
+	dma_sync(&gb->dma);
+	apu_sync(&gb->apu);
+	return gb->cpu.cycles - start;
+}
+
+/**
+ * @brief Runs until the PPU starts its next VBlank
+ *
+ * With the LCD off no VBlank comes, so one frame's worth of cycles is run.
+ * Breakpoints and watchpoints end it early, as with gameboy_run().
+ *
+ * @param gb machine to run
+ * @return T-cycles executed
+ */
+uint64_t gameboy_run_frame(gameboy_t *gb)
+{
+	assert(gb != NULL);
+
+	uint64_t start = gb->cpu.cycles;
+	uint64_t limit = start + PPU_CYCLES_PER_FRAME;
+
+	gb->ppu.frame_ready = false;
+	while (!gb->ppu.frame_ready && gb->cpu.cycles < limit) {
+		uint64_t next = MIN(scheduler_next_deadline(&gb->scheduler), limit);
+
+		gameboy_run(gb, next - gb->cpu.cycles);
+		if (gameboy_stopped(gb)) {
+			break;
+		}
+	}
+
+	return gb->cpu.cycles - start;
+}
+
+/**
+ * @brief Hashes the framebuffer (FNV-1a), for comparing runs cheaply
+ *
+ * @param gb machine to inspect
+ * @return 64-bit hash of the current framebuffer contents
+ */
+uint64_t gameboy_framebuffer_hash(const gameboy_t *gb)
+{
+	assert(gb != NULL);
+
+	const byte *pixels = &gb->ppu.framebuffer[0][0];
+	uint64_t hash = 0xCBF29CE484222325ULL;
+
+	for (size_t i = 0; i < sizeof(gb->ppu.framebuffer); i++) {
+		hash ^= pixels[i];
+		hash *= 0x100000001B3ULL;
+	}
+
+	return hash;
+}
@@ -0,0 +1,1103 @@
+#define _DEFAULT_SOURCE
+
+#include "../include/jit.h"
+#include "../include/cpu.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if JIT_SUPPORTED
+#include <sys/mman.h>
+#endif
+
+/* Ways LAHF results are turned into Z, N, H and C */
+#define JIT_FLAGS_ADD 0
+#define JIT_FLAGS_SUB 1
+#define JIT_FLAGS_AND 2
+#define JIT_FLAGS_LOGIC 3
+#define JIT_FLAGS_INC 4
+#define JIT_FLAGS_DEC 5
+
+/* LAHF puts SF:ZF:0:AF:0:PF:1:CF in AH */
+#define JIT_LAHF_ZF 0x40
+#define JIT_LAHF_AF 0x10
+#define JIT_LAHF_CF 0x01
+
+/* Generous upper bound on the native code of one guest instruction */
+#define JIT_INSTRUCTION_CODE_MAX 192
+#define JIT_BLOCK_CODE_MAX (128 + JIT_MAX_INSTRUCTIONS * JIT_INSTRUCTION_CODE_MAX)
+
+static void jit_build_flag_tables(jit_t *jit)
+{
+	for (int lahf = 0; lahf < 256; lahf++) {
+		byte z = (lahf & JIT_LAHF_ZF) ? CPU_FLAG_Z : 0;
+		byte h = (lahf & JIT_LAHF_AF) ? CPU_FLAG_H : 0;
+		byte c = (lahf & JIT_LAHF_CF) ? CPU_FLAG_C : 0;
+
+		jit->flag_tables[JIT_FLAGS_ADD][lahf] = z | h | c;
+		jit->flag_tables[JIT_FLAGS_SUB][lahf] = z | CPU_FLAG_N | h | c;
+		jit->flag_tables[JIT_FLAGS_AND][lahf] = z | CPU_FLAG_H;
+		jit->flag_tables[JIT_FLAGS_LOGIC][lahf] = z;
+		jit->flag_tables[JIT_FLAGS_INC][lahf] = z | h;
+		jit->flag_tables[JIT_FLAGS_DEC][lahf] = z | CPU_FLAG_N | h;
+	}
+}
+
+bool jit_init(jit_t *jit)
+{
+	if (jit == NULL) {
+		printf("Cannot initialize NULL JIT\n");
+		return false;
+	}
+
+	jit->available = false;
+	jit->code = NULL;
+	jit->blocks = NULL;
+	jit->blocks_compiled = 0;
+	jit->flushes = 0;
+	jit_build_flag_tables(jit);
+
+#if JIT_SUPPORTED
+	/* Never writable and executable at once; see jit_compile() */
+	void *code = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_EXEC,
+			  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	jit->blocks = malloc(sizeof(jit_block_t) * JIT_BLOCK_COUNT);
+
+	if (code != MAP_FAILED && jit->blocks != NULL) {
+		jit->code = code;
+		jit->available = true;
+	} else {
+		/* Not fatal: jit_run() falls back to the interpreter */
+		printf("WARNING: NO EXECUTABLE MEMORY, JIT DISABLED\n");
+		if (code != MAP_FAILED) {
+			munmap(code, JIT_CODE_SIZE);
+		}
+		free(jit->blocks);
+		jit->blocks = NULL;
+	}
+#endif
+
+	jit_flush(jit);
+	return true;
+}
+
+void jit_cleanup(jit_t *jit)
+{
+	if (jit == NULL) {
+		return;
+	}
+
+#if JIT_SUPPORTED
+	if (jit->code != NULL) {
+		munmap(jit->code, JIT_CODE_SIZE);
+	}
+#endif
+	free(jit->blocks);
+	jit->code = NULL;
+	jit->blocks = NULL;
+	jit->available = false;
+}
+
+/**
+ * @brief Drops every translation
+ *
+ * Needed in the same places as block_cache_flush(), since blocks are keyed
+ * by host address.
+ *
+ * @param jit JIT to empty
+ */
+void jit_flush(jit_t *jit)
+{
+	assert(jit != NULL);
+
+	jit->code_used = 0;
+	jit->block_count = 0;
+	memset(jit->table, 0, sizeof(jit->table));
+	memset(jit->heat, 0, sizeof(jit->heat));
+	jit->flushes++;
+}
+
+#if JIT_SUPPORTED
+
+static uint64_t jit_hash(const byte *key, address pc)
+{
+	return ((uint64_t)(uintptr_t)key ^ pc) * 0x9E3779B97F4A7C15ull;
+}
+
+/* Host registers by encoding */
+enum {
+	JIT_RAX, JIT_RCX, JIT_RDX, JIT_RBX, JIT_RSP, JIT_RBP, JIT_RSI, JIT_RDI,
+	JIT_R8, JIT_R9, JIT_R10, JIT_R11, JIT_R12, JIT_R13, JIT_R14, JIT_R15,
+};
+
+/*
+ * While a block runs: rbx = cpu, r12 = target cycle, r13 = flag tables,
+ * r14 = memory system, r15 = cycle counter, ebp = nonzero once a bus
+ * access went through a handler. rax, rcx, rdx and r8 are scratch.
+ */
+#define JIT_CPU JIT_RBX
+#define JIT_TARGET JIT_R12
+#define JIT_FLAGS JIT_R13
+#define JIT_MEMORY JIT_R14
+#define JIT_CYCLES JIT_R15
+
+#define JIT_CPU_FIELD(field) ((int32_t)offsetof(cpu_t, field))
+#define JIT_MEMORY_FIELD(field) ((int32_t)offsetof(memory_system_t, field))
+
+/* The operand 0x80-0xBF, LD r,r' and INC r address, (HL) being 6 */
+static const int32_t jit_register_offsets[8] = {
+	JIT_CPU_FIELD(b), JIT_CPU_FIELD(c), JIT_CPU_FIELD(d), JIT_CPU_FIELD(e),
+	JIT_CPU_FIELD(h), JIT_CPU_FIELD(l), -1,		  JIT_CPU_FIELD(a),
+};
+
+/* High byte of BC, DE, HL; the low byte follows it */
+static const int32_t jit_pair_offsets[3] = {
+	JIT_CPU_FIELD(b), JIT_CPU_FIELD(d), JIT_CPU_FIELD(h),
+};
+
+typedef struct jit_emitter {
+	jit_t *jit;
+	memory_system_t *mem_sys;
+	byte *p;
+	byte *epilogue;
+	/* Native start and guest address of each instruction so far */
+	byte *labels[JIT_MAX_INSTRUCTIONS];
+	address pcs[JIT_MAX_INSTRUCTIONS];
+	int count;
+} jit_emitter_t;
+
+static void emit8(jit_emitter_t *e, byte value)
+{
+	*e->p++ = value;
+}
+
+static void emit16(jit_emitter_t *e, uint16_t value)
+{
+	memcpy(e->p, &value, sizeof(value));
+	e->p += sizeof(value);
+}
+
+static void emit32(jit_emitter_t *e, uint32_t value)
+{
+	memcpy(e->p, &value, sizeof(value));
+	e->p += sizeof(value);
+}
+
+static void emit64(jit_emitter_t *e, uint64_t value)
+{
+	memcpy(e->p, &value, sizeof(value));
+	e->p += sizeof(value);
+}
+
+/*
+ * Emits [REX] opcode ModRM [SIB] disp for reg and [base + index * scale +
+ * disp]. Opcodes above 0xFF are 0x0F-prefixed. Byte registers are only
+ * ever al, cl, dl or r8b, so REX is only added when something needs it.
+ */
+static void emit_mem(jit_emitter_t *e, bool wide, int opcode, int reg,
+		     int base, int index, int scale, int32_t disp)
+{
+	byte rex = 0x40 | (wide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) |
+		   (index >= 0 && (index & 8) ? 0x02 : 0) |
+		   ((base & 8) ? 0x01 : 0);
+	bool short_disp = disp >= -128 && disp <= 127;
+	bool sib = index >= 0 || (base & 7) == JIT_RSP;
+
+	if (rex != 0x40) {
+		emit8(e, rex);
+	}
+	if (opcode > 0xFF) {
+		emit8(e, 0x0F);
+	}
+	emit8(e, (byte)opcode);
+
+	emit8(e, (byte)((short_disp ? 0x40 : 0x80) | ((reg & 7) << 3) |
+			(sib ? 4 : (base & 7))));
+	if (sib) {
+		int scale_bits = scale == 8 ? 3 : scale == 4 ? 2 : scale == 2 ? 1 : 0;
+
+		emit8(e, (byte)((scale_bits << 6) |
+				((index >= 0 ? index & 7 : 4) << 3) |
+				(base & 7)));
+	}
+
+	if (short_disp) {
+		emit8(e, (byte)(int8_t)disp);
+	} else {
+		emit32(e, (uint32_t)disp);
+	}
+}
+
+/* Field of the cpu */
+static void emit_cpu(jit_emitter_t *e, bool wide, int opcode, int reg,
+		     int32_t offset)
+{
+	emit_mem(e, wide, opcode, reg, JIT_CPU, -1, 1, offset);
+}
+
+/* Field of the memory system */
+static void emit_memory(jit_emitter_t *e, bool wide, int opcode, int reg,
+			int32_t offset)
+{
+	emit_mem(e, wide, opcode, reg, JIT_MEMORY, -1, 1, offset);
+}
+
+static byte *emit_jcc8(jit_emitter_t *e, byte opcode)
+{
+	emit8(e, opcode);
+	emit8(e, 0);
+	return e->p - 1;
+}
+
+static void patch8(byte *at, const byte *target)
+{
+	ptrdiff_t distance = target - (at + 1);
+
+	assert(distance >= -128 && distance <= 127);
+	*at = (byte)(int8_t)distance;
+}
+
+static void emit_jmp(jit_emitter_t *e, const byte *target)
+{
+	emit8(e, 0xE9);
+	emit32(e, (uint32_t)(int32_t)(target - (e->p + 4)));
+}
+
+static void emit_add_cycles(jit_emitter_t *e, int cycles)
+{
+	/* add r15, imm8 */
+	emit8(e, 0x49);
+	emit8(e, 0x83);
+	emit8(e, 0xC7);
+	emit8(e, (byte)cycles);
+}
+
+static void emit_store_cycles(jit_emitter_t *e)
+{
+	emit_cpu(e, true, 0x89, JIT_CYCLES, JIT_CPU_FIELD(cycles));
+}
+
+static void emit_set_pc(jit_emitter_t *e, address pc)
+{
+	emit8(e, 0x66);
+	emit_cpu(e, false, 0xC7, 0, JIT_CPU_FIELD(pc));
+	emit16(e, pc);
+}
+
+/* Leaves the block with execution to resume at pc */
+static void emit_exit(jit_emitter_t *e, address pc)
+{
+	emit_set_pc(e, pc);
+	emit_jmp(e, e->epilogue);
+}
+
+static void emit_handler_went(jit_emitter_t *e)
+{
+	/* mov ebp, 1 */
+	emit8(e, 0xBD);
+	emit32(e, 1);
+}
+
+/*
+ * After an instruction that does not end the block: leave if the budget
+ * is spent or, when it touched the bus, if a handler was involved.
+ */
+static void emit_check(jit_emitter_t *e, address next, bool bus)
+{
+	/* cmp r15, r12 */
+	emit8(e, 0x4D);
+	emit8(e, 0x39);
+	emit8(e, 0xE7);
+
+	if (!bus) {
+		byte *skip = emit_jcc8(e, 0x72);	/* jb */
+
+		emit_exit(e, next);
+		patch8(skip, e->p);
+		return;
+	}
+
+	byte *spent = emit_jcc8(e, 0x73);	/* jae */
+	emit8(e, 0x85);				/* test ebp, ebp */
+	emit8(e, 0xED);
+	byte *skip = emit_jcc8(e, 0x74);	/* jz */
+	patch8(spent, e->p);
+	emit_exit(e, next);
+	patch8(skip, e->p);
+}
+
+/* eax = BC, DE or HL */
+static void emit_load_pair(jit_emitter_t *e, int pair)
+{
+	emit_cpu(e, false, 0x0FB7, JIT_RAX, jit_pair_offsets[pair]);
+	emit8(e, 0x66);		/* rol ax, 8 */
+	emit8(e, 0xC1);
+	emit8(e, 0xC0);
+	emit8(e, 0x08);
+}
+
+/* BC, DE or HL = ax, which is left byte-swapped */
+static void emit_store_pair(jit_emitter_t *e, int pair)
+{
+	emit8(e, 0x66);		/* rol ax, 8 */
+	emit8(e, 0xC1);
+	emit8(e, 0xC0);
+	emit8(e, 0x08);
+	emit8(e, 0x66);
+	emit_cpu(e, false, 0x89, JIT_RAX, jit_pair_offsets[pair]);
+}
+
+/* HL += delta, for the (HL+) and (HL-) forms */
+static void emit_step_hl(jit_emitter_t *e, int delta)
+{
+	emit_load_pair(e, 2);
+	emit8(e, 0x66);		/* inc ax / dec ax */
+	emit8(e, 0xFF);
+	emit8(e, delta > 0 ? 0xC0 : 0xC8);
+	emit_store_pair(e, 2);
+}
+
+static void emit_call_setup(jit_emitter_t *e)
+{
+	emit_store_cycles(e);
+	emit8(e, 0x4C);		/* mov rdi, r14 */
+	emit8(e, 0x89);
+	emit8(e, 0xF7);
+}
+
+/* eax = byte at the address in eax */
+static void emit_read(jit_emitter_t *e)
+{
+	emit8(e, 0x89);		/* mov edx, eax */
+	emit8(e, 0xC2);
+	emit8(e, 0xC1);		/* shr edx, 8 */
+	emit8(e, 0xEA);
+	emit8(e, 0x08);
+	emit_mem(e, true, 0x8B, JIT_RCX, JIT_MEMORY, JIT_RDX, 8,
+		 JIT_MEMORY_FIELD(read_map));
+	emit8(e, 0x48);		/* test rcx, rcx */
+	emit8(e, 0x85);
+	emit8(e, 0xC9);
+	byte *slow = emit_jcc8(e, 0x74);
+
+	emit8(e, 0x0F);		/* movzx eax, al */
+	emit8(e, 0xB6);
+	emit8(e, 0xC0);
+	emit_mem(e, false, 0x0FB6, JIT_RAX, JIT_RCX, JIT_RAX, 1, 0);
+	byte *done = emit_jcc8(e, 0xEB);
+
+	patch8(slow, e->p);
+	emit_call_setup(e);
+	emit8(e, 0x89);		/* mov esi, eax */
+	emit8(e, 0xC6);
+	emit_mem(e, false, 0xFF, 2, JIT_MEMORY, JIT_RDX, 8,
+		 JIT_MEMORY_FIELD(read_handlers));
+	emit8(e, 0x0F);		/* movzx eax, al */
+	emit8(e, 0xB6);
+	emit8(e, 0xC0);
+	emit_handler_went(e);
+	patch8(done, e->p);
+}
+
+/* Byte in r8b to the address in eax */
+static void emit_write(jit_emitter_t *e)
+{
+	emit8(e, 0x89);		/* mov edx, eax */
+	emit8(e, 0xC2);
+	emit8(e, 0xC1);		/* shr edx, 8 */
+	emit8(e, 0xEA);
+	emit8(e, 0x08);
+	emit_mem(e, true, 0x8B, JIT_RCX, JIT_MEMORY, JIT_RDX, 8,
+		 JIT_MEMORY_FIELD(write_map));
+	emit8(e, 0x48);		/* test rcx, rcx */
+	emit8(e, 0x85);
+	emit8(e, 0xC9);
+	byte *slow = emit_jcc8(e, 0x74);
+
+	emit8(e, 0x0F);		/* movzx eax, al */
+	emit8(e, 0xB6);
+	emit8(e, 0xC0);
+	emit_mem(e, false, 0x88, JIT_R8, JIT_RCX, JIT_RAX, 1, 0);
+	byte *done = emit_jcc8(e, 0xEB);
+
+	patch8(slow, e->p);
+	emit_call_setup(e);
+	emit8(e, 0x89);		/* mov esi, eax */
+	emit8(e, 0xC6);
+	emit_mem(e, true, 0x8B, JIT_RAX, JIT_MEMORY, JIT_RDX, 8,
+		 JIT_MEMORY_FIELD(write_handlers));
+	emit8(e, 0x41);		/* movzx edx, r8b */
+	emit8(e, 0x0F);
+	emit8(e, 0xB6);
+	emit8(e, 0xD0);
+	emit8(e, 0xFF);		/* call rax */
+	emit8(e, 0xD0);
+	emit_handler_went(e);
+	patch8(done, e->p);
+}
+
+/* eax = byte at a fixed address */
+static void emit_read_const(jit_emitter_t *e, address addr)
+{
+	int page = MEMORY_PAGE(addr);
+
+	if (addr >= IO_REGISTERS_START &&
+	    memory_plain_io(e->mem_sys, addr, false) != NULL) {
+		emit_memory(e, false, 0x0FB6, JIT_RAX,
+			    JIT_MEMORY_FIELD(high_page) + MEMORY_PAGE_OFFSET(addr));
+		return;
+	}
+
+	emit_memory(e, true, 0x8B, JIT_RCX,
+		    JIT_MEMORY_FIELD(read_map) + page * 8);
+	emit8(e, 0x48);		/* test rcx, rcx */
+	emit8(e, 0x85);
+	emit8(e, 0xC9);
+	byte *slow = emit_jcc8(e, 0x74);
+
+	emit_mem(e, false, 0x0FB6, JIT_RAX, JIT_RCX, -1, 1,
+		 MEMORY_PAGE_OFFSET(addr));
+	byte *done = emit_jcc8(e, 0xEB);
+
+	patch8(slow, e->p);
+	emit_call_setup(e);
+	emit8(e, 0xBE);		/* mov esi, addr */
+	emit32(e, addr);
+	emit_memory(e, false, 0xFF, 2, JIT_MEMORY_FIELD(read_handlers) + page * 8);
+	emit8(e, 0x0F);		/* movzx eax, al */
+	emit8(e, 0xB6);
+	emit8(e, 0xC0);
+	emit_handler_went(e);
+	patch8(done, e->p);
+}
+
+/* Byte in r8b to a fixed address */
+static void emit_write_const(jit_emitter_t *e, address addr)
+{
+	int page = MEMORY_PAGE(addr);
+	byte *slow;
+
+	if (addr >= IO_REGISTERS_START &&
+	    memory_plain_io(e->mem_sys, addr, true) != NULL) {
+		/* HRAM and plain registers, unless code there is watched */
+		emit_memory(e, false, 0x80, 7,
+			    JIT_MEMORY_FIELD(page_traps) + page);
+		emit8(e, 0x00);	/* cmp byte [traps], 0 */
+		slow = emit_jcc8(e, 0x75);
+		emit_memory(e, false, 0x88, JIT_R8,
+			    JIT_MEMORY_FIELD(high_page) + MEMORY_PAGE_OFFSET(addr));
+
+		/* New interrupt state is looked at outside the block */
+		if (addr == IF_REGISTER || addr == IE_REGISTER) {
+			emit_handler_went(e);
+		}
+	} else {
+		emit_memory(e, true, 0x8B, JIT_RCX,
+			    JIT_MEMORY_FIELD(write_map) + page * 8);
+		emit8(e, 0x48);	/* test rcx, rcx */
+		emit8(e, 0x85);
+		emit8(e, 0xC9);
+		slow = emit_jcc8(e, 0x74);
+		emit_mem(e, false, 0x88, JIT_R8, JIT_RCX, -1, 1,
+			 MEMORY_PAGE_OFFSET(addr));
+	}
+	byte *done = emit_jcc8(e, 0xEB);
+
+	patch8(slow, e->p);
+	emit_call_setup(e);
+	emit8(e, 0xBE);		/* mov esi, addr */
+	emit32(e, addr);
+	emit8(e, 0x41);		/* movzx edx, r8b */
+	emit8(e, 0x0F);
+	emit8(e, 0xB6);
+	emit8(e, 0xD0);
+	emit_memory(e, false, 0xFF, 2, JIT_MEMORY_FIELD(write_handlers) + page * 8);
+	emit_handler_went(e);
+	patch8(done, e->p);
+}
+
+/* cl = flags for the LAHF result in ah, through one of the tables */
+static void emit_flags_from_lahf(jit_emitter_t *e, int table)
+{
+	emit8(e, 0x0F);		/* movzx ecx, ah */
+	emit8(e, 0xB6);
+	emit8(e, 0xCC);
+	emit_mem(e, false, 0x0FB6, JIT_RCX, JIT_FLAGS, JIT_RCX, 1, table * 256);
+}
+
+/* A op= dl, for the eight ALU operations in opcode order */
+static void emit_alu(jit_emitter_t *e, int operation)
+{
+	static const byte opcodes[8] = {
+		0x00, 0x10, 0x28, 0x18, 0x20, 0x30, 0x08, 0x38,
+	};
+	static const int tables[8] = {
+		JIT_FLAGS_ADD, JIT_FLAGS_ADD, JIT_FLAGS_SUB, JIT_FLAGS_SUB,
+		JIT_FLAGS_AND, JIT_FLAGS_LOGIC, JIT_FLAGS_LOGIC, JIT_FLAGS_SUB,
+	};
+
+	emit_cpu(e, false, 0x8A, JIT_RAX, JIT_CPU_FIELD(a));
+
+	/* ADC and SBC take the carry in CF */
+	if (operation == 1 || operation == 3) {
+		emit_cpu(e, false, 0x0FB6, JIT_RCX, JIT_CPU_FIELD(f));
+		emit8(e, 0x0F);	/* bt ecx, 4 */
+		emit8(e, 0xBA);
+		emit8(e, 0xE1);
+		emit8(e, 0x04);
+	}
+
+	emit8(e, opcodes[operation]);	/* op al, dl */
+	emit8(e, 0xD0);
+	emit8(e, 0x9F);			/* lahf */
+
+	if (operation != 7) {
+		emit_cpu(e, false, 0x88, JIT_RAX, JIT_CPU_FIELD(a));
+	}
+	emit_flags_from_lahf(e, tables[operation]);
+	emit_cpu(e, false, 0x88, JIT_RCX, JIT_CPU_FIELD(f));
+}
+
+/* INC r or DEC r, which leave C alone */
+static void emit_inc_dec(jit_emitter_t *e, int32_t offset, bool increment)
+{
+	emit_cpu(e, false, 0x8A, JIT_RAX, offset);
+	emit8(e, 0xFE);			/* inc al / dec al */
+	emit8(e, increment ? 0xC0 : 0xC8);
+	emit8(e, 0x9F);			/* lahf */
+	emit_cpu(e, false, 0x88, JIT_RAX, offset);
+	emit_flags_from_lahf(e, increment ? JIT_FLAGS_INC : JIT_FLAGS_DEC);
+	emit_cpu(e, false, 0x8A, JIT_RDX, JIT_CPU_FIELD(f));
+	emit8(e, 0x80);			/* and dl, C */
+	emit8(e, 0xE2);
+	emit8(e, CPU_FLAG_C);
+	emit8(e, 0x08);			/* or dl, cl */
+	emit8(e, 0xCA);
+	emit_cpu(e, false, 0x88, JIT_RDX, JIT_CPU_FIELD(f));
+}
+
+/* op byte [cpu + offset], imm8 for the 0x80 group (/1 or, /4 and, /6 xor) */
+static void emit_flag_op(jit_emitter_t *e, int group, int32_t offset,
+			 byte value)
+{
+	emit_cpu(e, false, 0x80, group, offset);
+	emit8(e, value);
+}
+
+/* Native code of an earlier instruction of this block at pc, or NULL */
+static byte *jit_label(const jit_emitter_t *e, address pc)
+{
+	for (int i = 0; i < e->count; i++) {
+		if (e->pcs[i] == pc) {
+			return e->labels[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* A taken jump: loops inside the block stay native while cycles last */
+static void emit_branch(jit_emitter_t *e, address target)
+{
+	byte *label = jit_label(e, target);
+
+	if (label != NULL) {
+		emit8(e, 0x4D);	/* cmp r15, r12 */
+		emit8(e, 0x39);
+		emit8(e, 0xE7);
+		byte *spent = emit_jcc8(e, 0x73);
+
+		emit_jmp(e, label);
+		patch8(spent, e->p);
+	}
+
+	emit_exit(e, target);
+}
+
+/* Conditional jumps: skip the taken path unless the condition holds */
+static void emit_conditional(jit_emitter_t *e, int condition, int extra,
+			     address target)
+{
+	byte mask = condition < 2 ? CPU_FLAG_Z : CPU_FLAG_C;
+
+	emit_cpu(e, false, 0xF6, 0, JIT_CPU_FIELD(f));	/* test byte [f], mask */
+	emit8(e, mask);
+
+	/* NZ and NC are taken on a clear flag, Z and C on a set one */
+	byte *not_taken = emit_jcc8(e, (condition & 1) ? 0x74 : 0x75);
+	emit_add_cycles(e, extra);
+	emit_branch(e, target);
+	patch8(not_taken, e->p);
+}
+
+/*
+ * Emits one instruction whose base cycles are already added. Returns true
+ * if it ends the block.
+ */
+static bool jit_emit_instruction(jit_emitter_t *e,
+				 const cpu_instruction_t *instruction,
+				 const byte *bytes)
+{
+	byte opcode = bytes[0];
+	address next = (address)(instruction->pc + instruction->length);
+	address immediate16 = (address)(bytes[1] | (bytes[2] << 8));
+	bool bus = false;
+
+	if (opcode == 0x00) {
+		/* NOP */
+	} else if (opcode >= 0x40 && opcode < 0x80 && opcode != 0x76) {
+		int dst = (opcode >> 3) & 7;
+		int src = opcode & 7;
+
+		if (src == 6) {
+			emit_load_pair(e, 2);
+			emit_read(e);
+			emit_cpu(e, false, 0x88, JIT_RAX, jit_register_offsets[dst]);
+			bus = true;
+		} else if (dst == 6) {
+			emit_cpu(e, false, 0x8A, JIT_R8, jit_register_offsets[src]);
+			emit_load_pair(e, 2);
+			emit_write(e);
+			bus = true;
+		} else if (dst != src) {
+			emit_cpu(e, false, 0x8A, JIT_RAX, jit_register_offsets[src]);
+			emit_cpu(e, false, 0x88, JIT_RAX, jit_register_offsets[dst]);
+		}
+	} else if ((opcode & 0xC7) == 0x06) {
+		int dst = (opcode >> 3) & 7;
+
+		if (dst == 6) {
+			emit8(e, 0x41);	/* mov r8d, n */
+			emit8(e, 0xB8);
+			emit32(e, bytes[1]);
+			emit_load_pair(e, 2);
+			emit_write(e);
+			bus = true;
+		} else {
+			emit_cpu(e, false, 0xC6, 0, jit_register_offsets[dst]);
+			emit8(e, bytes[1]);
+		}
+	} else if ((opcode & 0xCF) == 0x01) {
+		/* LD rr, nn */
+		int pair = opcode >> 4;
+
+		emit8(e, 0x66);
+		if (pair == 3) {
+			emit_cpu(e, false, 0xC7, 0, JIT_CPU_FIELD(sp));
+			emit16(e, immediate16);
+		} else {
+			emit_cpu(e, false, 0xC7, 0, jit_pair_offsets[pair]);
+			emit16(e, (uint16_t)(bytes[2] | (bytes[1] << 8)));
+		}
+	} else if (opcode == 0x0A || opcode == 0x1A || opcode == 0x2A ||
+		   opcode == 0x3A) {
+		/* LD A, (BC) / (DE) / (HL+) / (HL-) */
+		emit_load_pair(e, opcode < 0x20 ? opcode >> 4 : 2);
+		emit_read(e);
+		emit_cpu(e, false, 0x88, JIT_RAX, JIT_CPU_FIELD(a));
+		if (opcode >= 0x20) {
+			emit_step_hl(e, opcode == 0x2A ? 1 : -1);
+		}
+		bus = true;
+	} else if (opcode == 0x02 || opcode == 0x12 || opcode == 0x22 ||
+		   opcode == 0x32) {
+		/* LD (BC) / (DE) / (HL+) / (HL-), A */
+		emit_cpu(e, false, 0x8A, JIT_R8, JIT_CPU_FIELD(a));
+		emit_load_pair(e, opcode < 0x20 ? opcode >> 4 : 2);
+		emit_write(e);
+		if (opcode >= 0x20) {
+			emit_step_hl(e, opcode == 0x22 ? 1 : -1);
+		}
+		bus = true;
+	} else if (opcode == 0xEA || opcode == 0xE0) {
+		address addr = opcode == 0xEA ? immediate16 :
+						(address)(0xFF00 | bytes[1]);
+
+		emit_cpu(e, false, 0x8A, JIT_R8, JIT_CPU_FIELD(a));
+		emit_write_const(e, addr);
+		bus = true;
+	} else if (opcode == 0xFA || opcode == 0xF0) {
+		address addr = opcode == 0xFA ? immediate16 :
+						(address)(0xFF00 | bytes[1]);
+
+		emit_read_const(e, addr);
+		emit_cpu(e, false, 0x88, JIT_RAX, JIT_CPU_FIELD(a));
+		bus = true;
+	} else if (opcode == 0xE2 || opcode == 0xF2) {
+		/* LD (C), A and LD A, (C) */
+		emit_cpu(e, false, 0x0FB6, JIT_RAX, JIT_CPU_FIELD(c));
+		emit8(e, 0x0D);	/* or eax, 0xFF00 */
+		emit32(e, 0xFF00);
+		if (opcode == 0xE2) {
+			emit_cpu(e, false, 0x8A, JIT_R8, JIT_CPU_FIELD(a));
+			emit_write(e);
+		} else {
+			emit_read(e);
+			emit_cpu(e, false, 0x88, JIT_RAX, JIT_CPU_FIELD(a));
+		}
+		bus = true;
+	} else if ((opcode & 0xC6) == 0x04 && (opcode & 0x38) != 0x30) {
+		/* INC r / DEC r */
+		emit_inc_dec(e, jit_register_offsets[(opcode >> 3) & 7],
+			     (opcode & 1) == 0);
+	} else if ((opcode & 0xC7) == 0x03) {
+		/* INC rr / DEC rr */
+		int pair = (opcode >> 4) & 3;
+		bool increment = (opcode & 0x08) == 0;
+
+		if (pair == 3) {
+			emit8(e, 0x66);
+			emit_cpu(e, false, 0xFF, increment ? 0 : 1,
+				 JIT_CPU_FIELD(sp));
+		} else {
+			emit_load_pair(e, pair);
+			emit8(e, 0x66);
+			emit8(e, 0xFF);
+			emit8(e, increment ? 0xC0 : 0xC8);
+			emit_store_pair(e, pair);
+		}
+	} else if (opcode >= 0x80 && opcode < 0xC0) {
+		int src = opcode & 7;
+
+		if (src == 6) {
+			emit_load_pair(e, 2);
+			emit_read(e);
+			emit8(e, 0x89);	/* mov edx, eax */
+			emit8(e, 0xC2);
+			bus = true;
+		} else {
+			emit_cpu(e, false, 0x8A, JIT_RDX, jit_register_offsets[src]);
+		}
+		emit_alu(e, (opcode >> 3) & 7);
+	} else if ((opcode & 0xC7) == 0xC6) {
+		/* ALU A, n */
+		emit8(e, 0xB2);	/* mov dl, n */
+		emit8(e, bytes[1]);
+		emit_alu(e, (opcode >> 3) & 7);
+	} else if (opcode == 0x2F) {
+		/* CPL */
+		emit_flag_op(e, 6, JIT_CPU_FIELD(a), 0xFF);
+		emit_flag_op(e, 1, JIT_CPU_FIELD(f), CPU_FLAG_N | CPU_FLAG_H);
+	} else if (opcode == 0x37) {
+		/* SCF */
+		emit_flag_op(e, 4, JIT_CPU_FIELD(f), CPU_FLAG_Z);
+		emit_flag_op(e, 1, JIT_CPU_FIELD(f), CPU_FLAG_C);
+	} else if (opcode == 0x3F) {
+		/* CCF */
+		emit_flag_op(e, 4, JIT_CPU_FIELD(f), CPU_FLAG_Z | CPU_FLAG_C);
+		emit_flag_op(e, 6, JIT_CPU_FIELD(f), CPU_FLAG_C);
+	} else if (opcode == 0x18 || opcode == 0xC3) {
+		emit_branch(e, opcode == 0x18 ?
+				       (address)(next + (int8_t)bytes[1]) :
+				       immediate16);
+		return true;
+	} else if ((opcode & 0xE7) == 0x20) {
+		/* JR cc, e */
+		emit_conditional(e, (opcode >> 3) & 3, 4,
+				 (address)(next + (int8_t)bytes[1]));
+	} else if ((opcode & 0xE7) == 0xC2) {
+		/* JP cc, nn */
+		emit_conditional(e, (opcode >> 3) & 3, 4, immediate16);
+	} else if (opcode == 0xCB && (bytes[1] & 7) != 6 && bytes[1] >= 0x40) {
+		/* BIT, RES and SET on a register */
+		byte cb = bytes[1];
+		int32_t offset = jit_register_offsets[cb & 7];
+		byte mask = (byte)(1 << ((cb >> 3) & 7));
+
+		if (cb < 0x80) {
+			/* Z from the bit, N clear, H set, C kept */
+			emit_cpu(e, false, 0xF6, 0, offset);
+			emit8(e, mask);
+			emit8(e, 0x0F);	/* setz al */
+			emit8(e, 0x94);
+			emit8(e, 0xC0);
+			emit8(e, 0xC0);	/* shl al, 7 */
+			emit8(e, 0xE0);
+			emit8(e, 0x07);
+			emit_cpu(e, false, 0x8A, JIT_RDX, JIT_CPU_FIELD(f));
+			emit8(e, 0x80);	/* and dl, C */
+			emit8(e, 0xE2);
+			emit8(e, CPU_FLAG_C);
+			emit8(e, 0x80);	/* or dl, H */
+			emit8(e, 0xCA);
+			emit8(e, CPU_FLAG_H);
+			emit8(e, 0x08);	/* or dl, al */
+			emit8(e, 0xC2);
+			emit_cpu(e, false, 0x88, JIT_RDX, JIT_CPU_FIELD(f));
+		} else if (cb < 0xC0) {
+			emit_flag_op(e, 4, offset, (byte)~mask);
+		} else {
+			emit_flag_op(e, 1, offset, mask);
+		}
+	} else {
+		/* Everything else runs the interpreter's handler in place */
+		emit_set_pc(e, (address)(instruction->pc +
+					 instruction->opcode_length));
+		emit_store_cycles(e);
+		emit8(e, 0x48);	/* mov rdi, rbx */
+		emit8(e, 0x89);
+		emit8(e, 0xDF);
+		emit8(e, 0x48);	/* mov rax, handler */
+		emit8(e, 0xB8);
+		emit64(e, (uint64_t)(uintptr_t)instruction->handler);
+		emit8(e, 0xFF);	/* call rax */
+		emit8(e, 0xD0);
+		emit_cpu(e, true, 0x8B, JIT_CYCLES, JIT_CPU_FIELD(cycles));
+
+		/*
+		 * Jumps have set pc; after bus access the dispatcher takes
+		 * another look, as after a handler, and pc is next already
+		 */
+		bool pops = (opcode & 0xCF) == 0xC1;
+		bool tests_memory = opcode == 0xCB && (bytes[1] & 7) == 6;
+
+		if ((instruction->flags & (CPU_INSTRUCTION_ENDS_BLOCK |
+					   CPU_INSTRUCTION_WRITES)) ||
+		    pops || tests_memory) {
+			emit_jmp(e, e->epilogue);
+			return true;
+		}
+	}
+
+	emit_check(e, next, bus);
+	return false;
+}
+
+static void emit_prologue(jit_emitter_t *e, const jit_t *jit)
+{
+	static const byte saves[] = {
+		0x55,			/* push rbp */
+		0x53,			/* push rbx */
+		0x41, 0x54,		/* push r12 */
+		0x41, 0x55,		/* push r13 */
+		0x41, 0x56,		/* push r14 */
+		0x41, 0x57,		/* push r15 */
+		0x48, 0x83, 0xEC, 0x08,	/* sub rsp, 8: align calls */
+		0x48, 0x89, 0xFB,	/* mov rbx, rdi */
+		0x49, 0x89, 0xF4,	/* mov r12, rsi */
+		0x31, 0xED,		/* xor ebp, ebp */
+	};
+	static const byte restores[] = {
+		0x48, 0x83, 0xC4, 0x08,	/* add rsp, 8 */
+		0x41, 0x5F,		/* pop r15 */
+		0x41, 0x5E,		/* pop r14 */
+		0x41, 0x5D,		/* pop r13 */
+		0x41, 0x5C,		/* pop r12 */
+		0x5B,			/* pop rbx */
+		0x5D,			/* pop rbp */
+		0xC3,			/* ret */
+	};
+
+	memcpy(e->p, saves, sizeof(saves));
+	e->p += sizeof(saves);
+	emit8(e, 0x49);			/* mov r13, flag tables */
+	emit8(e, 0xBD);
+	emit64(e, (uint64_t)(uintptr_t)jit->flag_tables);
+	emit_cpu(e, true, 0x8B, JIT_MEMORY, JIT_CPU_FIELD(mem_sys));
+	emit_cpu(e, true, 0x8B, JIT_CYCLES, JIT_CPU_FIELD(cycles));
+	byte *body = emit_jcc8(e, 0xEB);
+
+	/* Every exit comes back here */
+	e->epilogue = e->p;
+	emit_store_cycles(e);
+	memcpy(e->p, restores, sizeof(restores));
+	e->p += sizeof(restores);
+	patch8(body, e->p);
+}
+
+/*
+ * Translates the block at the cpu's pc, whose opcode is at key. Returns
+ * NULL if not even the first instruction fits in the page.
+ */
+static jit_code_t jit_compile(jit_t *jit, cpu_t *cpu, const byte *key)
+{
+	jit_emitter_t e;
+	address pc = cpu->pc;
+	int page = MEMORY_PAGE(pc);
+	const byte *page_base = key - MEMORY_PAGE_OFFSET(pc);
+	byte *start = jit->code + jit->code_used;
+
+	e.jit = jit;
+	e.mem_sys = cpu->mem_sys;
+	e.p = start;
+	e.count = 0;
+
+	mprotect(jit->code, JIT_CODE_SIZE, PROT_READ | PROT_WRITE);
+	emit_prologue(&e, jit);
+
+	bool ended = false;
+	while (e.count < JIT_MAX_INSTRUCTIONS) {
+		cpu_instruction_t instruction;
+
+		cpu_decode(cpu, pc, &instruction);
+		if (MEMORY_PAGE_OFFSET(pc) + instruction.length > MEMORY_PAGE_SIZE) {
+			break;
+		}
+
+		e.labels[e.count] = e.p;
+		e.pcs[e.count] = pc;
+		e.count++;
+
+		if (instruction.cycles > 0) {
+			emit_add_cycles(&e, instruction.cycles);
+		}
+		ended = jit_emit_instruction(&e, &instruction,
+					     page_base + MEMORY_PAGE_OFFSET(pc));
+		pc = (address)(pc + instruction.length);
+
+		if (ended || MEMORY_PAGE(pc) != page) {
+			break;
+		}
+	}
+
+	if (!ended) {
+		emit_exit(&e, pc);
+	}
+
+	assert((size_t)(e.p - start) <= JIT_BLOCK_CODE_MAX);
+	mprotect(jit->code, JIT_CODE_SIZE, PROT_READ | PROT_EXEC);
+
+	if (e.count == 0) {
+		return NULL;
+	}
+
+	jit->code_used += (size_t)(e.p - start);
+	jit->blocks_compiled++;
+	return (jit_code_t)(void *)start;
+}
+
+/* Host address of the opcode at pc, or NULL outside direct-mapped ROM */
+static const byte *jit_host_address(const memory_system_t *mem_sys,
+				    address pc)
+{
+	const byte *base = mem_sys->read_map[MEMORY_PAGE(pc)];
+
+	if (pc > ROM_END || base == NULL) {
+		return NULL;
+	}
+
+	return base + MEMORY_PAGE_OFFSET(pc);
+}
+
+static jit_block_t **jit_slot(jit_t *jit, const byte *key, address pc)
+{
+	size_t index = (size_t)(jit_hash(key, pc) >> 32) & (JIT_TABLE_SIZE - 1);
+
+	while (jit->table[index] != NULL &&
+	       (jit->table[index]->key != key || jit->table[index]->pc != pc)) {
+		index = (index + 1) & (JIT_TABLE_SIZE - 1);
+	}
+
+	return &jit->table[index];
+}
+
+/* The block at key, translated once it is hot; NULL while it is cold */
+static jit_block_t *jit_lookup(jit_t *jit, cpu_t *cpu, const byte *key)
+{
+	address pc = cpu->pc;
+	jit_block_t **slot = jit_slot(jit, key, pc);
+
+	if (*slot != NULL) {
+		return *slot;
+	}
+
+	byte *heat = &jit->heat[(jit_hash(key, pc) >> 40) & (JIT_HEAT_SIZE - 1)];
+	if (++*heat < JIT_HOT_THRESHOLD) {
+		return NULL;
+	}
+	*heat = 0;
+
+	if (jit->block_count == JIT_BLOCK_COUNT ||
+	    jit->code_used + JIT_BLOCK_CODE_MAX > JIT_CODE_SIZE) {
+		jit_flush(jit);
+		slot = jit_slot(jit, key, pc);
+	}
+
+	jit_block_t *block = &jit->blocks[jit->block_count++];
+	block->key = key;
+	block->pc = pc;
+	block->next_key = NULL;
+	block->next = NULL;
+	block->code = jit_compile(jit, cpu, key);
+	*slot = block;
+
+	return block;
+}
+
+#endif
+
+/**
+ * @brief Runs the cpu through translated code for at least the given cycles
+ *
+ * Produces the same machine state as cpu_run(). ROM code is interpreted
+ * until it is hot, and anything the translations do not cover is handed to
+ * cpu_step(). Without a backend this is cpu_run().
+ *
+ * @param jit JIT belonging to the cpu's memory system
+ * @param cpu cpu to advance
+ * @param cycles T-cycle budget
+ * @return T-cycles actually executed, which may overshoot by one instruction
+ */
+uint64_t jit_run(jit_t *jit, cpu_t *cpu, uint64_t cycles)
+{
+	assert(jit != NULL && cpu != NULL);
+
+	if (!jit->available) {
+		return cpu_run(cpu, cycles);
+	}
+
+#if JIT_SUPPORTED
+	uint64_t start = cpu->cycles;
+	uint64_t target = start + cycles;
+	jit_block_t *previous = NULL;
+
+	while (cpu->cycles < target) {
+		const byte *key = jit_host_address(cpu->mem_sys, cpu->pc);
+
+		if (key == NULL || cpu_must_step(cpu)) {
+			if (!cpu_skip_halt(cpu, target)) {
+				cpu_step(cpu);
+			}
+			previous = NULL;
+			continue;
+		}
+
+		jit_block_t *block;
+		if (previous != NULL && previous->next_key == key &&
+		    previous->next_pc == cpu->pc) {
+			block = previous->next;
+		} else {
+			uint64_t flushes = jit->flushes;
+
+			block = jit_lookup(jit, cpu, key);
+
+			/* A flush inside the lookup may have recycled previous */
+			if (previous != NULL && block != NULL &&
+			    flushes == jit->flushes) {
+				previous->next_key = key;
+				previous->next_pc = cpu->pc;
+				previous->next = block;
+			}
+		}
+
+		if (block == NULL || block->code == NULL) {
+			cpu_step(cpu);
+			previous = NULL;
+			continue;
+		}
+
+		block->code(cpu, target);
+		previous = block;
+	}
+
+	return cpu->cycles - start;
+#else
+	return 0;
+#endif
+}
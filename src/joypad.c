@@ -0,0 +1,98 @@
+#include "../include/joypad.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define JOYPAD_REGISTER(joypad) \
+	((joypad)->mem_sys->high_page[MEMORY_PAGE_OFFSET(JOYP_REGISTER)])
+
+#define JOYP_SELECT_MASK (JOYP_SELECT_DIRECTIONS | JOYP_SELECT_BUTTONS)
+
+/* Low P1 nibble: 0 for each key held in a selected group */
+static byte joypad_lines(const joypad_t *joypad, byte select)
+{
+	byte held = 0;
+
+	if (!(select & JOYP_SELECT_DIRECTIONS)) {
+		held |= joypad->buttons & 0x0F;
+	}
+	if (!(select & JOYP_SELECT_BUTTONS)) {
+		held |= joypad->buttons >> 4;
+	}
+
+	return (byte)(~held & 0x0F);
+}
+
+static byte joypad_read(memory_system_t *mem_sys, void *context, address addr)
+{
+	joypad_t *joypad = context;
+	byte select = mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)];
+
+	return (byte)(0xC0 | (select & JOYP_SELECT_MASK) |
+		      joypad_lines(joypad, select));
+}
+
+/* The interrupt fires when any input line falls from 1 to 0 */
+static void joypad_update(joypad_t *joypad, byte before)
+{
+	byte after = joypad_lines(joypad, JOYPAD_REGISTER(joypad));
+
+	if (before & ~after) {
+		memory_request_interrupt(joypad->mem_sys, INTERRUPT_JOYPAD);
+	}
+}
+
+static void joypad_write(memory_system_t *mem_sys, void *context, address addr,
+			 byte value)
+{
+	joypad_t *joypad = context;
+	byte *select = &mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)];
+	byte before = joypad_lines(joypad, *select);
+
+	*select = value & JOYP_SELECT_MASK;
+	joypad_update(joypad, before);
+}
+
+bool joypad_init(joypad_t *joypad, memory_system_t *mem_sys)
+{
+	if (joypad == NULL || mem_sys == NULL) {
+		printf("Cannot initialize joypad without memory system\n");
+		return false;
+	}
+
+	joypad->mem_sys = mem_sys;
+	joypad->buttons = 0;
+	memory_register_io(mem_sys, JOYP_REGISTER, joypad_read, joypad_write,
+			   joypad);
+	joypad_reset(joypad);
+
+	return true;
+}
+
+void joypad_reset(joypad_t *joypad)
+{
+	assert(joypad != NULL);
+
+	/* DMG register state after the boot ROM: neither group selected */
+	JOYPAD_REGISTER(joypad) = JOYP_SELECT_MASK;
+}
+
+/**
+ * @brief Sets which keys are held from now on
+ *
+ * @param joypad joypad to update
+ * @param buttons JOYPAD_* bits of the keys held
+ */
+void joypad_set_buttons(joypad_t *joypad, byte buttons)
+{
+	assert(joypad != NULL);
+
+	byte before = joypad_lines(joypad, JOYPAD_REGISTER(joypad));
+
+	joypad->buttons = buttons;
+	joypad_update(joypad, before);
+}
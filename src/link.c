@@ -0,0 +1,298 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/link.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static void link_start(link_t *link, int fd)
+{
+	link->fd = fd;
+	link->connected = fd >= 0;
+	link->out_size = 0;
+	link->in_size = 0;
+	link->in_offset = 0;
+	link->waits = 0;
+}
+
+/* Drops the connection; the link behaves as unplugged from then on */
+static void link_disconnect(link_t *link)
+{
+	if (link->fd >= 0) {
+		close(link->fd);
+	}
+	link->fd = -1;
+	link->connected = false;
+}
+
+static bool link_address(struct sockaddr_un *address, const char *path)
+{
+	if (strlen(path) >= sizeof(address->sun_path)) {
+		printf("ERROR: LINK SOCKET PATH TOO LONG\n");
+		return false;
+	}
+
+	memset(address, 0, sizeof(*address));
+	address->sun_family = AF_UNIX;
+	strcpy(address->sun_path, path);
+	return true;
+}
+
+/**
+ * @brief Connects two links within one process
+ *
+ * @param a one end, for one machine
+ * @param b the other end, for another machine on another thread
+ * @return false if the socket pair cannot be made
+ */
+bool link_pair(link_t *a, link_t *b)
+{
+	int fds[2];
+
+	if (a == NULL || b == NULL) {
+		printf("Cannot pair NULL links\n");
+		return false;
+	}
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+		printf("ERROR: COULD NOT MAKE LINK SOCKETS: %s\n", strerror(errno));
+		link_start(a, -1);
+		link_start(b, -1);
+		return false;
+	}
+
+	link_start(a, fds[0]);
+	link_start(b, fds[1]);
+	return true;
+}
+
+/**
+ * @brief Waits for the other instance to connect to a Unix socket
+ *
+ * @param link link to set up
+ * @param path socket path, replaced if it exists
+ * @return false if the socket cannot be made or nobody connects
+ */
+bool link_listen(link_t *link, const char *path)
+{
+	struct sockaddr_un address;
+
+	assert(link != NULL && path != NULL);
+	link_start(link, -1);
+
+	if (!link_address(&address, path)) {
+		return false;
+	}
+
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server < 0) {
+		printf("ERROR: COULD NOT MAKE LINK SOCKET: %s\n", strerror(errno));
+		return false;
+	}
+
+	unlink(path);
+	if (bind(server, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+	    listen(server, 1) != 0) {
+		printf("ERROR: COULD NOT LISTEN ON %s: %s\n", path, strerror(errno));
+		close(server);
+		return false;
+	}
+
+	int fd;
+	do {
+		fd = accept(server, NULL, NULL);
+	} while (fd < 0 && errno == EINTR);
+	close(server);
+	unlink(path);
+
+	if (fd < 0) {
+		printf("ERROR: NO LINK PEER: %s\n", strerror(errno));
+		return false;
+	}
+
+	link_start(link, fd);
+	return true;
+}
+
+/**
+ * @brief Connects to an instance waiting in link_listen()
+ *
+ * @param link link to set up
+ * @param path socket path the other instance listens on
+ * @return false if nobody is listening there
+ */
+bool link_connect(link_t *link, const char *path)
+{
+	struct sockaddr_un address;
+
+	assert(link != NULL && path != NULL);
+	link_start(link, -1);
+
+	if (!link_address(&address, path)) {
+		return false;
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		printf("ERROR: COULD NOT MAKE LINK SOCKET: %s\n", strerror(errno));
+		return false;
+	}
+
+	if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+		printf("ERROR: COULD NOT CONNECT TO %s: %s\n", path, strerror(errno));
+		close(fd);
+		return false;
+	}
+
+	link_start(link, fd);
+	return true;
+}
+
+void link_close(link_t *link)
+{
+	if (link == NULL) {
+		return;
+	}
+
+	if (link->connected) {
+		link_flush(link);
+	}
+	link_disconnect(link);
+}
+
+/**
+ * @brief Queues a message for the next link_flush()
+ *
+ * @param link link to send on
+ * @param message message to queue
+ * @return false if the link is disconnected
+ */
+bool link_send(link_t *link, const link_message_t *message)
+{
+	assert(link != NULL && message != NULL);
+
+	if (link->out_size == sizeof(link->out) && !link_flush(link)) {
+		return false;
+	}
+	if (!link->connected) {
+		return false;
+	}
+
+	byte *out = link->out + link->out_size;
+	out[0] = message->type;
+	out[1] = message->value;
+	for (int i = 0; i < 8; i++) {
+		out[2 + i] = (byte)(message->time >> (8 * i));
+	}
+	link->out_size += LINK_MESSAGE_SIZE;
+	return true;
+}
+
+/**
+ * @brief Writes out every queued message
+ *
+ * @param link link to flush
+ * @return false if the peer has gone away
+ */
+bool link_flush(link_t *link)
+{
+	assert(link != NULL);
+
+	size_t written = 0;
+	while (link->connected && written < link->out_size) {
+		ssize_t size = send(link->fd, link->out + written,
+				    link->out_size - written, MSG_NOSIGNAL);
+
+		if (size < 0 && errno == EINTR) {
+			continue;
+		}
+		if (size <= 0) {
+			link_disconnect(link);
+			break;
+		}
+		written += (size_t)size;
+	}
+
+	link->out_size = 0;
+	return link->connected;
+}
+
+/* Reads whatever has arrived, waiting for at least one byte if asked */
+static bool link_fill(link_t *link, bool wait)
+{
+	if (link->in_offset > 0) {
+		memmove(link->in, link->in + link->in_offset,
+			link->in_size - link->in_offset);
+		link->in_size -= link->in_offset;
+		link->in_offset = 0;
+	}
+
+	for (;;) {
+		ssize_t size = recv(link->fd, link->in + link->in_size,
+				    sizeof(link->in) - link->in_size,
+				    wait ? 0 : MSG_DONTWAIT);
+
+		if (size > 0) {
+			link->in_size += (size_t)size;
+			return true;
+		}
+		if (size < 0 && errno == EINTR) {
+			continue;
+		}
+		if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return false;
+		}
+
+		link_disconnect(link);
+		return false;
+	}
+}
+
+/**
+ * @brief Takes the next message from the peer
+ *
+ * @param link link to receive on
+ * @param message where the message goes
+ * @param wait true to block until one arrives
+ * @return false if none has arrived (without wait) or the peer is gone
+ */
+bool link_receive(link_t *link, link_message_t *message, bool wait)
+{
+	assert(link != NULL && message != NULL);
+
+	while (link->in_size - link->in_offset < LINK_MESSAGE_SIZE) {
+		if (!link->connected) {
+			return false;
+		}
+		if (link_fill(link, false)) {
+			continue;
+		}
+		if (!link->connected || !wait) {
+			return false;
+		}
+
+		/* Nothing has arrived yet: the peer is behind */
+		link->waits++;
+		if (!link_fill(link, true)) {
+			return false;
+		}
+	}
+
+	const byte *in = link->in + link->in_offset;
+	message->type = in[0];
+	message->value = in[1];
+	message->time = 0;
+	for (int i = 0; i < 8; i++) {
+		message->time |= (uint64_t)in[2 + i] << (8 * i);
+	}
+	link->in_offset += LINK_MESSAGE_SIZE;
+	return true;
+}
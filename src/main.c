@@ -0,0 +1,329 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/gameboy.h"
+#include "../include/batch.h"
+#include "../include/capture.h"
+#include "../include/runahead.h"
+#include "../include/link.h"
+#include "../include/serial.h"
+#include "../include/common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAIN_DEFAULT_FRAMES 600
+
+typedef struct options {
+	const char *rom_path;
+	const char *batch_path;
+	const char *csv_path;
+	const char *video_path;
+	const char *audio_path;
+	const char *trace_path;
+	const char *listen_path;
+	const char *connect_path;
+	long frames;
+	long run_ahead;
+	long jobs;
+	bool headless;
+	bool interpreter;
+	bool jit;
+} options_t;
+
+static void print_usage(const char *program)
+{
+	printf("Usage: %s [options] ROM\n", program);
+	printf("       %s [options] --batch LIST --csv OUT [--jobs N]\n",
+	       program);
+	printf("  --headless      run CPU and timing only, never draw pixels\n");
+	printf("  --interpreter   run without the block cache\n");
+	printf("  --jit           translate hot ROM code to native code\n");
+	printf("  --frames N      frames to run (default %d)\n",
+	       MAIN_DEFAULT_FRAMES);
+	printf("  --run-ahead N   show frames N frames ahead (0 to %d)\n",
+	       RUNAHEAD_MAX_FRAMES);
+	printf("  --video FILE    record raw 160x144 8-bit gray frames\n");
+	printf("  --audio FILE    record 48 kHz 16-bit stereo, WAV if FILE ends .wav\n");
+	printf("  --trace-memory FILE    write bus access counts as JSON at exit\n");
+	printf("                         (builds with -DMEMORY_TRACE only)\n");
+	printf("  --link-listen SOCKET   wait for another instance to link up\n");
+	printf("  --link-connect SOCKET  link up with an instance listening\n");
+	printf("  --batch LIST    run every \"ROM [CYCLES]\" line of LIST\n");
+	printf("  --csv OUT       where batch results are written\n");
+	printf("  --jobs N        batch threads (default: one per CPU)\n");
+}
+
+static bool parse_options(int argc, char **argv, options_t *options)
+{
+	options->rom_path = NULL;
+	options->batch_path = NULL;
+	options->csv_path = NULL;
+	options->video_path = NULL;
+	options->audio_path = NULL;
+	options->trace_path = NULL;
+	options->listen_path = NULL;
+	options->connect_path = NULL;
+	options->frames = MAIN_DEFAULT_FRAMES;
+	options->run_ahead = 0;
+	options->jobs = 0;
+	options->headless = false;
+	options->interpreter = false;
+	options->jit = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--headless") == 0) {
+			options->headless = true;
+		} else if (strcmp(argv[i], "--interpreter") == 0) {
+			options->interpreter = true;
+		} else if (strcmp(argv[i], "--jit") == 0) {
+			options->jit = true;
+		} else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			options->frames = strtol(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc) {
+			options->run_ahead = strtol(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--video") == 0 && i + 1 < argc) {
+			options->video_path = argv[++i];
+		} else if (strcmp(argv[i], "--audio") == 0 && i + 1 < argc) {
+			options->audio_path = argv[++i];
+		} else if (strcmp(argv[i], "--trace-memory") == 0 && i + 1 < argc) {
+			options->trace_path = argv[++i];
+		} else if (strcmp(argv[i], "--link-listen") == 0 && i + 1 < argc) {
+			options->listen_path = argv[++i];
+		} else if (strcmp(argv[i], "--link-connect") == 0 && i + 1 < argc) {
+			options->connect_path = argv[++i];
+		} else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+			options->batch_path = argv[++i];
+		} else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+			options->csv_path = argv[++i];
+		} else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+			options->jobs = strtol(argv[++i], NULL, 10);
+		} else if (argv[i][0] != '-' && options->rom_path == NULL) {
+			options->rom_path = argv[i];
+		} else {
+			printf("Unknown option: %s\n", argv[i]);
+			return false;
+		}
+	}
+
+#ifndef MEMORY_TRACE
+	if (options->trace_path != NULL) {
+		printf("Memory tracing is not compiled in; rebuild with -DMEMORY_TRACE\n");
+		return false;
+	}
+#endif
+
+	if (options->interpreter && options->jit) {
+		printf("Cannot use both the interpreter and the JIT\n");
+		return false;
+	}
+
+	if (options->batch_path != NULL) {
+		return options->rom_path == NULL && options->csv_path != NULL &&
+		       options->trace_path == NULL && options->jobs >= 0;
+	}
+
+	/* Headless runs make neither pixels nor samples to record */
+	if (options->headless &&
+	    (options->video_path != NULL || options->audio_path != NULL)) {
+		printf("Cannot record in headless mode\n");
+		return false;
+	}
+
+	/* Running ahead would send the peer bytes from frames that get undone */
+	if ((options->listen_path != NULL || options->connect_path != NULL) &&
+	    (options->run_ahead > 0 ||
+	     (options->listen_path != NULL && options->connect_path != NULL))) {
+		printf("Cannot link with run-ahead, or both listen and connect\n");
+		return false;
+	}
+
+	return options->rom_path != NULL && options->frames > 0 &&
+	       options->run_ahead >= 0 && options->run_ahead <= RUNAHEAD_MAX_FRAMES;
+}
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int run_batch(const options_t *options)
+{
+	batch_job_t *jobs;
+	int count;
+
+	if (!batch_read_list(options->batch_path, &jobs, &count)) {
+		return 1;
+	}
+
+	batch_result_t *results = calloc(count > 0 ? count : 1,
+					 sizeof(batch_result_t));
+	if (results == NULL) {
+		batch_free_list(jobs, count);
+		return 1;
+	}
+
+	batch_options_t batch_options;
+	batch_options.threads = options->jobs > 0 ?
+					(int)MIN(options->jobs, BATCH_MAX_THREADS) :
+					(int)MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+	batch_options.headless = options->headless;
+	batch_options.use_block_cache = !options->interpreter;
+	batch_options.use_jit = options->jit;
+
+	double begin = now_seconds();
+	bool ok = batch_run(jobs, results, count, &batch_options);
+	double elapsed = now_seconds() - begin;
+
+	int failed = 0;
+	uint64_t cycles = 0;
+	for (int i = 0; i < count; i++) {
+		failed += !results[i].ok;
+		cycles += results[i].cycles;
+	}
+
+	if (ok) {
+		ok = batch_write_csv(options->csv_path, jobs, results, count);
+	}
+
+	if (ok) {
+		double emulated = (double)cycles / CPU_FREQUENCY;
+		printf("Ran %d ROMs (%d failed) on %d threads in %.3f s: "
+		       "%.2f s emulated, %.1fx real-time\n",
+		       count, failed, batch_options.threads, elapsed, emulated,
+		       emulated / elapsed);
+	}
+
+	free(results);
+	batch_free_list(jobs, count);
+	return ok && failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	options_t options;
+
+	if (!parse_options(argc, argv, &options)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (options.batch_path != NULL) {
+		return run_batch(&options);
+	}
+
+	gameboy_t *gb = malloc(sizeof(gameboy_t));
+	if (gb == NULL || !gameboy_init(gb)) {
+		printf("ERROR: FAILED TO INITIALIZE EMULATOR\n");
+		free(gb);
+		return 1;
+	}
+
+	if (!gameboy_load_rom(gb, options.rom_path)) {
+		gameboy_cleanup(gb);
+		free(gb);
+		return 1;
+	}
+
+	gb->use_block_cache = !options.interpreter;
+	gb->use_jit = options.jit;
+	gameboy_set_headless(gb, options.headless);
+
+	link_t link;
+	bool linked = options.listen_path != NULL || options.connect_path != NULL;
+	if (linked) {
+		bool connected = options.listen_path != NULL ?
+					 link_listen(&link, options.listen_path) :
+					 link_connect(&link, options.connect_path);
+
+		if (!connected) {
+			gameboy_cleanup(gb);
+			free(gb);
+			return 1;
+		}
+		serial_attach(&gb->serial, &link);
+	}
+
+	runahead_t runahead;
+	if (!runahead_init(&runahead, gb, (int)options.run_ahead)) {
+		if (linked) {
+			link_close(&link);
+		}
+		gameboy_cleanup(gb);
+		free(gb);
+		return 1;
+	}
+
+	capture_t capture;
+	bool capturing = options.video_path != NULL || options.audio_path != NULL;
+	if (capturing && !capture_open(&capture, gb, options.video_path,
+				       options.audio_path, 0)) {
+		if (linked) {
+			link_close(&link);
+		}
+		runahead_cleanup(&runahead);
+		gameboy_cleanup(gb);
+		free(gb);
+		return 1;
+	}
+
+	uint64_t cycles = 0;
+	double begin = now_seconds();
+	for (long frame = 0; frame < options.frames; frame++) {
+		cycles += runahead_run_frame(&runahead, gb);
+
+		if (capturing) {
+			capture_frame(&capture, gb);
+		}
+	}
+	double elapsed = now_seconds() - begin;
+
+	/* The peer carries on unplugged if it has frames left */
+	if (linked) {
+		link_close(&link);
+	}
+
+	bool ok = !capturing || capture_close(&capture, gb);
+
+	double emulated = (double)cycles / CPU_FREQUENCY;
+	printf("Ran %ld frames (%llu cycles, %.2f s emulated) in %.3f s: "
+	       "%.1fx real-time, %.0f fps\n",
+	       options.frames, (unsigned long long)cycles, emulated, elapsed,
+	       emulated / elapsed, options.frames / elapsed);
+	const char *core = options.interpreter ? "interpreter" : "block cache";
+	if (options.jit) {
+		core = gb->jit.available ? "JIT" : "interpreter (no JIT here)";
+	}
+	printf("Mode: %s, %s\n", options.headless ? "headless" : "rendering",
+	       core);
+	if (capturing) {
+		const capture_stream_t *video = &capture.streams[CAPTURE_VIDEO];
+		const capture_stream_t *audio = &capture.streams[CAPTURE_AUDIO];
+
+		printf("Captured %llu frames (%llu dropped), %llu samples "
+		       "(%llu dropped)%s\n",
+		       (unsigned long long)video->captured,
+		       (unsigned long long)video->dropped,
+		       (unsigned long long)audio->captured,
+		       (unsigned long long)audio->dropped,
+		       ok ? "" : ", WRITE FAILED");
+	}
+	if (linked) {
+		printf("Link: %llu bytes exchanged, waited for the peer %llu times\n",
+		       (unsigned long long)gb->serial.transfers,
+		       (unsigned long long)link.waits);
+	}
+	if (options.trace_path != NULL) {
+		ok = memory_trace_export(&gb->memory, options.trace_path) && ok;
+	}
+
+	runahead_cleanup(&runahead);
+	gameboy_cleanup(gb);
+	free(gb);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+#include "../include/mbc.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define MBC_RAM_ENABLE_END 0x1FFF
+#define MBC_ROM_BANK_END 0x3FFF
+#define MBC_RAM_BANK_END 0x5FFF
+#define MBC_RTC_FIRST_REGISTER 0x08
+#define MBC_RTC_LAST_REGISTER 0x0C
+
+bool mbc_init(mbc_t *mbc, byte cartridge_type, size_t rom_size,
+	      size_t ram_size)
+{
+	assert(mbc != NULL);
+
+	memset(mbc, 0, sizeof(*mbc));
+
+	switch (cartridge_type) {
+	case 0x00:
+		mbc->type = MBC_NONE;
+		break;
+	case 0x08:
+		mbc->type = MBC_NONE;
+		mbc->has_ram = true;
+		break;
+	case 0x09:
+		mbc->type = MBC_NONE;
+		mbc->has_ram = true;
+		mbc->has_battery = true;
+		break;
+	case 0x01:
+		mbc->type = MBC_1;
+		break;
+	case 0x02:
+		mbc->type = MBC_1;
+		mbc->has_ram = true;
+		break;
+	case 0x03:
+		mbc->type = MBC_1;
+		mbc->has_ram = true;
+		mbc->has_battery = true;
+		break;
+	case 0x0F:
+		mbc->type = MBC_3;
+		mbc->has_battery = true;
+		mbc->has_rtc = true;
+		break;
+	case 0x10:
+		mbc->type = MBC_3;
+		mbc->has_ram = true;
+		mbc->has_battery = true;
+		mbc->has_rtc = true;
+		break;
+	case 0x11:
+		mbc->type = MBC_3;
+		break;
+	case 0x12:
+		mbc->type = MBC_3;
+		mbc->has_ram = true;
+		break;
+	case 0x13:
+		mbc->type = MBC_3;
+		mbc->has_ram = true;
+		mbc->has_battery = true;
+		break;
+	case 0x19:
+	case 0x1C:
+		mbc->type = MBC_5;
+		break;
+	case 0x1A:
+	case 0x1D:
+		mbc->type = MBC_5;
+		mbc->has_ram = true;
+		break;
+	case 0x1B:
+	case 0x1E:
+		mbc->type = MBC_5;
+		mbc->has_ram = true;
+		mbc->has_battery = true;
+		break;
+	default:
+		printf("ERROR: UNSUPPORTED CARTRIDGE TYPE 0x%02X\n",
+		       cartridge_type);
+		return false;
+	}
+
+	if (ram_size == 0) {
+		mbc->has_ram = false;
+	}
+
+	mbc->rom_bank_count = MAX(rom_size / ROM_BANK_SIZE, 2);
+	mbc->ram_bank_count = MAX(ram_size / RAM_BANK_SIZE, 1);
+	mbc->rom_bank = 1;
+
+	/* Carts without a controller have their RAM permanently enabled */
+	mbc->ram_enabled = mbc->type == MBC_NONE;
+
+	return true;
+}
+
+size_t mbc_ram_size(byte ram_size_code)
+{
+	switch (ram_size_code) {
+	case 0x01:
+		return 0x800;
+	case 0x02:
+		return 0x2000;
+	case 0x03:
+		return 0x8000;
+	case 0x04:
+		return 0x20000;
+	case 0x05:
+		return 0x10000;
+	default:
+		return 0;
+	}
+}
+
+static byte mbc_ram_disabled_read(memory_system_t *mem_sys, address addr)
+{
+	UNUSED(mem_sys);
+	UNUSED(addr);
+	return 0xFF;
+}
+
+static void mbc_ram_disabled_write(memory_system_t *mem_sys, address addr,
+				   byte value)
+{
+	UNUSED(mem_sys);
+	UNUSED(addr);
+	UNUSED(value);
+}
+
+static byte mbc_rtc_read(memory_system_t *mem_sys, address addr)
+{
+	UNUSED(addr);
+	const mbc_t *mbc = &mem_sys->mbc;
+
+	return mbc->rtc_latched[mbc->ram_bank - MBC_RTC_FIRST_REGISTER];
+}
+
+static void mbc_rtc_write(memory_system_t *mem_sys, address addr, byte value)
+{
+	UNUSED(addr);
+	mbc_t *mbc = &mem_sys->mbc;
+
+	mbc->rtc[mbc->ram_bank - MBC_RTC_FIRST_REGISTER] = value;
+}
+
+static void mbc_map_rom(memory_system_t *mem_sys)
+{
+	const mbc_t *mbc = &mem_sys->mbc;
+	size_t low_bank = 0;
+	size_t high_bank = mbc->rom_bank;
+
+	if (mem_sys->rom == NULL) {
+		return;
+	}
+
+	if (mbc->type == MBC_1) {
+		high_bank = (mbc->rom_bank & 0x1F) | ((mbc->ram_bank & 0x03) << 5);
+		if (mbc->banking_mode == 1) {
+			low_bank = (mbc->ram_bank & 0x03) << 5;
+		}
+	}
+
+	low_bank %= mbc->rom_bank_count;
+	high_bank %= mbc->rom_bank_count;
+
+	memory_map_direct(mem_sys, 0x0000, 0x3FFF,
+			  mem_sys->rom + low_bank * ROM_BANK_SIZE, NULL);
+	memory_map_direct(mem_sys, 0x4000, 0x7FFF,
+			  mem_sys->rom + high_bank * ROM_BANK_SIZE, NULL);
+	mem_sys->rom_mapping_version++;
+}
+
+static void mbc_map_ram(memory_system_t *mem_sys)
+{
+	const mbc_t *mbc = &mem_sys->mbc;
+
+	if (mbc->type == MBC_3 && mbc->ram_enabled &&
+	    mbc->ram_bank >= MBC_RTC_FIRST_REGISTER) {
+		if (mbc->has_rtc && mbc->ram_bank <= MBC_RTC_LAST_REGISTER) {
+			memory_map_handlers(mem_sys, ERAM_START, ERAM_END,
+					    mbc_rtc_read, mbc_rtc_write);
+			return;
+		}
+
+		memory_map_handlers(mem_sys, ERAM_START, ERAM_END,
+				    mbc_ram_disabled_read,
+				    mbc_ram_disabled_write);
+		return;
+	}
+
+	if (!mbc->has_ram || !mbc->ram_enabled || mem_sys->eram == NULL) {
+		memory_map_handlers(mem_sys, ERAM_START, ERAM_END,
+				    mbc_ram_disabled_read,
+				    mbc_ram_disabled_write);
+		return;
+	}
+
+	size_t bank = mbc->ram_bank;
+	if (mbc->type == MBC_1 && mbc->banking_mode == 0) {
+		bank = 0;
+	}
+	bank %= mbc->ram_bank_count;
+
+	byte *ram = mem_sys->eram + bank * RAM_BANK_SIZE;
+	memory_map_direct(mem_sys, ERAM_START, ERAM_END, ram, ram);
+}
+
+void mbc_update_mapping(memory_system_t *mem_sys)
+{
+	assert(mem_sys != NULL);
+
+	mbc_map_rom(mem_sys);
+	mbc_map_ram(mem_sys);
+}
+
+static void mbc1_write(memory_system_t *mem_sys, address addr, byte value)
+{
+	mbc_t *mbc = &mem_sys->mbc;
+
+	if (addr <= MBC_RAM_ENABLE_END) {
+		mbc->ram_enabled = (value & 0x0F) == 0x0A;
+		mbc_map_ram(mem_sys);
+	} else if (addr <= MBC_ROM_BANK_END) {
+		mbc->rom_bank = value & 0x1F;
+		if (mbc->rom_bank == 0) {
+			mbc->rom_bank = 1;
+		}
+		mbc_map_rom(mem_sys);
+	} else if (addr <= MBC_RAM_BANK_END) {
+		mbc->ram_bank = value & 0x03;
+		mbc_update_mapping(mem_sys);
+	} else {
+		mbc->banking_mode = value & 0x01;
+		mbc_update_mapping(mem_sys);
+	}
+}
+
+static void mbc3_write(memory_system_t *mem_sys, address addr, byte value)
+{
+	mbc_t *mbc = &mem_sys->mbc;
+
+	if (addr <= MBC_RAM_ENABLE_END) {
+		mbc->ram_enabled = (value & 0x0F) == 0x0A;
+		mbc_map_ram(mem_sys);
+	} else if (addr <= MBC_ROM_BANK_END) {
+		mbc->rom_bank = value & 0x7F;
+		if (mbc->rom_bank == 0) {
+			mbc->rom_bank = 1;
+		}
+		mbc_map_rom(mem_sys);
+	} else if (addr <= MBC_RAM_BANK_END) {
+		mbc->ram_bank = value & 0x0F;
+		mbc_map_ram(mem_sys);
+	} else {
+		if (mbc->rtc_latch == 0x00 && value == 0x01) {
+			memcpy(mbc->rtc_latched, mbc->rtc, sizeof(mbc->rtc));
+		}
+		mbc->rtc_latch = value;
+	}
+}
+
+static void mbc5_write(memory_system_t *mem_sys, address addr, byte value)
+{
+	mbc_t *mbc = &mem_sys->mbc;
+
+	if (addr <= MBC_RAM_ENABLE_END) {
+		mbc->ram_enabled = (value & 0x0F) == 0x0A;
+		mbc_map_ram(mem_sys);
+	} else if (addr <= 0x2FFF) {
+		mbc->rom_bank = (mbc->rom_bank & 0x100) | value;
+		mbc_map_rom(mem_sys);
+	} else if (addr <= MBC_ROM_BANK_END) {
+		mbc->rom_bank = (mbc->rom_bank & 0xFF) | ((value & 0x01) << 8);
+		mbc_map_rom(mem_sys);
+	} else if (addr <= MBC_RAM_BANK_END) {
+		mbc->ram_bank = value & 0x0F;
+		mbc_map_ram(mem_sys);
+	}
+}
+
+void mbc_write(memory_system_t *mem_sys, address addr, byte value)
+{
+	assert(mem_sys != NULL);
+
+	switch (mem_sys->mbc.type) {
+	case MBC_1:
+		mbc1_write(mem_sys, addr, value);
+		break;
+	case MBC_3:
+		mbc3_write(mem_sys, addr, value);
+		break;
+	case MBC_5:
+		mbc5_write(mem_sys, addr, value);
+		break;
+	case MBC_NONE:
+		break;
+	}
+}
+
+const char *mbc_get_type_name(mbc_type_t type)
+{
+	switch (type) {
+	case MBC_NONE:
+		return "ROM ONLY";
+	case MBC_1:
+		return "MBC1";
+	case MBC_3:
+		return "MBC3";
+	case MBC_5:
+		return "MBC5";
+	}
+
+	return "Unknown";
+}
@@ -1,243 +1,1465 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "../include/memory.h"
 #include "../include/common.h"
 
 #include <assert.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-bool memory_init(memory_system_t *mem_sys)
+#if defined(__unix__) || defined(__APPLE__)
+#define MEMORY_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* memory_dump_region(): bytes per row, and room for a row and the header */
+#define MEMORY_DUMP_ROW 16
+#define MEMORY_DUMP_LINE_SIZE 80
+#define MEMORY_DUMP_HEADER_SIZE 256
+
+static byte memory_unmapped_read(memory_system_t *mem_sys, address addr)
 {
-	if (mem_sys == NULL) {
-		printf("Cannot initialize NULL memory system"); 
-		return false;
-	}
+	UNUSED(mem_sys);
+	UNUSED(addr);
+	return 0xFF;
+}
 
-	memset(mem_sys->rom, 0x00, ROM_SIZE);
-	memset(mem_sys->vram, 0x00, VRAM_SIZE);
-	memset(mem_sys->wram, 0x00, WRAM_SIZE);
+static void memory_unmapped_write(memory_system_t *mem_sys, address addr,
+				  byte value)
+{
+	UNUSED(mem_sys);
+	UNUSED(addr);
+	UNUSED(value);
+}
 
-	mem_sys->rom_loaded = false;
+static byte memory_empty_rom_read(memory_system_t *mem_sys, address addr)
+{
+	UNUSED(mem_sys);
+	UNUSED(addr);
+	return 0x00;
+}
 
-	return true;
+static byte memory_oam_read(memory_system_t *mem_sys, address addr)
+{
+	if (addr > OAM_END) {
+		return 0x00;
+	}
+
+	return mem_sys->oam[addr - OAM_START];
 }
 
-void memory_cleanup(memory_system_t *mem_sys)
+static void memory_oam_write(memory_system_t *mem_sys, address addr, byte value)
 {
-	if (mem_sys == NULL) {
-		printf("ERROR: CANNOT CLEANUP NULL MEMORY SYSTEM"); 
+	if (addr > OAM_END) {
 		return;
 	}
 
-	memset(mem_sys->rom, 0x00, ROM_SIZE);
-	memset(mem_sys->vram, 0x00, VRAM_SIZE);
-	memset(mem_sys->wram, 0x00, WRAM_SIZE);
+	mem_sys->oam[addr - OAM_START] = value;
+}
 
-	mem_sys->rom_loaded = false;
-	printf("Memory cleaned up successfully\n");
+static void memory_vram_tile_write(memory_system_t *mem_sys, address addr,
+				   byte value)
+{
+	mem_sys->vram[addr - VRAM_START] = value;
+	mem_sys->vram_tile_dirty[(addr - VRAM_START) / VRAM_TILE_SIZE] = true;
 }
-static int memory_calculate_offset(address addr)
+
+static byte memory_high_read(memory_system_t *mem_sys, address addr)
 {
-	if (addr > 0xFFFF) {
+	byte offset = MEMORY_PAGE_OFFSET(addr);
+	const memory_io_handler_t *handler = &mem_sys->io_handlers[offset];
+
+	if (handler->read == NULL) {
+		return mem_sys->high_page[offset];
+	}
+
+	return handler->read(mem_sys, handler->context, addr);
+}
+
+static void memory_high_write(memory_system_t *mem_sys, address addr,
+			      byte value)
+{
+	byte offset = MEMORY_PAGE_OFFSET(addr);
+	const memory_io_handler_t *handler = &mem_sys->io_handlers[offset];
+
+	if (handler->write == NULL) {
+		mem_sys->high_page[offset] = value;
+		return;
+	}
+
+	handler->write(mem_sys, handler->context, addr, value);
+}
+
+/*
+ * Index into cow_shared of a WRAM or cartridge RAM page that a fork still
+ * shares with its snapshot, or -1. source receives the snapshot's copy.
+ */
+static int memory_cow_index(const memory_system_t *mem_sys, const byte *page,
+			    byte **source)
+{
+	memory_snapshot_t *snapshot = mem_sys->snapshot;
+	int index = -1;
+
+	if (mem_sys->cow_shared == NULL || page == NULL) {
 		return -1;
 	}
 
-	if (addr >= ROM_START && addr <= ROM_END) {
-		return addr - ROM_START;
+	if (page >= mem_sys->wram && page < mem_sys->wram + WRAM_SIZE) {
+		size_t offset = (size_t)(page - mem_sys->wram);
+
+		index = (int)(offset / MEMORY_PAGE_SIZE);
+		*source = snapshot->wram + offset;
+	} else if (mem_sys->eram != NULL && page >= mem_sys->eram &&
+		   page < mem_sys->eram + mem_sys->eram_size) {
+		size_t offset = (size_t)(page - mem_sys->eram);
+
+		index = MEMORY_WRAM_PAGES + (int)(offset / MEMORY_PAGE_SIZE);
+		*source = snapshot->eram + offset;
 	}
 
-	if (addr >= VRAM_START && addr <= VRAM_END) {
-		return addr - VRAM_START;
+	if (index < 0 || !mem_sys->cow_shared[index]) {
+		return -1;
 	}
 
-	if (addr >= WRAM_START && addr <= WRAM_END) {
-		return addr - WRAM_START;
+	return index;
+}
+
+static void memory_cow_copy(memory_system_t *mem_sys, byte *page)
+{
+	byte *source;
+	int index = memory_cow_index(mem_sys, page, &source);
+
+	if (index < 0) {
+		return;
 	}
 
-	
-	return -1;
+	memcpy(page, source, MEMORY_PAGE_SIZE);
+	mem_sys->cow_shared[index] = false;
+
+	/* Echo RAM aliases switch over together with their WRAM page */
+	for (int alias = 0; alias < MEMORY_PAGE_COUNT; alias++) {
+		if (mem_sys->read_map[alias] == source) {
+			mem_sys->read_map[alias] = page;
+			memory_untrap_page(mem_sys, alias, MEMORY_TRAP_COW);
+		} else if ((mem_sys->page_traps[alias] & MEMORY_TRAP_READS) &&
+			   mem_sys->trap_read_map[alias] == source) {
+			mem_sys->trap_read_map[alias] = page;
+			memory_untrap_page(mem_sys, alias, MEMORY_TRAP_COW);
+		}
+	}
 }
 
-byte memory_read_byte(memory_system_t *mem_sys, address addr)
+void memory_map_direct(memory_system_t *mem_sys, address start, address end,
+		       byte *read, byte *write)
 {
-	assert(mem_sys != NULL);
+	for (int page = MEMORY_PAGE(start); page <= MEMORY_PAGE(end); page++) {
+		size_t offset = (size_t)(page - MEMORY_PAGE(start)) *
+				MEMORY_PAGE_SIZE;
+		byte *read_page = read != NULL ? read + offset : NULL;
+		byte *write_page = write != NULL ? write + offset : NULL;
+		byte *source;
+
+		/* Shared RAM is read from the snapshot until first written */
+		if (read_page == write_page &&
+		    memory_cow_index(mem_sys, write_page, &source) >= 0) {
+			read_page = source;
+			memory_trap_page(mem_sys, page, MEMORY_TRAP_COW);
+		} else {
+			memory_untrap_page(mem_sys, page, MEMORY_TRAP_COW);
+		}
 
-	int offset = memory_calculate_offset(addr);
-	if (offset < 0) {
-		return 0xFF;
+		if (mem_sys->page_traps[page] & MEMORY_TRAP_READS) {
+			mem_sys->trap_read_map[page] = read_page;
+		} else {
+			mem_sys->read_map[page] = read_page;
+		}
+
+		/* Trapped pages keep trapping; the new target is parked */
+		if (mem_sys->page_traps[page] != 0) {
+			mem_sys->trap_write_map[page] = write_page;
+		} else {
+			mem_sys->write_map[page] = write_page;
+		}
 	}
-	
-	byte result;
-	if (addr >= ROM_START && addr <= ROM_END) {
-		result = mem_sys->rom[offset];
+}
+
+void memory_map_handlers(memory_system_t *mem_sys, address start, address end,
+			 memory_read_handler_t read_handler,
+			 memory_write_handler_t write_handler)
+{
+	for (int page = MEMORY_PAGE(start); page <= MEMORY_PAGE(end); page++) {
+		memory_untrap_page(mem_sys, page, MEMORY_TRAP_COW);
+		if (mem_sys->page_traps[page] & MEMORY_TRAP_READS) {
+			mem_sys->trap_read_map[page] = NULL;
+			mem_sys->trap_read_handlers[page] = read_handler;
+		} else {
+			mem_sys->read_map[page] = NULL;
+			mem_sys->read_handlers[page] = read_handler;
+		}
+
+		if (mem_sys->page_traps[page] != 0) {
+			mem_sys->trap_write_map[page] = NULL;
+			mem_sys->trap_write_handlers[page] = write_handler;
+		} else {
+			mem_sys->write_map[page] = NULL;
+			mem_sys->write_handlers[page] = write_handler;
+		}
 	}
-	else if (addr >= VRAM_START && addr <= VRAM_END) {
-		result = mem_sys->vram[offset];
+}
+
+/* Echo RAM pages share their code version with the WRAM page they alias */
+static int memory_code_page(int page)
+{
+	if (page >= MEMORY_PAGE(ECHO_RAM_START) &&
+	    page <= MEMORY_PAGE(ECHO_RAM_END)) {
+		return page - MEMORY_PAGE(ECHO_RAM_START - WRAM_START);
 	}
-	else if (addr >= WRAM_START && addr <= WRAM_END) {
-		result = mem_sys->wram[offset];
+
+	return page;
+}
+
+static int memory_echo_page(int page)
+{
+	int echo = page + MEMORY_PAGE(ECHO_RAM_START - WRAM_START);
+
+	if (page < MEMORY_PAGE(WRAM_START) || echo > MEMORY_PAGE(ECHO_RAM_END)) {
+		return -1;
 	}
-	
-	return result;
+
+	return echo;
 }
 
-void memory_write_byte(memory_system_t *mem_sys, address addr, byte value)
+/* Retires translations of a code page and stops watching it */
+static void memory_code_changed(memory_system_t *mem_sys, int code_page)
 {
-	assert(mem_sys != NULL);
+	int echo_page = memory_echo_page(code_page);
+
+	mem_sys->code_versions[code_page]++;
+	memory_untrap_page(mem_sys, code_page, MEMORY_TRAP_CODE);
+	if (echo_page >= 0) {
+		memory_untrap_page(mem_sys, echo_page, MEMORY_TRAP_CODE);
+	}
+}
 
-	int offset = memory_calculate_offset(addr);
-	if (offset < 0) {
+static byte memory_trap_read(memory_system_t *mem_sys, address addr)
+{
+	int page = MEMORY_PAGE(addr);
+	const byte *target = mem_sys->trap_read_map[page];
+	byte value;
+
+	/* The bus belongs to the DMA, so reads see whatever it says */
+	if (mem_sys->page_traps[page] & MEMORY_TRAP_LOCK) {
+		const memory_io_handler_t *handler = &mem_sys->lock_handler;
+
+		value = handler->read(mem_sys, handler->context, addr);
+	} else if (target != NULL) {
+		value = target[MEMORY_PAGE_OFFSET(addr)];
+	} else {
+		value = mem_sys->trap_read_handlers[page](mem_sys, addr);
+	}
+
+	if (mem_sys->page_traps[page] & MEMORY_TRAP_WATCH) {
+		memory_watch_check(mem_sys, addr, MEMORY_WATCH_READ, value);
+	}
+	return value;
+}
+
+static void memory_trap_write(memory_system_t *mem_sys, address addr,
+			      byte value)
+{
+	int page = MEMORY_PAGE(addr);
+
+	if (mem_sys->page_traps[page] & MEMORY_TRAP_WATCH) {
+		memory_watch_check(mem_sys, addr, MEMORY_WATCH_WRITE, value);
+	}
+
+	/* The bus belongs to the DMA, so the write never arrives */
+	if (mem_sys->page_traps[page] & MEMORY_TRAP_LOCK) {
 		return;
 	}
 
-	if (addr >= ROM_START && addr <= ROM_END) {
-		printf("ERROR: tried writing to ROM address");
-		return; 
+	if (mem_sys->page_traps[page] & MEMORY_TRAP_COW) {
+		memory_cow_copy(mem_sys, mem_sys->trap_write_map[page]);
 	}
 
-	if (addr >= VRAM_START && addr <= VRAM_END) {
-		mem_sys->vram[offset] = value;
+	if ((mem_sys->page_traps[page] & MEMORY_TRAP_CODE) &&
+	    (page != MEMORY_PAGE(HRAM_START) || addr >= HRAM_START)) {
+		memory_code_changed(mem_sys, memory_code_page(page));
 	}
 
-	else if (addr >= WRAM_START && addr <= WRAM_END) {
-		mem_sys->wram[offset] = value;
+	byte *target = mem_sys->page_traps[page] != 0 ?
+			       mem_sys->trap_write_map[page] :
+			       mem_sys->write_map[page];
+	if (target != NULL) {
+		target[MEMORY_PAGE_OFFSET(addr)] = value;
+		return;
 	}
+
+	memory_write_handler_t handler = mem_sys->page_traps[page] != 0 ?
+						 mem_sys->trap_write_handlers[page] :
+						 mem_sys->write_handlers[page];
+	handler(mem_sys, addr, value);
 }
 
-word memory_read_word(memory_system_t *mem_sys, address addr)
+void memory_trap_page(memory_system_t *mem_sys, int page, byte trap)
 {
-	byte low_byte = memory_read_byte(mem_sys, addr);
-	byte high_byte = memory_read_byte(mem_sys, addr + 1);
+	assert(mem_sys != NULL);
 
-	return low_byte | (high_byte << 8);
+	byte traps = mem_sys->page_traps[page];
+
+	if (traps == 0) {
+		mem_sys->trap_write_map[page] = mem_sys->write_map[page];
+		mem_sys->trap_write_handlers[page] = mem_sys->write_handlers[page];
+		mem_sys->write_map[page] = NULL;
+		mem_sys->write_handlers[page] = memory_trap_write;
+	}
+
+	if (!(traps & MEMORY_TRAP_READS) && (trap & MEMORY_TRAP_READS)) {
+		mem_sys->trap_read_map[page] = mem_sys->read_map[page];
+		mem_sys->trap_read_handlers[page] = mem_sys->read_handlers[page];
+		mem_sys->read_map[page] = NULL;
+		mem_sys->read_handlers[page] = memory_trap_read;
+	}
+
+	mem_sys->page_traps[page] |= trap;
 }
 
-void memory_write_word(memory_system_t *mem_sys, address addr, word value)
+void memory_untrap_page(memory_system_t *mem_sys, int page, byte trap)
 {
-	byte low_byte = value & 0xFF;
-	byte high_byte = (value >> 8) & 0xFF;
+	assert(mem_sys != NULL);
 
-	memory_write_byte(mem_sys, addr, low_byte);
-	memory_write_byte(mem_sys, addr + 1,  high_byte);
+	byte traps = mem_sys->page_traps[page];
+
+	if (traps == 0) {
+		return;
+	}
+
+	mem_sys->page_traps[page] &= (byte)~trap;
+	if ((traps & MEMORY_TRAP_READS) &&
+	    !(mem_sys->page_traps[page] & MEMORY_TRAP_READS)) {
+		mem_sys->read_map[page] = mem_sys->trap_read_map[page];
+		mem_sys->read_handlers[page] = mem_sys->trap_read_handlers[page];
+	}
+	if (mem_sys->page_traps[page] == 0) {
+		mem_sys->write_map[page] = mem_sys->trap_write_map[page];
+		mem_sys->write_handlers[page] = mem_sys->trap_write_handlers[page];
+	}
 }
 
-bool memory_is_valid_address(address addr)
+/**
+ * @brief Marks the page holding addr as containing translated code
+ *
+ * The next write to the page, or to its echo RAM alias, bumps its code
+ * version so cached translations of it can be discarded.
+ *
+ * @param mem_sys memory system the code lives in
+ * @param addr any address inside the page
+ */
+void memory_protect_code(memory_system_t *mem_sys, address addr)
 {
-	if (addr > 0xFFFF) {
-		return false;
+	int page = memory_code_page(MEMORY_PAGE(addr));
+	int echo_page = memory_echo_page(page);
+
+	memory_trap_page(mem_sys, page, MEMORY_TRAP_CODE);
+	if (echo_page >= 0) {
+		memory_trap_page(mem_sys, echo_page, MEMORY_TRAP_CODE);
 	}
-	
-	if (addr >= ROM_START && addr <= ROM_END) {
-		return true;
+}
+
+/**
+ * @brief Hands a range of pages over to a DMA transfer
+ *
+ * Until unlocked, writes to the pages are dropped and reads return
+ * whatever read gives, as when the CPU collides with DMA on a bus. Mapping
+ * changes made meanwhile are parked and take effect on unlocking.
+ *
+ * @param mem_sys memory system to lock
+ * @param start first address, rounded down to its page
+ * @param end last address, rounded up to its page
+ * @param read answers every read of a locked page
+ * @param context passed to read
+ */
+void memory_lock_pages(memory_system_t *mem_sys, address start, address end,
+		       memory_io_read_t read, void *context)
+{
+	assert(mem_sys != NULL && read != NULL);
+
+	mem_sys->lock_handler.read = read;
+	mem_sys->lock_handler.write = NULL;
+	mem_sys->lock_handler.context = context;
+
+	for (int page = MEMORY_PAGE(start); page <= MEMORY_PAGE(end); page++) {
+		memory_trap_page(mem_sys, page, MEMORY_TRAP_LOCK);
 	}
-	
-	if (addr >= VRAM_START && addr <= VRAM_END) {
-		return true;
+}
+
+void memory_unlock_pages(memory_system_t *mem_sys, address start, address end)
+{
+	assert(mem_sys != NULL);
+
+	for (int page = MEMORY_PAGE(start); page <= MEMORY_PAGE(end); page++) {
+		memory_untrap_page(mem_sys, page, MEMORY_TRAP_LOCK);
 	}
-	
-	if (addr >= WRAM_START && addr <= WRAM_END) {
-		return true;
+}
+
+/* Direct read target of a page as if it were not locked, or NULL */
+const byte *memory_unlocked_page(const memory_system_t *mem_sys, int page)
+{
+	assert(mem_sys != NULL);
+
+	if (mem_sys->page_traps[page] & MEMORY_TRAP_LOCK) {
+		return mem_sys->trap_read_map[page];
 	}
 
-	return false;
+	return mem_sys->read_map[page];
 }
 
-const char *memory_get_region_name(address addr)
+/* Reads a byte the way the bus would without any lock, for the DMA itself */
+byte memory_read_unlocked(memory_system_t *mem_sys, address addr)
 {
-	if (addr >= ROM_START && addr <= ROM_END) {
-		return "ROM";
+	assert(mem_sys != NULL);
+
+	int page = MEMORY_PAGE(addr);
+
+	if (!(mem_sys->page_traps[page] & MEMORY_TRAP_LOCK)) {
+		return memory_read_byte(mem_sys, addr);
 	}
-    
-	if (addr >= VRAM_START && addr <= VRAM_END) {
-		return "VRAM";
+
+	const byte *base = mem_sys->trap_read_map[page];
+	if (base != NULL) {
+		return base[MEMORY_PAGE_OFFSET(addr)];
 	}
-    
-	if (addr >= WRAM_START && addr <= WRAM_END) {
-    	    return "WRAM";
-    	}
-    	
-    	if (addr > 0xFFFF) {
-    	    return "Invalid";
-    	}
-    	
-    	return "Unmapped";
+
+	return mem_sys->trap_read_handlers[page](mem_sys, addr);
 }
 
-void memory_dump_region(memory_system_t *mem_sys, address start, address end)
+/**
+ * @brief Gives a fork private copies of every page it still shares
+ *
+ * @param mem_sys memory system, forked or not
+ */
+void memory_unshare(memory_system_t *mem_sys)
 {
-	if (mem_sys == NULL) {
-    	    printf("Error: Cannot dump memory with NULL memory system\n");
-    	    return;
-    	}
-    	
-    	if (start > end) {
-    	    printf("Error: Start address (0x%04X) > end address (0x%04X)\n", start, end);
-    	    return;
-    	}
-    	
-    	printf("Memory dump from 0x%04X to 0x%04X (%s):\n", 
-    	       start, end, memory_get_region_name(start));
-    	printf("Address  : 00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F | ASCII\n");
-    	printf("---------|------------------------------------------------|----------------\n");
-    	
-    	for (address addr = start; addr <= end; addr += 16) {
-    	    printf("0x%04X : ", addr);
-    	    
-    	    for (int offset = 0; offset < 16 && (addr + offset) <= end; offset++) {
-    	        byte value = memory_read_byte(mem_sys, addr + offset);
-    	        printf("%02X ", value);
-    	    }
-    	    
-    	    int bytes_in_row = (end >= addr + 15) ? 16 : (end - addr + 1);
-    	    for (int i = bytes_in_row; i < 16; i++) {
-    	        printf("   ");
-    	    }
-    	    
-    	    printf("| ");
-    	    
-    	    for (int offset = 0; offset < 16 && (addr + offset) <= end; offset++) {
-    	        byte value = memory_read_byte(mem_sys, addr + offset);
-    	        if (value >= 32 && value <= 126) {
-    	            printf("%c", value);
-    	        } else {
-    	            printf(".");
-    	        }
-    	    }
-    	    
-    	    printf("\n");
-    	}
-    	printf("\n");
-}
-
-/**
- * @brief [TODO:description]
- *
- * @param mem_sys [TODO:parameter]
- * @param filename [TODO:parameter]
- * @return [TODO:return]
+	assert(mem_sys != NULL);
+
+	if (mem_sys->cow_shared == NULL) {
+		return;
+	}
+
+	for (size_t offset = 0; offset < WRAM_SIZE; offset += MEMORY_PAGE_SIZE) {
+		memory_cow_copy(mem_sys, mem_sys->wram + offset);
+	}
+	for (size_t offset = 0; offset < mem_sys->eram_size;
+	     offset += MEMORY_PAGE_SIZE) {
+		memory_cow_copy(mem_sys, mem_sys->eram + offset);
+	}
+}
+
+/**
+ * @brief Finds where a page of WRAM or cartridge RAM currently lives
+ *
+ * Pages a fork has not written yet are still in its snapshot.
+ *
+ * @param mem_sys memory system owning the RAM
+ * @param page page-aligned address inside wram or eram
+ * @return the page itself or the snapshot's copy of it
  */
-bool memory_load_rom(memory_system_t *mem_sys, const char *filename)
+const byte *memory_backing_page(const memory_system_t *mem_sys,
+				const byte *page)
 {
-	if (mem_sys == NULL || filename == NULL) {
-		printf("ERROR: INVALID PARAMETERS FOR LOADING ROM");
-		return false;
+	assert(mem_sys != NULL);
+
+	byte *source;
+
+	if (memory_cow_index(mem_sys, page, &source) < 0) {
+		return page;
 	}
 
-	FILE *rom_file = fopen(filename, "rb");
-	if (rom_file == NULL) {
-		printf("ERROR: COULD NOT READ ROM FILE '%s' \n", filename);
-		return false;
+	return source;
+}
+
+/**
+ * @brief Copies out WRAM or cartridge RAM without unsharing any of it
+ *
+ * @param mem_sys memory system owning the RAM
+ * @param backing start of a page-aligned range inside wram or eram
+ * @param out destination
+ * @param size bytes to copy, a multiple of MEMORY_PAGE_SIZE
+ */
+void memory_read_backing(const memory_system_t *mem_sys, const byte *backing,
+			 byte *out, size_t size)
+{
+	assert(mem_sys != NULL && size % MEMORY_PAGE_SIZE == 0);
+
+	for (size_t offset = 0; offset < size; offset += MEMORY_PAGE_SIZE) {
+		memcpy(out + offset, memory_backing_page(mem_sys, backing + offset),
+		       MEMORY_PAGE_SIZE);
 	}
-	
-	size_t bytes_read = fread(mem_sys->rom, 1, ROM_SIZE, rom_file);
-	fclose(rom_file);
+}
 
-	if (bytes_read == 0) {
-		printf("ERROR: FAILED TO READ ROM DATA");
+static void memory_build_page_table(memory_system_t *mem_sys)
+{
+	memset(mem_sys->page_traps, 0, sizeof(mem_sys->page_traps));
+	memset(mem_sys->code_versions, 0, sizeof(mem_sys->code_versions));
+
+	memory_map_handlers(mem_sys, 0x0000, 0xFFFF, memory_unmapped_read,
+			    memory_unmapped_write);
+
+	/* ROM writes are MBC register writes; banks are mapped by the MBC */
+	memory_map_handlers(mem_sys, ROM_START, ROM_END, memory_empty_rom_read,
+			    mbc_write);
+
+	/* Tile data reads stay direct; writes go through to mark the tile */
+	memory_map_handlers(mem_sys, VRAM_START, VRAM_TILE_DATA_END,
+			    memory_unmapped_read, memory_vram_tile_write);
+	memory_map_direct(mem_sys, VRAM_START, VRAM_TILE_DATA_END,
+			  mem_sys->vram, NULL);
+	memory_map_direct(mem_sys, VRAM_TILE_DATA_END + 1, VRAM_END,
+			  mem_sys->vram + (VRAM_TILE_DATA_END + 1 - VRAM_START),
+			  mem_sys->vram + (VRAM_TILE_DATA_END + 1 - VRAM_START));
+	memset(mem_sys->vram_tile_dirty, true, sizeof(mem_sys->vram_tile_dirty));
+
+	mbc_update_mapping(mem_sys);
+	memory_map_direct(mem_sys, WRAM_START, WRAM_END, mem_sys->wram,
+			  mem_sys->wram);
+
+	/* Echo RAM aliases the first 7.5 KiB of WRAM */
+	memory_map_direct(mem_sys, ECHO_RAM_START, ECHO_RAM_END, mem_sys->wram,
+			  mem_sys->wram);
+
+	memory_map_handlers(mem_sys, OAM_START, UNUSABLE_END, memory_oam_read,
+			    memory_oam_write);
+	memory_map_handlers(mem_sys, IO_REGISTERS_START, IE_REGISTER,
+			    memory_high_read, memory_high_write);
+
+	/* Watchpoints outlive the page table they were set on */
+	memory_watch_pages(mem_sys);
+}
+
+void memory_register_io(memory_system_t *mem_sys, address addr,
+			memory_io_read_t read, memory_io_write_t write,
+			void *context)
+{
+	assert(mem_sys != NULL);
+	assert(addr >= IO_REGISTERS_START);
+
+	memory_io_handler_t *handler =
+		&mem_sys->io_handlers[MEMORY_PAGE_OFFSET(addr)];
+	handler->read = read;
+	handler->write = write;
+	handler->context = context;
+}
+
+/**
+ * @brief Storage behind a high page address that no IO handler claims
+ *
+ * Such bytes behave as plain memory, so code that knows the address up
+ * front may access them directly. The page is never locked; writes still
+ * have to go through the bus while it is trapped.
+ *
+ * @param mem_sys memory system to look in
+ * @param addr address in 0xFF00-0xFFFF
+ * @param write true for the write direction, false for reads
+ * @return the byte in high_page, or NULL if a handler is registered
+ */
+byte *memory_plain_io(memory_system_t *mem_sys, address addr, bool write)
+{
+	assert(mem_sys != NULL);
+	assert(addr >= IO_REGISTERS_START);
+
+	const memory_io_handler_t *handler =
+		&mem_sys->io_handlers[MEMORY_PAGE_OFFSET(addr)];
+
+	bool claimed = write ? handler->write != NULL : handler->read != NULL;
+
+	if (claimed) {
+		return NULL;
+	}
+
+	return &mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)];
+}
+
+static void memory_free_rom(byte *rom, size_t rom_size, bool mapped)
+{
+	if (rom == NULL) {
+		return;
+	}
+
+#ifdef MEMORY_HAVE_MMAP
+	if (mapped) {
+		munmap(rom, rom_size);
+		return;
+	}
+#else
+	UNUSED(rom_size);
+	UNUSED(mapped);
+#endif
+
+	free(rom);
+}
+
+static void memory_release_cartridge(memory_system_t *mem_sys)
+{
+	if (mem_sys->snapshot != NULL) {
+		/* Keep what the CPU sees; the snapshot may be gone after this */
+		memory_unshare(mem_sys);
+		memory_snapshot_release(mem_sys->snapshot);
+	} else {
+		memory_free_rom(mem_sys->rom, mem_sys->rom_size,
+				mem_sys->rom_mapped);
+	}
+	free(mem_sys->cow_shared);
+	free(mem_sys->eram);
+
+	mem_sys->snapshot = NULL;
+	mem_sys->cow_shared = NULL;
+	mem_sys->rom = NULL;
+	mem_sys->rom_size = 0;
+	mem_sys->rom_mapped = false;
+	mem_sys->rom_hash = 0;
+	mem_sys->eram = NULL;
+	mem_sys->eram_size = 0;
+	mbc_init(&mem_sys->mbc, 0x00, 0, 0);
+}
+
+bool memory_init(memory_system_t *mem_sys)
+{
+	if (mem_sys == NULL) {
+		printf("Cannot initialize NULL memory system"); 
 		return false;
 	}
-	
+
+	mem_sys->snapshot = NULL;
+	mem_sys->cow_shared = NULL;
+	mem_sys->rom = NULL;
+	mem_sys->rom_size = 0;
+	mem_sys->rom_mapped = false;
+	mem_sys->rom_hash = 0;
+	mem_sys->eram = NULL;
+	mem_sys->eram_size = 0;
+	mem_sys->rom_mapping_version = 0;
+	mbc_init(&mem_sys->mbc, 0x00, 0, 0);
+
+	memset(mem_sys->vram, 0x00, VRAM_SIZE);
+	memset(mem_sys->wram, 0x00, WRAM_SIZE);
+	memset(mem_sys->oam, 0x00, OAM_SIZE);
+	memset(mem_sys->high_page, 0x00, MEMORY_PAGE_SIZE);
+	memset(mem_sys->io_handlers, 0, sizeof(mem_sys->io_handlers));
+
+	mem_sys->watch_count = 0;
+	mem_sys->watch_hit_pending = false;
+
+	mem_sys->rom_loaded = false;
+	memory_build_page_table(mem_sys);
+	memory_trace_reset(mem_sys);
+
+	return true;
+}
+
+void memory_cleanup(memory_system_t *mem_sys)
+{
+	if (mem_sys == NULL) {
+		printf("ERROR: CANNOT CLEANUP NULL MEMORY SYSTEM"); 
+		return;
+	}
+
+	memory_release_cartridge(mem_sys);
+
+	memset(mem_sys->vram, 0x00, VRAM_SIZE);
+	memset(mem_sys->wram, 0x00, WRAM_SIZE);
+	memset(mem_sys->oam, 0x00, OAM_SIZE);
+	memset(mem_sys->high_page, 0x00, MEMORY_PAGE_SIZE);
+
+	mem_sys->rom_loaded = false;
+	memory_build_page_table(mem_sys);
+}
+
+word memory_read_word(memory_system_t *mem_sys, address addr)
+{
+	byte low_byte = memory_read_byte(mem_sys, addr);
+	byte high_byte = memory_read_byte(mem_sys, addr + 1);
+
+	return low_byte | (high_byte << 8);
+}
+
+void memory_write_word(memory_system_t *mem_sys, address addr, word value)
+{
+	byte low_byte = value & 0xFF;
+	byte high_byte = (value >> 8) & 0xFF;
+
+	memory_write_byte(mem_sys, addr, low_byte);
+	memory_write_byte(mem_sys, addr + 1,  high_byte);
+}
+
+/**
+ * @brief Copies a range of the address space out the way the bus reads it
+ *
+ * Directly mapped pages are copied with one memcpy() for as long as their
+ * backing storage stays contiguous, so a whole WRAM or ROM bank is a
+ * single copy; pages behind a handler are read a byte at a time. The
+ * range wraps at 0xFFFF like the bus.
+ *
+ * @param mem_sys memory system to read
+ * @param start first address
+ * @param out destination of size bytes
+ * @param size bytes to read, at most MEMORY_SIZE
+ */
+void memory_read_block(memory_system_t *mem_sys, address start, byte *out,
+		       size_t size)
+{
+	assert(mem_sys != NULL && out != NULL && size <= MEMORY_SIZE);
+
+#ifdef MEMORY_TRACE
+	for (size_t i = 0; i < size; i++) {
+		MEMORY_TRACE_READ(mem_sys, (address)(start + i));
+	}
+#endif
+
+	size_t done = 0;
+
+	while (done < size) {
+		address addr = (address)(start + done);
+		int page = MEMORY_PAGE(addr);
+		const byte *base = mem_sys->read_map[page];
+		size_t run = MIN((size_t)(MEMORY_PAGE_SIZE - MEMORY_PAGE_OFFSET(addr)),
+				 size - done);
+
+		if (base == NULL) {
+			for (size_t i = 0; i < run; i++) {
+				out[done + i] = mem_sys->read_handlers[page](
+					mem_sys, (address)(addr + i));
+			}
+			done += run;
+			continue;
+		}
+
+		while (done + run < size && page + 1 < MEMORY_PAGE_COUNT &&
+		       mem_sys->read_map[page + 1] ==
+			       mem_sys->read_map[page] + MEMORY_PAGE_SIZE) {
+			page++;
+			run += MIN((size_t)MEMORY_PAGE_SIZE, size - done - run);
+		}
+
+		memcpy(out + done, base + MEMORY_PAGE_OFFSET(addr), run);
+		done += run;
+	}
+}
+
+/**
+ * @brief Writes a range of the address space the way the bus would
+ *
+ * The write-side twin of memory_read_block(): contiguous directly
+ * writable pages take one memcpy(), everything else (ROM, VRAM, shared or
+ * trapped pages) goes through the page's handler byte by byte.
+ *
+ * @param mem_sys memory system to write
+ * @param start first address
+ * @param data size bytes to write
+ * @param size bytes to write, at most MEMORY_SIZE
+ */
+void memory_write_block(memory_system_t *mem_sys, address start,
+			const byte *data, size_t size)
+{
+	assert(mem_sys != NULL && data != NULL && size <= MEMORY_SIZE);
+
+#ifdef MEMORY_TRACE
+	for (size_t i = 0; i < size; i++) {
+		MEMORY_TRACE_WRITE(mem_sys, (address)(start + i));
+	}
+#endif
+
+	size_t done = 0;
+
+	while (done < size) {
+		address addr = (address)(start + done);
+		int page = MEMORY_PAGE(addr);
+		byte *base = mem_sys->write_map[page];
+		size_t run = MIN((size_t)(MEMORY_PAGE_SIZE - MEMORY_PAGE_OFFSET(addr)),
+				 size - done);
+
+		if (base == NULL) {
+			for (size_t i = 0; i < run; i++) {
+				mem_sys->write_handlers[page](
+					mem_sys, (address)(addr + i),
+					data[done + i]);
+			}
+			done += run;
+			continue;
+		}
+
+		while (done + run < size && page + 1 < MEMORY_PAGE_COUNT &&
+		       mem_sys->write_map[page + 1] ==
+			       mem_sys->write_map[page] + MEMORY_PAGE_SIZE) {
+			page++;
+			run += MIN((size_t)MEMORY_PAGE_SIZE, size - done - run);
+		}
+
+		memcpy(base + MEMORY_PAGE_OFFSET(addr), data + done, run);
+		done += run;
+	}
+}
+
+bool memory_is_valid_address(address addr)
+{
+	if (addr > 0xFFFF) {
+		return false;
+	}
+
+	if (addr >= UNUSABLE_START && addr <= UNUSABLE_END) {
+		return false;
+	}
+
+	return true;
+}
+
+const char *memory_get_region_name(address addr)
+{
+	if (addr >= ROM_START && addr <= ROM_END) {
+		return "ROM";
+	}
+    
+	if (addr >= VRAM_START && addr <= VRAM_END) {
+		return "VRAM";
+	}
+
+	if (addr >= ERAM_START && addr <= ERAM_END) {
+		return "ERAM";
+	}
+    
+	if (addr >= WRAM_START && addr <= WRAM_END) {
+		return "WRAM";
+	}
+
+	if (addr >= ECHO_RAM_START && addr <= ECHO_RAM_END) {
+		return "Echo RAM";
+	}
+
+	if (addr >= OAM_START && addr <= OAM_END) {
+		return "OAM";
+	}
+
+	if (addr >= IO_REGISTERS_START && addr <= IO_REGISTERS_END) {
+		return "IO";
+	}
+
+	if (addr >= HRAM_START && addr <= HRAM_END) {
+		return "HRAM";
+	}
+
+	if (addr == IE_REGISTER) {
+		return "IE";
+	}
+
+	return "Unmapped";
+}
+
+/* Hex and ASCII columns of one 16-byte row, padded when it is short */
+static size_t memory_format_row(char *out, address addr, const byte *row,
+				size_t count)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	char *p = out + sprintf(out, "0x%04X : ", addr);
+
+	for (size_t i = 0; i < MEMORY_DUMP_ROW; i++) {
+		if (i < count) {
+			*p++ = hex[row[i] >> 4];
+			*p++ = hex[row[i] & 0x0F];
+		} else {
+			*p++ = ' ';
+			*p++ = ' ';
+		}
+		*p++ = ' ';
+	}
+
+	*p++ = '|';
+	*p++ = ' ';
+	for (size_t i = 0; i < count; i++) {
+		*p++ = row[i] >= 32 && row[i] <= 126 ? (char)row[i] : '.';
+	}
+	*p++ = '\n';
+
+	return (size_t)(p - out);
+}
+
+/**
+ * @brief Prints a hex dump of start..end inclusive
+ *
+ * The range is read once with memory_read_block() and formatted into one
+ * buffer that goes to stdout in a single write.
+ *
+ * @param mem_sys memory system to read
+ * @param start first address
+ * @param end last address
+ */
+void memory_dump_region(memory_system_t *mem_sys, address start, address end)
+{
+	if (mem_sys == NULL) {
+		printf("Error: Cannot dump memory with NULL memory system\n");
+		return;
+	}
+
+	if (start > end) {
+		printf("Error: Start address (0x%04X) > end address (0x%04X)\n",
+		       start, end);
+		return;
+	}
+
+	size_t size = (size_t)end - start + 1;
+	size_t rows = (size + MEMORY_DUMP_ROW - 1) / MEMORY_DUMP_ROW;
+	byte *data = malloc(size);
+	char *text = malloc(MEMORY_DUMP_HEADER_SIZE + rows * MEMORY_DUMP_LINE_SIZE);
+
+	if (data == NULL || text == NULL) {
+		printf("ERROR: COULD NOT ALLOCATE MEMORY DUMP BUFFER\n");
+		free(data);
+		free(text);
+		return;
+	}
+
+	memory_read_block(mem_sys, start, data, size);
+
+	size_t length = (size_t)sprintf(
+		text,
+		"Memory dump from 0x%04X to 0x%04X (%s):\n"
+		"Address  : 00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F | ASCII\n"
+		"---------|------------------------------------------------|----------------\n",
+		start, end, memory_get_region_name(start));
+
+	for (size_t offset = 0; offset < size; offset += MEMORY_DUMP_ROW) {
+		length += memory_format_row(text + length,
+					    (address)(start + offset),
+					    data + offset,
+					    MIN(size - offset, (size_t)MEMORY_DUMP_ROW));
+	}
+	text[length++] = '\n';
+
+	fwrite(text, 1, length, stdout);
+	free(data);
+	free(text);
+}
+
+static size_t memory_round_rom_size(size_t size)
+{
+	size_t rounded = 2 * ROM_BANK_SIZE;
+
+	while (rounded < size) {
+		rounded *= 2;
+	}
+
+	return rounded;
+}
+
+/**
+ * @brief Takes ownership of a cartridge image and maps it through its MBC
+ *
+ * @param mem_sys memory system to attach the cartridge to
+ * @param rom cartridge image, at least rom_size bytes
+ * @param rom_size size of the image in bytes
+ * @param mapped true when rom is an mmap of the file rather than a malloc
+ * @return false if the cartridge cannot be used; rom stays owned by the caller
+ */
+static bool memory_attach_rom(memory_system_t *mem_sys, byte *rom,
+			      size_t rom_size, bool mapped)
+{
+	byte type = rom[CARTRIDGE_TYPE_ADDRESS];
+	size_t ram_size = mbc_ram_size(rom[CARTRIDGE_RAM_SIZE_ADDRESS]);
+
+	mbc_t mbc;
+	if (!mbc_init(&mbc, type, rom_size, ram_size)) {
+		return false;
+	}
+
+	byte *eram = NULL;
+	if (mbc.has_ram) {
+		eram = malloc(MAX(ram_size, RAM_BANK_SIZE));
+		if (eram == NULL) {
+			printf("ERROR: COULD NOT ALLOCATE CARTRIDGE RAM\n");
+			return false;
+		}
+		memset(eram, 0xFF, MAX(ram_size, RAM_BANK_SIZE));
+	}
+
+	memory_release_cartridge(mem_sys);
+	mem_sys->rom = rom;
+	mem_sys->rom_size = rom_size;
+	mem_sys->rom_mapped = mapped;
+	mem_sys->rom_hash = 0;
+	mem_sys->eram = eram;
+	mem_sys->eram_size = eram != NULL ? MAX(ram_size, RAM_BANK_SIZE) : 0;
+	mem_sys->mbc = mbc;
+	mbc_update_mapping(mem_sys);
+
+	mem_sys->rom_loaded = true;
+	return true;
+}
+
+/**
+ * @brief Identifies the loaded cartridge, for telling whose save state is whose
+ *
+ * The FNV-1a hash of the whole image is only worked out on first use, so
+ * loading a mapped ROM does not read every page of it.
+ *
+ * @param mem_sys memory system with a cartridge loaded
+ * @return hash of the cartridge image, never 0
+ */
+uint64_t memory_rom_hash(memory_system_t *mem_sys)
+{
+	assert(mem_sys != NULL);
+
+	if (mem_sys->rom_hash != 0) {
+		return mem_sys->rom_hash;
+	}
+
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (size_t i = 0; i < mem_sys->rom_size; i++) {
+		hash ^= mem_sys->rom[i];
+		hash *= 0x100000001B3ULL;
+	}
+
+	mem_sys->rom_hash = hash != 0 ? hash : 1;
+	return mem_sys->rom_hash;
+}
+
+/**
+ * @brief Loads a whole cartridge image and sets up its memory bank controller
+ *
+ * @param mem_sys memory system to load into
+ * @param filename path of the .gb file
+ * @return true when the cartridge is mapped and ready to run
+ */
+bool memory_load_rom(memory_system_t *mem_sys, const char *filename)
+{
+	if (mem_sys == NULL || filename == NULL) {
+		printf("ERROR: INVALID PARAMETERS FOR LOADING ROM");
+		return false;
+	}
+
+	FILE *rom_file = fopen(filename, "rb");
+	if (rom_file == NULL) {
+		printf("ERROR: COULD NOT READ ROM FILE '%s' \n", filename);
+		return false;
+	}
+
+	long file_size = -1;
+	if (fseek(rom_file, 0, SEEK_END) == 0) {
+		file_size = ftell(rom_file);
+		rewind(rom_file);
+	}
+
+	if (file_size <= 0) {
+		fclose(rom_file);
+		printf("ERROR: FAILED TO READ ROM DATA");
+		return false;
+	}
+
+	/* Pad short or oddly sized images up to a whole power-of-two bank count */
+	size_t rom_size = memory_round_rom_size((size_t)file_size);
+	byte *rom = malloc(rom_size);
+	if (rom == NULL) {
+		fclose(rom_file);
+		printf("ERROR: COULD NOT ALLOCATE ROM\n");
+		return false;
+	}
+	memset(rom, 0xFF, rom_size);
+
+	size_t bytes_read = fread(rom, 1, (size_t)file_size, rom_file);
+	fclose(rom_file);
+
+	if (bytes_read == 0) {
+		free(rom);
+		printf("ERROR: FAILED TO READ ROM DATA");
+		return false;
+	}
+
+	if (bytes_read <= CARTRIDGE_HEADER_END) {
+		memset(rom + CARTRIDGE_TYPE_ADDRESS, 0x00,
+		       CARTRIDGE_HEADER_END - CARTRIDGE_TYPE_ADDRESS + 1);
+	}
+
+	if (!memory_attach_rom(mem_sys, rom, rom_size, false)) {
+		free(rom);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Loads a cartridge image that is already in memory
+ *
+ * @param mem_sys memory system to load into
+ * @param data cartridge image, copied so the caller keeps ownership
+ * @param size size of the image in bytes
+ * @return true when the cartridge is mapped and ready to run
+ */
+bool memory_load_rom_data(memory_system_t *mem_sys, const byte *data,
+			  size_t size)
+{
+	if (mem_sys == NULL || data == NULL || size == 0) {
+		printf("ERROR: INVALID PARAMETERS FOR LOADING ROM");
+		return false;
+	}
+
+	size_t rom_size = memory_round_rom_size(size);
+	byte *rom = malloc(rom_size);
+	if (rom == NULL) {
+		printf("ERROR: COULD NOT ALLOCATE ROM\n");
+		return false;
+	}
+	memset(rom, 0xFF, rom_size);
+	memcpy(rom, data, size);
+
+	if (size <= CARTRIDGE_HEADER_END) {
+		memset(rom + CARTRIDGE_TYPE_ADDRESS, 0x00,
+		       CARTRIDGE_HEADER_END - CARTRIDGE_TYPE_ADDRESS + 1);
+	}
+
+	if (!memory_attach_rom(mem_sys, rom, rom_size, false)) {
+		free(rom);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Maps a cartridge file read-only instead of reading it into memory
+ *
+ * Banks are served straight out of the mapping, so loading costs the same
+ * for any cartridge size, pages are only faulted in when a bank is touched
+ * and instances running the same file share physical memory. Images whose
+ * size is not a whole power-of-two bank count need padding and go through
+ * memory_load_rom() instead.
+ *
+ * @param mem_sys memory system to load into
+ * @param filename path of the .gb file
+ * @return true when the cartridge is mapped and ready to run
+ */
+bool memory_load_rom_mapped(memory_system_t *mem_sys, const char *filename)
+{
+	if (mem_sys == NULL || filename == NULL) {
+		printf("ERROR: INVALID PARAMETERS FOR LOADING ROM");
+		return false;
+	}
+
+#ifdef MEMORY_HAVE_MMAP
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		printf("ERROR: COULD NOT READ ROM FILE '%s' \n", filename);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		printf("ERROR: COULD NOT READ ROM FILE '%s' \n", filename);
+		return false;
+	}
+
+	size_t rom_size = (size_t)info.st_size;
+	if (rom_size != memory_round_rom_size(rom_size)) {
+		close(fd);
+		return memory_load_rom(mem_sys, filename);
+	}
+
+	void *mapping = mmap(NULL, rom_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return memory_load_rom(mem_sys, filename);
+	}
+
+	if (!memory_attach_rom(mem_sys, mapping, rom_size, true)) {
+		munmap(mapping, rom_size);
+		return false;
+	}
+
+	return true;
+#else
+	return memory_load_rom(mem_sys, filename);
+#endif
+}
+
+/**
+ * @brief Allocates a memory state sized for the memory system's cartridge
+ *
+ * @param state state to initialize
+ * @param mem_sys memory system the state will be saved from
+ * @return false if the cartridge RAM copy cannot be allocated
+ */
+bool memory_state_init(memory_state_t *state, const memory_system_t *mem_sys)
+{
+	if (state == NULL || mem_sys == NULL) {
+		printf("Cannot initialize memory state\n");
+		return false;
+	}
+
+	state->eram_size = mem_sys->eram_size;
+	state->eram = NULL;
+	if (state->eram_size > 0) {
+		state->eram = malloc(state->eram_size);
+		if (state->eram == NULL) {
+			printf("ERROR: COULD NOT ALLOCATE MEMORY STATE\n");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void memory_state_cleanup(memory_state_t *state)
+{
+	if (state == NULL) {
+		return;
+	}
+
+	free(state->eram);
+	state->eram = NULL;
+	state->eram_size = 0;
+}
+
+/**
+ * @brief Copies out everything the machine can change, with no allocation
+ *
+ * A fork stops sharing its RAM here, since restoring will write all of it.
+ *
+ * @param mem_sys memory system to save
+ * @param state state made by memory_state_init() for this memory system
+ */
+void memory_save_state(memory_system_t *mem_sys, memory_state_t *state)
+{
+	assert(mem_sys != NULL && state != NULL);
+	assert(state->eram_size == mem_sys->eram_size);
+
+	memory_unshare(mem_sys);
+
+	state->mbc = mem_sys->mbc;
+	memcpy(state->vram, mem_sys->vram, VRAM_SIZE);
+	memcpy(state->vram_tile_dirty, mem_sys->vram_tile_dirty,
+	       sizeof(state->vram_tile_dirty));
+	memcpy(state->wram, mem_sys->wram, WRAM_SIZE);
+	memcpy(state->oam, mem_sys->oam, OAM_SIZE);
+	memcpy(state->high_page, mem_sys->high_page, MEMORY_PAGE_SIZE);
+	if (state->eram_size > 0) {
+		memcpy(state->eram, mem_sys->eram, state->eram_size);
+	}
+}
+
+/*
+ * Bytes of a page a state copy holds, where writes retire translated code;
+ * NULL for cartridge RAM, whose banks are not tracked per page.
+ */
+static const byte *memory_code_bytes(const byte *vram, const byte *wram,
+				     const byte *oam, const byte *high_page,
+				     int page, size_t *size)
+{
+	address addr = (address)(page * MEMORY_PAGE_SIZE);
+
+	*size = MEMORY_PAGE_SIZE;
+	if (addr >= VRAM_START && addr <= VRAM_END) {
+		return vram + (addr - VRAM_START);
+	}
+	if (addr >= WRAM_START && addr <= WRAM_END) {
+		return wram + (addr - WRAM_START);
+	}
+	if (addr == OAM_START) {
+		*size = OAM_SIZE;
+		return oam;
+	}
+	if (addr == IO_REGISTERS_START) {
+		*size = MEMORY_PAGE_SIZE - MEMORY_PAGE_OFFSET(HRAM_START);
+		return high_page + MEMORY_PAGE_OFFSET(HRAM_START);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Puts back a state saved from this memory system
+ *
+ * The page tables stay as they are apart from the MBC's banks. Code pages
+ * whose bytes change count as written, so only their translations are
+ * dropped rather than the whole block cache.
+ *
+ * @param mem_sys memory system the state was saved from
+ * @param state state to restore
+ */
+void memory_restore_state(memory_system_t *mem_sys,
+			  const memory_state_t *state)
+{
+	assert(mem_sys != NULL && state != NULL);
+	assert(state->eram_size == mem_sys->eram_size);
+
+	memory_unshare(mem_sys);
+
+	for (int page = MEMORY_PAGE(VRAM_START); page < MEMORY_PAGE_COUNT;
+	     page++) {
+		if (!(mem_sys->page_traps[page] & MEMORY_TRAP_CODE) ||
+		    memory_code_page(page) != page) {
+			continue;
+		}
+
+		size_t size;
+		const byte *current = memory_code_bytes(mem_sys->vram,
+							mem_sys->wram,
+							mem_sys->oam,
+							mem_sys->high_page,
+							page, &size);
+		const byte *saved = memory_code_bytes(state->vram, state->wram,
+						      state->oam,
+						      state->high_page, page,
+						      &size);
+		if (current == NULL || memcmp(current, saved, size) != 0) {
+			memory_code_changed(mem_sys, page);
+		}
+	}
+
+	mem_sys->mbc = state->mbc;
+	memcpy(mem_sys->vram, state->vram, VRAM_SIZE);
+	memcpy(mem_sys->vram_tile_dirty, state->vram_tile_dirty,
+	       sizeof(mem_sys->vram_tile_dirty));
+	memcpy(mem_sys->wram, state->wram, WRAM_SIZE);
+	memcpy(mem_sys->oam, state->oam, OAM_SIZE);
+	memcpy(mem_sys->high_page, state->high_page, MEMORY_PAGE_SIZE);
+	if (state->eram_size > 0) {
+		memcpy(mem_sys->eram, state->eram, state->eram_size);
+	}
+
+	mbc_update_mapping(mem_sys);
+}
+
+static memory_snapshot_t *memory_snapshot_retain(memory_snapshot_t *snapshot)
+{
+	atomic_fetch_add(&snapshot->references, 1);
+	return snapshot;
+}
+
+/**
+ * @brief Freezes the current RAM and registers so forks can start from them
+ *
+ * The snapshot takes over the cartridge ROM, which the memory system keeps
+ * using, so a big ROM is never copied no matter how many forks are made.
+ *
+ * @param mem_sys memory system with a cartridge loaded
+ * @return snapshot holding one reference for the caller, or NULL
+ */
+memory_snapshot_t *memory_snapshot_create(memory_system_t *mem_sys)
+{
+	assert(mem_sys != NULL);
+
+	if (!mem_sys->rom_loaded) {
+		printf("ERROR: NO CARTRIDGE TO SNAPSHOT\n");
+		return NULL;
+	}
+
+	memory_snapshot_t *snapshot = malloc(sizeof(memory_snapshot_t));
+	byte *eram = mem_sys->eram_size > 0 ? malloc(mem_sys->eram_size) : NULL;
+	if (snapshot == NULL || (mem_sys->eram_size > 0 && eram == NULL)) {
+		printf("ERROR: COULD NOT ALLOCATE SNAPSHOT\n");
+		free(snapshot);
+		free(eram);
+		return NULL;
+	}
+
+	atomic_init(&snapshot->references, 1);
+	snapshot->mbc = mem_sys->mbc;
+	memcpy(snapshot->vram, mem_sys->vram, VRAM_SIZE);
+	memory_read_backing(mem_sys, mem_sys->wram, snapshot->wram, WRAM_SIZE);
+	memcpy(snapshot->oam, mem_sys->oam, OAM_SIZE);
+	memcpy(snapshot->high_page, mem_sys->high_page, MEMORY_PAGE_SIZE);
+	snapshot->eram = eram;
+	snapshot->eram_size = mem_sys->eram_size;
+	if (eram != NULL) {
+		memory_read_backing(mem_sys, mem_sys->eram, eram,
+				    mem_sys->eram_size);
+	}
+
+	snapshot->rom = mem_sys->rom;
+	snapshot->rom_size = mem_sys->rom_size;
+	snapshot->rom_hash = mem_sys->rom_hash;
+	if (mem_sys->snapshot != NULL) {
+		/* The ROM is already borrowed; keep its owner alive instead */
+		snapshot->rom_mapped = false;
+		snapshot->rom_owner = memory_snapshot_retain(mem_sys->snapshot);
+	} else {
+		snapshot->rom_mapped = mem_sys->rom_mapped;
+		snapshot->rom_owner = NULL;
+		mem_sys->snapshot = memory_snapshot_retain(snapshot);
+	}
+
+	return snapshot;
+}
+
+/**
+ * @brief Drops one reference, freeing the snapshot after the last one
+ *
+ * @param snapshot snapshot to release, may be NULL
+ */
+void memory_snapshot_release(memory_snapshot_t *snapshot)
+{
+	if (snapshot == NULL ||
+	    atomic_fetch_sub(&snapshot->references, 1) != 1) {
+		return;
+	}
+
+	if (snapshot->rom_owner != NULL) {
+		memory_snapshot_release(snapshot->rom_owner);
+	} else {
+		memory_free_rom(snapshot->rom, snapshot->rom_size,
+				snapshot->rom_mapped);
+	}
+	free(snapshot->eram);
+	free(snapshot);
+}
+
+/**
+ * @brief Turns an initialized memory system into a fork of a snapshot
+ *
+ * VRAM, OAM and the 0xFF00 page are copied since the PPU reads them
+ * directly. WRAM and cartridge RAM are shared page by page and only copied
+ * in when first written, and the ROM is shared outright.
+ *
+ * @param mem_sys memory system to fork into; its cartridge is released
+ * @param snapshot snapshot to fork from, which gains a reference
+ * @return false if the fork's bookkeeping cannot be allocated
+ */
+bool memory_fork(memory_system_t *mem_sys, memory_snapshot_t *snapshot)
+{
+	assert(mem_sys != NULL && snapshot != NULL);
+
+	size_t pages = MEMORY_WRAM_PAGES + snapshot->eram_size / MEMORY_PAGE_SIZE;
+	bool *shared = malloc(pages * sizeof(bool));
+	/* Left unwritten so untouched pages never become resident */
+	byte *eram = snapshot->eram_size > 0 ? malloc(snapshot->eram_size) : NULL;
+	if (shared == NULL || (snapshot->eram_size > 0 && eram == NULL)) {
+		printf("ERROR: COULD NOT ALLOCATE FORK\n");
+		free(shared);
+		free(eram);
+		return false;
+	}
+
+	memory_release_cartridge(mem_sys);
+	mem_sys->snapshot = memory_snapshot_retain(snapshot);
+	mem_sys->cow_shared = shared;
+	memset(shared, true, pages * sizeof(bool));
+
+	mem_sys->rom = snapshot->rom;
+	mem_sys->rom_size = snapshot->rom_size;
+	mem_sys->rom_mapped = false;
+	mem_sys->rom_hash = snapshot->rom_hash;
+	mem_sys->eram = eram;
+	mem_sys->eram_size = snapshot->eram_size;
+	mem_sys->mbc = snapshot->mbc;
+
+	memcpy(mem_sys->vram, snapshot->vram, VRAM_SIZE);
+	memcpy(mem_sys->oam, snapshot->oam, OAM_SIZE);
+	memcpy(mem_sys->high_page, snapshot->high_page, MEMORY_PAGE_SIZE);
+
 	mem_sys->rom_loaded = true;
-	printf("ROM LOADED SUCCESSFULLY");
+	memory_build_page_table(mem_sys);
 	return true;
 }
@@ -0,0 +1,150 @@
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Every name memory_get_region_name() can return, in address order */
+#define MEMORY_TRACE_REGION_COUNT 10
+
+/**
+ * @brief Zeroes the access counters of a tracing build
+ *
+ * @param mem_sys memory system to reset; a no-op without MEMORY_TRACE
+ */
+void memory_trace_reset(memory_system_t *mem_sys)
+{
+	assert(mem_sys != NULL);
+
+#ifdef MEMORY_TRACE
+	memset(&mem_sys->trace, 0, sizeof(mem_sys->trace));
+#else
+	UNUSED(mem_sys);
+#endif
+}
+
+#ifdef MEMORY_TRACE
+
+typedef struct memory_trace_region {
+	const char *name;
+	uint64_t reads;
+	uint64_t writes;
+} memory_trace_region_t;
+
+static uint64_t memory_trace_total(const memory_trace_t *trace, address addr)
+{
+	return trace->reads[addr] + trace->writes[addr];
+}
+
+/* The busiest addresses, busiest first; returns how many were used at all */
+static int memory_trace_hottest(const memory_trace_t *trace,
+				address hot[MEMORY_TRACE_HOT_ADDRESSES])
+{
+	int count = 0;
+
+	for (size_t addr = 0; addr < MEMORY_SIZE; addr++) {
+		uint64_t total = memory_trace_total(trace, (address)addr);
+
+		if (total == 0 ||
+		    (count == MEMORY_TRACE_HOT_ADDRESSES &&
+		     total <= memory_trace_total(trace, hot[count - 1]))) {
+			continue;
+		}
+
+		int i = count < MEMORY_TRACE_HOT_ADDRESSES ? count++ : count - 1;
+		while (i > 0 && memory_trace_total(trace, hot[i - 1]) < total) {
+			hot[i] = hot[i - 1];
+			i--;
+		}
+		hot[i] = (address)addr;
+	}
+
+	return count;
+}
+
+static void memory_trace_regions(const memory_trace_t *trace,
+				 memory_trace_region_t *regions, int *count)
+{
+	*count = 0;
+
+	for (size_t addr = 0; addr < MEMORY_SIZE; addr++) {
+		const char *name = memory_get_region_name((address)addr);
+		int i = 0;
+
+		while (i < *count && strcmp(regions[i].name, name) != 0) {
+			i++;
+		}
+		if (i == *count) {
+			assert(*count < MEMORY_TRACE_REGION_COUNT);
+			regions[i].name = name;
+			regions[i].reads = 0;
+			regions[i].writes = 0;
+			(*count)++;
+		}
+
+		regions[i].reads += trace->reads[addr];
+		regions[i].writes += trace->writes[addr];
+	}
+}
+
+#endif
+
+/**
+ * @brief Writes the access counters out as JSON
+ *
+ * Totals per region as named by memory_get_region_name(), then the
+ * MEMORY_TRACE_HOT_ADDRESSES busiest addresses with their counts.
+ *
+ * @param mem_sys memory system of a build with MEMORY_TRACE
+ * @param path file to create or replace
+ * @return false if tracing is not compiled in or the file cannot be written
+ */
+bool memory_trace_export(const memory_system_t *mem_sys, const char *path)
+{
+	assert(mem_sys != NULL && path != NULL);
+
+#ifdef MEMORY_TRACE
+	const memory_trace_t *trace = &mem_sys->trace;
+	memory_trace_region_t regions[MEMORY_TRACE_REGION_COUNT];
+	address hot[MEMORY_TRACE_HOT_ADDRESSES];
+	int region_count;
+
+	memory_trace_regions(trace, regions, &region_count);
+	int hot_count = memory_trace_hottest(trace, hot);
+
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		printf("ERROR: CANNOT WRITE MEMORY TRACE TO %s\n", path);
+		return false;
+	}
+
+	fprintf(file, "{\n  \"regions\": {\n");
+	for (int i = 0; i < region_count; i++) {
+		fprintf(file, "    \"%s\": { \"reads\": %llu, \"writes\": %llu }%s\n",
+			regions[i].name, (unsigned long long)regions[i].reads,
+			(unsigned long long)regions[i].writes,
+			i + 1 < region_count ? "," : "");
+	}
+
+	fprintf(file, "  },\n  \"hot_addresses\": [\n");
+	for (int i = 0; i < hot_count; i++) {
+		fprintf(file,
+			"    { \"address\": \"0x%04X\", \"region\": \"%s\", "
+			"\"reads\": %llu, \"writes\": %llu }%s\n",
+			hot[i], memory_get_region_name(hot[i]),
+			(unsigned long long)trace->reads[hot[i]],
+			(unsigned long long)trace->writes[hot[i]],
+			i + 1 < hot_count ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+
+	return fclose(file) == 0;
+#else
+	UNUSED(mem_sys);
+	UNUSED(path);
+	printf("Memory tracing is not compiled in; rebuild with -DMEMORY_TRACE\n");
+	return false;
+#endif
+}
@@ -0,0 +1,134 @@
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+static bool memory_watch_covers(const memory_watch_t *watch, int page)
+{
+	return MEMORY_PAGE(watch->start) <= page &&
+	       page <= MEMORY_PAGE(watch->end);
+}
+
+/**
+ * @brief Traps exactly the pages some watchpoint covers
+ *
+ * Every other page keeps its direct mapping, so watchpoints cost nothing
+ * outside the pages they are on.
+ *
+ * @param mem_sys memory system whose watch list changed
+ */
+void memory_watch_pages(memory_system_t *mem_sys)
+{
+	assert(mem_sys != NULL);
+
+	for (int page = 0; page < MEMORY_PAGE_COUNT; page++) {
+		bool watched = false;
+
+		for (int i = 0; i < mem_sys->watch_count && !watched; i++) {
+			watched = memory_watch_covers(&mem_sys->watches[i], page);
+		}
+
+		if (watched) {
+			memory_trap_page(mem_sys, page, MEMORY_TRAP_WATCH);
+		} else {
+			memory_untrap_page(mem_sys, page, MEMORY_TRAP_WATCH);
+		}
+	}
+}
+
+/**
+ * @brief Watches an address range for reads, writes or both
+ *
+ * @param mem_sys memory system to watch
+ * @param start first address watched
+ * @param end last address watched
+ * @param kinds MEMORY_WATCH_READ and/or MEMORY_WATCH_WRITE
+ * @return false if the range is empty or MEMORY_WATCH_MAX are already set
+ */
+bool memory_add_watch(memory_system_t *mem_sys, address start, address end,
+		      byte kinds)
+{
+	assert(mem_sys != NULL);
+
+	if (start > end || kinds == 0) {
+		printf("ERROR: INVALID WATCHPOINT 0x%04X-0x%04X\n", start, end);
+		return false;
+	}
+	if (mem_sys->watch_count == MEMORY_WATCH_MAX) {
+		printf("ERROR: NO MORE THAN %d WATCHPOINTS\n", MEMORY_WATCH_MAX);
+		return false;
+	}
+
+	memory_watch_t *watch = &mem_sys->watches[mem_sys->watch_count++];
+	watch->start = start;
+	watch->end = end;
+	watch->kinds = kinds;
+	memory_watch_pages(mem_sys);
+	return true;
+}
+
+/**
+ * @brief Removes the watchpoint set on exactly this range
+ *
+ * @param mem_sys memory system being watched
+ * @param start first address of the watchpoint
+ * @param end last address of the watchpoint
+ * @return false if no watchpoint has that range
+ */
+bool memory_remove_watch(memory_system_t *mem_sys, address start, address end)
+{
+	assert(mem_sys != NULL);
+
+	for (int i = 0; i < mem_sys->watch_count; i++) {
+		if (mem_sys->watches[i].start == start &&
+		    mem_sys->watches[i].end == end) {
+			mem_sys->watches[i] = mem_sys->watches[--mem_sys->watch_count];
+			memory_watch_pages(mem_sys);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void memory_clear_watches(memory_system_t *mem_sys)
+{
+	assert(mem_sys != NULL);
+
+	mem_sys->watch_count = 0;
+	mem_sys->watch_hit_pending = false;
+	memory_watch_pages(mem_sys);
+}
+
+/**
+ * @brief Records an access to a watched page if a watchpoint wants it
+ *
+ * Only the first hit is kept; later ones are dropped until whoever stopped
+ * on it clears watch_hit_pending.
+ *
+ * @param mem_sys memory system accessed
+ * @param addr address accessed
+ * @param kind MEMORY_WATCH_READ or MEMORY_WATCH_WRITE
+ * @param value byte read or written
+ */
+void memory_watch_check(memory_system_t *mem_sys, address addr, byte kind,
+			byte value)
+{
+	if (mem_sys->watch_hit_pending) {
+		return;
+	}
+
+	for (int i = 0; i < mem_sys->watch_count; i++) {
+		const memory_watch_t *watch = &mem_sys->watches[i];
+
+		if ((watch->kinds & kind) && watch->start <= addr &&
+		    addr <= watch->end) {
+			mem_sys->watch_hit.addr = addr;
+			mem_sys->watch_hit.kind = kind;
+			mem_sys->watch_hit.value = value;
+			mem_sys->watch_hit_pending = true;
+			return;
+		}
+	}
+}
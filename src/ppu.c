@@ -0,0 +1,715 @@
+#include "../include/ppu.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+/*
+ * Tiles are decoded into the tile cache eight pixels at a time with 64-bit
+ * SWAR arithmetic unless PPU_SCALAR is defined, which selects the per-pixel
+ * reference code. Lines are then drawn from the cache.
+ */
+
+#define PPU_REGISTER(ppu, reg) ((ppu)->mem_sys->high_page[MEMORY_PAGE_OFFSET(reg)])
+
+#define PPU_VBLANK_LINE SCREEN_HEIGHT
+#define PPU_BG_MAP_LOW 0x1800
+#define PPU_BG_MAP_HIGH 0x1C00
+#define PPU_SIGNED_TILE_BASE 0x1000
+#define PPU_WINDOW_X_OFFSET 7
+#define PPU_SPRITE_Y_OFFSET 16
+#define PPU_SPRITE_X_OFFSET 8
+
+/* Enough decoded pixels for a line scrolled by up to 7 pixels */
+#define PPU_ROW_TILES (SCREEN_WIDTH / 8 + 1)
+
+/* Line buffers have room for sprites hanging 8 pixels off either edge */
+#define PPU_LINE_PADDING 8
+#define PPU_LINE_SIZE (PPU_LINE_PADDING + SCREEN_WIDTH + PPU_LINE_PADDING)
+
+#ifndef PPU_SCALAR
+
+#define PPU_BYTE_ONES 0x0101010101010101ull
+
+/*
+ * Spreads the eight bits of a tile row to one byte per pixel, leftmost pixel
+ * (bit 7) first in memory. The multiply places copies of the byte nine bits
+ * apart, so byte k of the product has bit 7 - k of the input in its top bit.
+ */
+static inline uint64_t ppu_spread_bits(byte bits)
+{
+	uint64_t spread = ((bits * 0x8040201008040201ull) &
+			   0x8080808080808080ull) >> 7;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	spread = __builtin_bswap64(spread);
+#endif
+	return spread;
+}
+
+static inline void ppu_decode_tile_row(byte low, byte high, byte *pixels)
+{
+	uint64_t row = ppu_spread_bits(low) | (ppu_spread_bits(high) << 1);
+
+	memcpy(pixels, &row, sizeof(row));
+}
+
+/* Maps eight color indices to shades through a palette register */
+static inline uint64_t ppu_shade_row(uint64_t row, byte palette)
+{
+	/* One 0x01 per pixel in exactly one of the four masks */
+	uint64_t low = row & PPU_BYTE_ONES;
+	uint64_t high = (row >> 1) & PPU_BYTE_ONES;
+	uint64_t color3 = low & high;
+	uint64_t color2 = high ^ color3;
+	uint64_t color1 = low ^ color3;
+	uint64_t color0 = PPU_BYTE_ONES ^ (low | high);
+
+	return color0 * (palette & 0x03) + color1 * ((palette >> 2) & 0x03) +
+	       color2 * ((palette >> 4) & 0x03) + color3 * (palette >> 6);
+}
+
+static void ppu_apply_palette(const byte *indices, byte palette, byte *shades)
+{
+	for (int x = 0; x < SCREEN_WIDTH; x += 8) {
+		uint64_t row;
+
+		memcpy(&row, indices + x, sizeof(row));
+		row = ppu_shade_row(row, palette);
+		memcpy(shades + x, &row, sizeof(row));
+	}
+}
+
+/*
+ * Draws eight sprite pixels over the line. Pixels already claimed by an
+ * earlier sprite in owned are skipped, and behind hides the sprite wherever
+ * the background is not color 0.
+ */
+static inline void ppu_draw_sprite_row(const byte *pixels, byte palette,
+				       bool behind, const byte *bg_indices,
+				       byte *owned, byte *shades)
+{
+	uint64_t colors, background, claimed, line;
+
+	memcpy(&colors, pixels, sizeof(colors));
+	memcpy(&background, bg_indices, sizeof(background));
+	memcpy(&claimed, owned, sizeof(claimed));
+	memcpy(&line, shades, sizeof(line));
+
+	uint64_t opaque = (colors | (colors >> 1)) & PPU_BYTE_ONES & ~claimed;
+	uint64_t hidden = behind ? (background | (background >> 1)) &
+					   PPU_BYTE_ONES :
+				   0;
+	uint64_t mask = (opaque & ~hidden) * 0xFF;
+
+	claimed |= opaque;
+	line = (line & ~mask) | (ppu_shade_row(colors, palette) & mask);
+
+	memcpy(owned, &claimed, sizeof(claimed));
+	memcpy(shades, &line, sizeof(line));
+}
+
+#else
+
+static inline void ppu_decode_tile_row(byte low, byte high, byte *pixels)
+{
+	for (int x = 0; x < 8; x++) {
+		int bit = 7 - x;
+
+		pixels[x] = (byte)(((low >> bit) & 1) | (((high >> bit) & 1) << 1));
+	}
+}
+
+static void ppu_apply_palette(const byte *indices, byte palette, byte *shades)
+{
+	for (int x = 0; x < SCREEN_WIDTH; x++) {
+		shades[x] = (palette >> (indices[x] * 2)) & 0x03;
+	}
+}
+
+static inline void ppu_draw_sprite_row(const byte *pixels, byte palette,
+				       bool behind, const byte *bg_indices,
+				       byte *owned, byte *shades)
+{
+	for (int x = 0; x < 8; x++) {
+		if (pixels[x] == 0 || owned[x]) {
+			continue;
+		}
+
+		owned[x] = 1;
+		if (!behind || bg_indices[x] == 0) {
+			shades[x] = (palette >> (pixels[x] * 2)) & 0x03;
+		}
+	}
+}
+
+#endif
+
+static void ppu_decode_tile(ppu_t *ppu, int tile)
+{
+	const byte *data = ppu->mem_sys->vram + tile * VRAM_TILE_SIZE;
+
+	for (int row = 0; row < 8; row++) {
+		ppu_decode_tile_row(data[row * 2], data[row * 2 + 1],
+				    ppu->tiles[tile][row]);
+	}
+	ppu->mem_sys->vram_tile_dirty[tile] = false;
+}
+
+/* One decoded row of a tile, refreshed first if VRAM changed under it */
+static inline const byte *ppu_tile_row(ppu_t *ppu, int tile, int row)
+{
+	if (ppu->mem_sys->vram_tile_dirty[tile]) {
+		ppu_decode_tile(ppu, tile);
+	}
+
+	return ppu->tiles[tile][row];
+}
+
+/* Tiles 0-255 at 0x8000, or -128 to 127 around 0x9000 */
+static inline int ppu_bg_tile(byte lcdc, byte tile_index)
+{
+	if (lcdc & LCDC_TILE_DATA) {
+		return tile_index;
+	}
+
+	return PPU_SIGNED_TILE_BASE / VRAM_TILE_SIZE + (int8_t)tile_index;
+}
+
+/* Copies count consecutive map tiles of one pixel row, wrapping at 32 */
+static void ppu_decode_map_row(ppu_t *ppu, byte lcdc, int map, int tile_x,
+			       int y, int count, byte *pixels)
+{
+	const byte *map_row = ppu->mem_sys->vram + map + (y >> 3) * TILES_PER_ROW;
+	int fine_y = y & 7;
+
+	for (int t = 0; t < count; t++) {
+		byte tile_index = map_row[(tile_x + t) & (TILES_PER_ROW - 1)];
+		int tile = ppu_bg_tile(lcdc, tile_index);
+
+		memcpy(pixels + t * 8, ppu_tile_row(ppu, tile, fine_y), 8);
+	}
+}
+
+static void ppu_render_background(ppu_t *ppu, byte lcdc, int line,
+				  byte *indices)
+{
+	uint64_t row[PPU_ROW_TILES];
+	byte *pixels = (byte *)row;
+
+	if (!(lcdc & LCDC_BG_ENABLE)) {
+		memset(indices, 0, SCREEN_WIDTH);
+		return;
+	}
+
+	byte scx = PPU_REGISTER(ppu, SCX_REGISTER);
+	byte y = (byte)(line + PPU_REGISTER(ppu, SCY_REGISTER));
+	int map = (lcdc & LCDC_BG_MAP) ? PPU_BG_MAP_HIGH : PPU_BG_MAP_LOW;
+
+	ppu_decode_map_row(ppu, lcdc, map, scx >> 3, y, PPU_ROW_TILES, pixels);
+	memcpy(indices, pixels + (scx & 7), SCREEN_WIDTH);
+
+	int wx = PPU_REGISTER(ppu, WX_REGISTER) - PPU_WINDOW_X_OFFSET;
+	if (!(lcdc & LCDC_WINDOW_ENABLE) || line < PPU_REGISTER(ppu, WY_REGISTER) ||
+	    wx >= SCREEN_WIDTH) {
+		return;
+	}
+
+	/* A window left of the screen edge is clipped, not shifted */
+	int skip = wx < 0 ? -wx : 0;
+	int start = wx < 0 ? 0 : wx;
+	int tiles = (SCREEN_WIDTH - start + skip + 7) / 8;
+
+	map = (lcdc & LCDC_WINDOW_MAP) ? PPU_BG_MAP_HIGH : PPU_BG_MAP_LOW;
+	ppu_decode_map_row(ppu, lcdc, map, 0, ppu->window_line, tiles, pixels);
+	memcpy(indices + start, pixels + skip, SCREEN_WIDTH - start);
+	ppu->window_line++;
+}
+
+/* Sprites on the line in drawing priority: lowest X first, then OAM order */
+static int ppu_select_sprites(const ppu_t *ppu, int line, int height,
+			      const byte **sprites)
+{
+	const byte *oam = ppu->mem_sys->oam;
+	int count = 0;
+
+	for (int i = 0; i < PPU_SPRITE_COUNT && count < PPU_SPRITES_PER_LINE;
+	     i++) {
+		const byte *sprite = oam + i * 4;
+		int top = sprite[0] - PPU_SPRITE_Y_OFFSET;
+
+		if (line < top || line >= top + height) {
+			continue;
+		}
+
+		int slot = count++;
+		while (slot > 0 && sprites[slot - 1][1] > sprite[1]) {
+			sprites[slot] = sprites[slot - 1];
+			slot--;
+		}
+		sprites[slot] = sprite;
+	}
+
+	return count;
+}
+
+static void ppu_render_sprites(ppu_t *ppu, byte lcdc, int line,
+			       const byte *bg_indices, byte *shades)
+{
+	const byte *sprites[PPU_SPRITES_PER_LINE];
+	int height = (lcdc & LCDC_OBJ_TALL) ? 16 : 8;
+	int count = ppu_select_sprites(ppu, line, height, sprites);
+	byte owned[PPU_LINE_SIZE];
+
+	if (count == 0) {
+		return;
+	}
+	memset(owned, 0, sizeof(owned));
+
+	for (int i = 0; i < count; i++) {
+		const byte *sprite = sprites[i];
+		byte attributes = sprite[3];
+		byte tile_index = sprite[2];
+		int row = line - (sprite[0] - PPU_SPRITE_Y_OFFSET);
+		int left = sprite[1] - PPU_SPRITE_X_OFFSET;
+		byte pixels[8];
+
+		/*
+		 * Off the right edge: still one of the line's sprites, but the
+		 * padding only covers a partly visible one
+		 */
+		if (left >= SCREEN_WIDTH) {
+			continue;
+		}
+		if (height == 16) {
+			tile_index &= 0xFE;
+		}
+		if (attributes & OAM_ATTR_FLIP_Y) {
+			row = height - 1 - row;
+		}
+
+		const byte *tile_row = ppu_tile_row(ppu, tile_index + row / 8,
+						    row % 8);
+		if (attributes & OAM_ATTR_FLIP_X) {
+			for (int p = 0; p < 8; p++) {
+				pixels[p] = tile_row[7 - p];
+			}
+		} else {
+			memcpy(pixels, tile_row, 8);
+		}
+
+		byte palette = (attributes & OAM_ATTR_PALETTE) ?
+				       PPU_REGISTER(ppu, OBP1_REGISTER) :
+				       PPU_REGISTER(ppu, OBP0_REGISTER);
+
+		/* The first opaque sprite pixel wins even if hidden */
+		int x = PPU_LINE_PADDING + left;
+		ppu_draw_sprite_row(pixels, palette,
+				    (attributes & OAM_ATTR_BEHIND_BG) != 0,
+				    bg_indices + x, owned + x, shades + x);
+	}
+}
+
+/**
+ * @brief Draws one visible line into the framebuffer
+ *
+ * Normally called by ppu_step() when a line leaves pixel transfer.
+ *
+ * @param ppu ppu to draw with
+ * @param line line between 0 and SCREEN_HEIGHT - 1
+ */
+void ppu_render_line(ppu_t *ppu, int line)
+{
+	assert(ppu != NULL && line >= 0 && line < SCREEN_HEIGHT);
+
+	byte indices[PPU_LINE_SIZE] = { 0 };
+	byte shades[PPU_LINE_SIZE] = { 0 };
+	byte lcdc = PPU_REGISTER(ppu, LCDC_REGISTER);
+
+	ppu_render_background(ppu, lcdc, line, indices + PPU_LINE_PADDING);
+	ppu_apply_palette(indices + PPU_LINE_PADDING,
+			  PPU_REGISTER(ppu, BGP_REGISTER),
+			  shades + PPU_LINE_PADDING);
+
+	if (lcdc & LCDC_OBJ_ENABLE) {
+		ppu_render_sprites(ppu, lcdc, line, indices, shades);
+	}
+
+	memcpy(ppu->framebuffer[line], shades + PPU_LINE_PADDING, SCREEN_WIDTH);
+}
+
+static void ppu_update_stat(ppu_t *ppu)
+{
+	byte stat = PPU_REGISTER(ppu, STAT_REGISTER);
+	bool coincidence = ppu->ly == PPU_REGISTER(ppu, LYC_REGISTER);
+
+	stat = (byte)((stat & ~(STAT_MODE_MASK | STAT_COINCIDENCE)) | 0x80 |
+		      ppu->mode | (coincidence ? STAT_COINCIDENCE : 0));
+	PPU_REGISTER(ppu, STAT_REGISTER) = stat;
+
+	bool line = (coincidence && (stat & STAT_LYC_INTERRUPT)) ||
+		    (ppu->mode == PPU_MODE_HBLANK && (stat & STAT_HBLANK_INTERRUPT)) ||
+		    (ppu->mode == PPU_MODE_VBLANK && (stat & STAT_VBLANK_INTERRUPT)) ||
+		    (ppu->mode == PPU_MODE_OAM_SCAN && (stat & STAT_OAM_INTERRUPT));
+
+	if (line && !ppu->stat_line) {
+		memory_request_interrupt(ppu->mem_sys, INTERRUPT_LCD_STAT);
+	}
+	ppu->stat_line = line;
+}
+
+static void ppu_next_line(ppu_t *ppu)
+{
+	ppu->dot = 0;
+	ppu->ly++;
+
+	if (ppu->ly == PPU_VBLANK_LINE) {
+		ppu->mode = PPU_MODE_VBLANK;
+		ppu->frame_ready = true;
+		ppu->frames++;
+		memory_request_interrupt(ppu->mem_sys, INTERRUPT_VBLANK);
+	} else if (ppu->ly == PPU_LINES_PER_FRAME) {
+		ppu->ly = 0;
+		ppu->window_line = 0;
+		ppu->mode = PPU_MODE_OAM_SCAN;
+	} else if (ppu->ly < PPU_VBLANK_LINE) {
+		ppu->mode = PPU_MODE_OAM_SCAN;
+	}
+
+	PPU_REGISTER(ppu, LY_REGISTER) = ppu->ly;
+}
+
+/* Dot at which the current mode ends */
+static int ppu_mode_end(const ppu_t *ppu)
+{
+	switch (ppu->mode) {
+	case PPU_MODE_OAM_SCAN:
+		return PPU_OAM_SCAN_DOTS;
+	case PPU_MODE_TRANSFER:
+		return PPU_OAM_SCAN_DOTS + PPU_TRANSFER_DOTS;
+	default:
+		return PPU_DOTS_PER_LINE;
+	}
+}
+
+/**
+ * @brief T-cycles until the PPU next changes mode
+ *
+ * Interrupts and STAT changes only happen at mode changes, so running the
+ * rest of the machine up to this point loses no timing.
+ *
+ * @param ppu ppu to query
+ * @return dots left in the current mode, or one line while the LCD is off
+ */
+int ppu_cycles_until_event(const ppu_t *ppu)
+{
+	assert(ppu != NULL);
+
+	if (!(PPU_REGISTER(ppu, LCDC_REGISTER) & LCDC_ENABLE)) {
+		return PPU_DOTS_PER_LINE;
+	}
+
+	return ppu_mode_end(ppu) - ppu->dot;
+}
+
+/**
+ * @brief Advances the PPU by the given number of T-cycles
+ *
+ * Lines are drawn whole at the end of pixel transfer, unless the ppu is
+ * headless, and mode changes, LY, STAT and the VBlank/STAT interrupts are
+ * updated as they happen.
+ *
+ * @param ppu ppu to advance
+ * @param cycles T-cycles, one dot each
+ */
+void ppu_step(ppu_t *ppu, int cycles)
+{
+	assert(ppu != NULL);
+
+	if (!(PPU_REGISTER(ppu, LCDC_REGISTER) & LCDC_ENABLE)) {
+		return;
+	}
+
+	while (cycles > 0) {
+		int end = ppu_mode_end(ppu);
+		int run = MIN(cycles, end - ppu->dot);
+
+		ppu->dot += run;
+		cycles -= run;
+		if (ppu->dot < end) {
+			break;
+		}
+
+		switch (ppu->mode) {
+		case PPU_MODE_OAM_SCAN:
+			ppu->mode = PPU_MODE_TRANSFER;
+			break;
+		case PPU_MODE_TRANSFER:
+			if (!ppu->headless) {
+				ppu_render_line(ppu, ppu->ly);
+			}
+			ppu->mode = PPU_MODE_HBLANK;
+			break;
+		default:
+			ppu_next_line(ppu);
+			break;
+		}
+		ppu_update_stat(ppu);
+	}
+}
+
+/* STAT interrupt sources; with any enabled every mode change may fire */
+#define PPU_STAT_SOURCES (STAT_HBLANK_INTERRUPT | STAT_VBLANK_INTERRUPT | \
+			  STAT_OAM_INTERRUPT | STAT_LYC_INTERRUPT)
+
+/*
+ * T-cycles until the next mode change that has to happen on time: one that
+ * draws a line, starts VBlank or may raise a STAT interrupt. The changes in
+ * between only update LY and STAT, which ppu_sync() catches up on when they
+ * are read.
+ */
+static int ppu_cycles_until_deadline(const ppu_t *ppu)
+{
+	if (PPU_REGISTER(ppu, STAT_REGISTER) & PPU_STAT_SOURCES) {
+		return ppu_mode_end(ppu) - ppu->dot;
+	}
+
+	int position = ppu->ly * PPU_DOTS_PER_LINE + ppu->dot;
+	int vblank = PPU_VBLANK_LINE * PPU_DOTS_PER_LINE;
+	int until_vblank = position < vblank ?
+				   vblank - position :
+				   PPU_CYCLES_PER_FRAME - position + vblank;
+
+	if (ppu->headless) {
+		return until_vblank;
+	}
+
+	/* Otherwise every visible line is drawn as its pixel transfer ends */
+	int drawn = PPU_OAM_SCAN_DOTS + PPU_TRANSFER_DOTS;
+	if (ppu->ly < PPU_VBLANK_LINE && ppu->mode != PPU_MODE_HBLANK) {
+		return drawn - ppu->dot;
+	}
+
+	int next_line = ppu->ly < PPU_VBLANK_LINE ?
+				PPU_DOTS_PER_LINE - ppu->dot :
+				PPU_CYCLES_PER_FRAME - position;
+	return MIN(until_vblank, next_line + drawn);
+}
+
+static void ppu_advance(ppu_t *ppu, uint64_t clock)
+{
+	if (clock > ppu->clock) {
+		ppu_step(ppu, (int)(clock - ppu->clock));
+		ppu->clock = clock;
+	}
+	ppu->next_mode_change = ppu->clock + ppu_cycles_until_event(ppu);
+}
+
+static void ppu_schedule(ppu_t *ppu)
+{
+	if (ppu->scheduler == NULL) {
+		return;
+	}
+
+	ppu->next_mode_change = ppu->clock + ppu_cycles_until_event(ppu);
+
+	if (!(PPU_REGISTER(ppu, LCDC_REGISTER) & LCDC_ENABLE)) {
+		scheduler_cancel(ppu->scheduler, SCHEDULER_EVENT_PPU);
+		return;
+	}
+
+	scheduler_schedule(ppu->scheduler, SCHEDULER_EVENT_PPU,
+			   ppu->clock + ppu_cycles_until_deadline(ppu));
+}
+
+static void ppu_event(void *context, uint64_t deadline)
+{
+	ppu_t *ppu = context;
+
+	ppu_advance(ppu, deadline);
+	ppu_schedule(ppu);
+}
+
+/**
+ * @brief Brings LY, STAT and the mode up to the scheduler's clock
+ *
+ * The clock only passes the next PPU event during the last instruction
+ * before that event is dispatched, so catching up never draws a line or
+ * raises an interrupt any earlier than the event would have.
+ *
+ * @param ppu ppu to update; nothing happens without a scheduler
+ */
+void ppu_sync(ppu_t *ppu)
+{
+	assert(ppu != NULL);
+
+	if (ppu->scheduler != NULL) {
+		ppu_advance(ppu, scheduler_now(ppu->scheduler));
+	}
+}
+
+/**
+ * @brief Restarts the PPU's timeline at the scheduler's current cycle
+ *
+ * Needed whenever the PPU state or the clock was replaced wholesale, as by
+ * a reset, a loaded state or a fork, and after switching headless mode.
+ *
+ * @param ppu ppu with an attached scheduler; others are left alone
+ */
+void ppu_reschedule(ppu_t *ppu)
+{
+	assert(ppu != NULL);
+
+	if (ppu->scheduler == NULL) {
+		return;
+	}
+
+	ppu->clock = scheduler_now(ppu->scheduler);
+	ppu_schedule(ppu);
+}
+
+/**
+ * @brief Drives the PPU from a scheduler instead of ppu_step() calls
+ *
+ * @param ppu ppu to attach
+ * @param scheduler scheduler whose clock the machine runs on
+ */
+void ppu_attach_scheduler(ppu_t *ppu, scheduler_t *scheduler)
+{
+	assert(ppu != NULL && scheduler != NULL);
+
+	ppu->scheduler = scheduler;
+	scheduler_register(scheduler, SCHEDULER_EVENT_PPU, ppu_event, ppu);
+	ppu_reschedule(ppu);
+}
+
+static byte ppu_timing_read(memory_system_t *mem_sys, void *context,
+			    address addr)
+{
+	ppu_t *ppu = context;
+
+	if (ppu->scheduler != NULL &&
+	    scheduler_now(ppu->scheduler) >= ppu->next_mode_change) {
+		ppu_sync(ppu);
+	}
+	return mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)];
+}
+
+static void ppu_lcdc_write(memory_system_t *mem_sys, void *context,
+			   address addr, byte value)
+{
+	UNUSED(addr);
+	ppu_t *ppu = context;
+	byte old = mem_sys->high_page[MEMORY_PAGE_OFFSET(LCDC_REGISTER)];
+
+	ppu_sync(ppu);
+	mem_sys->high_page[MEMORY_PAGE_OFFSET(LCDC_REGISTER)] = value;
+
+	/* Switching the LCD off parks it at the top of the frame */
+	if ((old & LCDC_ENABLE) && !(value & LCDC_ENABLE)) {
+		ppu->ly = 0;
+		ppu->dot = 0;
+		ppu->window_line = 0;
+		ppu->mode = PPU_MODE_HBLANK;
+		PPU_REGISTER(ppu, LY_REGISTER) = 0;
+		ppu_update_stat(ppu);
+	} else if (!(old & LCDC_ENABLE) && (value & LCDC_ENABLE)) {
+		ppu->mode = PPU_MODE_OAM_SCAN;
+		ppu_update_stat(ppu);
+	}
+	ppu_schedule(ppu);
+}
+
+static void ppu_stat_write(memory_system_t *mem_sys, void *context,
+			   address addr, byte value)
+{
+	UNUSED(addr);
+	ppu_t *ppu = context;
+	byte *stat = &mem_sys->high_page[MEMORY_PAGE_OFFSET(STAT_REGISTER)];
+
+	ppu_sync(ppu);
+	/* Mode and coincidence bits are read-only */
+	*stat = (byte)((value & 0x78) | (*stat & 0x07));
+	ppu_update_stat(ppu);
+	ppu_schedule(ppu);
+}
+
+static void ppu_ly_write(memory_system_t *mem_sys, void *context,
+			 address addr, byte value)
+{
+	UNUSED(mem_sys);
+	UNUSED(context);
+	UNUSED(addr);
+	UNUSED(value);
+}
+
+static void ppu_lyc_write(memory_system_t *mem_sys, void *context,
+			  address addr, byte value)
+{
+	UNUSED(addr);
+	ppu_t *ppu = context;
+
+	ppu_sync(ppu);
+	mem_sys->high_page[MEMORY_PAGE_OFFSET(LYC_REGISTER)] = value;
+	ppu_update_stat(ppu);
+	ppu_schedule(ppu);
+}
+
+bool ppu_init(ppu_t *ppu, memory_system_t *mem_sys)
+{
+	if (ppu == NULL || mem_sys == NULL) {
+		printf("Cannot initialize PPU without memory system\n");
+		return false;
+	}
+
+	ppu->mem_sys = mem_sys;
+	ppu->headless = false;
+	ppu->scheduler = NULL;
+	ppu->clock = 0;
+	ppu->next_mode_change = 0;
+	memory_register_io(mem_sys, LCDC_REGISTER, NULL, ppu_lcdc_write, ppu);
+	memory_register_io(mem_sys, STAT_REGISTER, ppu_timing_read,
+			   ppu_stat_write, ppu);
+	memory_register_io(mem_sys, LY_REGISTER, ppu_timing_read, ppu_ly_write,
+			   ppu);
+	memory_register_io(mem_sys, LYC_REGISTER, NULL, ppu_lyc_write, ppu);
+	ppu_reset(ppu);
+
+	return true;
+}
+
+void ppu_reset(ppu_t *ppu)
+{
+	assert(ppu != NULL);
+
+	/* DMG register state after the boot ROM */
+	PPU_REGISTER(ppu, LCDC_REGISTER) = 0x91;
+	PPU_REGISTER(ppu, STAT_REGISTER) = 0x80;
+	PPU_REGISTER(ppu, SCY_REGISTER) = 0x00;
+	PPU_REGISTER(ppu, SCX_REGISTER) = 0x00;
+	PPU_REGISTER(ppu, LY_REGISTER) = 0x00;
+	PPU_REGISTER(ppu, LYC_REGISTER) = 0x00;
+	PPU_REGISTER(ppu, BGP_REGISTER) = 0xFC;
+	PPU_REGISTER(ppu, OBP0_REGISTER) = 0xFF;
+	PPU_REGISTER(ppu, OBP1_REGISTER) = 0xFF;
+	PPU_REGISTER(ppu, WY_REGISTER) = 0x00;
+	PPU_REGISTER(ppu, WX_REGISTER) = 0x00;
+
+	ppu->mode = PPU_MODE_OAM_SCAN;
+	ppu->dot = 0;
+	ppu->ly = 0;
+	ppu->window_line = 0;
+	ppu->stat_line = false;
+	ppu->frame_ready = false;
+	ppu->frames = 0;
+	memset(ppu->framebuffer, 0, sizeof(ppu->framebuffer));
+	memset(ppu->mem_sys->vram_tile_dirty, true,
+	       sizeof(ppu->mem_sys->vram_tile_dirty));
+
+	ppu_update_stat(ppu);
+	ppu_reschedule(ppu);
+}
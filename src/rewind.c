@@ -0,0 +1,341 @@
+#include "../include/rewind.h"
+#include "../include/savestate.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*
+ * A delta is a list of (skip, literal) runs counted in 64-bit words, each
+ * count a LEB128 varint, with the literal words holding old XOR new. Almost
+ * all of a frame's state is unchanged, so most of it is one long skip.
+ *
+ * Captures diff the machine's memory directly against the newest state
+ * through savestate_regions(), so the state is never serialized in full.
+ */
+#define REWIND_WORD_SIZE sizeof(uint64_t)
+/* Unchanged stretches are skipped with memcmp, big chunks first */
+#define REWIND_CHUNK_WORDS 32
+#define REWIND_BIG_CHUNK_WORDS 512
+
+static byte *rewind_put_varint(byte *out, size_t value)
+{
+	while (value >= 0x80) {
+		*out++ = (byte)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (byte)value;
+	return out;
+}
+
+static size_t rewind_get_varint(const byte **in)
+{
+	size_t value = 0;
+	int shift = 0;
+	byte part;
+
+	do {
+		part = *(*in)++;
+		value |= (size_t)(part & 0x7F) << shift;
+		shift += 7;
+	} while (part & 0x80);
+
+	return value;
+}
+
+static uint64_t rewind_load_word(const byte *data, size_t word)
+{
+	uint64_t value;
+
+	memcpy(&value, data + word * REWIND_WORD_SIZE, REWIND_WORD_SIZE);
+	return value;
+}
+
+/* Brings current up to date with the regions, returning the delta's size */
+static size_t rewind_encode(byte *current, const savestate_region_t *regions,
+			    int count, byte *out)
+{
+	byte *start = out;
+	size_t skip = 0;
+
+	for (int region = 0; region < count; region++) {
+		const byte *newer = regions[region].data;
+		size_t words = regions[region].size / REWIND_WORD_SIZE;
+		size_t word = 0;
+
+		while (word < words) {
+			size_t from = word;
+
+			while (word + REWIND_BIG_CHUNK_WORDS <= words &&
+			       memcmp(current + word * REWIND_WORD_SIZE,
+				      newer + word * REWIND_WORD_SIZE,
+				      REWIND_BIG_CHUNK_WORDS * REWIND_WORD_SIZE) == 0) {
+				word += REWIND_BIG_CHUNK_WORDS;
+			}
+			while (word + REWIND_CHUNK_WORDS <= words &&
+			       memcmp(current + word * REWIND_WORD_SIZE,
+				      newer + word * REWIND_WORD_SIZE,
+				      REWIND_CHUNK_WORDS * REWIND_WORD_SIZE) == 0) {
+				word += REWIND_CHUNK_WORDS;
+			}
+			while (word < words &&
+			       rewind_load_word(current, word) ==
+				       rewind_load_word(newer, word)) {
+				word++;
+			}
+			skip += word - from;
+
+			if (word == words) {
+				break;
+			}
+
+			from = word;
+			while (word < words &&
+			       rewind_load_word(current, word) !=
+				       rewind_load_word(newer, word)) {
+				word++;
+			}
+
+			out = rewind_put_varint(out, skip);
+			out = rewind_put_varint(out, word - from);
+			for (size_t i = from; i < word; i++) {
+				uint64_t value = rewind_load_word(current, i) ^
+						 rewind_load_word(newer, i);
+				memcpy(out, &value, REWIND_WORD_SIZE);
+				out += REWIND_WORD_SIZE;
+			}
+			memcpy(current + from * REWIND_WORD_SIZE,
+			       newer + from * REWIND_WORD_SIZE,
+			       (word - from) * REWIND_WORD_SIZE);
+			skip = 0;
+		}
+
+		current += regions[region].size;
+	}
+
+	return (size_t)(out - start);
+}
+
+static void rewind_apply(byte *state, const byte *delta, size_t delta_size)
+{
+	const byte *in = delta;
+	const byte *end = delta + delta_size;
+	size_t word = 0;
+
+	while (in < end) {
+		word += rewind_get_varint(&in);
+		size_t literal = rewind_get_varint(&in);
+
+		for (size_t i = 0; i < literal; i++, word++) {
+			uint64_t value = rewind_load_word(state, word);
+			uint64_t change;
+
+			memcpy(&change, in, REWIND_WORD_SIZE);
+			value ^= change;
+			memcpy(state + word * REWIND_WORD_SIZE, &value,
+			       REWIND_WORD_SIZE);
+			in += REWIND_WORD_SIZE;
+		}
+	}
+}
+
+/**
+ * @brief Sets up an empty history for one machine
+ *
+ * @param rewind history to initialize
+ * @param gb machine whose states will be captured; its cartridge fixes
+ *           the state size
+ * @param capacity bytes for deltas, 0 for REWIND_DEFAULT_CAPACITY
+ * @param max_frames states to keep at most, 0 for REWIND_DEFAULT_FRAMES
+ * @return false if out of memory
+ */
+bool rewind_init(rewind_t *rewind, const gameboy_t *gb, size_t capacity,
+		 int max_frames)
+{
+	assert(rewind != NULL && gb != NULL);
+
+	memset(rewind, 0, sizeof(*rewind));
+	rewind->state_size = savestate_size(gb);
+	rewind->capacity = capacity > 0 ? capacity : REWIND_DEFAULT_CAPACITY;
+	rewind->max_entries = max_frames > 0 ? max_frames : REWIND_DEFAULT_FRAMES;
+
+	/* Worst case is every word changed plus a run header per region */
+	size_t delta_bound = rewind->state_size + rewind->state_size / 4 + 16;
+
+	rewind->current = malloc(rewind->state_size);
+	rewind->delta = malloc(delta_bound);
+	rewind->data = malloc(rewind->capacity);
+	rewind->entries = malloc(sizeof(rewind_entry_t) * rewind->max_entries);
+
+	if (rewind->current == NULL || rewind->delta == NULL || rewind->data == NULL ||
+	    rewind->entries == NULL || rewind->capacity < delta_bound) {
+		printf("ERROR: COULD NOT ALLOCATE REWIND BUFFER\n");
+		rewind_cleanup(rewind);
+		return false;
+	}
+
+	return true;
+}
+
+void rewind_cleanup(rewind_t *rewind)
+{
+	if (rewind == NULL) {
+		return;
+	}
+
+	free(rewind->current);
+	free(rewind->delta);
+	free(rewind->data);
+	free(rewind->entries);
+	memset(rewind, 0, sizeof(*rewind));
+}
+
+/**
+ * @brief Forgets all captured states, e.g. after loading a save state
+ *
+ * @param rewind history to empty
+ */
+void rewind_clear(rewind_t *rewind)
+{
+	assert(rewind != NULL);
+
+	rewind->has_state = false;
+	rewind->head = 0;
+	rewind->used = 0;
+	rewind->first = 0;
+	rewind->count = 0;
+}
+
+static void rewind_drop_oldest(rewind_t *rewind)
+{
+	rewind->used -= rewind->entries[rewind->first].size;
+	rewind->first = (rewind->first + 1) % rewind->max_entries;
+	rewind->count--;
+}
+
+static const rewind_entry_t *rewind_oldest(const rewind_t *rewind)
+{
+	return rewind->count > 0 ? &rewind->entries[rewind->first] : NULL;
+}
+
+static void rewind_push(rewind_t *rewind, size_t size)
+{
+	const rewind_entry_t *oldest;
+
+	if (rewind->count == rewind->max_entries) {
+		rewind_drop_oldest(rewind);
+	}
+
+	/*
+	 * Deltas never wrap. Everything past the head is older than anything
+	 * before it, so on wrapping that tail goes first, then whatever the
+	 * new delta overlaps.
+	 */
+	if (rewind->head + size > rewind->capacity) {
+		while ((oldest = rewind_oldest(rewind)) != NULL &&
+		       oldest->offset >= rewind->head) {
+			rewind_drop_oldest(rewind);
+		}
+		rewind->head = 0;
+	}
+
+	while ((oldest = rewind_oldest(rewind)) != NULL &&
+	       oldest->offset >= rewind->head &&
+	       oldest->offset < rewind->head + size) {
+		rewind_drop_oldest(rewind);
+	}
+
+	int index = (rewind->first + rewind->count) % rewind->max_entries;
+	rewind->entries[index].offset = rewind->head;
+	rewind->entries[index].size = size;
+	rewind->count++;
+
+	memcpy(rewind->data + rewind->head, rewind->delta, size);
+	rewind->head += size;
+	rewind->used += size;
+}
+
+/**
+ * @brief Records the machine's current state, normally once per frame
+ *
+ * @param rewind history to add to
+ * @param gb machine to capture
+ * @return false if the state could not be serialized
+ */
+bool rewind_capture(rewind_t *rewind, gameboy_t *gb)
+{
+	assert(rewind != NULL && gb != NULL);
+
+	if (!gb->memory.rom_loaded || savestate_size(gb) != rewind->state_size) {
+		return false;
+	}
+
+	if (!rewind->has_state) {
+		rewind->has_state = savestate_save(gb, rewind->current,
+						   rewind->state_size) ==
+				    rewind->state_size;
+		return rewind->has_state;
+	}
+
+	int count = savestate_regions(gb, rewind->machine, rewind->regions);
+	size_t size = rewind_encode(rewind->current, rewind->regions, count,
+				    rewind->delta);
+	rewind_push(rewind, size);
+	return true;
+}
+
+/**
+ * @brief Puts the machine back to the state captured before the newest one
+ *
+ * The framebuffer is not part of the history; it catches up on the next
+ * frame run.
+ *
+ * @param rewind history to take the state from
+ * @param gb machine to restore
+ * @return false when there is no older state left
+ */
+bool rewind_step_back(rewind_t *rewind, gameboy_t *gb)
+{
+	assert(rewind != NULL && gb != NULL);
+
+	if (rewind->count == 0) {
+		return false;
+	}
+
+	int index = (rewind->first + rewind->count - 1) % rewind->max_entries;
+	const rewind_entry_t *entry = &rewind->entries[index];
+
+	rewind_apply(rewind->current, rewind->data + entry->offset, entry->size);
+	if (!savestate_load(gb, rewind->current, rewind->state_size)) {
+		return false;
+	}
+
+	rewind->head = entry->offset;
+	rewind->used -= entry->size;
+	rewind->count--;
+	return true;
+}
+
+/**
+ * @brief Counts the states that can still be restored, the newest included
+ */
+int rewind_frames(const rewind_t *rewind)
+{
+	assert(rewind != NULL);
+
+	return rewind->has_state ? rewind->count + 1 : 0;
+}
+
+/**
+ * @brief Bytes the history occupies: live deltas plus the newest state
+ */
+size_t rewind_memory_used(const rewind_t *rewind)
+{
+	assert(rewind != NULL);
+
+	return rewind->used + (rewind->has_state ? rewind->state_size : 0);
+}
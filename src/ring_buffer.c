@@ -0,0 +1,133 @@
+#include "../include/ring_buffer.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/**
+ * @brief Allocates an empty ring
+ *
+ * @param ring ring to initialize
+ * @param capacity size in bytes, rounded up to a power of two
+ * @return false if the storage cannot be allocated
+ */
+bool ring_buffer_init(ring_buffer_t *ring, size_t capacity)
+{
+	if (ring == NULL || capacity == 0) {
+		printf("Cannot initialize ring buffer\n");
+		return false;
+	}
+
+	size_t rounded = 1;
+	while (rounded < capacity) {
+		rounded *= 2;
+	}
+
+	ring->data = malloc(rounded);
+	if (ring->data == NULL) {
+		printf("ERROR: COULD NOT ALLOCATE RING BUFFER\n");
+		return false;
+	}
+
+	ring->capacity = rounded;
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	return true;
+}
+
+void ring_buffer_cleanup(ring_buffer_t *ring)
+{
+	if (ring == NULL) {
+		return;
+	}
+
+	free(ring->data);
+	ring->data = NULL;
+	ring->capacity = 0;
+}
+
+/* Drops everything queued; only safe while neither side is running */
+void ring_buffer_clear(ring_buffer_t *ring)
+{
+	assert(ring != NULL);
+
+	atomic_store(&ring->tail, atomic_load(&ring->head));
+}
+
+/* Bytes the producer can write right now */
+size_t ring_buffer_space(const ring_buffer_t *ring)
+{
+	assert(ring != NULL);
+
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+	return ring->capacity - (head - tail);
+}
+
+/* Bytes the consumer can read right now */
+size_t ring_buffer_available(const ring_buffer_t *ring)
+{
+	assert(ring != NULL);
+
+	size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+	return head - tail;
+}
+
+/**
+ * @brief Queues as much of data as fits; producer side only
+ *
+ * @param ring ring to write to
+ * @param data bytes to queue
+ * @param size number of bytes
+ * @return bytes actually queued
+ */
+size_t ring_buffer_write(ring_buffer_t *ring, const void *data, size_t size)
+{
+	assert(ring != NULL && (data != NULL || size == 0));
+
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	size = MIN(size, ring_buffer_space(ring));
+
+	size_t offset = head & (ring->capacity - 1);
+	size_t first = MIN(size, ring->capacity - offset);
+
+	memcpy(ring->data + offset, data, first);
+	memcpy(ring->data, (const byte *)data + first, size - first);
+
+	/* Publishes the bytes before the consumer can see the new head */
+	atomic_store_explicit(&ring->head, head + size, memory_order_release);
+	return size;
+}
+
+/**
+ * @brief Takes up to size queued bytes; consumer side only
+ *
+ * @param ring ring to read from
+ * @param out destination
+ * @param size most bytes to take
+ * @return bytes actually taken
+ */
+size_t ring_buffer_read(ring_buffer_t *ring, void *out, size_t size)
+{
+	assert(ring != NULL && (out != NULL || size == 0));
+
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	size = MIN(size, ring_buffer_available(ring));
+
+	size_t offset = tail & (ring->capacity - 1);
+	size_t first = MIN(size, ring->capacity - offset);
+
+	memcpy(out, ring->data + offset, first);
+	memcpy((byte *)out + first, ring->data, size - first);
+
+	/* Hands the space back only after the bytes have been copied out */
+	atomic_store_explicit(&ring->tail, tail + size, memory_order_release);
+	return size;
+}
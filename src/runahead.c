@@ -0,0 +1,88 @@
+#include "../include/runahead.h"
+#include "../include/gameboy.h"
+#include "../include/ppu.h"
+#include "../include/apu.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Sets up run-ahead for a machine with its cartridge loaded
+ *
+ * @param runahead run-ahead to initialize
+ * @param gb machine it will run; a new cartridge needs a new run-ahead
+ * @param frames frames to run ahead, 0 to RUNAHEAD_MAX_FRAMES
+ * @return false if frames is out of range or the state cannot be allocated
+ */
+bool runahead_init(runahead_t *runahead, const gameboy_t *gb, int frames)
+{
+	if (runahead == NULL || gb == NULL || frames < 0 ||
+	    frames > RUNAHEAD_MAX_FRAMES) {
+		printf("Cannot initialize run-ahead\n");
+		return false;
+	}
+
+	runahead->frames = frames;
+	return gameboy_state_init(&runahead->state, gb);
+}
+
+void runahead_cleanup(runahead_t *runahead)
+{
+	if (runahead == NULL) {
+		return;
+	}
+
+	gameboy_state_cleanup(&runahead->state);
+}
+
+/* Turns pixel generation on or off without touching audio */
+static void runahead_set_drawing(gameboy_t *gb, bool drawing)
+{
+	if (gb->ppu.headless == !drawing) {
+		return;
+	}
+
+	ppu_sync(&gb->ppu);
+	gb->ppu.headless = !drawing;
+	ppu_reschedule(&gb->ppu);
+}
+
+/**
+ * @brief Runs one frame, leaving the framebuffer as it will be later on
+ *
+ * The machine itself only advances by one frame, and only that frame's
+ * audio reaches the output, so the game runs and sounds exactly as without
+ * run-ahead. Set the input with joypad_set_buttons() before each call.
+ *
+ * @param runahead run-ahead made for this machine
+ * @param gb machine to run
+ * @return T-cycles the machine advanced
+ */
+uint64_t runahead_run_frame(runahead_t *runahead, gameboy_t *gb)
+{
+	assert(runahead != NULL && gb != NULL);
+
+	if (runahead->frames == 0) {
+		return gameboy_run_frame(gb);
+	}
+
+	bool drawing = !gb->ppu.headless;
+
+	/* The real frame is only heard; the picture comes from further on */
+	runahead_set_drawing(gb, false);
+	uint64_t cycles = gameboy_run_frame(gb);
+	gameboy_save_state(gb, &runahead->state);
+
+	apu_set_output(&gb->apu, NULL);
+	for (int frame = 1; frame <= runahead->frames; frame++) {
+		runahead_set_drawing(gb, drawing && frame == runahead->frames);
+		gameboy_run_frame(gb);
+	}
+
+	gameboy_restore_state(gb, &runahead->state);
+	runahead_set_drawing(gb, drawing);
+	return cycles;
+}
@@ -0,0 +1,597 @@
+#include "../include/savestate.h"
+#include "../include/gameboy.h"
+#include "../include/block_cache.h"
+#include "../include/jit.h"
+#include "../include/memory.h"
+#include "../include/mbc.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*
+ * Layout, all integers little-endian:
+ *
+ *   header   magic, version, ROM hash, cartridge RAM size, reserved
+ *   cpu      registers, interrupt and halt state, cycle count
+ *   mbc      bank registers and RTC
+ *   ppu      mode, dot, line counters, STAT line, frame count
+ *   timer    internal counter behind DIV
+ *   dma      cycles left of the OAM transfer, 0 when idle
+ *   apu      channel counters, sweep, noise LFSR, frame sequencer
+ *   serial   cycles left of the transfer this side clocks, 0 when idle
+ *   padding  zeros up to SAVESTATE_MACHINE_SIZE
+ *   memory   VRAM, WRAM, OAM, 0xFF00-0xFFFF, cartridge RAM
+ *
+ * The ROM itself is only referenced by its hash, and the framebuffer and
+ * decoded tiles are left out because they are rebuilt from VRAM.
+ */
+#define SAVESTATE_CPU_SIZE 26
+#define SAVESTATE_MBC_SIZE (6 + 2 * MBC_RTC_REGISTER_COUNT)
+#define SAVESTATE_PPU_SIZE 17
+#define SAVESTATE_TIMER_SIZE 2
+#define SAVESTATE_DMA_SIZE 2
+#define SAVESTATE_APU_SIZE (10 * APU_CHANNEL_COUNT + 9)
+#define SAVESTATE_SERIAL_SIZE 2
+#define SAVESTATE_MEMORY_SIZE (VRAM_SIZE + WRAM_SIZE + OAM_SIZE + MEMORY_PAGE_SIZE)
+
+static_assert(SAVESTATE_HEADER_SIZE + SAVESTATE_CPU_SIZE + SAVESTATE_MBC_SIZE +
+		      SAVESTATE_PPU_SIZE + SAVESTATE_TIMER_SIZE +
+		      SAVESTATE_DMA_SIZE + SAVESTATE_APU_SIZE +
+		      SAVESTATE_SERIAL_SIZE <=
+		      SAVESTATE_MACHINE_SIZE,
+	      "registers do not fit the machine section");
+static_assert(SAVESTATE_MACHINE_SIZE % 8 == 0 && OAM_SIZE % 8 == 0,
+	      "memory regions must start word aligned");
+
+static byte *savestate_put8(byte *out, byte value)
+{
+	*out = value;
+	return out + 1;
+}
+
+static byte *savestate_put16(byte *out, uint16_t value)
+{
+	out[0] = (byte)value;
+	out[1] = (byte)(value >> 8);
+	return out + 2;
+}
+
+static byte *savestate_put32(byte *out, uint32_t value)
+{
+	out = savestate_put16(out, (uint16_t)value);
+	return savestate_put16(out, (uint16_t)(value >> 16));
+}
+
+static byte *savestate_put64(byte *out, uint64_t value)
+{
+	out = savestate_put32(out, (uint32_t)value);
+	return savestate_put32(out, (uint32_t)(value >> 32));
+}
+
+static byte *savestate_put_bytes(byte *out, const byte *data, size_t size)
+{
+	memcpy(out, data, size);
+	return out + size;
+}
+
+static byte savestate_get8(const byte **in)
+{
+	return *(*in)++;
+}
+
+static uint16_t savestate_get16(const byte **in)
+{
+	uint16_t value = (uint16_t)((*in)[0] | ((*in)[1] << 8));
+
+	*in += 2;
+	return value;
+}
+
+static uint32_t savestate_get32(const byte **in)
+{
+	uint32_t low = savestate_get16(in);
+
+	return low | ((uint32_t)savestate_get16(in) << 16);
+}
+
+static uint64_t savestate_get64(const byte **in)
+{
+	uint64_t low = savestate_get32(in);
+
+	return low | ((uint64_t)savestate_get32(in) << 32);
+}
+
+static void savestate_get_bytes(const byte **in, byte *data, size_t size)
+{
+	memcpy(data, *in, size);
+	*in += size;
+}
+
+/**
+ * @brief Gives the exact size of a save state of this machine
+ *
+ * Depends only on the cartridge: about 17 KiB plus the cartridge RAM.
+ *
+ * @param gb machine with a cartridge loaded
+ * @return size in bytes
+ */
+size_t savestate_size(const gameboy_t *gb)
+{
+	assert(gb != NULL);
+
+	return SAVESTATE_MACHINE_SIZE + SAVESTATE_MEMORY_SIZE + gb->memory.eram_size;
+}
+
+static byte *savestate_save_cpu(const cpu_t *cpu, byte *out)
+{
+	out = savestate_put8(out, cpu->a);
+	out = savestate_put8(out, cpu->f);
+	out = savestate_put8(out, cpu->b);
+	out = savestate_put8(out, cpu->c);
+	out = savestate_put8(out, cpu->d);
+	out = savestate_put8(out, cpu->e);
+	out = savestate_put8(out, cpu->h);
+	out = savestate_put8(out, cpu->l);
+	out = savestate_put16(out, cpu->sp);
+	out = savestate_put16(out, cpu->pc);
+	out = savestate_put8(out, cpu->ime);
+	out = savestate_put8(out, cpu->ime_pending);
+	out = savestate_put8(out, cpu->halted);
+	out = savestate_put8(out, cpu->halt_bug);
+	out = savestate_put8(out, cpu->stopped);
+	out = savestate_put8(out, cpu->locked);
+	return savestate_put64(out, cpu->cycles);
+}
+
+static void savestate_load_cpu(cpu_t *cpu, const byte **in)
+{
+	cpu->a = savestate_get8(in);
+	cpu->f = savestate_get8(in);
+	cpu->b = savestate_get8(in);
+	cpu->c = savestate_get8(in);
+	cpu->d = savestate_get8(in);
+	cpu->e = savestate_get8(in);
+	cpu->h = savestate_get8(in);
+	cpu->l = savestate_get8(in);
+	cpu->sp = savestate_get16(in);
+	cpu->pc = savestate_get16(in);
+	cpu->ime = savestate_get8(in) != 0;
+	cpu->ime_pending = savestate_get8(in) != 0;
+	cpu->halted = savestate_get8(in) != 0;
+	cpu->halt_bug = savestate_get8(in) != 0;
+	cpu->stopped = savestate_get8(in) != 0;
+	cpu->locked = savestate_get8(in) != 0;
+	cpu->cycles = savestate_get64(in);
+}
+
+static byte *savestate_save_mbc(const mbc_t *mbc, byte *out)
+{
+	out = savestate_put8(out, mbc->ram_enabled);
+	out = savestate_put16(out, mbc->rom_bank);
+	out = savestate_put8(out, mbc->ram_bank);
+	out = savestate_put8(out, mbc->banking_mode);
+	out = savestate_put8(out, mbc->rtc_latch);
+	out = savestate_put_bytes(out, mbc->rtc, MBC_RTC_REGISTER_COUNT);
+	return savestate_put_bytes(out, mbc->rtc_latched, MBC_RTC_REGISTER_COUNT);
+}
+
+static void savestate_load_mbc(mbc_t *mbc, const byte **in)
+{
+	mbc->ram_enabled = savestate_get8(in) != 0;
+	mbc->rom_bank = savestate_get16(in);
+	mbc->ram_bank = savestate_get8(in);
+	mbc->banking_mode = savestate_get8(in);
+	mbc->rtc_latch = savestate_get8(in);
+	savestate_get_bytes(in, mbc->rtc, MBC_RTC_REGISTER_COUNT);
+	savestate_get_bytes(in, mbc->rtc_latched, MBC_RTC_REGISTER_COUNT);
+}
+
+static byte *savestate_save_ppu(const ppu_t *ppu, byte *out)
+{
+	out = savestate_put8(out, (byte)ppu->mode);
+	out = savestate_put16(out, (uint16_t)ppu->dot);
+	out = savestate_put8(out, ppu->ly);
+	out = savestate_put16(out, (uint16_t)ppu->window_line);
+	out = savestate_put8(out, ppu->stat_line);
+	out = savestate_put8(out, ppu->frame_ready);
+	out = savestate_put8(out, 0);
+	return savestate_put64(out, ppu->frames);
+}
+
+static void savestate_load_ppu(ppu_t *ppu, const byte **in)
+{
+	ppu->mode = savestate_get8(in);
+	ppu->dot = savestate_get16(in);
+	ppu->ly = savestate_get8(in);
+	ppu->window_line = savestate_get16(in);
+	ppu->stat_line = savestate_get8(in) != 0;
+	ppu->frame_ready = savestate_get8(in) != 0;
+	savestate_get8(in);
+	ppu->frames = savestate_get64(in);
+}
+
+/* The sequencer step is stored relative to the CPU clock it runs on */
+static byte *savestate_save_apu(const apu_t *apu, uint64_t cycles, byte *out)
+{
+	for (int i = 0; i < APU_CHANNEL_COUNT; i++) {
+		const apu_channel_t *ch = &apu->channels[i];
+
+		out = savestate_put8(out, ch->enabled);
+		out = savestate_put16(out, (uint16_t)ch->length);
+		out = savestate_put8(out, (byte)ch->volume);
+		out = savestate_put8(out, (byte)ch->envelope_timer);
+		out = savestate_put32(out, (uint32_t)ch->timer);
+		out = savestate_put8(out, (byte)ch->position);
+	}
+
+	out = savestate_put8(out, apu->sweep_enabled);
+	out = savestate_put8(out, (byte)apu->sweep_timer);
+	out = savestate_put16(out, (uint16_t)apu->sweep_shadow);
+	out = savestate_put16(out, apu->lfsr);
+	out = savestate_put8(out, (byte)apu->step);
+	return savestate_put16(out, apu->next_step > cycles ?
+					    (uint16_t)(apu->next_step - cycles) :
+					    0);
+}
+
+static void savestate_load_apu(apu_t *apu, uint64_t cycles, const byte **in)
+{
+	for (int i = 0; i < APU_CHANNEL_COUNT; i++) {
+		apu_channel_t *ch = &apu->channels[i];
+
+		ch->enabled = savestate_get8(in) != 0;
+		ch->length = savestate_get16(in);
+		ch->volume = savestate_get8(in);
+		ch->envelope_timer = savestate_get8(in);
+		ch->timer = (int)savestate_get32(in);
+		ch->position = savestate_get8(in);
+	}
+
+	apu->sweep_enabled = savestate_get8(in) != 0;
+	apu->sweep_timer = savestate_get8(in);
+	apu->sweep_shadow = savestate_get16(in);
+	apu->lfsr = savestate_get16(in);
+	apu->step = savestate_get8(in);
+	apu->next_step = cycles + savestate_get16(in);
+}
+
+/*
+ * Mode and line must agree and the dot must lie inside the mode, or
+ * ppu_step() would draw past the framebuffer or never leave the mode.
+ * HBLANK may start at dot 0 since switching the LCD off parks it there.
+ */
+static bool savestate_check_ppu(const byte **in)
+{
+	int mode = savestate_get8(in);
+	int dot = savestate_get16(in);
+	int ly = savestate_get8(in);
+	int window_line = savestate_get16(in);
+	int first = 0;
+	int end = PPU_DOTS_PER_LINE;
+
+	if (mode == PPU_MODE_OAM_SCAN) {
+		end = PPU_OAM_SCAN_DOTS;
+	} else if (mode == PPU_MODE_TRANSFER) {
+		first = PPU_OAM_SCAN_DOTS;
+		end = PPU_OAM_SCAN_DOTS + PPU_TRANSFER_DOTS;
+	}
+
+	*in += SAVESTATE_PPU_SIZE - 6;
+	return mode <= PPU_MODE_TRANSFER && ly < PPU_LINES_PER_FRAME &&
+	       (mode == PPU_MODE_VBLANK) == (ly >= SCREEN_HEIGHT) &&
+	       first <= dot && dot < end && window_line <= SCREEN_HEIGHT;
+}
+
+static bool savestate_check_apu(const byte **in)
+{
+	bool valid = true;
+
+	for (int i = 0; i < APU_CHANNEL_COUNT; i++) {
+		int positions = i == APU_CHANNEL_WAVE ? APU_WAVE_SAMPLES : 8;
+		int max_length = i == APU_CHANNEL_WAVE ? 256 : 64;
+
+		savestate_get8(in);
+		int length = savestate_get16(in);
+		int volume = savestate_get8(in);
+		int envelope_timer = savestate_get8(in);
+		uint32_t timer = savestate_get32(in);
+		int position = savestate_get8(in);
+
+		valid = valid && length <= max_length && volume <= 15 &&
+			envelope_timer <= 7 && timer <= APU_MAX_PERIOD &&
+			position < positions;
+	}
+
+	savestate_get8(in);
+	int sweep_timer = savestate_get8(in);
+	int sweep_shadow = savestate_get16(in);
+	uint16_t lfsr = savestate_get16(in);
+	int step = savestate_get8(in);
+	int next_step = savestate_get16(in);
+
+	return valid && sweep_timer <= 8 && sweep_shadow <= APU_MAX_FREQUENCY &&
+	       lfsr <= 0x7FFF && step <= 7 && next_step <= APU_SEQUENCER_CYCLES;
+}
+
+/* Range-checks the registers so a corrupt state cannot reach the machine */
+static bool savestate_check_machine(const byte *machine)
+{
+	const byte *in = machine + SAVESTATE_HEADER_SIZE + SAVESTATE_CPU_SIZE +
+			 SAVESTATE_MBC_SIZE;
+
+	if (!savestate_check_ppu(&in)) {
+		return false;
+	}
+
+	savestate_get16(&in);
+	int dma_cycles = savestate_get16(&in);
+	if (dma_cycles > DMA_STARTUP_CYCLES + DMA_TRANSFER_CYCLES ||
+	    !savestate_check_apu(&in)) {
+		return false;
+	}
+
+	return savestate_get16(&in) <= SERIAL_TRANSFER_CYCLES;
+}
+
+static int savestate_add_region(savestate_region_t *regions, int count,
+				const byte *data, size_t size)
+{
+	/* No cartridge RAM: nothing to copy, and data may be NULL */
+	if (size == 0) {
+		return count;
+	}
+
+	if (count > 0 && regions[count - 1].data + regions[count - 1].size == data) {
+		regions[count - 1].size += size;
+		return count;
+	}
+
+	regions[count].data = data;
+	regions[count].size = size;
+	return count + 1;
+}
+
+/* A fork's RAM pages may live in its snapshot, so they are added one by one */
+static int savestate_add_backing(const memory_system_t *mem_sys,
+				 savestate_region_t *regions, int count,
+				 const byte *backing, size_t size)
+{
+	if (mem_sys->cow_shared == NULL) {
+		return savestate_add_region(regions, count, backing, size);
+	}
+
+	for (size_t offset = 0; offset < size; offset += MEMORY_PAGE_SIZE) {
+		count = savestate_add_region(regions, count,
+					     memory_backing_page(mem_sys,
+								 backing + offset),
+					     MEMORY_PAGE_SIZE);
+	}
+
+	return count;
+}
+
+/**
+ * @brief Describes a save state as a list of byte ranges without copying it
+ *
+ * Put together, the ranges are exactly what savestate_save() writes. The
+ * first one is machine, which receives the header and registers; the others
+ * point into the machine's memory and are only valid until it runs again.
+ * Every range is a whole number of 64-bit words.
+ *
+ * @param gb machine with a cartridge loaded
+ * @param machine SAVESTATE_MACHINE_SIZE bytes for the header and registers
+ * @param regions room for SAVESTATE_MAX_REGIONS ranges
+ * @return number of ranges
+ */
+int savestate_regions(gameboy_t *gb, byte *machine,
+		      savestate_region_t *regions)
+{
+	assert(gb != NULL && machine != NULL && regions != NULL);
+	assert(gb->memory.eram_size <= SAVESTATE_MAX_ERAM_SIZE);
+
+	memory_system_t *mem_sys = &gb->memory;
+	byte *out = machine;
+
+	memset(machine, 0, SAVESTATE_MACHINE_SIZE);
+	out = savestate_put32(out, SAVESTATE_MAGIC);
+	out = savestate_put32(out, SAVESTATE_VERSION);
+	out = savestate_put64(out, memory_rom_hash(mem_sys));
+	out = savestate_put32(out, (uint32_t)mem_sys->eram_size);
+	out = savestate_put32(out, 0);
+
+	out = savestate_save_cpu(&gb->cpu, out);
+	out = savestate_save_mbc(&mem_sys->mbc, out);
+	out = savestate_save_ppu(&gb->ppu, out);
+	out = savestate_put16(out, gb->timer.counter);
+	out = savestate_put16(out, dma_remaining(&gb->dma));
+	out = savestate_save_apu(&gb->apu, gb->cpu.cycles, out);
+	savestate_put16(out, serial_remaining(&gb->serial));
+
+	regions[0].data = machine;
+	regions[0].size = SAVESTATE_MACHINE_SIZE;
+	int count = 1;
+
+	count = savestate_add_region(regions, count, mem_sys->vram, VRAM_SIZE);
+	count = savestate_add_backing(mem_sys, regions, count, mem_sys->wram,
+				      WRAM_SIZE);
+	count = savestate_add_region(regions, count, mem_sys->oam, OAM_SIZE);
+	count = savestate_add_region(regions, count, mem_sys->high_page,
+				     MEMORY_PAGE_SIZE);
+	count = savestate_add_backing(mem_sys, regions, count, mem_sys->eram,
+				      mem_sys->eram_size);
+
+	return count;
+}
+
+/**
+ * @brief Serializes the machine state into a caller-provided buffer
+ *
+ * @param gb machine with a cartridge loaded
+ * @param buffer destination, at least savestate_size() bytes
+ * @param size size of buffer
+ * @return bytes written, or 0 if the buffer is too small or no ROM is loaded
+ */
+size_t savestate_save(gameboy_t *gb, byte *buffer, size_t size)
+{
+	assert(gb != NULL && buffer != NULL);
+
+	size_t total = savestate_size(gb);
+
+	if (!gb->memory.rom_loaded || size < total) {
+		return 0;
+	}
+
+	savestate_region_t regions[SAVESTATE_MAX_REGIONS];
+	int count = savestate_regions(gb, buffer, regions);
+	byte *out = buffer + SAVESTATE_MACHINE_SIZE;
+
+	for (int i = 1; i < count; i++) {
+		memcpy(out, regions[i].data, regions[i].size);
+		out += regions[i].size;
+	}
+
+	assert((size_t)(out - buffer) == total);
+	return total;
+}
+
+/**
+ * @brief Restores a state made by savestate_save() for the loaded cartridge
+ *
+ * The state is checked in full before anything is touched, so a rejected
+ * state leaves the machine as it was. Cached decodes (blocks and tiles) are
+ * dropped since the memory under them has changed.
+ *
+ * @param gb machine with the same cartridge loaded
+ * @param buffer serialized state
+ * @param size size of the state in bytes
+ * @return false if the state is malformed, from another version or for
+ *         another cartridge
+ */
+bool savestate_load(gameboy_t *gb, const byte *buffer, size_t size)
+{
+	assert(gb != NULL && buffer != NULL);
+
+	memory_system_t *mem_sys = &gb->memory;
+	const byte *in = buffer;
+
+	if (size < SAVESTATE_HEADER_SIZE || !mem_sys->rom_loaded) {
+		printf("ERROR: INVALID SAVE STATE\n");
+		return false;
+	}
+
+	uint32_t magic = savestate_get32(&in);
+	uint32_t version = savestate_get32(&in);
+	uint64_t rom_hash = savestate_get64(&in);
+	uint32_t eram_size = savestate_get32(&in);
+	savestate_get32(&in);
+
+	if (magic != SAVESTATE_MAGIC || version != SAVESTATE_VERSION) {
+		printf("ERROR: UNSUPPORTED SAVE STATE VERSION\n");
+		return false;
+	}
+
+	if (rom_hash != memory_rom_hash(mem_sys) ||
+	    eram_size != mem_sys->eram_size) {
+		printf("ERROR: SAVE STATE IS FOR A DIFFERENT CARTRIDGE\n");
+		return false;
+	}
+
+	if (size != savestate_size(gb)) {
+		printf("ERROR: TRUNCATED SAVE STATE\n");
+		return false;
+	}
+
+	if (!savestate_check_machine(buffer)) {
+		printf("ERROR: CORRUPT SAVE STATE\n");
+		return false;
+	}
+
+	/* A fork stops sharing: everything it shared is about to change */
+	memory_unshare(mem_sys);
+
+	savestate_load_cpu(&gb->cpu, &in);
+	savestate_load_mbc(&mem_sys->mbc, &in);
+	savestate_load_ppu(&gb->ppu, &in);
+	gb->timer.counter = savestate_get16(&in);
+	uint16_t dma_cycles = savestate_get16(&in);
+	savestate_load_apu(&gb->apu, gb->cpu.cycles, &in);
+	uint16_t serial_cycles = savestate_get16(&in);
+	in = buffer + SAVESTATE_MACHINE_SIZE;
+
+	savestate_get_bytes(&in, mem_sys->vram, VRAM_SIZE);
+	savestate_get_bytes(&in, mem_sys->wram, WRAM_SIZE);
+	savestate_get_bytes(&in, mem_sys->oam, OAM_SIZE);
+	savestate_get_bytes(&in, mem_sys->high_page, MEMORY_PAGE_SIZE);
+	if (eram_size > 0) {
+		savestate_get_bytes(&in, mem_sys->eram, eram_size);
+	}
+
+	mbc_update_mapping(mem_sys);
+	memset(mem_sys->vram_tile_dirty, true, sizeof(mem_sys->vram_tile_dirty));
+	block_cache_flush(&gb->block_cache);
+	jit_flush(&gb->jit);
+	ppu_reschedule(&gb->ppu);
+	timer_reschedule(&gb->timer);
+	dma_restore(&gb->dma, dma_cycles);
+	apu_reschedule(&gb->apu);
+	serial_restore(&gb->serial, serial_cycles);
+
+	return true;
+}
+
+bool savestate_save_file(gameboy_t *gb, const char *filename)
+{
+	assert(gb != NULL && filename != NULL);
+
+	size_t size = savestate_size(gb);
+	byte *buffer = malloc(size);
+	if (buffer == NULL) {
+		return false;
+	}
+
+	bool ok = savestate_save(gb, buffer, size) == size;
+	FILE *file = ok ? fopen(filename, "wb") : NULL;
+	if (file == NULL) {
+		printf("ERROR: COULD NOT WRITE SAVE STATE '%s'\n", filename);
+		free(buffer);
+		return false;
+	}
+
+	ok = fwrite(buffer, 1, size, file) == size;
+	if (fclose(file) != 0) {
+		ok = false;
+	}
+
+	free(buffer);
+	return ok;
+}
+
+bool savestate_load_file(gameboy_t *gb, const char *filename)
+{
+	assert(gb != NULL && filename != NULL);
+
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL) {
+		printf("ERROR: COULD NOT READ SAVE STATE '%s'\n", filename);
+		return false;
+	}
+
+	/* One byte of slack catches files longer than any valid state */
+	size_t capacity = savestate_size(gb) + 1;
+	byte *buffer = malloc(capacity);
+	if (buffer == NULL) {
+		fclose(file);
+		return false;
+	}
+
+	size_t size = fread(buffer, 1, capacity, file);
+	fclose(file);
+
+	bool ok = savestate_load(gb, buffer, size);
+	free(buffer);
+	return ok;
+}
@@ -0,0 +1,189 @@
+#include "../include/scheduler.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static bool scheduler_before(const scheduler_t *scheduler, int a, int b)
+{
+	uint64_t deadline_a = scheduler->events[a].deadline;
+	uint64_t deadline_b = scheduler->events[b].deadline;
+
+	return deadline_a < deadline_b || (deadline_a == deadline_b && a < b);
+}
+
+static void scheduler_place(scheduler_t *scheduler, int position, int type)
+{
+	scheduler->heap[position] = type;
+	scheduler->events[type].position = position;
+}
+
+static void scheduler_sift_up(scheduler_t *scheduler, int position)
+{
+	int type = scheduler->heap[position];
+
+	while (position > 0) {
+		int parent = (position - 1) / 2;
+
+		if (!scheduler_before(scheduler, type, scheduler->heap[parent])) {
+			break;
+		}
+		scheduler_place(scheduler, position, scheduler->heap[parent]);
+		position = parent;
+	}
+	scheduler_place(scheduler, position, type);
+}
+
+static void scheduler_sift_down(scheduler_t *scheduler, int position)
+{
+	int type = scheduler->heap[position];
+
+	for (;;) {
+		int child = position * 2 + 1;
+
+		if (child >= scheduler->size) {
+			break;
+		}
+		if (child + 1 < scheduler->size &&
+		    scheduler_before(scheduler, scheduler->heap[child + 1],
+				     scheduler->heap[child])) {
+			child++;
+		}
+		if (!scheduler_before(scheduler, scheduler->heap[child], type)) {
+			break;
+		}
+		scheduler_place(scheduler, position, scheduler->heap[child]);
+		position = child;
+	}
+	scheduler_place(scheduler, position, type);
+}
+
+bool scheduler_init(scheduler_t *scheduler, const uint64_t *clock)
+{
+	if (scheduler == NULL || clock == NULL) {
+		printf("Cannot initialize scheduler without a clock\n");
+		return false;
+	}
+
+	scheduler->clock = clock;
+	scheduler->size = 0;
+	for (int type = 0; type < SCHEDULER_EVENT_COUNT; type++) {
+		scheduler->events[type].deadline = SCHEDULER_NEVER;
+		scheduler->events[type].position = -1;
+		scheduler->events[type].callback = NULL;
+		scheduler->events[type].context = NULL;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Sets the function that handles an event type when it comes due
+ *
+ * The event is removed before the callback runs, so the callback is free
+ * to schedule the next one.
+ *
+ * @param scheduler scheduler to configure
+ * @param type SCHEDULER_EVENT_* type
+ * @param callback handler, called with context and the event's deadline
+ * @param context passed to the callback
+ */
+void scheduler_register(scheduler_t *scheduler, int type,
+			scheduler_callback_t callback, void *context)
+{
+	assert(scheduler != NULL && callback != NULL);
+	assert(type >= 0 && type < SCHEDULER_EVENT_COUNT);
+
+	scheduler->events[type].callback = callback;
+	scheduler->events[type].context = context;
+}
+
+/**
+ * @brief Schedules an event, replacing any pending event of the same type
+ *
+ * @param scheduler scheduler to add to
+ * @param type SCHEDULER_EVENT_* type with a registered callback
+ * @param deadline absolute cycle at which the event is due
+ */
+void scheduler_schedule(scheduler_t *scheduler, int type, uint64_t deadline)
+{
+	assert(scheduler != NULL && type >= 0 && type < SCHEDULER_EVENT_COUNT);
+	assert(scheduler->events[type].callback != NULL);
+
+	scheduler_event_t *event = &scheduler->events[type];
+	uint64_t old = event->deadline;
+
+	event->deadline = deadline;
+	if (event->position < 0) {
+		scheduler_place(scheduler, scheduler->size++, type);
+		scheduler_sift_up(scheduler, event->position);
+	} else if (deadline < old) {
+		scheduler_sift_up(scheduler, event->position);
+	} else {
+		scheduler_sift_down(scheduler, event->position);
+	}
+}
+
+void scheduler_cancel(scheduler_t *scheduler, int type)
+{
+	assert(scheduler != NULL && type >= 0 && type < SCHEDULER_EVENT_COUNT);
+
+	scheduler_event_t *event = &scheduler->events[type];
+	int position = event->position;
+
+	if (position < 0) {
+		return;
+	}
+
+	event->position = -1;
+	event->deadline = SCHEDULER_NEVER;
+	if (--scheduler->size == position) {
+		return;
+	}
+
+	/* Move the last entry into the hole and restore the heap around it */
+	int moved = scheduler->heap[scheduler->size];
+
+	scheduler_place(scheduler, position, moved);
+	scheduler_sift_up(scheduler, position);
+	scheduler_sift_down(scheduler, scheduler->events[moved].position);
+}
+
+void scheduler_cancel_all(scheduler_t *scheduler)
+{
+	assert(scheduler != NULL);
+
+	while (scheduler->size > 0) {
+		scheduler_cancel(scheduler, scheduler->heap[0]);
+	}
+}
+
+/**
+ * @brief Runs every event that is due by the clock, earliest first
+ *
+ * Events that callbacks schedule at or before the current cycle run in the
+ * same call.
+ *
+ * @param scheduler scheduler to dispatch from
+ */
+void scheduler_dispatch(scheduler_t *scheduler)
+{
+	assert(scheduler != NULL);
+
+	uint64_t now = scheduler_now(scheduler);
+
+	while (scheduler->size > 0) {
+		int type = scheduler->heap[0];
+		scheduler_event_t *event = &scheduler->events[type];
+		uint64_t deadline = event->deadline;
+
+		if (deadline > now) {
+			break;
+		}
+
+		scheduler_cancel(scheduler, type);
+		event->callback(event->context, deadline);
+	}
+}
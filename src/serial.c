@@ -0,0 +1,344 @@
+#include "../include/serial.h"
+#include "../include/link.h"
+#include "../include/scheduler.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define SERIAL_REGISTER(serial, reg) \
+	((serial)->mem_sys->high_page[MEMORY_PAGE_OFFSET(reg)])
+
+/* Unused SC bits read back as 1 */
+#define SERIAL_SC_UNUSED 0x7E
+
+/* What comes in with nothing on the other end */
+#define SERIAL_UNPLUGGED 0xFF
+
+/* How often a linked machine reports its time, unasked */
+#define SERIAL_REPORT_CYCLES (SERIAL_TRANSFER_CYCLES / 2)
+
+/*
+ * Room left below the horizon for the instruction and interrupt dispatch
+ * that can run past an event, so a byte from the peer never lands in the
+ * past
+ */
+#define SERIAL_LINK_SLACK 64
+
+static inline bool serial_linked(const serial_t *serial)
+{
+	return serial->link != NULL && serial->link->connected;
+}
+
+/* Running up to here cannot miss a transfer the peer has yet to start */
+static inline uint64_t serial_horizon(const serial_t *serial)
+{
+	return serial->peer_time + SERIAL_TRANSFER_CYCLES - SERIAL_LINK_SLACK;
+}
+
+static void serial_schedule(serial_t *serial)
+{
+	uint64_t deadline = MIN(serial->end, serial->incoming_end);
+
+	if (serial_linked(serial)) {
+		deadline = MIN(deadline, MIN(serial->next_report,
+					     serial_horizon(serial)));
+	}
+
+	if (deadline == SCHEDULER_NEVER) {
+		scheduler_cancel(serial->scheduler, SCHEDULER_EVENT_SERIAL);
+	} else {
+		scheduler_schedule(serial->scheduler, SCHEDULER_EVENT_SERIAL,
+				   deadline);
+	}
+}
+
+static void serial_send(serial_t *serial, byte type, uint64_t time, byte value)
+{
+	link_message_t message;
+
+	message.time = time - serial->base;
+	message.type = type;
+	message.value = value;
+	link_send(serial->link, &message);
+}
+
+/* Tells the peer how far this side has run, with everything queued before */
+static void serial_report(serial_t *serial)
+{
+	uint64_t now = scheduler_now(serial->scheduler);
+
+	serial_send(serial, LINK_MESSAGE_TIME, now, 0);
+	link_flush(serial->link);
+	serial->next_report = now + SERIAL_REPORT_CYCLES;
+}
+
+static void serial_handle(serial_t *serial, const link_message_t *message)
+{
+	uint64_t time = serial->base + message->time;
+
+	/* Every message is sent in time order, so each one is a report too */
+	serial->peer_time = MAX(serial->peer_time, time);
+
+	switch (message->type) {
+	case LINK_MESSAGE_START:
+		serial->incoming = message->value;
+		serial->incoming_end = time + SERIAL_TRANSFER_CYCLES;
+		break;
+	case LINK_MESSAGE_REPLY:
+		/* A reply to a transfer that was called off is stale */
+		if (time == serial->end) {
+			serial->reply = message->value;
+			serial->reply_ready = true;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static bool serial_receive(serial_t *serial, bool wait)
+{
+	link_message_t message;
+
+	if (!link_receive(serial->link, &message, wait)) {
+		return false;
+	}
+
+	serial_handle(serial, &message);
+	return true;
+}
+
+static void serial_finish(serial_t *serial, byte value)
+{
+	SERIAL_REGISTER(serial, SB_REGISTER) = value;
+	SERIAL_REGISTER(serial, SC_REGISTER) &= (byte)~SC_TRANSFER;
+	memory_request_interrupt(serial->mem_sys, INTERRUPT_SERIAL);
+}
+
+/*
+ * The peer's byte lands. Bits only shift if this side was waiting on the
+ * external clock; what was in SB goes back either way, as the peer reads
+ * whatever is on the line.
+ */
+static void serial_transfer_in(serial_t *serial)
+{
+	byte sc = SERIAL_REGISTER(serial, SC_REGISTER);
+	bool armed = (sc & (SC_TRANSFER | SC_INTERNAL_CLOCK)) == SC_TRANSFER;
+	byte reply = armed ? SERIAL_REGISTER(serial, SB_REGISTER) :
+			     SERIAL_UNPLUGGED;
+
+	if (armed) {
+		serial_finish(serial, serial->incoming);
+	}
+
+	/* The peer is waiting for this, so it goes out at once */
+	if (serial_linked(serial)) {
+		serial_send(serial, LINK_MESSAGE_REPLY, serial->incoming_end, reply);
+		link_flush(serial->link);
+	}
+
+	serial->incoming_end = SCHEDULER_NEVER;
+	serial->transfers++;
+}
+
+/* This side's transfer ends, with the peer's byte once it is there */
+static void serial_transfer_out(serial_t *serial)
+{
+	if (serial_linked(serial)) {
+		serial_report(serial);
+	}
+	while (serial_linked(serial) && !serial->reply_ready) {
+		serial_receive(serial, true);
+	}
+
+	if (serial->reply_ready) {
+		serial->transfers++;
+	}
+	serial_finish(serial, serial->reply_ready ? serial->reply :
+						    SERIAL_UNPLUGGED);
+	serial->end = SCHEDULER_NEVER;
+	serial->reply_ready = false;
+}
+
+static void serial_event(void *context, uint64_t deadline)
+{
+	UNUSED(deadline);
+	serial_t *serial = context;
+	uint64_t now = scheduler_now(serial->scheduler);
+
+	if (serial_linked(serial)) {
+		while (serial_receive(serial, false)) {
+		}
+
+		if (now >= serial->next_report || now >= serial_horizon(serial)) {
+			serial_report(serial);
+		}
+		while (serial_linked(serial) && now >= serial_horizon(serial)) {
+			serial_receive(serial, true);
+		}
+	}
+
+	/* Either way, bytes land in the order they were clocked */
+	while (MIN(serial->end, serial->incoming_end) <= now) {
+		if (serial->incoming_end <= serial->end) {
+			serial_transfer_in(serial);
+		} else {
+			serial_transfer_out(serial);
+		}
+	}
+
+	serial_schedule(serial);
+}
+
+static void serial_sc_write(memory_system_t *mem_sys, void *context,
+			    address addr, byte value)
+{
+	serial_t *serial = context;
+
+	mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)] = value | SERIAL_SC_UNUSED;
+
+	if (!(value & SC_TRANSFER)) {
+		serial->end = SCHEDULER_NEVER;
+	} else if ((value & SC_INTERNAL_CLOCK) && serial->end == SCHEDULER_NEVER) {
+		uint64_t now = scheduler_now(serial->scheduler);
+
+		serial->end = now + SERIAL_TRANSFER_CYCLES;
+		serial->reply_ready = false;
+
+		/* Goes out with the next report, which comes well before it lands */
+		if (serial_linked(serial)) {
+			serial_send(serial, LINK_MESSAGE_START, now,
+				    mem_sys->high_page[MEMORY_PAGE_OFFSET(SB_REGISTER)]);
+		}
+	}
+
+	serial_schedule(serial);
+}
+
+/**
+ * @brief Plugs a link cable into the serial port
+ *
+ * Both machines should attach at the same point, normally right after
+ * loading their cartridges: the cycle each attaches at is time 0 on the
+ * link.
+ *
+ * @param serial serial port of one machine
+ * @param link connected link to the other machine, kept by the caller
+ */
+void serial_attach(serial_t *serial, link_t *link)
+{
+	assert(serial != NULL && link != NULL);
+
+	serial->link = link;
+	serial->base = scheduler_now(serial->scheduler);
+	serial->peer_time = serial->base;
+	serial->next_report = serial->base + SERIAL_REPORT_CYCLES;
+	serial->reply_ready = false;
+	serial->incoming_end = SCHEDULER_NEVER;
+	serial_schedule(serial);
+}
+
+void serial_detach(serial_t *serial)
+{
+	assert(serial != NULL);
+
+	serial->link = NULL;
+	serial->incoming_end = SCHEDULER_NEVER;
+	serial_schedule(serial);
+}
+
+/**
+ * @brief Restarts serial events after end was replaced wholesale
+ *
+ * @param serial serial port to restart
+ */
+void serial_reschedule(serial_t *serial)
+{
+	assert(serial != NULL);
+
+	serial_schedule(serial);
+}
+
+/**
+ * @brief Cycles left of the transfer this side clocks, 0 when idle
+ *
+ * @param serial serial port to inspect
+ * @return remaining cycles, at most SERIAL_TRANSFER_CYCLES
+ */
+uint16_t serial_remaining(const serial_t *serial)
+{
+	assert(serial != NULL);
+
+	if (serial->end == SCHEDULER_NEVER) {
+		return 0;
+	}
+
+	return (uint16_t)(serial->end - scheduler_now(serial->scheduler));
+}
+
+/**
+ * @brief Resumes a transfer saved with serial_remaining()
+ *
+ * A byte the peer had in flight is not part of the machine and is lost.
+ *
+ * @param serial serial port to restore
+ * @param remaining cycles until the transfer completes, 0 when idle
+ */
+void serial_restore(serial_t *serial, uint16_t remaining)
+{
+	assert(serial != NULL);
+
+	serial->end = remaining > 0 ?
+			      scheduler_now(serial->scheduler) + remaining :
+			      SCHEDULER_NEVER;
+	serial->reply_ready = false;
+	serial->incoming_end = SCHEDULER_NEVER;
+	serial_schedule(serial);
+}
+
+bool serial_init(serial_t *serial, memory_system_t *mem_sys,
+		 scheduler_t *scheduler)
+{
+	if (serial == NULL || mem_sys == NULL || scheduler == NULL) {
+		printf("Cannot initialize serial port without memory system and scheduler\n");
+		return false;
+	}
+
+	serial->mem_sys = mem_sys;
+	serial->scheduler = scheduler;
+	serial->link = NULL;
+	serial->base = 0;
+	scheduler_register(scheduler, SCHEDULER_EVENT_SERIAL, serial_event,
+			   serial);
+	memory_register_io(mem_sys, SC_REGISTER, NULL, serial_sc_write, serial);
+	serial_reset(serial);
+
+	return true;
+}
+
+/**
+ * @brief Puts the port back into its post-boot state
+ *
+ * The cycle counter restarts with the machine, so the cable is unplugged;
+ * it has to be attached again.
+ *
+ * @param serial serial port to reset
+ */
+void serial_reset(serial_t *serial)
+{
+	assert(serial != NULL);
+
+	/* DMG register state after the boot ROM */
+	SERIAL_REGISTER(serial, SB_REGISTER) = 0x00;
+	SERIAL_REGISTER(serial, SC_REGISTER) = SERIAL_SC_UNUSED;
+	serial->link = NULL;
+	serial->end = SCHEDULER_NEVER;
+	serial->reply_ready = false;
+	serial->incoming_end = SCHEDULER_NEVER;
+	serial->transfers = 0;
+	serial_schedule(serial);
+}
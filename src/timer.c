@@ -0,0 +1,245 @@
+#include "../include/timer.h"
+#include "../include/scheduler.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TIMER_REGISTER(timer, reg) \
+	((timer)->mem_sys->high_page[MEMORY_PAGE_OFFSET(reg)])
+
+/* Unused TAC bits read back as 1 */
+#define TIMER_TAC_UNUSED 0xF8
+
+/* DMG counter value after the boot ROM */
+#define TIMER_BOOT_COUNTER 0xABCC
+
+/*
+ * TIMA ticks when the counter bit selected by TAC falls, i.e. every
+ * 1 << shift cycles: 4096, 262144, 65536 or 16384 Hz
+ */
+static const int timer_shifts[4] = { 10, 4, 6, 8 };
+
+static inline bool timer_enabled(const gb_timer_t *timer)
+{
+	return (TIMER_REGISTER(timer, TAC_REGISTER) & TAC_ENABLE) != 0;
+}
+
+static inline int timer_shift(const gb_timer_t *timer)
+{
+	return timer_shifts[TIMER_REGISTER(timer, TAC_REGISTER) & TAC_CLOCK_MASK];
+}
+
+/* Overflow reloads TMA and raises the interrupt in the same cycle */
+static void timer_increment(gb_timer_t *timer, uint64_t ticks)
+{
+	byte *tima = &TIMER_REGISTER(timer, TIMA_REGISTER);
+
+	while (ticks > 0) {
+		uint64_t room = 0x100 - *tima;
+
+		if (ticks < room) {
+			*tima = (byte)(*tima + ticks);
+			return;
+		}
+
+		ticks -= room;
+		*tima = TIMER_REGISTER(timer, TMA_REGISTER);
+		memory_request_interrupt(timer->mem_sys, INTERRUPT_TIMER);
+	}
+}
+
+static void timer_advance(gb_timer_t *timer, uint64_t clock)
+{
+	if (clock <= timer->clock) {
+		return;
+	}
+
+	uint64_t start = timer->counter;
+	uint64_t end = start + (clock - timer->clock);
+
+	if (timer_enabled(timer)) {
+		int shift = timer_shift(timer);
+
+		timer_increment(timer, (end >> shift) - (start >> shift));
+	}
+
+	timer->counter = (uint16_t)end;
+	timer->clock = clock;
+	TIMER_REGISTER(timer, DIV_REGISTER) = (byte)(timer->counter >> 8);
+}
+
+static void timer_schedule(gb_timer_t *timer)
+{
+	if (!timer_enabled(timer)) {
+		scheduler_cancel(timer->scheduler, SCHEDULER_EVENT_TIMER);
+		return;
+	}
+
+	int shift = timer_shift(timer);
+	uint64_t ticks = 0x100 - TIMER_REGISTER(timer, TIMA_REGISTER);
+	uint64_t overflow = ((timer->counter >> shift) + ticks) << shift;
+
+	scheduler_schedule(timer->scheduler, SCHEDULER_EVENT_TIMER,
+			   timer->clock + overflow - timer->counter);
+}
+
+static void timer_event(void *context, uint64_t deadline)
+{
+	gb_timer_t *timer = context;
+
+	timer_advance(timer, deadline);
+	timer_schedule(timer);
+}
+
+/**
+ * @brief Brings DIV and TIMA up to the scheduler's clock
+ *
+ * @param timer timer to update
+ */
+void timer_sync(gb_timer_t *timer)
+{
+	assert(timer != NULL);
+
+	timer_advance(timer, scheduler_now(timer->scheduler));
+}
+
+/**
+ * @brief Restarts the timer at the scheduler's current cycle
+ *
+ * Needed whenever the counter, the timer registers or the clock were
+ * replaced wholesale, as by a loaded state or a fork.
+ *
+ * @param timer timer to restart
+ */
+void timer_reschedule(gb_timer_t *timer)
+{
+	assert(timer != NULL);
+
+	timer->clock = scheduler_now(timer->scheduler);
+	TIMER_REGISTER(timer, DIV_REGISTER) = (byte)(timer->counter >> 8);
+	timer_schedule(timer);
+}
+
+/* DIV moves every 256 cycles, far more often than anything else changes */
+static byte timer_div_read(memory_system_t *mem_sys, void *context,
+			   address addr)
+{
+	UNUSED(mem_sys);
+	UNUSED(addr);
+	const gb_timer_t *timer = context;
+	uint64_t elapsed = scheduler_now(timer->scheduler) - timer->clock;
+
+	return (byte)((timer->counter + elapsed) >> 8);
+}
+
+static byte timer_tima_read(memory_system_t *mem_sys, void *context,
+			    address addr)
+{
+	UNUSED(addr);
+
+	timer_sync(context);
+	return mem_sys->high_page[MEMORY_PAGE_OFFSET(TIMA_REGISTER)];
+}
+
+/*
+ * Resetting the counter, or selecting another bit, can make the selected
+ * bit fall and tick TIMA just like the counter running would
+ */
+static void timer_set_counter(gb_timer_t *timer, uint16_t counter, byte tac)
+{
+	byte old_tac = TIMER_REGISTER(timer, TAC_REGISTER);
+	bool old_level = (old_tac & TAC_ENABLE) &&
+			 ((timer->counter >> (timer_shifts[old_tac & TAC_CLOCK_MASK] - 1)) & 1);
+	bool new_level = (tac & TAC_ENABLE) &&
+			 ((counter >> (timer_shifts[tac & TAC_CLOCK_MASK] - 1)) & 1);
+
+	if (old_level && !new_level) {
+		timer_increment(timer, 1);
+	}
+
+	timer->counter = counter;
+	TIMER_REGISTER(timer, TAC_REGISTER) = tac;
+	TIMER_REGISTER(timer, DIV_REGISTER) = (byte)(counter >> 8);
+}
+
+static void timer_div_write(memory_system_t *mem_sys, void *context,
+			    address addr, byte value)
+{
+	UNUSED(addr);
+	UNUSED(value);
+	gb_timer_t *timer = context;
+
+	timer_sync(timer);
+	timer_set_counter(timer, 0,
+			  mem_sys->high_page[MEMORY_PAGE_OFFSET(TAC_REGISTER)]);
+	timer_schedule(timer);
+}
+
+static void timer_tac_write(memory_system_t *mem_sys, void *context,
+			    address addr, byte value)
+{
+	UNUSED(mem_sys);
+	UNUSED(addr);
+	gb_timer_t *timer = context;
+
+	timer_sync(timer);
+	timer_set_counter(timer, timer->counter, value | TIMER_TAC_UNUSED);
+	timer_schedule(timer);
+}
+
+static void timer_tima_write(memory_system_t *mem_sys, void *context,
+			     address addr, byte value)
+{
+	gb_timer_t *timer = context;
+
+	timer_sync(timer);
+	mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)] = value;
+	timer_schedule(timer);
+}
+
+static void timer_tma_write(memory_system_t *mem_sys, void *context,
+			    address addr, byte value)
+{
+	/* Overflows up to now must still reload the old value */
+	timer_sync(context);
+	mem_sys->high_page[MEMORY_PAGE_OFFSET(addr)] = value;
+}
+
+bool timer_init(gb_timer_t *timer, memory_system_t *mem_sys,
+		scheduler_t *scheduler)
+{
+	if (timer == NULL || mem_sys == NULL || scheduler == NULL) {
+		printf("Cannot initialize timer without memory system and scheduler\n");
+		return false;
+	}
+
+	timer->mem_sys = mem_sys;
+	timer->scheduler = scheduler;
+	scheduler_register(scheduler, SCHEDULER_EVENT_TIMER, timer_event, timer);
+	memory_register_io(mem_sys, DIV_REGISTER, timer_div_read,
+			   timer_div_write, timer);
+	memory_register_io(mem_sys, TIMA_REGISTER, timer_tima_read,
+			   timer_tima_write, timer);
+	memory_register_io(mem_sys, TMA_REGISTER, NULL, timer_tma_write, timer);
+	memory_register_io(mem_sys, TAC_REGISTER, NULL, timer_tac_write, timer);
+	timer_reset(timer);
+
+	return true;
+}
+
+void timer_reset(gb_timer_t *timer)
+{
+	assert(timer != NULL);
+
+	/* DMG register state after the boot ROM */
+	timer->counter = TIMER_BOOT_COUNTER;
+	TIMER_REGISTER(timer, TIMA_REGISTER) = 0x00;
+	TIMER_REGISTER(timer, TMA_REGISTER) = 0x00;
+	TIMER_REGISTER(timer, TAC_REGISTER) = TIMER_TAC_UNUSED;
+
+	timer_reschedule(timer);
+}
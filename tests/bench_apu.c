@@ -0,0 +1,171 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/apu.h"
+#include "../include/ring_buffer.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// One minute of play
+#define BENCH_FRAMES 3600
+// Best of several runs, the machines this runs on are noisy
+#define BENCH_REPEATS 3
+// A quarter second of audio, far more than one frame makes
+#define BENCH_RING_SIZE (APU_SAMPLE_RATE / 4 * sizeof(apu_frame_t))
+// A 60 Hz frame is 70224 cycles
+#define BENCH_SECONDS (BENCH_FRAMES * 70224.0 / CPU_FREQUENCY)
+
+static byte rom_image[2 * ROM_BANK_SIZE];
+static apu_frame_t drain_buffer[APU_SAMPLE_RATE / 4];
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Music: all four channels play at full volume, and every VBlank the
+ * handler moves the square and wave pitches and retriggers the noise, so
+ * synthesis is split by register writes the way a sound driver splits it.
+ */
+static void build_rom(void)
+{
+    const byte vblank_handler[] = {
+        0xF5,               // PUSH AF
+        0xFA, 0x00, 0xC0,   // LD A, (0xC000)
+        0xC6, 0x07,         // ADD A, 7
+        0xEA, 0x00, 0xC0,   // LD (0xC000), A
+        0xE0, 0x13,         // LDH (NR13), A
+        0xE0, 0x18,         // LDH (NR23), A
+        0xE0, 0x1D,         // LDH (NR33), A
+        0x3E, 0x80,         // LD A, TRIGGER
+        0xE0, 0x23,         // LDH (NR44), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+    const byte setup[] = {
+        0x3E, 0x77,         // LD A, 0x77
+        0xE0, 0x24,         // LDH (NR50), A
+        0x3E, 0xFF,         // LD A, 0xFF
+        0xE0, 0x25,         // LDH (NR51), A
+        0x3E, 0xF0,         // LD A, 0xF0
+        0xE0, 0x12,         // LDH (NR12), A
+        0xE0, 0x17,         // LDH (NR22), A
+        0xE0, 0x21,         // LDH (NR42), A
+        0x3E, 0x86,         // LD A, TRIGGER | 6
+        0xE0, 0x14,         // LDH (NR14), A
+        0xE0, 0x19,         // LDH (NR24), A
+        0x3E, 0x80,         // LD A, DAC ON
+        0xE0, 0x1A,         // LDH (NR30), A
+        0x3E, 0x20,         // LD A, FULL VOLUME
+        0xE0, 0x1C,         // LDH (NR32), A
+        0x3E, 0x86,         // LD A, TRIGGER | 6
+        0xE0, 0x1E,         // LDH (NR34), A
+        0x3E, 0x45,         // LD A, 0x45
+        0xE0, 0x22,         // LDH (NR43), A
+        0x3E, 0x80,         // LD A, TRIGGER
+        0xE0, 0x23,         // LDH (NR44), A
+        0x3E, 0x01,         // LD A, VBLANK
+        0xE0, 0xFF,         // LDH (IE), A
+        0xFB,               // EI
+        0x76,               // HALT
+        0x18, 0xFD,         // JR -3
+    };
+
+    test_rom_init(rom_image, sizeof(rom_image), 0x00, 0x00);
+    test_rom_put(rom_image, TEST_ROM_MAIN, setup, sizeof(setup));
+    test_rom_put(rom_image, TEST_ROM_VBLANK_HANDLER, vblank_handler, sizeof(vblank_handler));
+}
+
+// Seconds for a minute of play; samples drained from the ring are counted
+static double bench_run(bool headless, ring_buffer_t *output, uint64_t *samples)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom_image, sizeof(rom_image))) {
+        printf("Failed to initialize benchmark machine\n");
+        exit(1);
+    }
+    gameboy_set_headless(gb, headless);
+    apu_set_output(&gb->apu, output);
+
+    // Let the setup code start every channel
+    gameboy_run_frame(gb);
+    if (output != NULL) {
+        ring_buffer_clear(output);
+    }
+
+    *samples = 0;
+    double begin = bench_now();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+
+        if (output != NULL) {
+            *samples += ring_buffer_read(output, drain_buffer, sizeof(drain_buffer)) /
+                        sizeof(apu_frame_t);
+        }
+    }
+    double elapsed = bench_now() - begin;
+
+    if (gb->apu.dropped != 0) {
+        printf("Benchmark dropped %llu samples\n",
+               (unsigned long long)gb->apu.dropped);
+        exit(1);
+    }
+
+    gameboy_cleanup(gb);
+    free(gb);
+    return elapsed;
+}
+
+int main(void)
+{
+    ring_buffer_t output;
+    double headless = 1e9;
+    double silent = 1e9;
+    double audio = 1e9;
+    uint64_t samples = 0;
+
+    printf("=== Game Boy APU Benchmark ===\n");
+    printf("best of %d runs of %d frames (one minute), four channels playing\n",
+           BENCH_REPEATS, BENCH_FRAMES);
+
+    build_rom();
+    if (!ring_buffer_init(&output, BENCH_RING_SIZE)) {
+        printf("Failed to allocate output ring\n");
+        return 1;
+    }
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        uint64_t count;
+
+        headless = MIN(headless, bench_run(true, NULL, &count));
+        silent = MIN(silent, bench_run(false, NULL, &count));
+        audio = MIN(audio, bench_run(false, &output, &samples));
+    }
+
+    double synthesis = audio - silent;
+
+    printf("headless:              %.3f s, %.0fx real time\n",
+           headless, BENCH_SECONDS / headless);
+    printf("rendering, no audio:   %.3f s, %.0fx real time\n",
+           silent, BENCH_SECONDS / silent);
+    printf("rendering with audio:  %.3f s, %.0fx real time\n",
+           audio, BENCH_SECONDS / audio);
+    printf("  %llu samples at %d Hz: %.2f Msamples/s of emulation\n",
+           (unsigned long long)samples, APU_SAMPLE_RATE,
+           samples / audio / 1e6);
+    printf("  synthesis %.1f us/frame, %.1f%% over rendering, %.1f ns/sample\n",
+           synthesis / BENCH_FRAMES * 1e6, 100.0 * synthesis / silent,
+           synthesis / samples * 1e9);
+
+    ring_buffer_cleanup(&output);
+    return 0;
+}
@@ -0,0 +1,124 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/cpu.h"
+#include "../include/memory.h"
+#include "../include/block_cache.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Emulated seconds per run
+#define BENCH_EMULATED_SECONDS 60
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * A loop mixing the instruction classes games spend their time in: memory
+ * copies through HL/DE, ALU work, conditional branches, calls, stack traffic
+ * and CB-prefixed bit operations.
+ */
+static const byte bench_program[] = {
+    // 0x0150 main:
+    0x21, 0x00, 0xC0,   // LD HL, 0xC000
+    0x11, 0x00, 0xC1,   // LD DE, 0xC100
+    0x06, 0x40,         // LD B, 0x40
+    // 0x0158 copy:
+    0x2A,               // LD A, (HL+)
+    0x12,               // LD (DE), A
+    0x13,               // INC DE
+    0x80,               // ADD A, B
+    0xA9,               // XOR C
+    0x4F,               // LD C, A
+    0xCB, 0x11,         // RL C
+    0x05,               // DEC B
+    0x20, 0xF5,         // JR NZ, copy
+    0xCD, 0x69, 0x01,   // CALL sub
+    0xC3, 0x50, 0x01,   // JP main
+    // 0x0169 sub:
+    0xC5,               // PUSH BC
+    0xE5,               // PUSH HL
+    0xF0, 0x80,         // LDH A, (0x80)
+    0xCB, 0x37,         // SWAP A
+    0x3C,               // INC A
+    0xE0, 0x80,         // LDH (0x80), A
+    0xE1,               // POP HL
+    0xC1,               // POP BC
+    0xC9,               // RET
+};
+
+static void bench_report(const char *name, uint64_t budget, double elapsed)
+{
+    double cycles_per_second = budget / elapsed;
+
+    printf("%-12s %d s emulated in %.3f s: %.1f M cycles/sec = %.1fx real-time\n",
+           name, BENCH_EMULATED_SECONDS, elapsed, cycles_per_second / 1e6,
+           cycles_per_second / CPU_FREQUENCY);
+}
+
+int main(void)
+{
+    static byte rom_image[2 * ROM_BANK_SIZE];
+    memory_system_t *mem_sys = malloc(sizeof(memory_system_t));
+    cpu_t cpu;
+
+    // Entry point jumps to the benchmark loop at 0x0150
+    rom_image[0x0100] = 0x00;
+    rom_image[0x0101] = 0xC3;
+    rom_image[0x0102] = 0x50;
+    rom_image[0x0103] = 0x01;
+    memcpy(rom_image + 0x0150, bench_program, sizeof(bench_program));
+
+    if (mem_sys == NULL || !memory_init(mem_sys) ||
+        !memory_load_rom_data(mem_sys, rom_image, sizeof(rom_image)) ||
+        !cpu_init(&cpu, mem_sys)) {
+        printf("Failed to initialize benchmark machine\n");
+        return 1;
+    }
+
+    printf("=== Game Boy CPU Benchmark ===\n");
+
+    uint64_t budget = (uint64_t)CPU_FREQUENCY * BENCH_EMULATED_SECONDS;
+    uint64_t instructions = 0;
+
+    double begin = bench_now();
+    uint64_t target = cpu.cycles + budget;
+    while (cpu.cycles < target) {
+        cpu_step(&cpu);
+        instructions++;
+    }
+    double elapsed = bench_now() - begin;
+
+    printf("emulated %d s (%llu cycles, %llu instructions) in %.3f s\n",
+           BENCH_EMULATED_SECONDS, (unsigned long long)budget,
+           (unsigned long long)instructions, elapsed);
+    printf("%.1f M instructions/sec\n", instructions / elapsed / 1e6);
+    bench_report("interpreter", budget, elapsed);
+
+    block_cache_t cache;
+    if (!block_cache_init(&cache)) {
+        return 1;
+    }
+
+    cpu_reset(&cpu);
+    begin = bench_now();
+    block_cache_run(&cache, &cpu, budget);
+    double cached_elapsed = bench_now() - begin;
+
+    bench_report("block cache", budget, cached_elapsed);
+    printf("block cache speedup: %.2fx (%llu blocks compiled)\n",
+           elapsed / cached_elapsed,
+           (unsigned long long)cache.blocks_compiled);
+
+    block_cache_cleanup(&cache);
+
+    memory_cleanup(mem_sys);
+    free(mem_sys);
+    return 0;
+}
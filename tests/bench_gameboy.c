@@ -0,0 +1,109 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// One minute of play
+#define BENCH_FRAMES 3600
+// Best of several runs, the machines this runs on are noisy
+#define BENCH_REPEATS 3
+
+static byte rom_image[2 * ROM_BANK_SIZE];
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * A game main loop: crunch on WRAM, then HALT until the VBlank handler has
+ * scrolled the screen, the way most games wait for the next frame.
+ */
+static void build_rom(void)
+{
+    const byte vblank_handler[] = {
+        0xF5,               // PUSH AF
+        0xFA, 0x00, 0xC8,   // LD A, (0xC800)
+        0x3C,               // INC A
+        0xEA, 0x00, 0xC8,   // LD (0xC800), A
+        0xE0, 0x43,         // LDH (SCX), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+    const byte main_loop[] = {
+        0x3E, 0x01,         // LD A, VBLANK
+        0xE0, 0xFF,         // LDH (IE), A
+        0xFB,               // EI
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0x06, 0x00,         // LD B, 0
+        0x7E,               // LD A, (HL)
+        0x80,               // ADD A, B
+        0x22,               // LD (HL+), A
+        0x05,               // DEC B
+        0x20, 0xFA,         // JR NZ, -6
+        0x76,               // HALT
+        0x18, 0xF2,         // JR -14
+    };
+
+    test_rom_init(rom_image, sizeof(rom_image), 0x00, 0x00);
+    test_rom_put(rom_image, TEST_ROM_MAIN, main_loop, sizeof(main_loop));
+    test_rom_put(rom_image, TEST_ROM_VBLANK_HANDLER, vblank_handler, sizeof(vblank_handler));
+}
+
+static double bench_run(bool headless, bool block_cache)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom_image, sizeof(rom_image))) {
+        printf("Failed to initialize benchmark machine\n");
+        exit(1);
+    }
+    gb->use_block_cache = block_cache;
+    gameboy_set_headless(gb, headless);
+
+    double begin = bench_now();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+    }
+    double elapsed = bench_now() - begin;
+
+    gameboy_cleanup(gb);
+    free(gb);
+    return elapsed;
+}
+
+static void bench_mode(bool headless, bool block_cache)
+{
+    double best = 1e9;
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        best = MIN(best, bench_run(headless, block_cache));
+    }
+
+    double emulated = (double)BENCH_FRAMES * PPU_CYCLES_PER_FRAME / CPU_FREQUENCY;
+    printf("%-9s %-12s %7.1f us/frame, %6.1fx real-time\n",
+           headless ? "headless" : "rendering",
+           block_cache ? "block cache" : "interpreter",
+           best / BENCH_FRAMES * 1e6, emulated / best);
+}
+
+int main(void)
+{
+    printf("=== Game Boy Machine Benchmark ===\n");
+    printf("best of %d runs of %d frames (one minute)\n", BENCH_REPEATS, BENCH_FRAMES);
+
+    build_rom();
+    bench_mode(false, false);
+    bench_mode(false, true);
+    bench_mode(true, false);
+    bench_mode(true, true);
+    return 0;
+}
@@ -0,0 +1,134 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/gameboy.h"
+#include "../include/jit.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// One minute of play
+#define BENCH_FRAMES 3600
+// Best of several runs, the machines this runs on are noisy
+#define BENCH_REPEATS 3
+
+#define BENCH_INTERPRETER 0
+#define BENCH_BLOCK_CACHE 1
+#define BENCH_JIT 2
+
+static byte rom_image[2 * ROM_BANK_SIZE];
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * A game that never waits for VBlank: a checksum over WRAM, table lookups
+ * and counters in HRAM, all from ROM, so the CPU core is all there is.
+ */
+static void build_rom(void)
+{
+    const byte vblank_handler[] = {
+        0xF5,               // PUSH AF
+        0xF0, 0x80,         // LDH A, (0x80)
+        0x3C,               // INC A
+        0xE0, 0x80,         // LDH (0x80), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+    const byte main_loop[] = {
+        0x3E, 0x01,         // LD A, VBLANK
+        0xE0, 0xFF,         // LDH (IE), A
+        0xFB,               // EI
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000    <- frame
+        0x11, 0x00, 0x00,   // LD DE, 0
+        0x06, 0x00,         // LD B, 0
+        0x7E,               // LD A, (HL)       <- inner
+        0x83,               // ADD A, E
+        0x5F,               // LD E, A
+        0x7A,               // LD A, D
+        0xCE, 0x00,         // ADC A, 0
+        0xA8,               // XOR B
+        0x57,               // LD D, A
+        0x22,               // LD (HL+), A
+        0x05,               // DEC B
+        0x20, 0xF4,         // JR NZ, inner
+        0x7B,               // LD A, E
+        0xEA, 0x00, 0xD0,   // LD (0xD000), A
+        0xF0, 0x81,         // LDH A, (0x81)
+        0x3C,               // INC A
+        0xE0, 0x81,         // LDH (0x81), A
+        0x18, 0xE0,         // JR frame
+    };
+
+    test_rom_init(rom_image, sizeof(rom_image), 0x00, 0x00);
+    test_rom_put(rom_image, TEST_ROM_MAIN, main_loop, sizeof(main_loop));
+    test_rom_put(rom_image, TEST_ROM_VBLANK_HANDLER, vblank_handler, sizeof(vblank_handler));
+}
+
+static double bench_run(int core, uint64_t *checksum)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom_image, sizeof(rom_image))) {
+        printf("Failed to initialize benchmark machine\n");
+        exit(1);
+    }
+    gb->use_block_cache = core == BENCH_BLOCK_CACHE;
+    gb->use_jit = core == BENCH_JIT;
+    gameboy_set_headless(gb, true);
+
+    double begin = bench_now();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+    }
+    double elapsed = bench_now() - begin;
+
+    // Every core has to end up in the same place
+    *checksum = gb->cpu.cycles ^ ((uint64_t)gb->memory.wram[0x1000] << 56) ^
+                ((uint64_t)gb->memory.high_page[0x81] << 48) ^
+                ((uint64_t)gb->cpu.d << 8) ^ gb->cpu.e;
+
+    gameboy_cleanup(gb);
+    free(gb);
+    return elapsed;
+}
+
+static uint64_t bench_core(int core, const char *name)
+{
+    double best = 1e9;
+    uint64_t checksum = 0;
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        best = MIN(best, bench_run(core, &checksum));
+    }
+
+    double emulated = (double)BENCH_FRAMES * PPU_CYCLES_PER_FRAME / CPU_FREQUENCY;
+    printf("%-12s %7.1f us/frame, %6.1fx real-time\n", name,
+           best / BENCH_FRAMES * 1e6, emulated / best);
+    return checksum;
+}
+
+int main(void)
+{
+    printf("=== Game Boy JIT Benchmark ===\n");
+    printf("best of %d headless runs of %d frames (one minute)\n",
+           BENCH_REPEATS, BENCH_FRAMES);
+
+    build_rom();
+    uint64_t interpreted = bench_core(BENCH_INTERPRETER, "interpreter");
+    uint64_t cached = bench_core(BENCH_BLOCK_CACHE, "block cache");
+    uint64_t translated = bench_core(BENCH_JIT, JIT_SUPPORTED ? "JIT" : "JIT (none)");
+
+    if (cached != interpreted || translated != interpreted) {
+        printf("Cores disagree on the final machine state\n");
+        return 1;
+    }
+    return 0;
+}
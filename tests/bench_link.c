@@ -0,0 +1,181 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/link.h"
+#include "../include/serial.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+// One minute of play
+#define BENCH_FRAMES 3600
+// Best of several runs, the machines this runs on are noisy
+#define BENCH_REPEATS 3
+
+static byte master_rom[2 * ROM_BANK_SIZE];
+static byte slave_rom[2 * ROM_BANK_SIZE];
+
+typedef struct bench_side {
+    gameboy_t *gb;
+    link_t link;
+    bool linked;
+    double elapsed;
+} bench_side_t;
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * The worst case for lock-step: the master clocks out a byte as soon as
+ * the last one is done, and the slave sleeps on the serial interrupt and
+ * answers each one, so a byte crosses the link every 4096 cycles for the
+ * whole minute. Both draw a busy screen meanwhile.
+ */
+static void build_roms(void)
+{
+    const byte master[] = {
+        0x3E, 0x91,         // LD A, 0x91       LCD on
+        0xE0, 0x40,         // LDH (LCDC), A
+        0x78,               // LD A, B
+        0xE0, 0x01,         // LDH (SB), A
+        0x3E, 0x81,         // LD A, TRANSFER | INTERNAL
+        0xE0, 0x02,         // LDH (SC), A
+        0xF0, 0x02,         // LDH A, (SC)
+        0xE0, 0x43,         // LDH (SCX), A
+        0xCB, 0x7F,         // BIT 7, A
+        0x20, 0xF8,         // JR NZ, -8
+        0xF0, 0x01,         // LDH A, (SB)
+        0x47,               // LD B, A
+        0xEA, 0x00, 0x98,   // LD (0x9800), A
+        0x18, 0xE9,         // JR -23
+    };
+    const byte slave[] = {
+        0x3E, 0x91,         // LD A, 0x91       LCD on
+        0xE0, 0x40,         // LDH (LCDC), A
+        0x3E, 0x08,         // LD A, SERIAL
+        0xE0, 0xFF,         // LDH (IE), A
+        0xAF,               // XOR A
+        0xE0, 0x0F,         // LDH (IF), A
+        0x3E, 0x80,         // LD A, TRANSFER
+        0xE0, 0x02,         // LDH (SC), A
+        0x76,               // HALT
+        0x00,               // NOP
+        0xF0, 0x01,         // LDH A, (SB)
+        0x3C,               // INC A
+        0xE0, 0x01,         // LDH (SB), A
+        0xE0, 0x42,         // LDH (SCY), A
+        0x18, 0xEE,         // JR -18
+    };
+    byte *roms[2] = { master_rom, slave_rom };
+
+    for (int i = 0; i < 2; i++) {
+        roms[i][0x0100] = 0xC3;   // JP 0x0150
+        roms[i][0x0101] = 0x50;
+        roms[i][0x0102] = 0x01;
+    }
+    memcpy(master_rom + 0x0150, master, sizeof(master));
+    memcpy(slave_rom + 0x0150, slave, sizeof(slave));
+}
+
+static gameboy_t *bench_machine(const byte *rom)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom, sizeof(master_rom))) {
+        printf("Failed to initialize benchmark machine\n");
+        exit(1);
+    }
+    return gb;
+}
+
+static void *bench_run(void *arg)
+{
+    bench_side_t *side = arg;
+
+    if (side->linked) {
+        serial_attach(&side->gb->serial, &side->link);
+    }
+
+    double begin = bench_now();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        gameboy_run_frame(side->gb);
+    }
+    side->elapsed = bench_now() - begin;
+
+    if (side->linked) {
+        link_close(&side->link);
+    }
+    return NULL;
+}
+
+// Runs both machines on their own threads, linked or not
+static void bench_pair(bench_side_t sides[2], bool linked)
+{
+    pthread_t threads[2];
+
+    sides[0].gb = bench_machine(master_rom);
+    sides[1].gb = bench_machine(slave_rom);
+    sides[0].linked = sides[1].linked = linked;
+    if (linked && !link_pair(&sides[0].link, &sides[1].link)) {
+        exit(1);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&threads[i], NULL, bench_run, &sides[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+static void bench_free(bench_side_t sides[2])
+{
+    for (int i = 0; i < 2; i++) {
+        gameboy_cleanup(sides[i].gb);
+        free(sides[i].gb);
+    }
+}
+
+int main(void)
+{
+    double times[2] = { 1e9, 1e9 };
+    uint64_t transfers = 0, waits = 0;
+
+    printf("=== Game Boy Link Cable Benchmark ===\n");
+    printf("best of %d runs of %d frames (one minute), a byte every 4096 cycles\n",
+           BENCH_REPEATS, BENCH_FRAMES);
+
+    build_roms();
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        for (int linked = 0; linked < 2; linked++) {
+            bench_side_t sides[2];
+
+            bench_pair(sides, linked);
+            times[linked] = MIN(times[linked],
+                                MAX(sides[0].elapsed, sides[1].elapsed));
+            if (linked) {
+                transfers = sides[0].gb->serial.transfers;
+                waits = sides[0].link.waits + sides[1].link.waits;
+            }
+            bench_free(sides);
+        }
+    }
+
+    double emulated = (double)BENCH_FRAMES * PPU_CYCLES_PER_FRAME / CPU_FREQUENCY;
+    printf("unplugged: %.1f us/frame, %.1fx real-time\n",
+           times[0] / BENCH_FRAMES * 1e6, emulated / times[0]);
+    printf("linked:    %.1f us/frame, %.1fx real-time, %.2fx unplugged\n",
+           times[1] / BENCH_FRAMES * 1e6, emulated / times[1],
+           times[1] / times[0]);
+    printf("%llu bytes exchanged, %llu waits for the peer\n",
+           (unsigned long long)transfers, (unsigned long long)waits);
+    return 0;
+}
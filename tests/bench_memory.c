@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/memory.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 50000000
+
+// Sink so the compiler cannot drop the reads
+static volatile byte bench_sink;
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_report(const char *name, long ops, double seconds)
+{
+    printf("%-28s %10.1f M ops/sec  (%.3f s)\n",
+           name, ops / seconds / 1e6, seconds);
+}
+
+static void bench_sequential_read(memory_system_t *mem_sys, const char *name,
+                                  address start, address size)
+{
+    byte acc = 0;
+    double begin = bench_now();
+    for (long i = 0; i < BENCH_ITERATIONS; i++) {
+        acc ^= memory_read_byte(mem_sys, start + (address)(i & (size - 1)));
+    }
+    double elapsed = bench_now() - begin;
+    bench_sink = acc;
+    bench_report(name, BENCH_ITERATIONS, elapsed);
+}
+
+static void bench_random_read(memory_system_t *mem_sys)
+{
+    // Pre-generate addresses so the RNG is not part of the measurement
+    enum { ADDRESS_COUNT = 1 << 16 };
+    address *addrs = malloc(ADDRESS_COUNT * sizeof(address));
+    if (addrs == NULL) {
+        return;
+    }
+
+    unsigned int seed = 0x1234;
+    for (int i = 0; i < ADDRESS_COUNT; i++) {
+        seed = seed * 1103515245 + 12345;
+        addrs[i] = (address)(seed >> 8);
+    }
+
+    byte acc = 0;
+    double begin = bench_now();
+    for (long i = 0; i < BENCH_ITERATIONS; i++) {
+        acc ^= memory_read_byte(mem_sys, addrs[i & (ADDRESS_COUNT - 1)]);
+    }
+    double elapsed = bench_now() - begin;
+    bench_sink = acc;
+    bench_report("random read (full map)", BENCH_ITERATIONS, elapsed);
+
+    free(addrs);
+}
+
+static void bench_sequential_write(memory_system_t *mem_sys, const char *name,
+                                   address start, address size)
+{
+    double begin = bench_now();
+    for (long i = 0; i < BENCH_ITERATIONS; i++) {
+        memory_write_byte(mem_sys, start + (address)(i & (size - 1)), (byte)i);
+    }
+    double elapsed = bench_now() - begin;
+    bench_report(name, BENCH_ITERATIONS, elapsed);
+}
+
+int main(void)
+{
+    memory_system_t *mem_sys = malloc(sizeof(memory_system_t));
+    if (mem_sys == NULL || !memory_init(mem_sys)) {
+        printf("Failed to initialize memory system\n");
+        return 1;
+    }
+
+    // Map a plain 32 KiB cartridge so ROM reads take the direct path
+    static byte rom_image[2 * ROM_BANK_SIZE];
+    if (!memory_load_rom_data(mem_sys, rom_image, sizeof(rom_image))) {
+        printf("Failed to load benchmark cartridge\n");
+        return 1;
+    }
+
+    printf("=== Game Boy Memory Bus Benchmark ===\n");
+    printf("%d operations per run\n\n", BENCH_ITERATIONS);
+
+    bench_sequential_read(mem_sys, "sequential read (ROM)", ROM_START, ROM_SIZE);
+    bench_sequential_read(mem_sys, "sequential read (VRAM)", VRAM_START, VRAM_SIZE);
+    bench_sequential_read(mem_sys, "sequential read (WRAM)", WRAM_START, WRAM_SIZE);
+    bench_random_read(mem_sys);
+    bench_sequential_write(mem_sys, "sequential write (VRAM)", VRAM_START, VRAM_SIZE);
+    bench_sequential_write(mem_sys, "sequential write (WRAM)", WRAM_START, WRAM_SIZE);
+
+    memory_cleanup(mem_sys);
+    free(mem_sys);
+    return 0;
+}
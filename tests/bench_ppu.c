@@ -0,0 +1,126 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/ppu.h"
+#include "../include/cpu.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_FRAMES 1000
+// Best of several runs, the machines this runs on are noisy
+#define BENCH_REPEATS 5
+#define BENCH_FRAME_RATE 59.73
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Busy frame: random tiles and maps, window over the lower half, 40 sprites
+static void fill_scene(memory_system_t *mem_sys)
+{
+    unsigned int seed = 12345;
+
+    for (int i = 0; i < VRAM_SIZE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        mem_sys->vram[i] = (byte)(seed >> 16);
+    }
+
+    for (int i = 0; i < PPU_SPRITE_COUNT; i++) {
+        mem_sys->oam[i * 4] = (byte)(16 + (i * 7) % SCREEN_HEIGHT);
+        mem_sys->oam[i * 4 + 1] = (byte)(8 + (i * 13) % SCREEN_WIDTH);
+        mem_sys->oam[i * 4 + 2] = (byte)i;
+        mem_sys->oam[i * 4 + 3] = (byte)((i & 3) << 5);
+    }
+
+    memory_write_byte(mem_sys, LCDC_REGISTER, 0xFF);
+    memory_write_byte(mem_sys, SCX_REGISTER, 5);
+    memory_write_byte(mem_sys, SCY_REGISTER, 3);
+    memory_write_byte(mem_sys, WY_REGISTER, 72);
+    memory_write_byte(mem_sys, WX_REGISTER, 7 + 40);
+    memory_write_byte(mem_sys, OBP0_REGISTER, 0xE4);
+    memory_write_byte(mem_sys, OBP1_REGISTER, 0x1B);
+}
+
+// Seconds the interpreter needs for one frame's worth of a tight ALU/load loop
+static double bench_cpu_frame(void)
+{
+    static byte rom_image[2 * ROM_BANK_SIZE];
+    static memory_system_t mem_sys;
+    cpu_t cpu;
+
+    const byte program[] = {
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0x06, 0x00,         // LD B, 0
+        0x7E,               // LD A, (HL)
+        0x80,               // ADD A, B
+        0x22,               // LD (HL+), A
+        0x05,               // DEC B
+        0x20, 0xFA,         // JR NZ, -6
+        0xC3, 0x00, 0x01,   // JP 0x0100
+    };
+    memcpy(rom_image + 0x0100, program, sizeof(program));
+
+    memory_init(&mem_sys);
+    memory_load_rom_data(&mem_sys, rom_image, sizeof(rom_image));
+    cpu_init(&cpu, &mem_sys);
+
+    double elapsed = 1e9;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        double begin = bench_now();
+        cpu_run(&cpu, (uint64_t)PPU_CYCLES_PER_FRAME * BENCH_FRAMES);
+        elapsed = MIN(elapsed, bench_now() - begin);
+    }
+
+    memory_cleanup(&mem_sys);
+    return elapsed / BENCH_FRAMES;
+}
+
+int main(void)
+{
+    memory_system_t *mem_sys = malloc(sizeof(memory_system_t));
+    ppu_t *ppu = malloc(sizeof(ppu_t));
+
+    if (mem_sys == NULL || ppu == NULL || !memory_init(mem_sys) ||
+        !ppu_init(ppu, mem_sys)) {
+        printf("Failed to initialize benchmark machine\n");
+        return 1;
+    }
+
+#ifdef PPU_SCALAR
+    printf("=== Game Boy PPU Benchmark (scalar) ===\n");
+#else
+    printf("=== Game Boy PPU Benchmark (SWAR) ===\n");
+#endif
+
+    fill_scene(mem_sys);
+
+    double elapsed = 1e9;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        double begin = bench_now();
+        for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+            ppu_step(ppu, PPU_CYCLES_PER_FRAME);
+        }
+        elapsed = MIN(elapsed, bench_now() - begin);
+    }
+
+    double frame_time = elapsed / BENCH_FRAMES;
+    double cpu_frame_time = bench_cpu_frame();
+
+    printf("best of %d runs: %d frames in %.3f s\n", BENCH_REPEATS, BENCH_FRAMES, elapsed);
+    printf("%.0f frames/sec = %.1fx real-time, %.1f us/frame\n",
+           BENCH_FRAMES / elapsed, BENCH_FRAMES / elapsed / BENCH_FRAME_RATE,
+           frame_time * 1e6);
+    printf("interpreter needs %.1f us/frame; rendering adds %.1f%%\n",
+           cpu_frame_time * 1e6, 100.0 * frame_time / cpu_frame_time);
+
+    memory_cleanup(mem_sys);
+    free(ppu);
+    free(mem_sys);
+    return 0;
+}
@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/rewind.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// One minute of play
+#define BENCH_FRAMES 3600
+// Best of several runs, the machines this runs on are noisy
+#define BENCH_REPEATS 3
+#define BENCH_BUDGET (64.0 * 1024 * 1024)
+
+static byte rom_image[4 * ROM_BANK_SIZE];
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * A busy game: the main loop keeps rewriting 1 KiB of WRAM, and every
+ * VBlank scrolls the screen, moves a sprite and changes the tile map. The
+ * cartridge has 32 KiB of RAM, which the snapshot has to cover as well.
+ */
+static void build_rom(void)
+{
+    const byte vblank_handler[] = {
+        0xF5,               // PUSH AF
+        0xFA, 0x00, 0xC8,   // LD A, (0xC800)
+        0x3C,               // INC A
+        0xEA, 0x00, 0xC8,   // LD (0xC800), A
+        0xE0, 0x43,         // LDH (SCX), A
+        0xEA, 0x00, 0xFE,   // LD (0xFE00), A
+        0xEA, 0x00, 0x98,   // LD (0x9800), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+    const byte main_loop[] = {
+        0x3E, 0x01,         // LD A, VBLANK
+        0xE0, 0xFF,         // LDH (IE), A
+        0xFB,               // EI
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0x0E, 0x04,         // LD C, 4
+        0x06, 0x00,         // LD B, 0
+        0x7E,               // LD A, (HL)
+        0x80,               // ADD A, B
+        0x22,               // LD (HL+), A
+        0x05,               // DEC B
+        0x20, 0xFA,         // JR NZ, -6
+        0x0D,               // DEC C
+        0x20, 0xF5,         // JR NZ, -11
+        0x18, 0xEE,         // JR -18
+    };
+
+    test_rom_init(rom_image, sizeof(rom_image), 0x03, 0x03);
+    test_rom_put(rom_image, TEST_ROM_MAIN, main_loop, sizeof(main_loop));
+    test_rom_put(rom_image, TEST_ROM_VBLANK_HANDLER, vblank_handler, sizeof(vblank_handler));
+}
+
+// Seconds for a minute of play; capture time is added up separately
+static double bench_run(bool headless, rewind_t *rewind, double *capture_time)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom_image, sizeof(rom_image))) {
+        printf("Failed to initialize benchmark machine\n");
+        exit(1);
+    }
+    gameboy_set_headless(gb, headless);
+
+    if (rewind != NULL && !rewind_init(rewind, gb, 0, BENCH_FRAMES)) {
+        exit(1);
+    }
+
+    *capture_time = 0;
+    double begin = bench_now();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+
+        if (rewind != NULL) {
+            double capture_begin = bench_now();
+            rewind_capture(rewind, gb);
+            *capture_time += bench_now() - capture_begin;
+        }
+    }
+    double elapsed = bench_now() - begin;
+
+    gameboy_cleanup(gb);
+    free(gb);
+    return elapsed;
+}
+
+static void bench_mode(bool headless)
+{
+    double plain = 1e9;
+    double with_capture = 1e9;
+    double capture = 1e9;
+    size_t used = 0;
+    int frames = 0;
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        rewind_t rewind;
+        double capture_time;
+
+        plain = MIN(plain, bench_run(headless, NULL, &capture_time));
+        with_capture = MIN(with_capture, bench_run(headless, &rewind, &capture_time));
+        capture = MIN(capture, capture_time);
+
+        used = rewind_memory_used(&rewind);
+        frames = rewind_frames(&rewind);
+        rewind_cleanup(&rewind);
+    }
+
+    double frame_time = plain / BENCH_FRAMES;
+    double capture_frame_time = capture / BENCH_FRAMES;
+
+    printf("%s:\n", headless ? "headless" : "rendering");
+    printf("  emulation %.1f us/frame, capture %.1f us/frame: %.1f%% overhead\n",
+           frame_time * 1e6, capture_frame_time * 1e6,
+           100.0 * capture_frame_time / frame_time);
+    printf("  wall time with capture %.3f s vs %.3f s\n", with_capture, plain);
+    printf("  %d frames kept in %.2f MiB: %.0f bytes/frame, %.2f MiB/minute, "
+           "%.1f minutes in 64 MiB\n",
+           frames, used / (1024.0 * 1024.0), (double)used / frames,
+           used / (1024.0 * 1024.0), BENCH_BUDGET / used);
+}
+
+int main(void)
+{
+    printf("=== Game Boy Rewind Benchmark ===\n");
+    printf("best of %d runs of %d frames (one minute)\n", BENCH_REPEATS, BENCH_FRAMES);
+
+    build_rom();
+    bench_mode(false);
+    bench_mode(true);
+    return 0;
+}
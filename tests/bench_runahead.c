@@ -0,0 +1,164 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/runahead.h"
+#include "../include/ring_buffer.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// One minute of play
+#define BENCH_FRAMES 3600
+// Best of several runs, the machines this runs on are noisy
+#define BENCH_REPEATS 3
+#define BENCH_RING_SIZE (APU_SAMPLE_RATE / 4 * sizeof(apu_frame_t))
+
+static byte rom_image[4 * ROM_BANK_SIZE];
+static apu_frame_t drain_buffer[APU_SAMPLE_RATE / 4];
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * A busy game: the main loop keeps rewriting 1 KiB of WRAM, and every
+ * VBlank scrolls the screen, moves a sprite and changes the tile map. The
+ * cartridge has 32 KiB of RAM, which the snapshot has to cover as well.
+ */
+static void build_rom(void)
+{
+    const byte vblank_handler[] = {
+        0xF5,               // PUSH AF
+        0xFA, 0x00, 0xC8,   // LD A, (0xC800)
+        0x3C,               // INC A
+        0xEA, 0x00, 0xC8,   // LD (0xC800), A
+        0xE0, 0x43,         // LDH (SCX), A
+        0xEA, 0x00, 0xFE,   // LD (0xFE00), A
+        0xEA, 0x00, 0x98,   // LD (0x9800), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+    const byte main_loop[] = {
+        0x3E, 0x01,         // LD A, VBLANK
+        0xE0, 0xFF,         // LDH (IE), A
+        0xFB,               // EI
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0x0E, 0x04,         // LD C, 4
+        0x06, 0x00,         // LD B, 0
+        0x7E,               // LD A, (HL)
+        0x80,               // ADD A, B
+        0x22,               // LD (HL+), A
+        0x05,               // DEC B
+        0x20, 0xFA,         // JR NZ, -6
+        0x0D,               // DEC C
+        0x20, 0xF5,         // JR NZ, -11
+        0x18, 0xEE,         // JR -18
+    };
+
+    test_rom_init(rom_image, sizeof(rom_image), 0x03, 0x03);
+    test_rom_put(rom_image, TEST_ROM_MAIN, main_loop, sizeof(main_loop));
+    test_rom_put(rom_image, TEST_ROM_VBLANK_HANDLER, vblank_handler, sizeof(vblank_handler));
+}
+
+static gameboy_t *bench_machine(ring_buffer_t *output)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom_image, sizeof(rom_image))) {
+        printf("Failed to initialize benchmark machine\n");
+        exit(1);
+    }
+    apu_set_output(&gb->apu, output);
+    return gb;
+}
+
+// Seconds for a minute of play, drawing and making audio as a player would
+static double bench_run(int frames_ahead, ring_buffer_t *output)
+{
+    gameboy_t *gb = bench_machine(output);
+    runahead_t runahead;
+
+    if (!runahead_init(&runahead, gb, frames_ahead)) {
+        exit(1);
+    }
+
+    double begin = bench_now();
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        joypad_set_buttons(&gb->joypad, (byte)(frame / 30));
+        runahead_run_frame(&runahead, gb);
+        ring_buffer_read(output, drain_buffer, sizeof(drain_buffer));
+    }
+    double elapsed = bench_now() - begin;
+
+    runahead_cleanup(&runahead);
+    gameboy_cleanup(gb);
+    free(gb);
+    return elapsed;
+}
+
+// Seconds for one save and one restore, averaged over a minute of them
+static double bench_state(ring_buffer_t *output)
+{
+    gameboy_t *gb = bench_machine(output);
+    gameboy_state_t state;
+    double spent = 0;
+
+    if (!gameboy_state_init(&state, gb)) {
+        exit(1);
+    }
+
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+
+        double begin = bench_now();
+        gameboy_save_state(gb, &state);
+        gameboy_restore_state(gb, &state);
+        spent += bench_now() - begin;
+        ring_buffer_read(output, drain_buffer, sizeof(drain_buffer));
+    }
+
+    gameboy_state_cleanup(&state);
+    gameboy_cleanup(gb);
+    free(gb);
+    return spent / BENCH_FRAMES;
+}
+
+int main(void)
+{
+    ring_buffer_t output;
+    double times[3] = { 1e9, 1e9, 1e9 };
+    double state_time = 1e9;
+
+    printf("=== Game Boy Run-Ahead Benchmark ===\n");
+    printf("best of %d runs of %d frames (one minute), drawing with audio\n",
+           BENCH_REPEATS, BENCH_FRAMES);
+
+    build_rom();
+    if (!ring_buffer_init(&output, BENCH_RING_SIZE)) {
+        return 1;
+    }
+
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        for (int frames = 0; frames < 3; frames++) {
+            times[frames] = MIN(times[frames], bench_run(frames, &output));
+        }
+        state_time = MIN(state_time, bench_state(&output));
+    }
+
+    printf("save + restore: %.2f us\n", state_time * 1e6);
+    for (int frames = 0; frames < 3; frames++) {
+        printf("%d frame%s ahead: %.1f us/frame, %.2fx a plain frame\n",
+               frames, frames == 1 ? "" : "s",
+               times[frames] / BENCH_FRAMES * 1e6, times[frames] / times[0]);
+    }
+
+    ring_buffer_cleanup(&output);
+    return 0;
+}
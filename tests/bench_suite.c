@@ -0,0 +1,614 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/gameboy.h"
+#include "../include/memory.h"
+#include "../include/cpu.h"
+#include "../include/block_cache.h"
+#include "../include/jit.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Regression benchmarks for CI. Every benchmark is run a few times to warm
+ * caches and branch predictors, then timed over a number of runs with the
+ * monotonic clock; the median and the 99th percentile (nearest rank) of the
+ * time per operation are reported, on stdout as a table and optionally as
+ * JSON for comparing versions:
+ *
+ *   bench_suite [--runs N] [--warmup N] [--json FILE]
+ */
+
+#define BENCH_DEFAULT_RUNS 21
+#define BENCH_DEFAULT_WARMUP 3
+#define BENCH_MAX_RUNS 1001
+#define BENCH_MAX_RESULTS 64
+#define BENCH_JSON_SCHEMA 1
+
+// Bus operations per run, a few milliseconds' worth
+#define BENCH_BUS_OPS (1 << 20)
+// Emulated time per CPU run, and frames per machine run
+#define BENCH_CPU_CYCLES (CPU_FREQUENCY / 8)
+#define BENCH_FRAMES 30
+// Cartridge written out for the loader benchmarks
+#define BENCH_ROM_PATH "/tmp/gameboy_bench_suite.gb"
+#define BENCH_ROM_BANKS 64
+
+typedef uint64_t (*bench_fn_t)(void *context);
+
+typedef struct bench_result {
+    char name[64];
+    const char *unit;
+    int runs;
+    uint64_t ops;
+    double median_ns;
+    double p99_ns;
+    double min_ns;
+    double mean_ns;
+} bench_result_t;
+
+typedef struct bench_bus {
+    memory_system_t *mem_sys;
+    address start;
+    address size;
+    const address *random;
+} bench_bus_t;
+
+typedef struct bench_core {
+    memory_system_t *mem_sys;
+    cpu_t cpu;
+    block_cache_t *cache;
+    jit_t *jit;
+    int core;
+} bench_core_t;
+
+static int bench_runs = BENCH_DEFAULT_RUNS;
+static int bench_warmup = BENCH_DEFAULT_WARMUP;
+static bench_result_t bench_results[BENCH_MAX_RESULTS];
+static int bench_result_count = 0;
+
+// Sink so the compiler cannot drop the reads
+static volatile byte bench_sink;
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted samples
+static double bench_percentile(const double *sorted, int count, int percent)
+{
+    int rank = (percent * count + 99) / 100;
+    return sorted[MAX(rank, 1) - 1];
+}
+
+/*
+ * Times fn, which does some number of operations and returns how many.
+ * Per-run times are turned into nanoseconds per operation before the
+ * statistics, so runs that do different amounts of work still compare.
+ */
+static void bench_measure(const char *name, const char *unit, bench_fn_t fn,
+                          void *context)
+{
+    static double samples[BENCH_MAX_RUNS];
+    uint64_t ops = 0;
+
+    for (int i = 0; i < bench_warmup; i++) {
+        fn(context);
+    }
+
+    double total = 0;
+    for (int i = 0; i < bench_runs; i++) {
+        double begin = bench_now();
+        ops = fn(context);
+        double elapsed = bench_now() - begin;
+
+        samples[i] = elapsed * 1e9 / (double)MAX(ops, 1);
+        total += samples[i];
+    }
+    qsort(samples, (size_t)bench_runs, sizeof(samples[0]), bench_compare);
+
+    if (bench_result_count == BENCH_MAX_RESULTS) {
+        printf("Too many benchmarks\n");
+        exit(1);
+    }
+    bench_result_t *result = &bench_results[bench_result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->unit = unit;
+    result->runs = bench_runs;
+    result->ops = ops;
+    result->median_ns = bench_percentile(samples, bench_runs, 50);
+    result->p99_ns = bench_percentile(samples, bench_runs, 99);
+    result->min_ns = samples[0];
+    result->mean_ns = total / bench_runs;
+
+    printf("%-34s %12.3f ns/%-6s p99 %12.3f %12.4g %s/s\n", name,
+           result->median_ns, unit, result->p99_ns,
+           1e9 / result->median_ns, unit);
+}
+
+static bool bench_write_json(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Cannot write %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"schema\": %d,\n  \"runs\": %d,\n  \"warmup\": %d,\n"
+            "  \"results\": [\n", BENCH_JSON_SCHEMA, bench_runs, bench_warmup);
+    for (int i = 0; i < bench_result_count; i++) {
+        const bench_result_t *r = &bench_results[i];
+
+        fprintf(file, "    { \"name\": \"%s\", \"unit\": \"%s\", "
+                "\"ops_per_run\": %llu, \"median_ns\": %.4f, "
+                "\"p99_ns\": %.4f, \"min_ns\": %.4f, \"mean_ns\": %.4f, "
+                "\"per_second\": %.1f }%s\n",
+                r->name, r->unit, (unsigned long long)r->ops, r->median_ns,
+                r->p99_ns, r->min_ns, r->mean_ns, 1e9 / r->median_ns,
+                i + 1 < bench_result_count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    return fclose(file) == 0;
+}
+
+/* --- Memory bus --- */
+
+static uint64_t bench_sequential_read(void *context)
+{
+    const bench_bus_t *bus = context;
+    byte acc = 0;
+
+    for (uint32_t i = 0; i < BENCH_BUS_OPS; i++) {
+        acc ^= memory_read_byte(bus->mem_sys,
+                                bus->start + (address)(i & (bus->size - 1)));
+    }
+    bench_sink = acc;
+    return BENCH_BUS_OPS;
+}
+
+static uint64_t bench_sequential_write(void *context)
+{
+    const bench_bus_t *bus = context;
+
+    for (uint32_t i = 0; i < BENCH_BUS_OPS; i++) {
+        memory_write_byte(bus->mem_sys,
+                          bus->start + (address)(i & (bus->size - 1)),
+                          (byte)i);
+    }
+    return BENCH_BUS_OPS;
+}
+
+static uint64_t bench_random_read(void *context)
+{
+    const bench_bus_t *bus = context;
+    byte acc = 0;
+
+    for (uint32_t i = 0; i < BENCH_BUS_OPS; i++) {
+        acc ^= memory_read_byte(bus->mem_sys, bus->random[i & 0xFFFF]);
+    }
+    bench_sink = acc;
+    return BENCH_BUS_OPS;
+}
+
+static uint64_t bench_random_write(void *context)
+{
+    const bench_bus_t *bus = context;
+
+    for (uint32_t i = 0; i < BENCH_BUS_OPS; i++) {
+        address offset = bus->random[i & 0xFFFF] & (bus->size - 1);
+        memory_write_byte(bus->mem_sys, bus->start + offset, (byte)i);
+    }
+    return BENCH_BUS_OPS;
+}
+
+static uint64_t bench_word_read(void *context)
+{
+    const bench_bus_t *bus = context;
+    word acc = 0;
+
+    for (uint32_t i = 0; i < BENCH_BUS_OPS; i += 2) {
+        acc ^= memory_read_word(bus->mem_sys,
+                                bus->start + (address)(i & (bus->size - 2)));
+    }
+    bench_sink = (byte)acc;
+    return BENCH_BUS_OPS / 2;
+}
+
+static uint64_t bench_word_write(void *context)
+{
+    const bench_bus_t *bus = context;
+
+    for (uint32_t i = 0; i < BENCH_BUS_OPS; i += 2) {
+        memory_write_word(bus->mem_sys,
+                          bus->start + (address)(i & (bus->size - 2)),
+                          (word)i);
+    }
+    return BENCH_BUS_OPS / 2;
+}
+
+// Operations are bytes moved
+static uint64_t bench_block_read(void *context)
+{
+    const bench_bus_t *bus = context;
+    static byte out[MEMORY_SIZE];
+    uint64_t copied = 0;
+
+    while (copied < BENCH_BUS_OPS * 8ull) {
+        memory_read_block(bus->mem_sys, bus->start, out, bus->size);
+        copied += bus->size;
+    }
+    bench_sink = out[bus->size - 1];
+    return copied;
+}
+
+typedef struct bench_region {
+    const char *name;
+    address start;
+    address size;
+    bool writable;
+} bench_region_t;
+
+static void bench_memory(memory_system_t *mem_sys)
+{
+    static const bench_region_t regions[] = {
+        { "ROM", ROM_START, ROM_SIZE, false },
+        { "VRAM", VRAM_START, VRAM_SIZE, true },
+        { "ERAM", ERAM_START, 0x2000, true },
+        { "WRAM", WRAM_START, WRAM_SIZE, true },
+        { "OAM", OAM_START, 0x80, true },
+        { "IO", IO_REGISTERS_START, 0x40, false },
+        { "HRAM", HRAM_START, 0x40, true },
+    };
+    static address random[0x10000];
+    char name[64];
+
+    unsigned int seed = 0x1234;
+    for (int i = 0; i < 0x10000; i++) {
+        seed = seed * 1103515245 + 12345;
+        random[i] = (address)(seed >> 8);
+    }
+
+    for (size_t i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        const bench_region_t *region = &regions[i];
+        bench_bus_t bus = { mem_sys, region->start, region->size, random };
+
+        snprintf(name, sizeof(name), "memory/read/sequential/%s", region->name);
+        bench_measure(name, "op", bench_sequential_read, &bus);
+        if (region->writable) {
+            snprintf(name, sizeof(name), "memory/write/sequential/%s",
+                     region->name);
+            bench_measure(name, "op", bench_sequential_write, &bus);
+            snprintf(name, sizeof(name), "memory/write/random/%s",
+                     region->name);
+            bench_measure(name, "op", bench_random_write, &bus);
+        }
+    }
+
+    bench_bus_t full = { mem_sys, 0, 0, random };
+    bench_measure("memory/read/random/all", "op", bench_random_read, &full);
+
+    bench_bus_t wram = { mem_sys, WRAM_START, WRAM_SIZE, random };
+    bench_measure("memory/word/read/WRAM", "op", bench_word_read, &wram);
+    bench_measure("memory/word/write/WRAM", "op", bench_word_write, &wram);
+    bench_measure("memory/block/read/WRAM", "byte", bench_block_read, &wram);
+
+    bench_bus_t rom = { mem_sys, ROM_START, ROM_SIZE, random };
+    bench_measure("memory/block/read/ROM", "byte", bench_block_read, &rom);
+}
+
+/* --- ROM loading --- */
+
+static bool bench_write_cartridge(const char *path)
+{
+    static byte bank[ROM_BANK_SIZE];
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < BENCH_ROM_BANKS; i++) {
+        memset(bank, i, sizeof(bank));
+        if (i == 0) {
+            bank[CARTRIDGE_TYPE_ADDRESS] = 0x19;   // MBC5
+            bank[CARTRIDGE_ROM_SIZE_ADDRESS] = 0x05; // 64 banks
+            bank[CARTRIDGE_RAM_SIZE_ADDRESS] = 0x00;
+        }
+        if (fwrite(bank, 1, sizeof(bank), file) != sizeof(bank)) {
+            fclose(file);
+            return false;
+        }
+    }
+
+    return fclose(file) == 0;
+}
+
+// Operations are whole loads
+static uint64_t bench_load(void *context)
+{
+    static memory_system_t mem_sys;
+    bool mapped = *(const bool *)context;
+
+    memory_init(&mem_sys);
+    bool ok = mapped ? memory_load_rom_mapped(&mem_sys, BENCH_ROM_PATH) :
+                       memory_load_rom(&mem_sys, BENCH_ROM_PATH);
+    if (!ok) {
+        printf("Failed to load benchmark cartridge\n");
+        exit(1);
+    }
+    bench_sink = memory_read_byte(&mem_sys, 0x4000);
+    memory_cleanup(&mem_sys);
+    return 1;
+}
+
+static void bench_loading(void)
+{
+    static const bool fread_load = false;
+    static const bool mapped_load = true;
+
+    if (!bench_write_cartridge(BENCH_ROM_PATH)) {
+        printf("Failed to write benchmark cartridge\n");
+        exit(1);
+    }
+
+    bench_measure("rom/load/fread/1MiB", "load", bench_load, (void *)&fread_load);
+    bench_measure("rom/load/mmap/1MiB", "load", bench_load, (void *)&mapped_load);
+    remove(BENCH_ROM_PATH);
+}
+
+/* --- CPU --- */
+
+#define BENCH_CORE_INTERPRETER 0
+#define BENCH_CORE_BLOCK_CACHE 1
+#define BENCH_CORE_JIT 2
+
+/*
+ * Copies through HL/DE, ALU work, branches, calls, stack traffic and
+ * CB-prefixed bit operations, the mix games spend their time in
+ */
+static const byte bench_program[] = {
+    0x21, 0x00, 0xC0,   // LD HL, 0xC000    <- main
+    0x11, 0x00, 0xC1,   // LD DE, 0xC100
+    0x06, 0x40,         // LD B, 0x40
+    0x2A,               // LD A, (HL+)      <- copy
+    0x12,               // LD (DE), A
+    0x13,               // INC DE
+    0x80,               // ADD A, B
+    0xA9,               // XOR C
+    0x4F,               // LD C, A
+    0xCB, 0x11,         // RL C
+    0x05,               // DEC B
+    0x20, 0xF5,         // JR NZ, copy
+    0xCD, 0x69, 0x01,   // CALL sub
+    0xC3, 0x50, 0x01,   // JP main
+    0xC5,               // PUSH BC          <- sub
+    0xE5,               // PUSH HL
+    0xF0, 0x80,         // LDH A, (0x80)
+    0xCB, 0x37,         // SWAP A
+    0x3C,               // INC A
+    0xE0, 0x80,         // LDH (0x80), A
+    0xE1,               // POP HL
+    0xC1,               // POP BC
+    0xC9,               // RET
+};
+
+// Operations are instructions
+static uint64_t bench_instructions(void *context)
+{
+    bench_core_t *core = context;
+    uint64_t target = core->cpu.cycles + BENCH_CPU_CYCLES;
+    uint64_t instructions = 0;
+
+    while (core->cpu.cycles < target) {
+        cpu_step(&core->cpu);
+        instructions++;
+    }
+    return instructions;
+}
+
+// Operations are emulated T-cycles
+static uint64_t bench_cycles(void *context)
+{
+    bench_core_t *core = context;
+
+    switch (core->core) {
+    case BENCH_CORE_BLOCK_CACHE:
+        return block_cache_run(core->cache, &core->cpu, BENCH_CPU_CYCLES);
+    case BENCH_CORE_JIT:
+        return jit_run(core->jit, &core->cpu, BENCH_CPU_CYCLES);
+    default:
+        return cpu_run(&core->cpu, BENCH_CPU_CYCLES);
+    }
+}
+
+static void bench_cpu(void)
+{
+    static byte rom_image[2 * ROM_BANK_SIZE];
+    static bench_core_t core;
+    static block_cache_t cache;
+    static jit_t jit;
+
+    rom_image[0x0100] = 0x00;
+    rom_image[0x0101] = 0xC3;   // JP 0x0150
+    rom_image[0x0102] = 0x50;
+    rom_image[0x0103] = 0x01;
+    memcpy(rom_image + 0x0150, bench_program, sizeof(bench_program));
+
+    core.mem_sys = malloc(sizeof(memory_system_t));
+    core.cache = &cache;
+    core.jit = &jit;
+    if (core.mem_sys == NULL || !memory_init(core.mem_sys) ||
+        !memory_load_rom_data(core.mem_sys, rom_image, sizeof(rom_image)) ||
+        !cpu_init(&core.cpu, core.mem_sys) || !block_cache_init(&cache) ||
+        !jit_init(&jit)) {
+        printf("Failed to initialize benchmark cpu\n");
+        exit(1);
+    }
+
+    core.core = BENCH_CORE_INTERPRETER;
+    bench_measure("cpu/interpreter/instructions", "instr",
+                  bench_instructions, &core);
+    bench_measure("cpu/interpreter/cycles", "cycle", bench_cycles, &core);
+
+    cpu_reset(&core.cpu);
+    core.core = BENCH_CORE_BLOCK_CACHE;
+    bench_measure("cpu/block_cache/cycles", "cycle", bench_cycles, &core);
+
+    if (jit.available) {
+        cpu_reset(&core.cpu);
+        core.core = BENCH_CORE_JIT;
+        bench_measure("cpu/jit/cycles", "cycle", bench_cycles, &core);
+    }
+
+    jit_cleanup(&jit);
+    block_cache_cleanup(&cache);
+    memory_cleanup(core.mem_sys);
+    free(core.mem_sys);
+}
+
+/* --- Whole machine --- */
+
+// Operations are frames
+static uint64_t bench_frames(void *context)
+{
+    gameboy_t *gb = context;
+
+    for (int frame = 0; frame < BENCH_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+    }
+    return BENCH_FRAMES;
+}
+
+/*
+ * A game main loop: crunch on WRAM, then HALT until the VBlank handler has
+ * scrolled the screen
+ */
+static void bench_machine(void)
+{
+    static byte rom_image[2 * ROM_BANK_SIZE];
+    const byte vblank_handler[] = {
+        0xF5,               // PUSH AF
+        0xFA, 0x00, 0xC8,   // LD A, (0xC800)
+        0x3C,               // INC A
+        0xEA, 0x00, 0xC8,   // LD (0xC800), A
+        0xE0, 0x43,         // LDH (SCX), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+    const byte main_loop[] = {
+        0x3E, 0x01,         // LD A, VBLANK
+        0xE0, 0xFF,         // LDH (IE), A
+        0xFB,               // EI
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000    <- frame
+        0x06, 0x00,         // LD B, 0
+        0x7E,               // LD A, (HL)       <- crunch
+        0x80,               // ADD A, B
+        0x22,               // LD (HL+), A
+        0x05,               // DEC B
+        0x20, 0xFA,         // JR NZ, crunch
+        0x76,               // HALT
+        0x18, 0xF2,         // JR frame
+    };
+    static const struct {
+        const char *name;
+        bool headless;
+        bool block_cache;
+        bool jit;
+    } modes[] = {
+        { "machine/rendering/interpreter", false, false, false },
+        { "machine/rendering/block_cache", false, true, false },
+        { "machine/headless/interpreter", true, false, false },
+        { "machine/headless/block_cache", true, true, false },
+        { "machine/headless/jit", true, false, true },
+    };
+
+    test_rom_init(rom_image, sizeof(rom_image), 0x00, 0x00);
+    test_rom_put(rom_image, TEST_ROM_MAIN, main_loop, sizeof(main_loop));
+    test_rom_put(rom_image, TEST_ROM_VBLANK_HANDLER, vblank_handler, sizeof(vblank_handler));
+
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+        if (gb == NULL || !gameboy_init(gb) ||
+            !gameboy_load_rom_data(gb, rom_image, sizeof(rom_image))) {
+            printf("Failed to initialize benchmark machine\n");
+            exit(1);
+        }
+        gb->use_block_cache = modes[i].block_cache;
+        gb->use_jit = modes[i].jit;
+        gameboy_set_headless(gb, modes[i].headless);
+
+        if (!modes[i].jit || gb->jit.available) {
+            bench_measure(modes[i].name, "frame", bench_frames, gb);
+        }
+
+        gameboy_cleanup(gb);
+        free(gb);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *json_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            bench_runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            bench_warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            printf("Usage: %s [--runs N] [--warmup N] [--json FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (bench_runs < 1 || bench_runs > BENCH_MAX_RUNS || bench_warmup < 0) {
+        printf("--runs must be 1 to %d and --warmup at least 0\n", BENCH_MAX_RUNS);
+        return 1;
+    }
+
+    printf("=== Game Boy Benchmark Suite ===\n");
+    printf("median and p99 of %d runs after %d warmup runs\n\n",
+           bench_runs, bench_warmup);
+
+    // MBC5 cartridge with RAM, enabled so ERAM takes the direct path
+    static byte rom_image[4 * ROM_BANK_SIZE];
+    rom_image[CARTRIDGE_TYPE_ADDRESS] = 0x1B;
+    rom_image[CARTRIDGE_ROM_SIZE_ADDRESS] = 0x01;
+    rom_image[CARTRIDGE_RAM_SIZE_ADDRESS] = 0x03;
+    memory_system_t *mem_sys = malloc(sizeof(memory_system_t));
+    if (mem_sys == NULL || !memory_init(mem_sys) ||
+        !memory_load_rom_data(mem_sys, rom_image, sizeof(rom_image))) {
+        printf("Failed to initialize memory system\n");
+        return 1;
+    }
+    memory_write_byte(mem_sys, 0x0000, 0x0A);
+
+    bench_memory(mem_sys);
+    memory_cleanup(mem_sys);
+    free(mem_sys);
+
+    bench_loading();
+    bench_cpu();
+    bench_machine();
+
+    if (json_path != NULL && !bench_write_json(json_path)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,415 @@
+#include "../include/apu.h"
+#include "../include/ring_buffer.h"
+#include "../include/gameboy.h"
+#include "../include/savestate.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+// Room for a little over one second of audio
+#define TEST_RING_SIZE (256 * 1024)
+// Samples left for the DC blocker to settle before measuring
+#define TEST_SETTLE (APU_SAMPLE_RATE / 10)
+// 131072 / (2048 - 1917) = 1000.5 Hz
+#define TEST_TONE_FREQUENCY 1917
+
+// Function declarations
+void test_registers(void);
+void test_length_counter(void);
+void test_square_tone(void);
+void test_wave_and_noise(void);
+void test_headless(void);
+void test_state_continues_audio(void);
+
+static memory_system_t test_memory;
+static scheduler_t test_scheduler;
+static apu_t test_apu;
+static ring_buffer_t test_ring;
+static uint64_t test_clock;
+static apu_frame_t test_frames[APU_SAMPLE_RATE * 2];
+
+static void setup_apu(void)
+{
+    test_clock = 0;
+    if (!memory_init(&test_memory) ||
+        !scheduler_init(&test_scheduler, &test_clock) ||
+        !apu_init(&test_apu, &test_memory, &test_scheduler) ||
+        !ring_buffer_init(&test_ring, TEST_RING_SIZE)) {
+        TEST_FAIL("APU initialization failed");
+    }
+}
+
+static void teardown_apu(void)
+{
+    ring_buffer_cleanup(&test_ring);
+    memory_cleanup(&test_memory);
+}
+
+// Moves the clock the way a CPU run would, stopping at every event
+static void run_cycles(uint64_t cycles)
+{
+    uint64_t target = test_clock + cycles;
+
+    while (test_clock < target) {
+        test_clock = MIN(scheduler_next_deadline(&test_scheduler), target);
+        scheduler_dispatch(&test_scheduler);
+    }
+    apu_sync(&test_apu);
+}
+
+static size_t drain(void)
+{
+    return ring_buffer_read(&test_ring, test_frames, sizeof(test_frames)) /
+           sizeof(apu_frame_t);
+}
+
+static void start_square(void)
+{
+    memory_write_byte(&test_memory, NR50_REGISTER, 0x77);
+    memory_write_byte(&test_memory, NR51_REGISTER, 0x22);
+    memory_write_byte(&test_memory, NR21_REGISTER, 0x80);
+    memory_write_byte(&test_memory, NR22_REGISTER, 0xF0);
+    memory_write_byte(&test_memory, NR23_REGISTER, TEST_TONE_FREQUENCY & 0xFF);
+    memory_write_byte(&test_memory, NR24_REGISTER,
+                      NRX4_TRIGGER | (TEST_TONE_FREQUENCY >> 8));
+}
+
+// Test read masks, channel status and power
+void test_registers(void)
+{
+    TEST_START("Registers");
+
+    setup_apu();
+    if (memory_read_byte(&test_memory, NR52_REGISTER) != 0xF1 ||
+        memory_read_byte(&test_memory, NR11_REGISTER) != 0xBF ||
+        memory_read_byte(&test_memory, 0xFF27) != 0xFF) {
+        TEST_FAIL("Registers should read back their post-boot values");
+    }
+
+    memory_write_byte(&test_memory, NR13_REGISTER, 0x12);
+    memory_write_byte(&test_memory, NR32_REGISTER, 0x20);
+    if (memory_read_byte(&test_memory, NR13_REGISTER) != 0xFF ||
+        memory_read_byte(&test_memory, NR32_REGISTER) != 0xBF) {
+        TEST_FAIL("Write-only bits should read as 1");
+    }
+
+    // Powering off clears everything and ignores writes until powered on
+    memory_write_byte(&test_memory, NR52_REGISTER, 0x00);
+    memory_write_byte(&test_memory, NR50_REGISTER, 0x55);
+    memory_write_byte(&test_memory, WAVE_RAM_START, 0xA5);
+    if (memory_read_byte(&test_memory, NR52_REGISTER) != 0x70 ||
+        memory_read_byte(&test_memory, NR50_REGISTER) != 0x00 ||
+        memory_read_byte(&test_memory, WAVE_RAM_START) != 0xA5) {
+        TEST_FAIL("Powered off APU should ignore register writes");
+    }
+
+    memory_write_byte(&test_memory, NR52_REGISTER, NR52_POWER);
+    memory_write_byte(&test_memory, NR50_REGISTER, 0x55);
+    if (memory_read_byte(&test_memory, NR50_REGISTER) != 0x55) {
+        TEST_FAIL("Powered on APU should take writes again");
+    }
+
+    teardown_apu();
+    TEST_PASS();
+}
+
+// Test that length counters silence channels on the frame sequencer
+void test_length_counter(void)
+{
+    TEST_START("Length Counter");
+
+    setup_apu();
+    memory_write_byte(&test_memory, NR22_REGISTER, 0xF0);
+    memory_write_byte(&test_memory, NR21_REGISTER, 0x3E);
+    memory_write_byte(&test_memory, NR24_REGISTER, NRX4_TRIGGER | NRX4_LENGTH_ENABLE);
+
+    if (!(memory_read_byte(&test_memory, NR52_REGISTER) & 0x02)) {
+        TEST_FAIL("Trigger should turn the channel on");
+    }
+
+    // Two length clocks, on steps 0 and 2
+    run_cycles(APU_SEQUENCER_CYCLES);
+    if (!(memory_read_byte(&test_memory, NR52_REGISTER) & 0x02)) {
+        TEST_FAIL("Channel should still be on after one clock");
+    }
+    run_cycles(APU_SEQUENCER_CYCLES * 2);
+    if (memory_read_byte(&test_memory, NR52_REGISTER) & 0x02) {
+        TEST_FAIL("Channel should stop when its length runs out");
+    }
+
+    // Turning the DAC off stops a channel at once
+    memory_write_byte(&test_memory, NR24_REGISTER, NRX4_TRIGGER);
+    memory_write_byte(&test_memory, NR22_REGISTER, 0x00);
+    if (memory_read_byte(&test_memory, NR52_REGISTER) & 0x02) {
+        TEST_FAIL("DAC off should disable the channel");
+    }
+
+    teardown_apu();
+    TEST_PASS();
+}
+
+// Test the rate, pitch and level of a square wave
+void test_square_tone(void)
+{
+    TEST_START("Square Tone");
+
+    setup_apu();
+    apu_set_output(&test_apu, &test_ring);
+    start_square();
+    run_cycles(CPU_FREQUENCY);
+
+    size_t count = drain();
+    if (count != APU_SAMPLE_RATE || test_apu.dropped != 0) {
+        TEST_FAIL("One second should make exactly one second of samples");
+    }
+
+    int crossings = 0;
+    int peak = 0;
+    for (size_t i = TEST_SETTLE; i < count; i++) {
+        if ((test_frames[i].left >= 0) != (test_frames[i - 1].left >= 0)) {
+            crossings++;
+        }
+        peak = MAX(peak, abs(test_frames[i].left));
+        if (test_frames[i].left != test_frames[i].right) {
+            TEST_FAIL("Both sides should carry the channel equally");
+        }
+    }
+
+    // Two crossings per period over 0.9 s
+    if (crossings < 1795 || crossings > 1807) {
+        TEST_FAIL("Tone should be at the programmed frequency");
+    }
+    // Half the 15 * 8 * 64 swing either side of zero, plus edge ringing
+    if (peak < 3600 || peak > 5200) {
+        TEST_FAIL("Tone should be at the programmed level");
+    }
+
+    // Panned away from the left, only the right side plays
+    memory_write_byte(&test_memory, NR51_REGISTER, 0x02);
+    run_cycles(CPU_FREQUENCY / 2);
+    count = drain();
+    int left_peak = 0;
+    for (size_t i = TEST_SETTLE; i < count; i++) {
+        left_peak = MAX(left_peak, abs(test_frames[i].left));
+    }
+    if (left_peak > 16) {
+        TEST_FAIL("Panning should silence the left side");
+    }
+
+    teardown_apu();
+    TEST_PASS();
+}
+
+// Test that the wave and noise channels sound and stop
+void test_wave_and_noise(void)
+{
+    TEST_START("Wave and Noise");
+
+    setup_apu();
+    apu_set_output(&test_apu, &test_ring);
+    memory_write_byte(&test_memory, NR51_REGISTER, 0xCC);
+    for (int i = 0; i < 16; i++) {
+        memory_write_byte(&test_memory, WAVE_RAM_START + i, (byte)(i * 0x11));
+    }
+    memory_write_byte(&test_memory, NR30_REGISTER, 0x80);
+    memory_write_byte(&test_memory, NR32_REGISTER, 0x20);
+    memory_write_byte(&test_memory, NR33_REGISTER, 0x00);
+    memory_write_byte(&test_memory, NR34_REGISTER, NRX4_TRIGGER | 0x07);
+    memory_write_byte(&test_memory, NR42_REGISTER, 0xA0);
+    memory_write_byte(&test_memory, NR43_REGISTER, 0x21);
+    memory_write_byte(&test_memory, NR44_REGISTER, NRX4_TRIGGER);
+
+    run_cycles(CPU_FREQUENCY / 4);
+    size_t count = drain();
+    int64_t energy = 0;
+    for (size_t i = TEST_SETTLE / 2; i < count; i++) {
+        energy += (int64_t)test_frames[i].left * test_frames[i].left;
+    }
+    if (memory_read_byte(&test_memory, NR52_REGISTER) != 0xFD ||
+        energy / (int64_t)count < 100000) {
+        TEST_FAIL("Wave and noise should both be playing");
+    }
+
+    // With both DACs off the output settles back to silence
+    memory_write_byte(&test_memory, NR30_REGISTER, 0x00);
+    memory_write_byte(&test_memory, NR42_REGISTER, 0x00);
+    run_cycles(CPU_FREQUENCY / 2);
+    count = drain();
+    for (size_t i = count - 100; i < count; i++) {
+        if (abs(test_frames[i].left) > 16) {
+            TEST_FAIL("Stopped channels should be silent");
+        }
+    }
+
+    teardown_apu();
+    TEST_PASS();
+}
+
+// Test that headless mode makes no samples and schedules nothing
+void test_headless(void)
+{
+    TEST_START("Headless");
+
+    setup_apu();
+    apu_set_output(&test_apu, &test_ring);
+    apu_set_headless(&test_apu, true);
+    if (scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_APU) != SCHEDULER_NEVER) {
+        TEST_FAIL("Headless APU should have no events");
+    }
+
+    start_square();
+    memory_write_byte(&test_memory, NR21_REGISTER, 0x80 | 0x3F);
+    memory_write_byte(&test_memory, NR24_REGISTER, NRX4_TRIGGER | NRX4_LENGTH_ENABLE |
+                      (TEST_TONE_FREQUENCY >> 8));
+    test_clock += CPU_FREQUENCY;
+    if (ring_buffer_available(&test_ring) != 0 || test_apu.samples != 0) {
+        TEST_FAIL("Headless APU should make no samples");
+    }
+    if (memory_read_byte(&test_memory, NR52_REGISTER) & 0x02) {
+        TEST_FAIL("Length counters should still run when headless");
+    }
+
+    apu_set_headless(&test_apu, false);
+    run_cycles(CPU_FREQUENCY / 8);
+    if (drain() != APU_SAMPLE_RATE / 8) {
+        TEST_FAIL("Leaving headless mode should resume the output");
+    }
+
+    teardown_apu();
+    TEST_PASS();
+}
+
+// Test that a loaded state and a fork play on identically
+void test_state_continues_audio(void)
+{
+    TEST_START("State Continues Audio");
+
+    static byte rom[2 * ROM_BANK_SIZE];
+    static apu_frame_t frames[2][APU_SAMPLE_RATE / 8];
+    const byte program[] = {
+        0x3E, 0x77,         // LD A, 0x77
+        0xE0, 0x24,         // LDH (NR50), A
+        0x3E, 0xFF,         // LD A, 0xFF
+        0xE0, 0x25,         // LDH (NR51), A
+        0x3E, 0xF3,         // LD A, 0xF3   volume 15, fading
+        0xE0, 0x12,         // LDH (NR12), A
+        0x3E, 0x17,         // LD A, 0x17   sweep up
+        0xE0, 0x10,         // LDH (NR10), A
+        0x3E, 0x80,         // LD A, 0x80
+        0xE0, 0x14,         // LDH (NR14), A
+        0x3E, 0xF1,         // LD A, 0xF1
+        0xE0, 0x21,         // LDH (NR42), A
+        0x3E, 0x80,         // LD A, 0x80
+        0xE0, 0x23,         // LDH (NR44), A
+        0x18, 0xFE,         // JR -2
+    };
+
+    memset(rom, 0, sizeof(rom));
+    rom[0x0100] = 0xC3;     // JP 0x0150
+    rom[0x0101] = 0x50;
+    rom[0x0102] = 0x01;
+    memcpy(rom + 0x0150, program, sizeof(program));
+
+    gameboy_t *gb[3];
+    ring_buffer_t rings[2];
+    for (int i = 0; i < 3; i++) {
+        gb[i] = malloc(sizeof(gameboy_t));
+        if (gb[i] == NULL || !gameboy_init(gb[i]) ||
+            !gameboy_load_rom_data(gb[i], rom, sizeof(rom))) {
+            TEST_FAIL("Could not start machine");
+        }
+    }
+
+    gameboy_run(gb[0], CPU_FREQUENCY / 7);
+
+    size_t size = savestate_size(gb[0]);
+    byte *state = malloc(size);
+    gameboy_snapshot_t *snapshot = gameboy_snapshot(gb[0]);
+    if (state == NULL || snapshot == NULL ||
+        savestate_save(gb[0], state, size) != size ||
+        !savestate_load(gb[1], state, size) ||
+        !gameboy_fork(gb[2], snapshot)) {
+        TEST_FAIL("Could not copy the machine");
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (!ring_buffer_init(&rings[i], TEST_RING_SIZE)) {
+            TEST_FAIL("Could not allocate output");
+        }
+        apu_set_output(&gb[i + 1]->apu, &rings[i]);
+        gameboy_run(gb[i + 1], CPU_FREQUENCY / 8);
+        if (ring_buffer_read(&rings[i], frames[i], sizeof(frames[i])) !=
+            sizeof(frames[i])) {
+            TEST_FAIL("Copies should make an eighth of a second of audio");
+        }
+    }
+
+    if (memcmp(frames[0], frames[1], sizeof(frames[0])) != 0 ||
+        memory_read_byte(&gb[1]->memory, NR52_REGISTER) !=
+        memory_read_byte(&gb[2]->memory, NR52_REGISTER)) {
+        TEST_FAIL("Loaded state and fork should sound the same");
+    }
+
+    gameboy_snapshot_free(snapshot);
+    free(state);
+    for (int i = 0; i < 2; i++) {
+        ring_buffer_cleanup(&rings[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        gameboy_cleanup(gb[i]);
+        free(gb[i]);
+    }
+
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator APU Test Suite ===\n\n");
+
+    test_registers();
+    test_length_counter();
+    test_square_tone();
+    test_wave_and_noise();
+    test_headless();
+    test_state_continues_audio();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your APU is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
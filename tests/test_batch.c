@@ -0,0 +1,327 @@
+#include "../include/batch.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_ROM_COUNT 6
+#define TEST_CYCLES (PPU_CYCLES_PER_FRAME * 3)
+#define TEST_LIST_PATH "/tmp/gameboy_test_batch.txt"
+#define TEST_BAD_LIST_PATH "/tmp/gameboy_test_batch_bad.txt"
+#define TEST_CSV_PATH "/tmp/gameboy_test_batch.csv"
+#define TEST_MISSING_ROM "/tmp/gameboy_test_batch_missing.gb"
+#define TEST_QUOTED_ROM "/tmp/gameboy \"test\",batch.gb"
+
+// Function declarations
+void test_read_list(void);
+void test_rejects_bad_entries(void);
+void test_matches_single_instance(void);
+void test_thread_counts_agree(void);
+void test_write_csv(void);
+
+static char rom_paths[TEST_ROM_COUNT][64];
+
+/*
+ * Each ROM fills tile 0 with its own pattern and then spins, so every ROM
+ * leaves a different picture behind.
+ */
+static void write_test_roms(void)
+{
+    static byte rom[2 * ROM_BANK_SIZE];
+
+    for (int i = 0; i < TEST_ROM_COUNT; i++) {
+        const byte program[] = {
+            0x3E, (byte)(0x11 * (i + 1)),   // LD A, pattern
+            0x21, 0x00, 0x80,               // LD HL, 0x8000
+            0x06, 0x10,                     // LD B, 16
+            0x22,                           // LD (HL+), A
+            0x05,                           // DEC B
+            0x20, 0xFC,                     // JR NZ, -4
+            0x18, 0xFE,                     // JR -2
+        };
+
+        memset(rom, 0, sizeof(rom));
+        rom[0x0100] = 0xC3;   // JP 0x0150
+        rom[0x0101] = 0x50;
+        rom[0x0102] = 0x01;
+        memcpy(rom + 0x0150, program, sizeof(program));
+
+        snprintf(rom_paths[i], sizeof(rom_paths[i]),
+                 "/tmp/gameboy_test_batch_%d.gb", i);
+        FILE *file = fopen(rom_paths[i], "wb");
+        if (file == NULL || fwrite(rom, 1, sizeof(rom), file) != sizeof(rom)) {
+            TEST_FAIL("Could not write test ROM");
+        }
+        fclose(file);
+    }
+
+    FILE *list = fopen(TEST_LIST_PATH, "w");
+    if (list == NULL) {
+        TEST_FAIL("Could not write batch list");
+    }
+    fprintf(list, "# test batch\n\n");
+    for (int i = 0; i < TEST_ROM_COUNT; i++) {
+        // Uneven budgets give the workers something to steal
+        fprintf(list, "%s %d\n", rom_paths[i], TEST_CYCLES * (i % 3 + 1));
+    }
+    fprintf(list, "  %s\n", TEST_MISSING_ROM);
+    fclose(list);
+}
+
+static void remove_test_files(void)
+{
+    for (int i = 0; i < TEST_ROM_COUNT; i++) {
+        remove(rom_paths[i]);
+    }
+    remove(TEST_LIST_PATH);
+    remove(TEST_BAD_LIST_PATH);
+    remove(TEST_CSV_PATH);
+}
+
+static batch_result_t *run_list(batch_job_t *jobs, int count, int threads)
+{
+    batch_result_t *results = calloc(count, sizeof(batch_result_t));
+    batch_options_t options = { threads, false, true, false };
+
+    if (results == NULL || !batch_run(jobs, results, count, &options)) {
+        TEST_FAIL("Batch should run");
+    }
+
+    return results;
+}
+
+// Test list parsing, comments and default budgets
+void test_read_list(void)
+{
+    TEST_START("Read List");
+
+    batch_job_t *jobs;
+    int count;
+
+    if (!batch_read_list(TEST_LIST_PATH, &jobs, &count) ||
+        count != TEST_ROM_COUNT + 1) {
+        TEST_FAIL("Should read one job per non-comment line");
+    }
+
+    if (strcmp(jobs[1].rom_path, rom_paths[1]) != 0 ||
+        jobs[1].cycles != (uint64_t)TEST_CYCLES * 2 ||
+        strcmp(jobs[TEST_ROM_COUNT].rom_path, TEST_MISSING_ROM) != 0 ||
+        jobs[TEST_ROM_COUNT].cycles != BATCH_DEFAULT_CYCLES) {
+        TEST_FAIL("Paths and cycle budgets not parsed");
+    }
+
+    batch_free_list(jobs, count);
+
+    if (batch_read_list("/tmp/gameboy_test_batch_no_list.txt", &jobs, &count)) {
+        TEST_FAIL("Missing list should fail");
+    }
+
+    TEST_PASS();
+}
+
+// Test that a malformed cycle budget fails the whole list
+void test_rejects_bad_entries(void)
+{
+    TEST_START("Reject Bad Entries");
+
+    static const char *const budgets[] = {
+        "-5", "+5", "0", "12abc", "0x10", "99999999999999999999999", "10 20",
+    };
+
+    for (size_t i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++) {
+        batch_job_t *jobs;
+        int count;
+        FILE *list = fopen(TEST_BAD_LIST_PATH, "w");
+
+        if (list == NULL) {
+            TEST_FAIL("Could not write batch list");
+        }
+        fprintf(list, "%s %d\n%s %s\n", rom_paths[0], TEST_CYCLES,
+                rom_paths[1], budgets[i]);
+        fclose(list);
+
+        if (batch_read_list(TEST_BAD_LIST_PATH, &jobs, &count)) {
+            batch_free_list(jobs, count);
+            TEST_FAIL("Malformed cycle budget should fail the list");
+        }
+    }
+
+    TEST_PASS();
+}
+
+// Test that each batch result equals a lone run of the same ROM
+void test_matches_single_instance(void)
+{
+    TEST_START("Matches Single Instance");
+
+    batch_job_t *jobs;
+    int count;
+
+    batch_read_list(TEST_LIST_PATH, &jobs, &count);
+    // Skip the missing ROM, whose default budget is a minute of emulation
+    count = TEST_ROM_COUNT;
+    batch_result_t *results = run_list(jobs, count, 4);
+
+    for (int i = 0; i < count; i++) {
+        gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+        if (gb == NULL || !gameboy_init(gb) ||
+            !gameboy_load_rom(gb, jobs[i].rom_path)) {
+            TEST_FAIL("Could not start reference machine");
+        }
+
+        uint64_t cycles = gameboy_run(gb, jobs[i].cycles);
+        if (!results[i].ok || results[i].cycles != cycles ||
+            results[i].framebuffer_hash != gameboy_framebuffer_hash(gb)) {
+            TEST_FAIL("Batch result differs from a single-instance run");
+        }
+
+        if (i > 0 && results[i].framebuffer_hash == results[0].framebuffer_hash) {
+            TEST_FAIL("Different ROMs should leave different pictures");
+        }
+
+        gameboy_cleanup(gb);
+        free(gb);
+    }
+
+    free(results);
+    batch_free_list(jobs, TEST_ROM_COUNT + 1);
+    TEST_PASS();
+}
+
+// Test that results do not depend on how the work is spread
+void test_thread_counts_agree(void)
+{
+    TEST_START("Thread Counts Agree");
+
+    batch_job_t *jobs;
+    int count;
+
+    batch_read_list(TEST_LIST_PATH, &jobs, &count);
+    count = TEST_ROM_COUNT;
+    batch_result_t *serial = run_list(jobs, count, 1);
+
+    const int thread_counts[] = { 2, 3, 8, BATCH_MAX_THREADS * 2 };
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        batch_result_t *parallel = run_list(jobs, count, thread_counts[t]);
+
+        for (int i = 0; i < count; i++) {
+            if (parallel[i].ok != serial[i].ok ||
+                parallel[i].cycles != serial[i].cycles ||
+                parallel[i].framebuffer_hash != serial[i].framebuffer_hash) {
+                TEST_FAIL("Result should not depend on thread count");
+            }
+        }
+
+        free(parallel);
+    }
+
+    free(serial);
+    batch_free_list(jobs, TEST_ROM_COUNT + 1);
+    TEST_PASS();
+}
+
+// Test CSV output, including a ROM that fails to load
+void test_write_csv(void)
+{
+    TEST_START("Write CSV");
+
+    batch_job_t jobs[3] = {
+        { rom_paths[0], TEST_CYCLES },
+        { TEST_MISSING_ROM, TEST_CYCLES },
+        { TEST_QUOTED_ROM, TEST_CYCLES },
+    };
+    batch_result_t *results = run_list(jobs, 3, 2);
+
+    if (!results[0].ok || results[1].ok || results[2].ok) {
+        TEST_FAIL("Only the missing ROMs should fail");
+    }
+
+    if (!batch_write_csv(TEST_CSV_PATH, jobs, results, 3)) {
+        TEST_FAIL("CSV should be written");
+    }
+
+    char line[256];
+    char expected[256];
+    FILE *file = fopen(TEST_CSV_PATH, "r");
+    if (file == NULL || fgets(line, sizeof(line), file) == NULL ||
+        strcmp(line, "rom,status,cycles,wall_seconds,framebuffer_hash\n") != 0) {
+        TEST_FAIL("CSV header missing");
+    }
+
+    snprintf(expected, sizeof(expected), "\"%s\",ok,%llu,", rom_paths[0],
+             (unsigned long long)results[0].cycles);
+    if (fgets(line, sizeof(line), file) == NULL ||
+        strncmp(line, expected, strlen(expected)) != 0) {
+        TEST_FAIL("First row should describe the first job");
+    }
+
+    snprintf(expected, sizeof(expected), "\"%s\",error,0,", TEST_MISSING_ROM);
+    if (fgets(line, sizeof(line), file) == NULL ||
+        strncmp(line, expected, strlen(expected)) != 0) {
+        TEST_FAIL("Second row should record the failure");
+    }
+
+    // Commas and quotes in a path stay inside the quoted field
+    strcpy(expected, "\"/tmp/gameboy \"\"test\"\",batch.gb\",error,0,");
+    if (fgets(line, sizeof(line), file) == NULL ||
+        strncmp(line, expected, strlen(expected)) != 0) {
+        TEST_FAIL("Quotes in the path should be doubled");
+    }
+
+    fclose(file);
+    free(results);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Batch Test Suite ===\n\n");
+
+    write_test_roms();
+    test_read_list();
+    test_rejects_bad_entries();
+    test_matches_single_instance();
+    test_thread_counts_agree();
+    test_write_csv();
+    remove_test_files();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your batch runner is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,342 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/capture.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_VIDEO_PATH "/tmp/gameboy_test_capture.gray"
+#define TEST_WAV_PATH "/tmp/gameboy_test_capture.wav"
+#define TEST_RAW_PATH "/tmp/gameboy_test_capture.pcm"
+#define TEST_FRAMES 60
+
+// Function declarations
+void test_video_frames(void);
+void test_wav_audio(void);
+void test_raw_audio(void);
+void test_drops_without_blocking(void);
+
+static byte rom_image[2 * ROM_BANK_SIZE];
+
+/*
+ * Draws stripes through tile 0, which fills the screen, and starts a
+ * square wave on both sides.
+ */
+static void build_rom(void)
+{
+    const byte program[] = {
+        0x21, 0x00, 0x80,   // LD HL, 0x8000
+        0x06, 0x08,         // LD B, 8
+        0x3E, 0xF0,         // LD A, 0xF0
+        0x22,               // LD (HL+), A
+        0x3E, 0xCC,         // LD A, 0xCC
+        0x22,               // LD (HL+), A
+        0x05,               // DEC B
+        0x20, 0xF7,         // JR NZ, -9
+        0x3E, 0xFF,         // LD A, 0xFF
+        0xE0, 0x25,         // LDH (NR51), A
+        0x3E, 0xF0,         // LD A, 0xF0
+        0xE0, 0x17,         // LDH (NR22), A
+        0x3E, 0x87,         // LD A, TRIGGER | 7
+        0xE0, 0x19,         // LDH (NR24), A
+        0x18, 0xFE,         // JR -2
+    };
+
+    test_rom_init(rom_image, sizeof(rom_image), 0x00, 0x00);
+    test_rom_put(rom_image, TEST_ROM_MAIN, program, sizeof(program));
+}
+
+static gameboy_t *start_machine(void)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom_image, sizeof(rom_image))) {
+        TEST_FAIL("Could not start machine");
+    }
+    return gb;
+}
+
+static void stop_machine(gameboy_t *gb)
+{
+    gameboy_cleanup(gb);
+    free(gb);
+}
+
+static byte *read_file(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        TEST_FAIL("Capture file should exist");
+    }
+
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    byte *data = malloc(*size + 1);
+    if (data == NULL || fread(data, 1, *size, file) != *size) {
+        TEST_FAIL("Could not read capture file");
+    }
+    fclose(file);
+    return data;
+}
+
+static uint32_t get_u32(const byte *data)
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+// Test that every frame reaches the file as gray levels
+void test_video_frames(void)
+{
+    TEST_START("Video Frames");
+
+    gameboy_t *gb = start_machine();
+    capture_t capture;
+    if (!capture_open(&capture, gb, TEST_VIDEO_PATH, NULL, 0)) {
+        TEST_FAIL("Could not open capture");
+    }
+
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+        capture_frame(&capture, gb);
+    }
+    if (!capture_close(&capture, gb)) {
+        TEST_FAIL("Capture should be written");
+    }
+
+    const capture_stream_t *video = &capture.streams[CAPTURE_VIDEO];
+    if (video->captured != TEST_FRAMES || video->dropped != 0 ||
+        video->written != TEST_FRAMES * CAPTURE_FRAME_SIZE) {
+        TEST_FAIL("Every frame should be captured");
+    }
+
+    size_t size;
+    byte *data = read_file(TEST_VIDEO_PATH, &size);
+    if (size != TEST_FRAMES * CAPTURE_FRAME_SIZE) {
+        TEST_FAIL("File should hold every frame");
+    }
+
+    // The last frame is the picture left on screen
+    const byte gray[4] = { 0xFF, 0xAA, 0x55, 0x00 };
+    const byte *last = data + size - CAPTURE_FRAME_SIZE;
+    bool shades[4] = { false };
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            byte shade = gb->ppu.framebuffer[y][x];
+
+            if (last[y * SCREEN_WIDTH + x] != gray[shade]) {
+                TEST_FAIL("Frames should be the framebuffer in gray");
+            }
+            shades[shade] = true;
+        }
+    }
+    if (!shades[0] || !shades[3]) {
+        TEST_FAIL("Test picture should have stripes");
+    }
+
+    free(data);
+    remove(TEST_VIDEO_PATH);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test the WAV header and that every sample made is in it
+void test_wav_audio(void)
+{
+    TEST_START("WAV Audio");
+
+    gameboy_t *gb = start_machine();
+    capture_t capture;
+    if (!capture_open(&capture, gb, NULL, TEST_WAV_PATH, 0)) {
+        TEST_FAIL("Could not open capture");
+    }
+
+    uint64_t cycles = 0;
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        cycles += gameboy_run_frame(gb);
+        capture_frame(&capture, gb);
+    }
+    if (!capture_close(&capture, gb) || gb->apu.output != NULL) {
+        TEST_FAIL("Capture should be written and the APU detached");
+    }
+
+    const capture_stream_t *audio = &capture.streams[CAPTURE_AUDIO];
+    uint64_t expected = cycles * APU_SAMPLE_RATE / CPU_FREQUENCY;
+    if (audio->captured != expected || audio->dropped != 0) {
+        TEST_FAIL("Every sample should be captured");
+    }
+
+    size_t size;
+    byte *data = read_file(TEST_WAV_PATH, &size);
+    if (size != CAPTURE_WAV_HEADER_SIZE + expected * sizeof(apu_frame_t) ||
+        memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVEfmt ", 8) != 0 ||
+        get_u32(data + 4) != size - 8 || get_u32(data + 24) != APU_SAMPLE_RATE ||
+        memcmp(data + 36, "data", 4) != 0 ||
+        get_u32(data + 40) != size - CAPTURE_WAV_HEADER_SIZE) {
+        TEST_FAIL("Header should describe the samples");
+    }
+
+    int peak = 0;
+    for (size_t i = CAPTURE_WAV_HEADER_SIZE; i < size; i += 2) {
+        int16_t sample = (int16_t)(data[i] | data[i + 1] << 8);
+        peak = MAX(peak, abs(sample));
+    }
+    if (peak < 1000) {
+        TEST_FAIL("Tone should be audible");
+    }
+
+    free(data);
+    remove(TEST_WAV_PATH);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test that other names get bare samples
+void test_raw_audio(void)
+{
+    TEST_START("Raw Audio");
+
+    gameboy_t *gb = start_machine();
+    capture_t capture;
+    if (!capture_open(&capture, gb, NULL, TEST_RAW_PATH, 0)) {
+        TEST_FAIL("Could not open capture");
+    }
+
+    for (int frame = 0; frame < 5; frame++) {
+        gameboy_run_frame(gb);
+        capture_frame(&capture, gb);
+    }
+    if (!capture_close(&capture, gb)) {
+        TEST_FAIL("Capture should be written");
+    }
+
+    size_t size;
+    byte *data = read_file(TEST_RAW_PATH, &size);
+    if (size != capture.streams[CAPTURE_AUDIO].captured * sizeof(apu_frame_t) ||
+        memcmp(data, "RIFF", 4) == 0) {
+        TEST_FAIL("Raw file should hold only samples");
+    }
+
+    free(data);
+    remove(TEST_RAW_PATH);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+static void *drain_pipe(void *argument)
+{
+    int fd = *(int *)argument;
+    static byte buffer[4096];
+    size_t *total = malloc(sizeof(size_t));
+    ssize_t size;
+
+    *total = 0;
+    while ((size = read(fd, buffer, sizeof(buffer))) > 0) {
+        *total += (size_t)size;
+    }
+    return total;
+}
+
+// Test that a stalled writer drops frames instead of stopping emulation
+void test_drops_without_blocking(void)
+{
+    TEST_START("Drops Without Blocking");
+
+    // Nobody reads the pipe yet, so the writer stalls on the first block
+    int fds[2];
+    char path[64];
+    if (pipe(fds) != 0) {
+        TEST_FAIL("Could not make pipe");
+    }
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fds[1]);
+
+    gameboy_t *gb = start_machine();
+    capture_t capture;
+    if (!capture_open(&capture, gb, path, NULL, 2)) {
+        TEST_FAIL("Could not open capture");
+    }
+    close(fds[1]);
+
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+        capture_frame(&capture, gb);
+    }
+
+    const capture_stream_t *video = &capture.streams[CAPTURE_VIDEO];
+    if (video->captured + video->dropped != TEST_FRAMES ||
+        video->captured > 2 * CAPTURE_BLOCK_SIZE / CAPTURE_FRAME_SIZE) {
+        TEST_FAIL("Frames past the pool should be dropped");
+    }
+
+    pthread_t reader;
+    size_t *total;
+    pthread_create(&reader, NULL, drain_pipe, &fds[0]);
+    if (!capture_close(&capture, gb)) {
+        TEST_FAIL("Queued frames should still be written");
+    }
+    pthread_join(reader, (void **)&total);
+    if (*total != video->captured * CAPTURE_FRAME_SIZE) {
+        TEST_FAIL("Every captured frame should reach the reader");
+    }
+
+    free(total);
+    close(fds[0]);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Capture Test Suite ===\n\n");
+
+    build_rom();
+    test_video_frames();
+    test_wav_audio();
+    test_raw_audio();
+    test_drops_without_blocking();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your capture is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,715 @@
+#include "../include/cpu.h"
+#include "../include/memory.h"
+#include "../include/block_cache.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define PROGRAM_START WRAM_START
+
+// Shared machine for the tests; programs run from WRAM
+static memory_system_t test_memory;
+static cpu_t test_cpu;
+
+// Function declarations
+void test_cpu_init(void);
+void test_loads(void);
+void test_alu_flags(void);
+void test_daa(void);
+void test_sixteen_bit(void);
+void test_stack_and_calls(void);
+void test_branch_cycles(void);
+void test_cb_instructions(void);
+void test_interrupts(void);
+void test_halt(void);
+void test_cycle_tables(void);
+void test_block_cache(void);
+void test_block_cache_self_modifying(void);
+void test_block_cache_bank_switch(void);
+
+// Reset the machine and copy a program to the start of WRAM
+static void load_program(const byte *program, size_t size)
+{
+    memory_init(&test_memory);
+    cpu_init(&test_cpu, &test_memory);
+
+    for (size_t i = 0; i < size; i++) {
+        memory_write_byte(&test_memory, PROGRAM_START + i, program[i]);
+    }
+    test_cpu.pc = PROGRAM_START;
+}
+
+static void run_steps(int steps)
+{
+    for (int i = 0; i < steps; i++) {
+        cpu_step(&test_cpu);
+    }
+}
+
+// Test post-boot register state
+void test_cpu_init(void)
+{
+    TEST_START("CPU Initialization");
+
+    memory_system_t mem_sys;
+    cpu_t cpu;
+    memory_init(&mem_sys);
+
+    if (!cpu_init(&cpu, &mem_sys)) {
+        TEST_FAIL("Initialization returned false");
+    }
+
+    if (cpu_get_af(&cpu) != 0x01B0 || cpu_get_bc(&cpu) != 0x0013 ||
+        cpu_get_de(&cpu) != 0x00D8 || cpu_get_hl(&cpu) != 0x014D) {
+        TEST_FAIL("Register pairs do not match the DMG post-boot state");
+    }
+
+    if (cpu.sp != 0xFFFE || cpu.pc != CPU_ENTRY_POINT) {
+        TEST_FAIL("SP/PC do not match the DMG post-boot state");
+    }
+
+    if (cpu_init(NULL, &mem_sys) || cpu_init(&cpu, NULL)) {
+        TEST_FAIL("Should return false for NULL pointers");
+    }
+
+    TEST_PASS();
+}
+
+// Test 8-bit load variants
+void test_loads(void)
+{
+    TEST_START("Load Instructions");
+
+    const byte program[] = {
+        0x21, 0x00, 0xD0,   // LD HL, 0xD000
+        0x3E, 0x5A,         // LD A, 0x5A
+        0x22,               // LD (HL+), A
+        0x36, 0x77,         // LD (HL), 0x77
+        0x46,               // LD B, (HL)
+        0x2B,               // DEC HL
+        0x4E,               // LD C, (HL)
+        0xE0, 0x80,         // LDH (0x80), A
+        0xEA, 0x10, 0xD0,   // LD (0xD010), A
+        0x3E, 0x00,         // LD A, 0
+        0xF0, 0x80,         // LDH A, (0x80)
+    };
+    load_program(program, sizeof(program));
+    run_steps(11);
+
+    if (test_cpu.b != 0x77 || test_cpu.c != 0x5A) {
+        TEST_FAIL("LD r, (HL) with HL+ / HL- addressing failed");
+    }
+
+    if (memory_read_byte(&test_memory, HRAM_START) != 0x5A) {
+        TEST_FAIL("LDH (n), A failed");
+    }
+
+    if (memory_read_byte(&test_memory, 0xD010) != 0x5A) {
+        TEST_FAIL("LD (nn), A failed");
+    }
+
+    if (test_cpu.a != 0x5A) {
+        TEST_FAIL("LDH A, (n) failed");
+    }
+
+    TEST_PASS();
+}
+
+// Test flag results of 8-bit arithmetic
+void test_alu_flags(void)
+{
+    TEST_START("ALU Flags");
+
+    const byte program[] = {
+        0x3E, 0x0F,   // LD A, 0x0F
+        0xC6, 0x01,   // ADD A, 1     -> 0x10, H
+        0xD6, 0x10,   // SUB 0x10     -> 0x00, Z N
+        0xDE, 0x01,   // SBC A, 1     -> 0xFF, N H C
+        0xCE, 0x00,   // ADC A, 0     -> 0x00, Z H C
+        0x3C,         // INC A        -> 0x01, C kept
+        0xFE, 0x02,   // CP 2         -> N H C
+        0xE6, 0x00,   // AND 0        -> Z H
+    };
+    load_program(program, sizeof(program));
+
+    run_steps(2);
+    if (test_cpu.a != 0x10 || test_cpu.f != CPU_FLAG_H) {
+        TEST_FAIL("ADD half-carry incorrect");
+    }
+
+    run_steps(1);
+    if (test_cpu.a != 0x00 || test_cpu.f != (CPU_FLAG_Z | CPU_FLAG_N)) {
+        TEST_FAIL("SUB zero result incorrect");
+    }
+
+    run_steps(1);
+    if (test_cpu.a != 0xFF || test_cpu.f != (CPU_FLAG_N | CPU_FLAG_H | CPU_FLAG_C)) {
+        TEST_FAIL("SBC borrow incorrect");
+    }
+
+    run_steps(1);
+    if (test_cpu.a != 0x00 || test_cpu.f != (CPU_FLAG_Z | CPU_FLAG_H | CPU_FLAG_C)) {
+        TEST_FAIL("ADC carry-in incorrect");
+    }
+
+    run_steps(1);
+    if (test_cpu.a != 0x01 || test_cpu.f != CPU_FLAG_C) {
+        TEST_FAIL("INC should preserve carry");
+    }
+
+    run_steps(1);
+    if (test_cpu.a != 0x01 || test_cpu.f != (CPU_FLAG_N | CPU_FLAG_H | CPU_FLAG_C)) {
+        TEST_FAIL("CP should only set flags");
+    }
+
+    run_steps(1);
+    if (test_cpu.f != (CPU_FLAG_Z | CPU_FLAG_H)) {
+        TEST_FAIL("AND flags incorrect");
+    }
+
+    TEST_PASS();
+}
+
+static byte to_bcd(int value)
+{
+    return (byte)(((value / 10) << 4) | (value % 10));
+}
+
+// Exhaustively check DAA after BCD addition and subtraction
+void test_daa(void)
+{
+    TEST_START("DAA Decimal Adjust");
+
+    const byte add_program[] = {0x80, 0x27};  // ADD A, B; DAA
+    const byte sub_program[] = {0x90, 0x27};  // SUB B; DAA
+
+    for (int x = 0; x < 100; x++) {
+        for (int y = 0; y < 100; y++) {
+            load_program(add_program, sizeof(add_program));
+            test_cpu.a = to_bcd(x);
+            test_cpu.b = to_bcd(y);
+            run_steps(2);
+
+            bool carry = (test_cpu.f & CPU_FLAG_C) != 0;
+            if (test_cpu.a != to_bcd((x + y) % 100) || carry != (x + y > 99)) {
+                TEST_FAIL("DAA after ADD produced the wrong BCD result");
+            }
+
+            load_program(sub_program, sizeof(sub_program));
+            test_cpu.a = to_bcd(x);
+            test_cpu.b = to_bcd(y);
+            run_steps(2);
+
+            carry = (test_cpu.f & CPU_FLAG_C) != 0;
+            if (test_cpu.a != to_bcd((x - y + 100) % 100) || carry != (x < y)) {
+                TEST_FAIL("DAA after SUB produced the wrong BCD result");
+            }
+        }
+    }
+
+    TEST_PASS();
+}
+
+// Test 16-bit arithmetic and SP-relative instructions
+void test_sixteen_bit(void)
+{
+    TEST_START("16-bit Arithmetic");
+
+    const byte program[] = {
+        0x21, 0xFF, 0x0F,   // LD HL, 0x0FFF
+        0x01, 0x01, 0x00,   // LD BC, 0x0001
+        0x09,               // ADD HL, BC   -> 0x1000, H
+        0x31, 0xF8, 0xFF,   // LD SP, 0xFFF8
+        0xE8, 0x08,         // ADD SP, 8    -> 0x0000, H C
+        0xF8, 0xFE,         // LD HL, SP-2  -> 0xFFFE
+        0x0B,               // DEC BC
+    };
+    load_program(program, sizeof(program));
+    test_cpu.f = 0;   // ADD HL, rr preserves Z
+
+    run_steps(3);
+    if (cpu_get_hl(&test_cpu) != 0x1000 || test_cpu.f != CPU_FLAG_H) {
+        TEST_FAIL("ADD HL, BC incorrect");
+    }
+
+    run_steps(2);
+    if (test_cpu.sp != 0x0000 || test_cpu.f != (CPU_FLAG_H | CPU_FLAG_C)) {
+        TEST_FAIL("ADD SP, e incorrect");
+    }
+
+    run_steps(1);
+    if (cpu_get_hl(&test_cpu) != 0xFFFE || test_cpu.f != 0) {
+        TEST_FAIL("LD HL, SP+e incorrect");
+    }
+
+    run_steps(1);
+    if (cpu_get_bc(&test_cpu) != 0x0000) {
+        TEST_FAIL("DEC BC incorrect");
+    }
+
+    TEST_PASS();
+}
+
+// Test PUSH/POP, CALL/RET and RST
+void test_stack_and_calls(void)
+{
+    TEST_START("Stack, Calls and Returns");
+
+    const byte program[] = {
+        0x31, 0x00, 0xE0,   // 0xC000 LD SP, 0xE000
+        0x01, 0x34, 0x12,   // 0xC003 LD BC, 0x1234
+        0xC5,               // 0xC006 PUSH BC
+        0xF1,               // 0xC007 POP AF    -> low nibble of F masked
+        0xCD, 0x10, 0xC0,   // 0xC008 CALL 0xC010
+        0x00,               // 0xC00B NOP
+        0x00, 0x00, 0x00, 0x00,
+        0x3E, 0x99,         // 0xC010 LD A, 0x99
+        0xC9,               // 0xC012 RET
+    };
+    load_program(program, sizeof(program));
+
+    run_steps(4);
+    if (cpu_get_af(&test_cpu) != 0x1230) {
+        TEST_FAIL("POP AF should mask the low flag nibble");
+    }
+
+    run_steps(1);
+    if (test_cpu.pc != 0xC010 || test_cpu.sp != 0xDFFE) {
+        TEST_FAIL("CALL did not jump and push");
+    }
+
+    if (memory_read_word(&test_memory, test_cpu.sp) != 0xC00B) {
+        TEST_FAIL("CALL pushed the wrong return address");
+    }
+
+    run_steps(2);
+    if (test_cpu.pc != 0xC00B || test_cpu.sp != 0xE000 || test_cpu.a != 0x99) {
+        TEST_FAIL("RET did not return to the caller");
+    }
+
+    TEST_PASS();
+}
+
+// Test taken/not-taken conditional cycle counts
+void test_branch_cycles(void)
+{
+    TEST_START("Conditional Branch Cycles");
+
+    const byte program[] = {
+        0xAF,               // XOR A        -> Z set
+        0x20, 0x10,         // JR NZ, +16   not taken: 8
+        0x28, 0x00,         // JR Z, +0     taken: 12
+        0xC2, 0x00, 0x00,   // JP NZ        not taken: 12
+        0xCC, 0x10, 0xC0,   // CALL Z       taken: 24
+    };
+    load_program(program, sizeof(program));
+    test_cpu.sp = 0xE000;
+
+    int expected[] = {4, 8, 12, 12, 24};
+    for (int i = 0; i < 5; i++) {
+        if (cpu_step(&test_cpu) != expected[i]) {
+            TEST_FAIL("Conditional branch cycle count incorrect");
+        }
+    }
+
+    TEST_PASS();
+}
+
+// Test CB-prefixed rotates, shifts and bit operations
+void test_cb_instructions(void)
+{
+    TEST_START("CB-prefixed Instructions");
+
+    const byte program[] = {
+        0x06, 0x81,         // LD B, 0x81
+        0xCB, 0x00,         // RLC B        -> 0x03, C
+        0xCB, 0x38,         // SRL B        -> 0x01, C
+        0xCB, 0x30,         // SWAP B       -> 0x10
+        0xCB, 0x60,         // BIT 4, B     -> Z clear, H
+        0x21, 0x00, 0xD0,   // LD HL, 0xD000
+        0xCB, 0xFE,         // SET 7, (HL)
+        0xCB, 0x46,         // BIT 0, (HL)  -> Z set
+        0xCB, 0xBE,         // RES 7, (HL)
+    };
+    load_program(program, sizeof(program));
+
+    run_steps(2);
+    if (test_cpu.b != 0x03 || test_cpu.f != CPU_FLAG_C) {
+        TEST_FAIL("RLC B incorrect");
+    }
+
+    run_steps(1);
+    if (test_cpu.b != 0x01 || test_cpu.f != CPU_FLAG_C) {
+        TEST_FAIL("SRL B incorrect");
+    }
+
+    run_steps(1);
+    if (test_cpu.b != 0x10 || test_cpu.f != 0) {
+        TEST_FAIL("SWAP B incorrect");
+    }
+
+    run_steps(1);
+    if (test_cpu.f != CPU_FLAG_H) {
+        TEST_FAIL("BIT 4, B incorrect");
+    }
+
+    run_steps(1);
+    if (cpu_step(&test_cpu) != 16 || memory_read_byte(&test_memory, 0xD000) != 0x80) {
+        TEST_FAIL("SET 7, (HL) incorrect");
+    }
+
+    if (cpu_step(&test_cpu) != 12 || !(test_cpu.f & CPU_FLAG_Z)) {
+        TEST_FAIL("BIT 0, (HL) incorrect");
+    }
+
+    run_steps(1);
+    if (memory_read_byte(&test_memory, 0xD000) != 0x00) {
+        TEST_FAIL("RES 7, (HL) incorrect");
+    }
+
+    TEST_PASS();
+}
+
+// Test interrupt dispatch and the EI delay
+void test_interrupts(void)
+{
+    TEST_START("Interrupt Dispatch");
+
+    const byte program[] = {
+        0xFB,   // EI
+        0x00,   // NOP  (interrupt cannot fire before this completes)
+        0x00,   // NOP
+    };
+    load_program(program, sizeof(program));
+    test_cpu.sp = 0xE000;
+
+    memory_write_byte(&test_memory, IE_REGISTER, INTERRUPT_TIMER | INTERRUPT_VBLANK);
+    memory_request_interrupt(&test_memory, INTERRUPT_TIMER);
+
+    run_steps(2);
+    if (test_cpu.pc != PROGRAM_START + 2 || !test_cpu.ime) {
+        TEST_FAIL("EI should take effect after the following instruction");
+    }
+
+    if (cpu_step(&test_cpu) != 20 || test_cpu.pc != 0x0050) {
+        TEST_FAIL("Timer interrupt should vector to 0x0050 in 20 cycles");
+    }
+
+    if (test_cpu.ime || (memory_read_byte(&test_memory, IF_REGISTER) & INTERRUPT_TIMER)) {
+        TEST_FAIL("Servicing should clear IME and the IF bit");
+    }
+
+    if (memory_read_word(&test_memory, test_cpu.sp) != PROGRAM_START + 2) {
+        TEST_FAIL("Interrupt pushed the wrong return address");
+    }
+
+    TEST_PASS();
+}
+
+// Test HALT wake-up and the HALT bug
+void test_halt(void)
+{
+    TEST_START("HALT Behaviour");
+
+    const byte program[] = {
+        0x76,         // HALT
+        0x3C,         // INC A
+    };
+    load_program(program, sizeof(program));
+    test_cpu.a = 0;
+
+    run_steps(5);
+    if (!test_cpu.halted || test_cpu.pc != PROGRAM_START + 1) {
+        TEST_FAIL("CPU should stay halted with no interrupt pending");
+    }
+
+    // A run skips its idle budget at once, still in 4-cycle HALT steps
+    if (cpu_run(&test_cpu, 1000001) != 1000004 || !test_cpu.halted) {
+        TEST_FAIL("Halted run should end on the first step past its budget");
+    }
+
+    // With IME off a pending interrupt wakes the CPU without servicing
+    memory_write_byte(&test_memory, IE_REGISTER, INTERRUPT_VBLANK);
+    memory_request_interrupt(&test_memory, INTERRUPT_VBLANK);
+    run_steps(1);
+    if (test_cpu.halted || test_cpu.a != 1) {
+        TEST_FAIL("Pending interrupt should end HALT");
+    }
+
+    // HALT with IME off and an interrupt pending runs the next byte twice
+    load_program(program, sizeof(program));
+    test_cpu.a = 0;
+    memory_write_byte(&test_memory, IE_REGISTER, INTERRUPT_VBLANK);
+    memory_request_interrupt(&test_memory, INTERRUPT_VBLANK);
+    run_steps(3);
+    if (test_cpu.a != 2) {
+        TEST_FAIL("HALT bug should execute the following byte twice");
+    }
+
+    TEST_PASS();
+}
+
+// Sanity check the published cycle tables
+void test_cycle_tables(void)
+{
+    TEST_START("Cycle Tables");
+
+    if (cpu_get_opcode_cycles(0x00) != 4 || cpu_get_opcode_cycles(0xCD) != 24 ||
+        cpu_get_opcode_cycles(0x08) != 20 || cpu_get_opcode_cycles(0x36) != 12) {
+        TEST_FAIL("Base opcode cycles incorrect");
+    }
+
+    for (int opcode = 0; opcode < 256; opcode++) {
+        byte cycles = cpu_get_cb_opcode_cycles((byte)opcode);
+        bool hl_operand = (opcode & 0x07) == 0x06;
+        bool bit_op = opcode >= 0x40 && opcode < 0x80;
+        byte expected = hl_operand ? (bit_op ? 12 : 16) : 8;
+        if (cycles != expected) {
+            TEST_FAIL("CB opcode cycles incorrect");
+        }
+    }
+
+    TEST_PASS();
+}
+
+// Run the same program through cpu_run and the block cache
+static void run_both(const byte *program, size_t size, uint64_t cycles,
+                     cpu_t *interpreted, cpu_t *cached, block_cache_t *cache)
+{
+    static memory_system_t cached_memory;
+
+    load_program(program, size);
+    cpu_run(&test_cpu, cycles);
+    *interpreted = test_cpu;
+
+    memory_init(&cached_memory);
+    cpu_init(cached, &cached_memory);
+    for (size_t i = 0; i < size; i++) {
+        memory_write_byte(&cached_memory, PROGRAM_START + i, program[i]);
+    }
+    cached->pc = PROGRAM_START;
+    block_cache_flush(cache);
+    block_cache_run(cache, cached, cycles);
+
+    if (memcmp(test_memory.wram, cached_memory.wram, WRAM_SIZE) != 0 ||
+        memcmp(test_memory.high_page, cached_memory.high_page,
+               MEMORY_PAGE_SIZE) != 0) {
+        TEST_FAIL("Block cache left different memory contents");
+    }
+}
+
+static bool same_registers(const cpu_t *a, const cpu_t *b)
+{
+    return a->a == b->a && a->f == b->f && a->b == b->b && a->c == b->c &&
+           a->d == b->d && a->e == b->e && a->h == b->h && a->l == b->l &&
+           a->sp == b->sp && a->pc == b->pc && a->cycles == b->cycles &&
+           a->ime == b->ime;
+}
+
+// Test that cached blocks behave exactly like the interpreter
+void test_block_cache(void)
+{
+    TEST_START("Block Cache Matches Interpreter");
+
+    const byte program[] = {
+        0x21, 0x00, 0xC8,   // LD HL, 0xC800
+        0x11, 0x00, 0xC9,   // LD DE, 0xC900
+        0x06, 0x40,         // LD B, 0x40
+        0x2A,               // LD A, (HL+)
+        0x12,               // LD (DE), A
+        0x13,               // INC DE
+        0x80,               // ADD A, B
+        0xA9,               // XOR C
+        0x4F,               // LD C, A
+        0xCB, 0x11,         // RL C
+        0x77,               // LD (HL), A
+        0x05,               // DEC B
+        0x20, 0xF4,         // JR NZ, -12
+        0xCD, 0x1A, 0xC0,   // CALL 0xC01A
+        0xC3, 0x00, 0xC0,   // JP 0xC000
+        0xC5,               // PUSH BC
+        0xF0, 0x80,         // LDH A, (0x80)
+        0xCB, 0x37,         // SWAP A
+        0x3C,               // INC A
+        0xE0, 0x80,         // LDH (0x80), A
+        0xC1,               // POP BC
+        0xC9,               // RET
+    };
+    block_cache_t cache;
+    cpu_t interpreted, cached;
+
+    if (!block_cache_init(&cache)) {
+        TEST_FAIL("Block cache initialization failed");
+    }
+
+    // Odd budgets end runs in the middle of blocks
+    const uint64_t budgets[] = { 1, 37, 1000, 123457 };
+    for (size_t i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++) {
+        run_both(program, sizeof(program), budgets[i], &interpreted, &cached,
+                 &cache);
+        if (!same_registers(&interpreted, &cached)) {
+            TEST_FAIL("Block cache left different register state");
+        }
+    }
+
+    if (cache.blocks_compiled == 0) {
+        TEST_FAIL("Program should have been compiled into blocks");
+    }
+
+    block_cache_cleanup(&cache);
+    TEST_PASS();
+}
+
+// Test that writes into cached code, directly or through echo RAM, are seen
+void test_block_cache_self_modifying(void)
+{
+    TEST_START("Block Cache Self-Modifying Code");
+
+    byte program[] = {
+        0x3E, 0x00,         // LD A, 0
+        0x3C,               // INC A            <- patched to NOP
+        0x21, 0x02, 0xC0,   // LD HL, 0xC002
+        0x36, 0x00,         // LD (HL), 0x00
+        0x18, 0xF8,         // JR -8
+    };
+    block_cache_t cache;
+    cpu_t interpreted, cached;
+
+    if (!block_cache_init(&cache)) {
+        TEST_FAIL("Block cache initialization failed");
+    }
+
+    for (int echo = 0; echo < 2; echo++) {
+        program[5] = echo ? 0xE0 : 0xC0;
+        run_both(program, sizeof(program), 2000, &interpreted, &cached,
+                 &cache);
+
+        if (cached.a != 1) {
+            TEST_FAIL("Patched instruction was still executed from the cache");
+        }
+        if (!same_registers(&interpreted, &cached)) {
+            TEST_FAIL("Block cache left different register state");
+        }
+    }
+
+    block_cache_cleanup(&cache);
+    TEST_PASS();
+}
+
+// Test that a ROM block stops where it switches its own bank away
+void test_block_cache_bank_switch(void)
+{
+    TEST_START("Block Cache Bank Switch");
+
+    static byte rom[4 * ROM_BANK_SIZE];
+    static memory_system_t interpreted_memory, cached_memory;
+    const byte start[] = {
+        0x3E, 0x01,         // LD A, 1
+        0xEA, 0x00, 0x20,   // LD (0x2000), A   ROM bank 1
+        0xC3, 0x00, 0x40,   // JP 0x4000
+    };
+    const byte bank1[] = {
+        0x3E, 0x02,         // LD A, 2
+        0xEA, 0x00, 0x20,   // LD (0x2000), A   ROM bank 2
+        0x3E, 0x11,         // LD A, 0x11
+        0xEA, 0x00, 0xC0,   // LD (0xC000), A
+        0x18, 0xFE,         // JR -2
+    };
+    const byte bank2[] = {
+        0x3C,               // INC A            <- 0x4005
+        0xEA, 0x00, 0xC0,   // LD (0xC000), A
+        0x18, 0xFE,         // JR -2
+    };
+    block_cache_t cache;
+    cpu_t interpreted, cached;
+
+    test_rom_init(rom, sizeof(rom), 0x01, 0x00);
+    test_rom_put(rom, TEST_ROM_MAIN, start, sizeof(start));
+    test_rom_put(rom, ROM_BANK_SIZE, bank1, sizeof(bank1));
+    test_rom_put(rom, 2 * ROM_BANK_SIZE + 5, bank2, sizeof(bank2));
+
+    if (!block_cache_init(&cache) || !memory_init(&interpreted_memory) ||
+        !memory_init(&cached_memory) ||
+        !memory_load_rom_data(&interpreted_memory, rom, sizeof(rom)) ||
+        !memory_load_rom_data(&cached_memory, rom, sizeof(rom))) {
+        TEST_FAIL("Could not set up the cartridge");
+    }
+    cpu_init(&interpreted, &interpreted_memory);
+    cpu_init(&cached, &cached_memory);
+
+    cpu_run(&interpreted, 1000);
+    block_cache_run(&cache, &cached, 1000);
+
+    if (interpreted_memory.wram[0] != 0x03) {
+        TEST_FAIL("Interpreter should run on in the new bank");
+    }
+    if (cached_memory.wram[0] != interpreted_memory.wram[0] ||
+        !same_registers(&interpreted, &cached)) {
+        TEST_FAIL("Block cache ran on in the old bank");
+    }
+
+    memory_cleanup(&interpreted_memory);
+    memory_cleanup(&cached_memory);
+    block_cache_cleanup(&cache);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator CPU Test Suite ===\n\n");
+
+    test_cpu_init();
+    test_loads();
+    test_alu_flags();
+    test_daa();
+    test_sixteen_bit();
+    test_stack_and_calls();
+    test_branch_cycles();
+    test_cb_instructions();
+    test_interrupts();
+    test_halt();
+    test_cycle_tables();
+    test_block_cache();
+    test_block_cache_self_modifying();
+    test_block_cache_bank_switch();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your CPU is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
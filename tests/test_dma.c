@@ -0,0 +1,314 @@
+#include "../include/dma.h"
+#include "../include/gameboy.h"
+#include "../include/savestate.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_END (DMA_STARTUP_CYCLES + DMA_TRANSFER_CYCLES)
+
+// Function declarations
+void test_transfer(void);
+void test_bus_conflicts(void);
+void test_video_bus_source(void);
+void test_restart(void);
+void test_state_mid_transfer(void);
+
+static memory_system_t test_memory;
+static scheduler_t test_scheduler;
+static dma_t test_dma;
+static uint64_t test_clock;
+
+static void setup_dma(void)
+{
+    test_clock = 0;
+    if (!memory_init(&test_memory) ||
+        !scheduler_init(&test_scheduler, &test_clock) ||
+        !dma_init(&test_dma, &test_memory, &test_scheduler)) {
+        TEST_FAIL("DMA initialization failed");
+    }
+
+    // Every source page gets its own pattern
+    for (int i = 0; i < WRAM_SIZE; i++) {
+        test_memory.wram[i] = (byte)(i * 7 + (i >> 8));
+    }
+    for (int i = 0; i < VRAM_SIZE; i++) {
+        test_memory.vram[i] = (byte)(i * 13 + 1);
+    }
+}
+
+static void teardown_dma(void)
+{
+    memory_cleanup(&test_memory);
+}
+
+// Moves the clock the way a CPU run would, then runs due events
+static void run_cycles(uint64_t cycles)
+{
+    test_clock += cycles;
+    scheduler_dispatch(&test_scheduler);
+}
+
+// Test a whole transfer from WRAM and its timing
+void test_transfer(void)
+{
+    TEST_START("OAM Transfer");
+
+    setup_dma();
+    memory_write_byte(&test_memory, DMA_REGISTER, 0xC1);
+    if (memory_read_byte(&test_memory, DMA_REGISTER) != 0xC1 ||
+        scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_DMA) != DMA_STARTUP_CYCLES) {
+        TEST_FAIL("Transfer should start after the startup delay");
+    }
+
+    run_cycles(DMA_STARTUP_CYCLES);
+    if (memory_read_byte(&test_memory, OAM_START) != 0xFF ||
+        scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_DMA) != TEST_END) {
+        TEST_FAIL("OAM should be busy for the whole transfer");
+    }
+
+    run_cycles(DMA_TRANSFER_CYCLES - 1);
+    if (test_dma.copied == DMA_LENGTH) {
+        TEST_FAIL("Transfer should not finish early");
+    }
+
+    run_cycles(1);
+    if (test_dma.active ||
+        scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_DMA) != SCHEDULER_NEVER) {
+        TEST_FAIL("Transfer should end after 160 bytes");
+    }
+    for (int i = 0; i < DMA_LENGTH; i++) {
+        if (memory_read_byte(&test_memory, OAM_START + i) != test_memory.wram[0x100 + i]) {
+            TEST_FAIL("OAM should hold a copy of the source");
+        }
+    }
+
+    // Sources above WRAM read WRAM
+    memory_write_byte(&test_memory, DMA_REGISTER, 0xFE);
+    run_cycles(TEST_END);
+    if (memcmp(test_memory.oam, test_memory.wram + 0x1E00, DMA_LENGTH) != 0) {
+        TEST_FAIL("Echo sources should copy from WRAM");
+    }
+
+    teardown_dma();
+    TEST_PASS();
+}
+
+// Test what the CPU sees of the external bus during a transfer
+void test_bus_conflicts(void)
+{
+    TEST_START("Bus Conflicts");
+
+    setup_dma();
+    memory_write_byte(&test_memory, 0xFF90, 0x12);
+    memory_write_byte(&test_memory, DMA_REGISTER, 0xC1);
+    run_cycles(DMA_STARTUP_CYCLES + 10 * DMA_CYCLES_PER_BYTE);
+
+    // Reads anywhere on the external bus return the byte in flight
+    byte in_flight = test_memory.wram[0x100 + 10];
+    if (memory_read_byte(&test_memory, 0xC000) != in_flight ||
+        memory_read_byte(&test_memory, 0x0150) != in_flight ||
+        memory_read_byte(&test_memory, 0xE123) != in_flight) {
+        TEST_FAIL("External bus reads should return the byte in flight");
+    }
+
+    // Writes there are lost, HRAM and VRAM stay usable
+    byte before = test_memory.wram[0];
+    memory_write_byte(&test_memory, 0xC000, before ^ 0xFF);
+    memory_write_byte(&test_memory, 0xFF90, 0x34);
+    if (memory_read_byte(&test_memory, 0xFF90) != 0x34 ||
+        memory_read_byte(&test_memory, 0x8010) != test_memory.vram[0x10]) {
+        TEST_FAIL("HRAM and VRAM should not be affected");
+    }
+
+    run_cycles(TEST_END);
+    if (test_memory.wram[0] != before ||
+        memory_read_byte(&test_memory, 0xC000) != before) {
+        TEST_FAIL("Writes during the transfer should be dropped");
+    }
+
+    memory_write_byte(&test_memory, 0xC000, 0x99);
+    if (memory_read_byte(&test_memory, 0xE000) != 0x99) {
+        TEST_FAIL("Bus should be released after the transfer");
+    }
+
+    teardown_dma();
+    TEST_PASS();
+}
+
+// Test that a VRAM source only takes the video bus
+void test_video_bus_source(void)
+{
+    TEST_START("Video Bus Source");
+
+    setup_dma();
+    memory_write_byte(&test_memory, DMA_REGISTER, 0x88);
+    run_cycles(DMA_STARTUP_CYCLES + 3 * DMA_CYCLES_PER_BYTE);
+
+    if (memory_read_byte(&test_memory, 0x9000) != test_memory.vram[0x803] ||
+        memory_read_byte(&test_memory, 0xC005) != test_memory.wram[5]) {
+        TEST_FAIL("Only VRAM should conflict");
+    }
+
+    run_cycles(TEST_END);
+    if (memcmp(test_memory.oam, test_memory.vram + 0x800, DMA_LENGTH) != 0) {
+        TEST_FAIL("OAM should hold a copy of VRAM");
+    }
+
+    teardown_dma();
+    TEST_PASS();
+}
+
+// Test that a new transfer keeps what the old one moved so far
+void test_restart(void)
+{
+    TEST_START("Restarted Transfer");
+
+    setup_dma();
+    memory_write_byte(&test_memory, DMA_REGISTER, 0xC1);
+    run_cycles(DMA_STARTUP_CYCLES + 50 * DMA_CYCLES_PER_BYTE);
+    memory_write_byte(&test_memory, DMA_REGISTER, 0xC2);
+
+    if (memcmp(test_memory.oam, test_memory.wram + 0x100, 50) != 0 ||
+        test_memory.oam[50] != 0x00) {
+        TEST_FAIL("Restart should keep the bytes already moved");
+    }
+
+    run_cycles(DMA_STARTUP_CYCLES + 10 * DMA_CYCLES_PER_BYTE);
+    dma_sync(&test_dma);
+    if (memcmp(test_memory.oam, test_memory.wram + 0x200, 10) != 0 ||
+        memcmp(test_memory.oam + 10, test_memory.wram + 0x10A, 40) != 0) {
+        TEST_FAIL("New transfer should overwrite from the start");
+    }
+
+    run_cycles(TEST_END);
+    if (memcmp(test_memory.oam, test_memory.wram + 0x200, DMA_LENGTH) != 0) {
+        TEST_FAIL("New transfer should complete");
+    }
+
+    teardown_dma();
+    TEST_PASS();
+}
+
+// Test saving and forking in the middle of a transfer started by a program
+void test_state_mid_transfer(void)
+{
+    TEST_START("State Mid-Transfer");
+
+    static byte rom[2 * ROM_BANK_SIZE];
+    // The usual HRAM routine: start the transfer and wait 160 M-cycles
+    const byte routine[] = {
+        0x3E, 0xC1,         // LD A, 0xC1
+        0xE0, 0x46,         // LDH (DMA), A
+        0x3E, 0x28,         // LD A, 40
+        0x3D,               // DEC A
+        0x20, 0xFD,         // JR NZ, -3
+        0x18, 0xF5,         // JR -11
+    };
+
+    memset(rom, 0, sizeof(rom));
+    gameboy_t *gb[3];
+    for (int i = 0; i < 3; i++) {
+        gb[i] = malloc(sizeof(gameboy_t));
+        if (gb[i] == NULL || !gameboy_init(gb[i]) ||
+            !gameboy_load_rom_data(gb[i], rom, sizeof(rom))) {
+            TEST_FAIL("Could not start machine");
+        }
+    }
+
+    memcpy(&gb[0]->memory.high_page[0x80], routine, sizeof(routine));
+    for (int i = 0; i < WRAM_SIZE; i++) {
+        gb[0]->memory.wram[i] = (byte)(i * 5 + 3);
+    }
+    gb[0]->cpu.pc = 0xFF80;
+
+    gameboy_run(gb[0], 2000);
+    if (!gb[0]->dma.active) {
+        TEST_FAIL("Program should be mid-transfer");
+    }
+
+    size_t size = savestate_size(gb[0]);
+    byte *state = malloc(size);
+    gameboy_snapshot_t *snapshot = gameboy_snapshot(gb[0]);
+    if (state == NULL || snapshot == NULL ||
+        savestate_save(gb[0], state, size) != size ||
+        !savestate_load(gb[1], state, size) ||
+        !gameboy_fork(gb[2], snapshot)) {
+        TEST_FAIL("Could not copy the machine");
+    }
+
+    for (int i = 0; i < 3; i++) {
+        gameboy_run(gb[i], 3000);
+    }
+
+    for (int i = 1; i < 3; i++) {
+        if (gb[i]->cpu.cycles != gb[0]->cpu.cycles ||
+            memcmp(gb[i]->memory.oam, gb[0]->memory.oam, OAM_SIZE) != 0 ||
+            gb[i]->dma.active != gb[0]->dma.active ||
+            gb[i]->dma.start != gb[0]->dma.start) {
+            TEST_FAIL("Copies should continue the transfer identically");
+        }
+    }
+    if (memcmp(gb[0]->memory.oam, gb[0]->memory.wram + 0x100, DMA_LENGTH) != 0) {
+        TEST_FAIL("Program should have filled OAM");
+    }
+
+    gameboy_snapshot_free(snapshot);
+    free(state);
+    for (int i = 0; i < 3; i++) {
+        gameboy_cleanup(gb[i]);
+        free(gb[i]);
+    }
+
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator DMA Test Suite ===\n\n");
+
+    test_transfer();
+    test_bus_conflicts();
+    test_video_bus_source();
+    test_restart();
+    test_state_mid_transfer();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your DMA is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,338 @@
+#include "../include/gameboy.h"
+#include "../include/savestate.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_FRAMES 5
+#define TEST_FORKS 200
+
+// Function declarations
+void test_fork_matches_parent(void);
+void test_copy_on_write(void);
+void test_snapshot_outlives_parent(void);
+void test_fork_of_fork(void);
+void test_many_forks(void);
+
+static byte test_rom[4 * ROM_BANK_SIZE];
+
+static gameboy_t *new_machine(void)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb)) {
+        TEST_FAIL("Could not create machine");
+    }
+
+    return gb;
+}
+
+static gameboy_t *start_machine(void)
+{
+    gameboy_t *gb = new_machine();
+
+    if (!gameboy_load_rom_data(gb, test_rom, sizeof(test_rom))) {
+        TEST_FAIL("Could not load ROM");
+    }
+
+    return gb;
+}
+
+static gameboy_t *fork_machine(const gameboy_snapshot_t *snapshot)
+{
+    gameboy_t *gb = new_machine();
+
+    if (!gameboy_fork(gb, snapshot)) {
+        TEST_FAIL("Could not fork");
+    }
+
+    return gb;
+}
+
+static void stop_machine(gameboy_t *gb)
+{
+    gameboy_cleanup(gb);
+    free(gb);
+}
+
+static void run_frames(gameboy_t *gb, int frames)
+{
+    for (int frame = 0; frame < frames; frame++) {
+        gameboy_run_frame(gb);
+    }
+}
+
+static int shared_pages(const gameboy_t *gb)
+{
+    int count = 0;
+    int pages = MEMORY_WRAM_PAGES + (int)(gb->memory.eram_size / MEMORY_PAGE_SIZE);
+
+    for (int i = 0; i < pages; i++) {
+        count += gb->memory.cow_shared[i];
+    }
+
+    return count;
+}
+
+// Compares through save states, which see shared pages as the CPU does
+static bool same_machine(gameboy_t *a, gameboy_t *b)
+{
+    size_t size = savestate_size(a);
+    byte *state_a = malloc(size);
+    byte *state_b = malloc(size);
+
+    bool same = savestate_save(a, state_a, size) == size &&
+                savestate_save(b, state_b, size) == size &&
+                memcmp(state_a, state_b, size) == 0 &&
+                gameboy_framebuffer_hash(a) == gameboy_framebuffer_hash(b);
+
+    free(state_a);
+    free(state_b);
+    return same;
+}
+
+// Test that a fork continues exactly like its parent
+void test_fork_matches_parent(void)
+{
+    TEST_START("Fork Matches Parent");
+
+    for (int mode = 0; mode < 2; mode++) {
+        gameboy_t *parent = start_machine();
+        parent->use_block_cache = mode == 1;
+        run_frames(parent, TEST_FRAMES);
+
+        gameboy_snapshot_t *snapshot = gameboy_snapshot(parent);
+        if (snapshot == NULL) {
+            TEST_FAIL("Snapshot should be created");
+        }
+
+        gameboy_t *child = fork_machine(snapshot);
+        child->use_block_cache = mode == 1;
+        if (child->cpu.pc != parent->cpu.pc || child->cpu.mem_sys != &child->memory ||
+            child->memory.rom != parent->memory.rom) {
+            TEST_FAIL("Fork should start at the parent's state and share its ROM");
+        }
+
+        run_frames(parent, TEST_FRAMES);
+        run_frames(child, TEST_FRAMES);
+        if (!same_machine(parent, child)) {
+            TEST_FAIL("Fork diverged from its parent");
+        }
+
+        gameboy_snapshot_free(snapshot);
+        stop_machine(child);
+        stop_machine(parent);
+    }
+
+    TEST_PASS();
+}
+
+// Test that pages are shared until written, and only the written ones copied
+void test_copy_on_write(void)
+{
+    TEST_START("Copy On Write");
+
+    gameboy_t *parent = start_machine();
+    run_frames(parent, TEST_FRAMES);
+    gameboy_snapshot_t *snapshot = gameboy_snapshot(parent);
+    memory_snapshot_t *shared = snapshot->memory;
+
+    gameboy_t *a = fork_machine(snapshot);
+    gameboy_t *b = fork_machine(snapshot);
+    int pages = MEMORY_WRAM_PAGES + (int)(a->memory.eram_size / MEMORY_PAGE_SIZE);
+
+    if (shared_pages(a) != pages ||
+        a->memory.read_map[MEMORY_PAGE(0xD000)] != shared->wram + 0x1000 ||
+        a->memory.read_map[MEMORY_PAGE(ERAM_START)] != shared->eram + 2 * RAM_BANK_SIZE) {
+        TEST_FAIL("Fresh fork should read all RAM from the snapshot");
+    }
+
+    // Write through the echo alias; both views must move to the copy
+    byte before = memory_read_byte(&a->memory, 0xD010);
+    memory_write_byte(&a->memory, 0xF010, (byte)(before + 1));
+    if (shared_pages(a) != pages - 1 ||
+        memory_read_byte(&a->memory, 0xD010) != (byte)(before + 1) ||
+        memory_read_byte(&a->memory, 0xF011) != memory_read_byte(&b->memory, 0xD011) ||
+        a->memory.read_map[MEMORY_PAGE(0xD000)] != a->memory.wram + 0x1000 ||
+        a->memory.read_map[MEMORY_PAGE(0xF000)] != a->memory.wram + 0x1000) {
+        TEST_FAIL("First write should copy the page into the fork");
+    }
+
+    if (memory_read_byte(&b->memory, 0xD010) != before || shared->wram[0x1010] != before ||
+        memory_read_byte(&parent->memory, 0xD010) != before) {
+        TEST_FAIL("A fork's write leaked into the snapshot or another fork");
+    }
+
+    // Switching to a shared cartridge RAM bank reads the snapshot again
+    memory_write_byte(&a->memory, ERAM_START, 0x55);
+    memory_write_byte(&a->memory, 0x4000, 0x01);
+    if (a->memory.read_map[MEMORY_PAGE(ERAM_START)] != shared->eram + RAM_BANK_SIZE) {
+        TEST_FAIL("Bank switch should map the snapshot's copy of a shared bank");
+    }
+    memory_write_byte(&a->memory, 0x4000, 0x02);
+    if (memory_read_byte(&a->memory, ERAM_START) != 0x55 ||
+        memory_read_byte(&b->memory, ERAM_START) == 0x55) {
+        TEST_FAIL("Copied cartridge RAM page should survive a bank switch");
+    }
+
+    // A frame of the test program only touches a few pages
+    run_frames(b, 1);
+    if (shared_pages(b) < pages - 4) {
+        TEST_FAIL("Running should copy only the pages it writes");
+    }
+
+    gameboy_snapshot_free(snapshot);
+    stop_machine(b);
+    stop_machine(a);
+    stop_machine(parent);
+    TEST_PASS();
+}
+
+// Test that forks keep running after the parent and snapshot are gone
+void test_snapshot_outlives_parent(void)
+{
+    TEST_START("Snapshot Outlives Parent");
+
+    gameboy_t *parent = start_machine();
+    run_frames(parent, TEST_FRAMES);
+    gameboy_snapshot_t *snapshot = gameboy_snapshot(parent);
+
+    gameboy_t *reference = fork_machine(snapshot);
+    gameboy_t *child = fork_machine(snapshot);
+    stop_machine(parent);
+    gameboy_snapshot_free(snapshot);
+
+    run_frames(child, TEST_FRAMES);
+    run_frames(reference, TEST_FRAMES);
+    if (!same_machine(child, reference) || memory_read_byte(&child->memory, 0x0150) != 0x3E) {
+        TEST_FAIL("Fork should keep the ROM and RAM it shares");
+    }
+
+    // Loading another cartridge gives the fork its RAM back
+    stop_machine(reference);
+    byte value = memory_read_byte(&child->memory, 0xC000);
+    if (!gameboy_load_rom_data(child, test_rom, sizeof(test_rom)) ||
+        child->memory.snapshot != NULL || child->memory.wram[0] != value) {
+        TEST_FAIL("Reloading a fork should leave it standalone");
+    }
+
+    stop_machine(child);
+    TEST_PASS();
+}
+
+// Test snapshotting a fork that still shares pages
+void test_fork_of_fork(void)
+{
+    TEST_START("Fork Of Fork");
+
+    gameboy_t *parent = start_machine();
+    run_frames(parent, TEST_FRAMES);
+    gameboy_snapshot_t *first = gameboy_snapshot(parent);
+
+    gameboy_t *child = fork_machine(first);
+    run_frames(child, 1);
+    gameboy_snapshot_t *second = gameboy_snapshot(child);
+    gameboy_t *grandchild = fork_machine(second);
+
+    gameboy_snapshot_free(first);
+    stop_machine(parent);
+
+    run_frames(child, TEST_FRAMES);
+    run_frames(grandchild, TEST_FRAMES);
+    if (!same_machine(child, grandchild)) {
+        TEST_FAIL("Fork of a fork diverged");
+    }
+
+    gameboy_snapshot_free(second);
+    stop_machine(child);
+    stop_machine(grandchild);
+    TEST_PASS();
+}
+
+// Test fanning out many forks from one boot
+void test_many_forks(void)
+{
+    TEST_START("Many Forks");
+
+    gameboy_t *parent = start_machine();
+    run_frames(parent, TEST_FRAMES);
+    gameboy_snapshot_t *snapshot = gameboy_snapshot(parent);
+    run_frames(parent, 2);
+
+    gameboy_t **forks = malloc(sizeof(gameboy_t *) * TEST_FORKS);
+    for (int i = 0; i < TEST_FORKS; i++) {
+        forks[i] = fork_machine(snapshot);
+    }
+
+    for (int i = 0; i < TEST_FORKS; i++) {
+        run_frames(forks[i], 2);
+        if (!same_machine(forks[i], parent)) {
+            TEST_FAIL("Every fork should match the parent");
+        }
+    }
+
+    if (atomic_load(&snapshot->memory->references) != TEST_FORKS + 2) {
+        TEST_FAIL("Snapshot should be referenced by each fork and the parent");
+    }
+
+    for (int i = 0; i < TEST_FORKS; i++) {
+        stop_machine(forks[i]);
+    }
+
+    free(forks);
+    gameboy_snapshot_free(snapshot);
+    stop_machine(parent);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Fork Test Suite ===\n\n");
+
+    test_rom_build_sampler(test_rom, sizeof(test_rom), TEST_ROM_CART_RAM | TEST_ROM_RAM_BANK);
+    test_fork_matches_parent();
+    test_copy_on_write();
+    test_snapshot_outlives_parent();
+    test_fork_of_fork();
+    test_many_forks();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your forks are working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,251 @@
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_FRAMES 10
+
+// Function declarations
+void test_gameboy_init(void);
+void test_run_frame(void);
+void test_headless_timing(void);
+void test_breakpoints(void);
+void test_machine_watchpoints(void);
+
+static byte test_rom[2 * ROM_BANK_SIZE];
+
+static gameboy_t *start_machine(bool headless, bool block_cache)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, test_rom, sizeof(test_rom))) {
+        TEST_FAIL("Could not start machine");
+    }
+
+    gb->use_block_cache = block_cache;
+    gameboy_set_headless(gb, headless);
+
+    // Solid color 3 tile 0 so rendering visibly fills the screen
+    for (int i = 0; i < 16; i++) {
+        memory_write_byte(&gb->memory, VRAM_START + i, 0xFF);
+    }
+
+    return gb;
+}
+
+static void stop_machine(gameboy_t *gb)
+{
+    gameboy_cleanup(gb);
+    free(gb);
+}
+
+// Test machine construction
+void test_gameboy_init(void)
+{
+    TEST_START("Gameboy Initialization");
+
+    gameboy_t *gb = start_machine(false, true);
+
+    if (gb->cpu.pc != CPU_ENTRY_POINT || gb->cpu.mem_sys != &gb->memory ||
+        gb->ppu.mem_sys != &gb->memory || !gb->memory.rom_loaded) {
+        TEST_FAIL("Components should share one memory system");
+    }
+
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test that a frame runs from VBlank to VBlank
+void test_run_frame(void)
+{
+    TEST_START("Run Frame");
+
+    gameboy_t *gb = start_machine(false, true);
+
+    gameboy_run_frame(gb);
+    uint64_t cycles = gameboy_run_frame(gb);
+    // Either end may be off by the instruction that crossed into VBlank
+    if (cycles < PPU_CYCLES_PER_FRAME - 24 || cycles > PPU_CYCLES_PER_FRAME + 24) {
+        TEST_FAIL("Frame should take 70224 cycles");
+    }
+
+    if (gb->ppu.ly != SCREEN_HEIGHT || gb->ppu.framebuffer[100][100] != 3) {
+        TEST_FAIL("Frame should end at VBlank with the screen drawn");
+    }
+
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test that headless runs see the same PPU timing as rendering runs
+void test_headless_timing(void)
+{
+    TEST_START("Headless Timing");
+
+    gameboy_t *reference = start_machine(false, false);
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        gameboy_run_frame(reference);
+    }
+
+    if (reference->memory.wram[0] < TEST_FRAMES - 1) {
+        TEST_FAIL("VBlank handler should run once per frame");
+    }
+
+    for (int mode = 0; mode < 2; mode++) {
+        gameboy_t *gb = start_machine(true, mode == 1);
+        for (int frame = 0; frame < TEST_FRAMES; frame++) {
+            gameboy_run_frame(gb);
+        }
+
+        if (memcmp(gb->memory.wram, reference->memory.wram, WRAM_SIZE) != 0 ||
+            gb->cpu.cycles != reference->cpu.cycles ||
+            gb->cpu.pc != reference->cpu.pc) {
+            TEST_FAIL("Headless run observed different LY/STAT/interrupts");
+        }
+
+        if (gb->ppu.framebuffer[100][100] != 0 || gb->ppu.frames != reference->ppu.frames) {
+            TEST_FAIL("Headless run should count frames without drawing");
+        }
+
+        stop_machine(gb);
+    }
+
+    stop_machine(reference);
+    TEST_PASS();
+}
+
+// Test that runs stop before breakpoints and resume past them
+void test_breakpoints(void)
+{
+    TEST_START("Breakpoints");
+
+    gameboy_t *reference = start_machine(true, false);
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        gameboy_run_frame(reference);
+    }
+
+    // Whatever core is chosen, breakpoints are honoured
+    gameboy_t *gb = start_machine(true, true);
+    gb->use_jit = true;
+    if (!gameboy_add_breakpoint(gb, 0x0200) || gameboy_add_breakpoint(gb, 0x0200)) {
+        TEST_FAIL("Breakpoint should be set once");
+    }
+
+    int stops = 0;
+    while (gb->cpu.cycles < reference->cpu.cycles) {
+        gameboy_run(gb, reference->cpu.cycles - gb->cpu.cycles);
+        if (!gameboy_stopped(gb)) {
+            break;
+        }
+        if (!gb->at_breakpoint || gb->cpu.pc != 0x0200) {
+            TEST_FAIL("Run should stop before the breakpoint");
+        }
+        stops++;
+    }
+
+    if (stops != reference->memory.wram[0]) {
+        TEST_FAIL("Every VBlank handler entry should stop once");
+    }
+
+    // Stepping through the breakpoints changes nothing the game sees
+    if (!gameboy_remove_breakpoint(gb, 0x0200) || gameboy_remove_breakpoint(gb, 0x0200)) {
+        TEST_FAIL("Breakpoint should be removed once");
+    }
+    if (memcmp(gb->memory.wram, reference->memory.wram, WRAM_SIZE) != 0 ||
+        gb->cpu.cycles != reference->cpu.cycles || gb->cpu.pc != reference->cpu.pc) {
+        TEST_FAIL("Stopping at breakpoints should not change the run");
+    }
+
+    stop_machine(gb);
+    stop_machine(reference);
+    TEST_PASS();
+}
+
+// Test that runs stop after the instruction that hits a watchpoint
+void test_machine_watchpoints(void)
+{
+    TEST_START("Machine Watchpoints");
+
+    gameboy_t *gb = start_machine(false, true);
+    memory_add_watch(&gb->memory, 0xC000, 0xC000, MEMORY_WATCH_WRITE);
+
+    gameboy_run_frame(gb);
+    gameboy_run_frame(gb);
+    if (!gameboy_stopped(gb) || gb->at_breakpoint ||
+        gb->memory.watch_hit.addr != 0xC000 || gb->memory.watch_hit.value != 1 ||
+        gb->memory.wram[0] != 1 || gb->cpu.pc != 0x0208) {
+        TEST_FAIL("Run should stop right after the counter is stored");
+    }
+
+    // Reads of LY from the main loop
+    memory_clear_watches(&gb->memory);
+    memory_add_watch(&gb->memory, 0xFF44, 0xFF44, MEMORY_WATCH_READ);
+    gameboy_run(gb, PPU_CYCLES_PER_FRAME);
+    if (!gameboy_stopped(gb) || gb->memory.watch_hit.kind != MEMORY_WATCH_READ ||
+        gb->memory.watch_hit.value != gb->memory.high_page[0x44] ||
+        gb->cpu.pc != 0x015A) {
+        TEST_FAIL("Run should stop right after LY is read");
+    }
+
+    memory_clear_watches(&gb->memory);
+    uint64_t cycles = gameboy_run(gb, PPU_CYCLES_PER_FRAME);
+    if (gameboy_stopped(gb) || cycles < PPU_CYCLES_PER_FRAME) {
+        TEST_FAIL("Run should not stop once watches are cleared");
+    }
+
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Machine Test Suite ===\n\n");
+
+    test_rom_build_sampler(test_rom, sizeof(test_rom), 0);
+    test_gameboy_init();
+    test_run_frame();
+    test_headless_timing();
+    test_breakpoints();
+    test_machine_watchpoints();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your machine is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,409 @@
+#include "../include/jit.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define PROGRAM_START 0x0150
+#define VBLANK_HANDLER 0x0200
+#define TIMER_HANDLER 0x0220
+
+// Function declarations
+void test_jit_init(void);
+void test_alu_flags(void);
+void test_memory_and_interrupts(void);
+void test_bank_switching(void);
+void test_ram_code(void);
+void test_unavailable(void);
+
+static byte test_rom[4 * ROM_BANK_SIZE];
+
+// MBC1 cartridge with four banks running program from PROGRAM_START
+static void build_test_rom(const byte *program, size_t size)
+{
+    memset(test_rom, 0, sizeof(test_rom));
+    test_rom[0x0040] = 0xC3;   // JP VBLANK_HANDLER
+    test_rom[0x0041] = VBLANK_HANDLER & 0xFF;
+    test_rom[0x0042] = VBLANK_HANDLER >> 8;
+    test_rom[0x0050] = 0xC3;   // JP TIMER_HANDLER
+    test_rom[0x0051] = TIMER_HANDLER & 0xFF;
+    test_rom[0x0052] = TIMER_HANDLER >> 8;
+    test_rom[0x0100] = 0xC3;   // JP PROGRAM_START
+    test_rom[0x0101] = PROGRAM_START & 0xFF;
+    test_rom[0x0102] = PROGRAM_START >> 8;
+    test_rom[CARTRIDGE_TYPE_ADDRESS] = 0x01;
+    test_rom[CARTRIDGE_ROM_SIZE_ADDRESS] = 0x01;
+    memcpy(test_rom + PROGRAM_START, program, size);
+}
+
+static gameboy_t *start_machine(bool jit)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, test_rom, sizeof(test_rom))) {
+        TEST_FAIL("Could not start machine");
+    }
+
+    gb->use_block_cache = false;
+    gb->use_jit = jit;
+    gameboy_set_headless(gb, true);
+    return gb;
+}
+
+static void stop_machine(gameboy_t *gb)
+{
+    gameboy_cleanup(gb);
+    free(gb);
+}
+
+static bool same_registers(const cpu_t *a, const cpu_t *b)
+{
+    return a->a == b->a && a->f == b->f && a->b == b->b && a->c == b->c &&
+           a->d == b->d && a->e == b->e && a->h == b->h && a->l == b->l &&
+           a->sp == b->sp && a->pc == b->pc && a->cycles == b->cycles &&
+           a->ime == b->ime && a->halted == b->halted;
+}
+
+static bool same_memory(const gameboy_t *a, const gameboy_t *b)
+{
+    return memcmp(a->memory.wram, b->memory.wram, WRAM_SIZE) == 0 &&
+           memcmp(a->memory.high_page, b->memory.high_page,
+                  MEMORY_PAGE_SIZE) == 0 &&
+           a->memory.mbc.rom_bank == b->memory.mbc.rom_bank;
+}
+
+/*
+ * Runs the ROM on the interpreter and on the JIT side by side, first one
+ * instruction at a time and then in odd-sized slices that end anywhere
+ * inside blocks, comparing the machines after every step. Returns the JIT
+ * machine for further checks.
+ */
+static gameboy_t *run_lockstep(int single_steps, int slices)
+{
+    gameboy_t *interpreted = start_machine(false);
+    gameboy_t *translated = start_machine(true);
+
+    for (int step = 0; step < single_steps + slices; step++) {
+        uint64_t cycles = step < single_steps ? 1 : (uint64_t)(step % 97) * 13 + 1;
+
+        gameboy_run(interpreted, cycles);
+        gameboy_run(translated, cycles);
+
+        if (!same_registers(&interpreted->cpu, &translated->cpu)) {
+            printf("\n  step %d: pc %04X/%04X af %02X%02X/%02X%02X "
+                   "cycles %llu/%llu\n", step, interpreted->cpu.pc,
+                   translated->cpu.pc, interpreted->cpu.a, interpreted->cpu.f,
+                   translated->cpu.a, translated->cpu.f,
+                   (unsigned long long)interpreted->cpu.cycles,
+                   (unsigned long long)translated->cpu.cycles);
+            TEST_FAIL("JIT left different register state");
+        }
+        if ((step % 256 == 0 || step == single_steps + slices - 1) &&
+            !same_memory(interpreted, translated)) {
+            TEST_FAIL("JIT left different memory contents");
+        }
+    }
+
+    stop_machine(interpreted);
+    return translated;
+}
+
+static void expect_translated(const gameboy_t *gb)
+{
+#if JIT_SUPPORTED
+    if (!gb->jit.available || gb->jit.blocks_compiled == 0) {
+        TEST_FAIL("Hot ROM code should have been translated");
+    }
+#else
+    (void)gb;
+#endif
+}
+
+// Test that the JIT starts empty and has a backend where one exists
+void test_jit_init(void)
+{
+    TEST_START("JIT Initialization");
+
+    jit_t *jit = malloc(sizeof(jit_t));
+    if (jit == NULL || !jit_init(jit)) {
+        TEST_FAIL("JIT initialization failed");
+    }
+
+    if (jit->available != JIT_SUPPORTED) {
+        TEST_FAIL("JIT should be available exactly where it is supported");
+    }
+    if (jit->block_count != 0 || jit->code_used != 0 ||
+        jit->blocks_compiled != 0) {
+        TEST_FAIL("JIT should start empty");
+    }
+    if (jit_init(NULL)) {
+        TEST_FAIL("NULL JIT should be rejected");
+    }
+
+    jit_cleanup(jit);
+    free(jit);
+    TEST_PASS();
+}
+
+// Test every translated ALU operation over all pairs of operands
+void test_alu_flags(void)
+{
+    TEST_START("JIT ALU Flags Match Interpreter");
+
+    const byte program[] = {
+        0x21, 0x00, 0x00,   // LD HL, 0
+        0x7C,               // LD A, H          <- loop
+        0x85,               // ADD A, L
+        0x4F,               // LD C, A
+        0x8C,               // ADC A, H
+        0x57,               // LD D, A
+        0x95,               // SUB A, L
+        0x9C,               // SBC A, H
+        0x5F,               // LD E, A
+        0xA5,               // AND L
+        0xB2,               // OR D
+        0xAB,               // XOR E
+        0xBC,               // CP H
+        0xCE, 0x7F,         // ADC A, 0x7F
+        0xDE, 0x80,         // SBC A, 0x80
+        0x3C,               // INC A
+        0x0D,               // DEC C
+        0x3F,               // CCF
+        0x2F,               // CPL
+        0xCB, 0x47,         // BIT 0, A
+        0xCB, 0xF9,         // SET 7, C
+        0xCB, 0x9A,         // RES 3, D
+        0x37,               // SCF
+        0x27,               // DAA
+        0x03,               // INC BC
+        0x1B,               // DEC DE
+        0x2C,               // INC L
+        0x20, 0xDF,         // JR NZ, loop
+        0x24,               // INC H
+        0xC2, 0x53, 0x01,   // JP NZ, loop
+        0xC3, 0x50, 0x01,   // JP PROGRAM_START
+    };
+
+    build_test_rom(program, sizeof(program));
+    gameboy_t *gb = run_lockstep(200000, 100000);
+    expect_translated(gb);
+    stop_machine(gb);
+
+    TEST_PASS();
+}
+
+// Test bus access through pages, IO handlers, HRAM and raised interrupts
+void test_memory_and_interrupts(void)
+{
+    TEST_START("JIT Memory And Interrupts Match Interpreter");
+
+    const byte program[] = {
+        0x3E, 0x05,         // LD A, VBLANK | TIMER
+        0xE0, 0xFF,         // LDH (IE), A
+        0x3E, 0x05,         // LD A, 0x05
+        0xE0, 0x07,         // LDH (TAC), A
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0x0E, 0x80,         // LD C, 0x80
+        0xFB,               // EI
+        0xF0, 0x44,         // LDH A, (LY)      <- loop
+        0x22,               // LD (HL+), A
+        0xF2,               // LD A, (C)
+        0x3C,               // INC A
+        0xE2,               // LD (C), A
+        0xE6, 0x3F,         // AND 0x3F
+        0x20, 0x04,         // JR NZ, +4
+        0x3E, 0x04,         // LD A, TIMER
+        0xE0, 0x0F,         // LDH (IF), A
+        0x7C,               // LD A, H
+        0xFE, 0xD0,         // CP 0xD0
+        0x38, 0x03,         // JR C, +3
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0xF0, 0x05,         // LDH A, (TIMA)
+        0xEA, 0x00, 0xD0,   // LD (0xD000), A
+        0x2B,               // DEC HL
+        0x7E,               // LD A, (HL)
+        0x23,               // INC HL
+        0x36, 0x5A,         // LD (HL), 0x5A
+        0xFA, 0x81, 0xFF,   // LD A, (0xFF81)
+        0x18, 0xDB,         // JR loop
+    };
+    const byte handler[] = {
+        0xF5,               // PUSH AF
+        0xF0, 0x81,         // LDH A, (0x81)
+        0x3C,               // INC A
+        0xE0, 0x81,         // LDH (0x81), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+
+    build_test_rom(program, sizeof(program));
+    memcpy(test_rom + VBLANK_HANDLER, handler, sizeof(handler));
+    memcpy(test_rom + TIMER_HANDLER, handler, sizeof(handler));
+    gameboy_t *gb = run_lockstep(100000, 50000);
+    expect_translated(gb);
+
+    if (gb->memory.high_page[0x81] == 0) {
+        TEST_FAIL("Interrupt handlers should have run");
+    }
+    stop_machine(gb);
+
+    TEST_PASS();
+}
+
+// Test that the same address in different banks runs its own code
+void test_bank_switching(void)
+{
+    TEST_START("JIT Bank Switching");
+
+    const byte program[] = {
+        0x3E, 0x01,         // LD A, 1          <- loop
+        0xEA, 0x00, 0x20,   // LD (0x2000), A
+        0xCD, 0x00, 0x40,   // CALL 0x4000
+        0x3E, 0x02,         // LD A, 2
+        0xEA, 0x00, 0x20,   // LD (0x2000), A
+        0xCD, 0x00, 0x40,   // CALL 0x4000
+        0x3E, 0x03,         // LD A, 3
+        0xEA, 0x00, 0x20,   // LD (0x2000), A
+        0xCD, 0x00, 0x40,   // CALL 0x4000
+        0x0C,               // INC C
+        0x18, 0xE5,         // JR loop
+    };
+
+    build_test_rom(program, sizeof(program));
+    for (int bank = 1; bank < 4; bank++) {
+        byte *code = test_rom + bank * ROM_BANK_SIZE;
+
+        code[0] = 0x78;                 // LD A, B
+        code[1] = 0xC6;                 // ADD A, bank * 0x10
+        code[2] = (byte)(bank * 0x10);
+        code[3] = 0x47;                 // LD B, A
+        code[4] = 0xEA;                 // LD (0xC000 + bank), A
+        code[5] = (byte)bank;
+        code[6] = 0xC0;
+        code[7] = 0xC9;                 // RET
+    }
+
+    gameboy_t *gb = run_lockstep(20000, 20000);
+    expect_translated(gb);
+
+    if (gb->memory.wram[1] == gb->memory.wram[2] ||
+        gb->memory.wram[2] == gb->memory.wram[3]) {
+        TEST_FAIL("Each bank should have run its own code");
+    }
+    stop_machine(gb);
+
+    TEST_PASS();
+}
+
+// Test that self-modifying code in WRAM is left to the interpreter
+void test_ram_code(void)
+{
+    TEST_START("JIT RAM Code Falls Back To Interpreter");
+
+    const byte program[] = {
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0x36, 0x04,         // LD (HL), INC B
+        0x23,               // INC HL
+        0x36, 0xC9,         // LD (HL), RET
+        0xCD, 0x00, 0xC0,   // CALL 0xC000      <- loop
+        0xFA, 0x00, 0xC0,   // LD A, (0xC000)
+        0xEE, 0x01,         // XOR 0x01         INC B <-> DEC B
+        0xEA, 0x00, 0xC0,   // LD (0xC000), A
+        0x0C,               // INC C
+        0x18, 0xF2,         // JR loop
+    };
+
+    build_test_rom(program, sizeof(program));
+    gameboy_t *gb = run_lockstep(20000, 20000);
+
+    if (gb->cpu.b > 1) {
+        TEST_FAIL("Patched RAM code should alternate INC B and DEC B");
+    }
+    stop_machine(gb);
+
+    TEST_PASS();
+}
+
+// Test that a JIT without a backend still runs the cpu like cpu_run()
+void test_unavailable(void)
+{
+    TEST_START("JIT Without Backend Interprets");
+
+    const byte program[] = {
+        0x3C,               // INC A            <- loop
+        0x80,               // ADD A, B
+        0x47,               // LD B, A
+        0x18, 0xFB,         // JR loop
+    };
+
+    build_test_rom(program, sizeof(program));
+    gameboy_t *interpreted = start_machine(false);
+    gameboy_t *fallback = start_machine(true);
+    fallback->jit.available = false;
+
+    gameboy_run(interpreted, 100000);
+    gameboy_run(fallback, 100000);
+
+    if (!same_registers(&interpreted->cpu, &fallback->cpu)) {
+        TEST_FAIL("Fallback left different register state");
+    }
+    if (fallback->jit.blocks_compiled != 0) {
+        TEST_FAIL("Nothing should be translated without a backend");
+    }
+
+    stop_machine(interpreted);
+    stop_machine(fallback);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator JIT Test Suite ===\n\n");
+
+    test_jit_init();
+    test_alu_flags();
+    test_memory_and_interrupts();
+    test_bank_switching();
+    test_ram_code();
+    test_unavailable();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your JIT is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,146 @@
+#include "../include/joypad.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+
+// Function declarations
+void test_register(void);
+void test_interrupt(void);
+
+static memory_system_t test_memory;
+static joypad_t test_joypad;
+
+static void setup_joypad(void)
+{
+    if (!memory_init(&test_memory) || !joypad_init(&test_joypad, &test_memory)) {
+        TEST_FAIL("Joypad initialization failed");
+    }
+}
+
+static byte pending_interrupts(void)
+{
+    return memory_read_byte(&test_memory, IF_REGISTER) & INTERRUPT_JOYPAD;
+}
+
+// Test that P1 shows the held keys of the selected group
+void test_register(void)
+{
+    TEST_START("P1 Register");
+
+    setup_joypad();
+    if (memory_read_byte(&test_memory, JOYP_REGISTER) != 0xFF) {
+        TEST_FAIL("Nothing selected should read all ones");
+    }
+
+    joypad_set_buttons(&test_joypad, JOYPAD_RIGHT | JOYPAD_UP | JOYPAD_A);
+    if (memory_read_byte(&test_memory, JOYP_REGISTER) != 0xFF) {
+        TEST_FAIL("Keys should not show while their group is unselected");
+    }
+
+    memory_write_byte(&test_memory, JOYP_REGISTER, JOYP_SELECT_BUTTONS);
+    if (memory_read_byte(&test_memory, JOYP_REGISTER) != 0xEA) {
+        TEST_FAIL("Directions should read as 0 bits when held");
+    }
+
+    memory_write_byte(&test_memory, JOYP_REGISTER, JOYP_SELECT_DIRECTIONS);
+    if (memory_read_byte(&test_memory, JOYP_REGISTER) != 0xDE) {
+        TEST_FAIL("Buttons should read as 0 bits when held");
+    }
+
+    // Both groups selected see the keys of either
+    memory_write_byte(&test_memory, JOYP_REGISTER, 0x00);
+    if (memory_read_byte(&test_memory, JOYP_REGISTER) != 0xCA) {
+        TEST_FAIL("Both groups should combine");
+    }
+
+    joypad_set_buttons(&test_joypad, 0);
+    if (memory_read_byte(&test_memory, JOYP_REGISTER) != 0xCF) {
+        TEST_FAIL("Released keys should read as 1 bits");
+    }
+
+    memory_cleanup(&test_memory);
+    TEST_PASS();
+}
+
+// Test that the interrupt fires when a selected line falls
+void test_interrupt(void)
+{
+    TEST_START("Joypad Interrupt");
+
+    setup_joypad();
+    memory_write_byte(&test_memory, JOYP_REGISTER, JOYP_SELECT_BUTTONS);
+
+    joypad_set_buttons(&test_joypad, JOYPAD_START);
+    if (pending_interrupts() != 0) {
+        TEST_FAIL("Unselected keys should not interrupt");
+    }
+
+    joypad_set_buttons(&test_joypad, JOYPAD_START | JOYPAD_DOWN);
+    if (pending_interrupts() == 0) {
+        TEST_FAIL("Pressing a selected key should interrupt");
+    }
+
+    memory_write_byte(&test_memory, IF_REGISTER, 0x00);
+    joypad_set_buttons(&test_joypad, JOYPAD_START);
+    if (pending_interrupts() != 0) {
+        TEST_FAIL("Releasing a key should not interrupt");
+    }
+
+    // Selecting a group with a key already held pulls its line low too
+    memory_write_byte(&test_memory, JOYP_REGISTER, JOYP_SELECT_DIRECTIONS);
+    if (pending_interrupts() == 0) {
+        TEST_FAIL("Selecting a held key should interrupt");
+    }
+
+    memory_cleanup(&test_memory);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Joypad Test Suite ===\n\n");
+
+    test_register();
+    test_interrupt();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your joypad is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
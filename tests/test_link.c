@@ -0,0 +1,418 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "../include/link.h"
+#include "../include/serial.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+
+#define TEST_BYTES 16
+// Far more than the 16 transfers take
+#define TEST_FRAMES 20
+#define TEST_SOCKET_PATH "/tmp/gameboy_test_link.sock"
+
+// Function declarations
+void test_messages(void);
+void test_unplugged(void);
+void test_threads(void);
+void test_independent_of_host_timing(void);
+void test_processes(void);
+
+static byte master_rom[2 * ROM_BANK_SIZE];
+static byte slave_rom[2 * ROM_BANK_SIZE];
+
+/*
+ * The master clocks out 0, 1, ... 15 and keeps what comes back at 0xC000.
+ * The slave sleeps on the serial interrupt, keeps each byte it gets at
+ * 0xC000 and answers the next one with it plus 0x40, so the master should
+ * see 0x3F, 0x40, ... 0x4E.
+ */
+static void build_test_roms(void)
+{
+    const byte master[] = {
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0x06, 0x00,         // LD B, 0
+        0x78,               // LD A, B
+        0xE0, 0x01,         // LDH (SB), A
+        0x3E, 0x81,         // LD A, TRANSFER | INTERNAL
+        0xE0, 0x02,         // LDH (SC), A
+        0xF0, 0x02,         // LDH A, (SC)
+        0xCB, 0x7F,         // BIT 7, A
+        0x20, 0xFA,         // JR NZ, -6
+        0xF0, 0x01,         // LDH A, (SB)
+        0x22,               // LD (HL+), A
+        0x04,               // INC B
+        0x78,               // LD A, B
+        0xFE, TEST_BYTES,   // CP 16
+        0x20, 0xEA,         // JR NZ, -22
+        0x18, 0xFE,         // JR -2
+    };
+    const byte slave[] = {
+        0x3E, 0x3F,         // LD A, 0x3F
+        0xE0, 0x01,         // LDH (SB), A
+        0x3E, 0x08,         // LD A, SERIAL
+        0xE0, 0xFF,         // LDH (IE), A
+        0x21, 0x00, 0xC0,   // LD HL, 0xC000
+        0xAF,               // XOR A
+        0xE0, 0x0F,         // LDH (IF), A
+        0x3E, 0x80,         // LD A, TRANSFER
+        0xE0, 0x02,         // LDH (SC), A
+        0x76,               // HALT
+        0x00,               // NOP
+        0xF0, 0x01,         // LDH A, (SB)
+        0x22,               // LD (HL+), A
+        0xC6, 0x40,         // ADD A, 0x40
+        0xE0, 0x01,         // LDH (SB), A
+        0x7D,               // LD A, L
+        0xFE, TEST_BYTES,   // CP 16
+        0x20, 0xEB,         // JR NZ, -21
+        0x18, 0xFE,         // JR -2
+    };
+    byte *roms[2] = { master_rom, slave_rom };
+
+    for (int i = 0; i < 2; i++) {
+        memset(roms[i], 0, sizeof(master_rom));
+        roms[i][0x0100] = 0xC3;   // JP 0x0150
+        roms[i][0x0101] = 0x50;
+        roms[i][0x0102] = 0x01;
+    }
+    memcpy(master_rom + 0x0150, master, sizeof(master));
+    memcpy(slave_rom + 0x0150, slave, sizeof(slave));
+}
+
+static gameboy_t *start_machine(const byte *rom)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom, sizeof(master_rom))) {
+        TEST_FAIL("Could not start machine");
+    }
+
+    gameboy_set_headless(gb, true);
+    return gb;
+}
+
+static void stop_machine(gameboy_t *gb)
+{
+    gameboy_cleanup(gb);
+    free(gb);
+}
+
+static bool received(gameboy_t *gb, byte first)
+{
+    for (int i = 0; i < TEST_BYTES; i++) {
+        if (memory_read_byte(&gb->memory, 0xC000 + i) != (byte)(first + i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+typedef struct linked_run {
+    gameboy_t *gb;
+    link_t link;
+    // Host time to waste after every frame
+    long delay_ns;
+} linked_run_t;
+
+static void pause_for(long ns)
+{
+    struct timespec ts = { 0, ns };
+    nanosleep(&ts, NULL);
+}
+
+static void *run_linked(void *arg)
+{
+    linked_run_t *run = arg;
+
+    serial_attach(&run->gb->serial, &run->link);
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        gameboy_run_frame(run->gb);
+        if (run->delay_ns > 0) {
+            pause_for(run->delay_ns);
+        }
+    }
+
+    // Lets the other side carry on unplugged once it gets here
+    link_close(&run->link);
+    return NULL;
+}
+
+static void run_pair(linked_run_t runs[2])
+{
+    pthread_t threads[2];
+
+    if (!link_pair(&runs[0].link, &runs[1].link)) {
+        TEST_FAIL("Could not pair links");
+    }
+
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&threads[i], NULL, run_linked, &runs[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+// Test that messages arrive whole and in order, and that EOF unplugs
+void test_messages(void)
+{
+    TEST_START("Messages");
+
+    link_t a, b;
+    link_message_t message;
+
+    if (!link_pair(&a, &b)) {
+        TEST_FAIL("Could not pair links");
+    }
+
+    if (link_receive(&b, &message, false)) {
+        TEST_FAIL("Nothing should have arrived yet");
+    }
+
+    // More than one batch, so sending has to flush on its own
+    for (int i = 0; i < 3 * LINK_BATCH_MESSAGES; i++) {
+        message.time = 0x0123456789ULL * i;
+        message.type = LINK_MESSAGE_START;
+        message.value = (byte)i;
+        if (!link_send(&a, &message)) {
+            TEST_FAIL("Sending should succeed");
+        }
+    }
+    if (!link_flush(&a)) {
+        TEST_FAIL("Flushing should succeed");
+    }
+
+    for (int i = 0; i < 3 * LINK_BATCH_MESSAGES; i++) {
+        if (!link_receive(&b, &message, true) ||
+            message.time != 0x0123456789ULL * i ||
+            message.type != LINK_MESSAGE_START || message.value != (byte)i) {
+            TEST_FAIL("Messages should arrive intact and in order");
+        }
+    }
+
+    link_close(&a);
+    if (link_receive(&b, &message, true) || b.connected) {
+        TEST_FAIL("A closed peer should leave the link disconnected");
+    }
+
+    message.type = LINK_MESSAGE_TIME;
+    if (link_send(&b, &message) || link_flush(&b)) {
+        TEST_FAIL("Sending on a disconnected link should fail");
+    }
+
+    link_close(&b);
+    TEST_PASS();
+}
+
+// Test that a transfer with no cable brings in 0xFF and raises the interrupt
+void test_unplugged(void)
+{
+    TEST_START("Unplugged");
+
+    gameboy_t *gb = start_machine(master_rom);
+
+    gameboy_run(gb, 1000);
+    if (received(gb, 0xFF) || gb->serial.end == SCHEDULER_NEVER) {
+        TEST_FAIL("The first transfer should still be going");
+    }
+
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+    }
+
+    for (int i = 0; i < TEST_BYTES; i++) {
+        if (memory_read_byte(&gb->memory, 0xC000 + i) != 0xFF) {
+            TEST_FAIL("An unplugged port should read 0xFF");
+        }
+    }
+    if (!(memory_read_byte(&gb->memory, IF_REGISTER) & INTERRUPT_SERIAL) ||
+        (memory_read_byte(&gb->memory, SC_REGISTER) & SC_TRANSFER) ||
+        gb->serial.transfers != 0) {
+        TEST_FAIL("Transfers should still complete");
+    }
+
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test that two machines on threads swap every byte
+void test_threads(void)
+{
+    TEST_START("Threads");
+
+    for (int cache = 0; cache < 2; cache++) {
+        linked_run_t runs[2] = {
+            { start_machine(master_rom), { 0 }, 0 },
+            { start_machine(slave_rom), { 0 }, 0 },
+        };
+
+        for (int i = 0; i < 2; i++) {
+            runs[i].gb->use_block_cache = cache;
+        }
+        run_pair(runs);
+
+        if (!received(runs[0].gb, 0x3F) || !received(runs[1].gb, 0x00)) {
+            TEST_FAIL("Both sides should get every byte the other sent");
+        }
+        if (runs[0].gb->serial.transfers != TEST_BYTES ||
+            runs[1].gb->serial.transfers != TEST_BYTES) {
+            TEST_FAIL("Every transfer should go over the link");
+        }
+
+        for (int i = 0; i < 2; i++) {
+            stop_machine(runs[i].gb);
+        }
+    }
+
+    TEST_PASS();
+}
+
+// Test that the machines end up the same however fast each one runs
+void test_independent_of_host_timing(void)
+{
+    TEST_START("Independent Of Host Timing");
+
+    uint64_t cycles[3][2];
+    byte wram[3][2][TEST_BYTES];
+
+    for (int slow = 0; slow < 3; slow++) {
+        linked_run_t runs[2] = {
+            { start_machine(master_rom), { 0 }, slow == 1 ? 2000000 : 0 },
+            { start_machine(slave_rom), { 0 }, slow == 2 ? 2000000 : 0 },
+        };
+
+        run_pair(runs);
+        for (int i = 0; i < 2; i++) {
+            cycles[slow][i] = runs[i].gb->cpu.cycles;
+            for (int j = 0; j < TEST_BYTES; j++) {
+                wram[slow][i][j] = memory_read_byte(&runs[i].gb->memory,
+                                                    0xC000 + j);
+            }
+            stop_machine(runs[i].gb);
+        }
+    }
+
+    for (int slow = 1; slow < 3; slow++) {
+        if (memcmp(cycles[slow], cycles[0], sizeof(cycles[0])) != 0 ||
+            memcmp(wram[slow], wram[0], sizeof(wram[0])) != 0) {
+            TEST_FAIL("A slow side should not change what either side sees");
+        }
+    }
+
+    TEST_PASS();
+}
+
+static bool connect_with_retry(link_t *link)
+{
+    for (int attempt = 0; attempt < 500; attempt++) {
+        if (access(TEST_SOCKET_PATH, F_OK) == 0 &&
+            link_connect(link, TEST_SOCKET_PATH)) {
+            return true;
+        }
+        pause_for(10000000);
+    }
+
+    return false;
+}
+
+// Test two instances in separate processes over a Unix socket
+void test_processes(void)
+{
+    TEST_START("Processes");
+
+    unlink(TEST_SOCKET_PATH);
+    fflush(stdout);
+
+    pid_t child = fork();
+    if (child < 0) {
+        TEST_FAIL("Could not fork");
+    }
+
+    if (child == 0) {
+        linked_run_t run = { start_machine(slave_rom), { 0 }, 0 };
+
+        if (!connect_with_retry(&run.link)) {
+            _exit(2);
+        }
+        run_linked(&run);
+        _exit(received(run.gb, 0x00) ? 0 : 1);
+    }
+
+    linked_run_t run = { start_machine(master_rom), { 0 }, 0 };
+    if (!link_listen(&run.link, TEST_SOCKET_PATH)) {
+        TEST_FAIL("Could not listen for the other process");
+    }
+    run_linked(&run);
+
+    int status;
+    if (waitpid(child, &status, 0) != child || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+        TEST_FAIL("The slave process should get every byte");
+    }
+    if (!received(run.gb, 0x3F)) {
+        TEST_FAIL("The master process should get every reply");
+    }
+
+    stop_machine(run.gb);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Link Cable Test Suite ===\n\n");
+
+    build_test_roms();
+    test_messages();
+    test_unplugged();
+    test_threads();
+    test_independent_of_host_timing();
+    test_processes();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your link cable is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,439 @@
+#include "../include/ppu.h"
+#include "../include/memory.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+// Shared machine for the tests
+static memory_system_t test_memory;
+static ppu_t test_ppu;
+
+// Function declarations
+void test_ppu_init(void);
+void test_line_timing(void);
+void test_stat_interrupts(void);
+void test_background(void);
+void test_scroll_and_window(void);
+void test_sprites(void);
+void test_offscreen_sprites(void);
+void test_tile_cache(void);
+
+static void reset_machine(void)
+{
+    memory_init(&test_memory);
+    ppu_init(&test_ppu, &test_memory);
+}
+
+// Write one 8x8 tile where every row uses the given low/high plane bytes
+static void write_tile(int tile, byte low, byte high)
+{
+    for (int row = 0; row < 8; row++) {
+        memory_write_byte(&test_memory, VRAM_START + tile * 16 + row * 2, low);
+        memory_write_byte(&test_memory, VRAM_START + tile * 16 + row * 2 + 1, high);
+    }
+}
+
+static void render_frame(void)
+{
+    ppu_step(&test_ppu, PPU_CYCLES_PER_FRAME);
+}
+
+// Test post-boot register state
+void test_ppu_init(void)
+{
+    TEST_START("PPU Initialization");
+
+    reset_machine();
+
+    if (memory_read_byte(&test_memory, LCDC_REGISTER) != 0x91 ||
+        memory_read_byte(&test_memory, BGP_REGISTER) != 0xFC) {
+        TEST_FAIL("LCDC and BGP should hold their post-boot values");
+    }
+
+    if (memory_read_byte(&test_memory, LY_REGISTER) != 0 ||
+        (memory_read_byte(&test_memory, STAT_REGISTER) & STAT_MODE_MASK) != PPU_MODE_OAM_SCAN) {
+        TEST_FAIL("PPU should start in OAM scan of line 0");
+    }
+
+    TEST_PASS();
+}
+
+// Test mode sequence, LY and VBlank timing
+void test_line_timing(void)
+{
+    TEST_START("Line Timing");
+
+    reset_machine();
+
+    ppu_step(&test_ppu, PPU_OAM_SCAN_DOTS);
+    if (test_ppu.mode != PPU_MODE_TRANSFER) {
+        TEST_FAIL("Mode 3 should follow 80 dots of OAM scan");
+    }
+
+    ppu_step(&test_ppu, PPU_TRANSFER_DOTS);
+    if (test_ppu.mode != PPU_MODE_HBLANK) {
+        TEST_FAIL("HBlank should follow pixel transfer");
+    }
+
+    ppu_step(&test_ppu, PPU_DOTS_PER_LINE - PPU_OAM_SCAN_DOTS - PPU_TRANSFER_DOTS);
+    if (memory_read_byte(&test_memory, LY_REGISTER) != 1) {
+        TEST_FAIL("LY should advance every 456 dots");
+    }
+
+    // Writes to LY are ignored
+    memory_write_byte(&test_memory, LY_REGISTER, 0x42);
+    if (memory_read_byte(&test_memory, LY_REGISTER) != 1) {
+        TEST_FAIL("LY should be read-only");
+    }
+
+    ppu_step(&test_ppu, PPU_DOTS_PER_LINE * (SCREEN_HEIGHT - 1));
+    if (test_ppu.mode != PPU_MODE_VBLANK || !test_ppu.frame_ready ||
+        !(memory_read_byte(&test_memory, IF_REGISTER) & INTERRUPT_VBLANK)) {
+        TEST_FAIL("Line 144 should enter VBlank and request the interrupt");
+    }
+
+    ppu_step(&test_ppu, PPU_DOTS_PER_LINE * (PPU_LINES_PER_FRAME - SCREEN_HEIGHT));
+    if (memory_read_byte(&test_memory, LY_REGISTER) != 0 || test_ppu.frames != 1) {
+        TEST_FAIL("Frame should wrap after 154 lines");
+    }
+
+    // Turning the LCD off stops and resets LY
+    ppu_step(&test_ppu, PPU_DOTS_PER_LINE * 3);
+    memory_write_byte(&test_memory, LCDC_REGISTER, 0x11);
+    ppu_step(&test_ppu, PPU_DOTS_PER_LINE * 3);
+    if (memory_read_byte(&test_memory, LY_REGISTER) != 0) {
+        TEST_FAIL("Disabled LCD should hold LY at 0");
+    }
+
+    TEST_PASS();
+}
+
+// Test LYC coincidence and mode STAT interrupts
+void test_stat_interrupts(void)
+{
+    TEST_START("STAT Interrupts");
+
+    reset_machine();
+
+    memory_write_byte(&test_memory, LYC_REGISTER, 10);
+    memory_write_byte(&test_memory, STAT_REGISTER, STAT_LYC_INTERRUPT | STAT_MODE_MASK);
+    if ((memory_read_byte(&test_memory, STAT_REGISTER) & STAT_MODE_MASK) != PPU_MODE_OAM_SCAN) {
+        TEST_FAIL("STAT mode bits should be read-only");
+    }
+
+    ppu_step(&test_ppu, PPU_DOTS_PER_LINE * 10 - 1);
+    if (memory_read_byte(&test_memory, IF_REGISTER) & INTERRUPT_LCD_STAT) {
+        TEST_FAIL("STAT interrupt requested before LY matched LYC");
+    }
+
+    ppu_step(&test_ppu, 1);
+    if (!(memory_read_byte(&test_memory, IF_REGISTER) & INTERRUPT_LCD_STAT) ||
+        !(memory_read_byte(&test_memory, STAT_REGISTER) & STAT_COINCIDENCE)) {
+        TEST_FAIL("LY == LYC should set coincidence and request STAT");
+    }
+
+    // HBlank source fires once per line
+    memory_write_byte(&test_memory, IF_REGISTER, 0);
+    memory_write_byte(&test_memory, STAT_REGISTER, STAT_HBLANK_INTERRUPT);
+    ppu_step(&test_ppu, PPU_DOTS_PER_LINE);
+    if (!(memory_read_byte(&test_memory, IF_REGISTER) & INTERRUPT_LCD_STAT)) {
+        TEST_FAIL("HBlank should request STAT when enabled");
+    }
+
+    TEST_PASS();
+}
+
+// Test tile decoding and the background palette
+void test_background(void)
+{
+    TEST_START("Background Rendering");
+
+    reset_machine();
+
+    // Tile 1 row: colors 0,1,2,3,3,2,1,0
+    write_tile(1, 0x5A, 0x3C);
+    memory_write_byte(&test_memory, 0x9800, 0x01);
+    memory_write_byte(&test_memory, BGP_REGISTER, 0xE4);
+    render_frame();
+
+    const byte expected[8] = { 0, 1, 2, 3, 3, 2, 1, 0 };
+    if (memcmp(test_ppu.framebuffer[0], expected, 8) != 0 ||
+        memcmp(test_ppu.framebuffer[7], expected, 8) != 0) {
+        TEST_FAIL("2bpp tile decoded incorrectly");
+    }
+
+    if (test_ppu.framebuffer[0][8] != 0 || test_ppu.framebuffer[8][0] != 0) {
+        TEST_FAIL("Tile 0 should render as color 0");
+    }
+
+    // Inverted palette
+    memory_write_byte(&test_memory, BGP_REGISTER, 0x1B);
+    render_frame();
+    if (test_ppu.framebuffer[0][0] != 3 || test_ppu.framebuffer[0][3] != 0) {
+        TEST_FAIL("BGP should remap colors");
+    }
+
+    // Signed tile addressing: index 0x81 reads 0x8810 when LCDC bit 4 is clear
+    write_tile(0x81, 0xFF, 0xFF);
+    memory_write_byte(&test_memory, 0x9800, 0x81);
+    memory_write_byte(&test_memory, BGP_REGISTER, 0xE4);
+    memory_write_byte(&test_memory, LCDC_REGISTER, 0x81);
+    render_frame();
+    if (test_ppu.framebuffer[0][0] != 3) {
+        TEST_FAIL("Signed tile data addressing incorrect");
+    }
+
+    TEST_PASS();
+}
+
+// Test SCX/SCY scrolling and the window layer
+void test_scroll_and_window(void)
+{
+    TEST_START("Scrolling And Window");
+
+    reset_machine();
+    memory_write_byte(&test_memory, BGP_REGISTER, 0xE4);
+
+    write_tile(1, 0xFF, 0x00);   // solid color 1
+    write_tile(2, 0x00, 0xFF);   // solid color 2
+    memory_write_byte(&test_memory, 0x9800 + 32 + 1, 0x01);
+
+    // Tile (1,1) scrolled to the top-left corner with its left 3 pixels cut
+    memory_write_byte(&test_memory, SCX_REGISTER, 11);
+    memory_write_byte(&test_memory, SCY_REGISTER, 8);
+    render_frame();
+    if (test_ppu.framebuffer[0][0] != 1 || test_ppu.framebuffer[0][4] != 1 ||
+        test_ppu.framebuffer[0][5] != 0 || test_ppu.framebuffer[7][4] != 1) {
+        TEST_FAIL("SCX/SCY scroll incorrect");
+    }
+
+    // Horizontal wrap at 256 pixels
+    memory_write_byte(&test_memory, SCY_REGISTER, 0);
+    memory_write_byte(&test_memory, SCX_REGISTER, 252);
+    memory_write_byte(&test_memory, 0x9800, 0x01);
+    render_frame();
+    if (test_ppu.framebuffer[0][3] != 0 || test_ppu.framebuffer[0][4] != 1) {
+        TEST_FAIL("Background should wrap horizontally");
+    }
+
+    // Window from the 9C00 map at (WX - 7, WY)
+    for (int i = 0; i < 32 * 32; i++) {
+        memory_write_byte(&test_memory, 0x9C00 + i, 0x02);
+    }
+    memory_write_byte(&test_memory, SCX_REGISTER, 0);
+    memory_write_byte(&test_memory, WX_REGISTER, 7 + 100);
+    memory_write_byte(&test_memory, WY_REGISTER, 50);
+    memory_write_byte(&test_memory, LCDC_REGISTER, 0x91 | LCDC_WINDOW_ENABLE | LCDC_WINDOW_MAP);
+    render_frame();
+    if (test_ppu.framebuffer[49][100] != 0 || test_ppu.framebuffer[50][99] != 0 ||
+        test_ppu.framebuffer[50][100] != 2 || test_ppu.framebuffer[143][159] != 2) {
+        TEST_FAIL("Window position incorrect");
+    }
+
+    TEST_PASS();
+}
+
+static void write_sprite(int index, int y, int x, byte tile, byte attributes)
+{
+    address base = OAM_START + index * 4;
+    memory_write_byte(&test_memory, base, (byte)(y + 16));
+    memory_write_byte(&test_memory, base + 1, (byte)(x + 8));
+    memory_write_byte(&test_memory, base + 2, tile);
+    memory_write_byte(&test_memory, base + 3, attributes);
+}
+
+// Test sprite palettes, transparency, flipping and priority
+void test_sprites(void)
+{
+    TEST_START("Sprite Rendering");
+
+    reset_machine();
+    memory_write_byte(&test_memory, BGP_REGISTER, 0xE4);
+    memory_write_byte(&test_memory, OBP0_REGISTER, 0xE4);
+    memory_write_byte(&test_memory, OBP1_REGISTER, 0x1B);
+    memory_write_byte(&test_memory, LCDC_REGISTER, 0x91 | LCDC_OBJ_ENABLE);
+
+    write_tile(1, 0xF0, 0xF0);   // left half color 3, right half transparent
+    write_tile(2, 0xFF, 0x00);   // solid color 1
+    write_sprite(0, 10, 20, 0x01, 0);
+    write_sprite(1, 30, 20, 0x01, OAM_ATTR_FLIP_X | OAM_ATTR_PALETTE);
+    render_frame();
+
+    if (test_ppu.framebuffer[10][20] != 3 || test_ppu.framebuffer[10][24] != 0) {
+        TEST_FAIL("Sprite color 0 should be transparent");
+    }
+    if (test_ppu.framebuffer[30][20] != 0 || test_ppu.framebuffer[30][24] != 0 ||
+        test_ppu.framebuffer[30][27] != 0) {
+        TEST_FAIL("Flipped sprite should show only its right half in OBP1");
+    }
+
+    // Lower X wins on overlap even when later in OAM
+    write_sprite(2, 50, 40, 0x02, 0);
+    write_sprite(3, 50, 36, 0x01, 0);
+    render_frame();
+    if (test_ppu.framebuffer[50][36] != 3 || test_ppu.framebuffer[50][40] != 1 ||
+        test_ppu.framebuffer[50][39] != 3) {
+        TEST_FAIL("Overlapping sprites drawn in wrong priority");
+    }
+
+    // Behind-background sprites only show over color 0
+    memory_write_byte(&test_memory, 0x9800 + 32 * 8 + 1, 0x02);   // tile at (8, 64)
+    write_sprite(4, 64, 4, 0x01, OAM_ATTR_BEHIND_BG);
+    render_frame();
+    if (test_ppu.framebuffer[64][7] != 3 || test_ppu.framebuffer[64][8] != 1) {
+        TEST_FAIL("Background priority flag ignored");
+    }
+
+    // Only ten sprites per line
+    reset_machine();
+    memory_write_byte(&test_memory, LCDC_REGISTER, 0x91 | LCDC_OBJ_ENABLE);
+    memory_write_byte(&test_memory, OBP0_REGISTER, 0xE4);
+    write_tile(2, 0xFF, 0x00);
+    for (int i = 0; i < 12; i++) {
+        write_sprite(i, 0, i * 8, 0x02, 0);
+    }
+    render_frame();
+    if (test_ppu.framebuffer[0][79] != 1 || test_ppu.framebuffer[0][80] != 0) {
+        TEST_FAIL("More than ten sprites drawn on a line");
+    }
+
+    TEST_PASS();
+}
+
+// Test sprites past the right edge: never drawn, but still use up the line
+void test_offscreen_sprites(void)
+{
+    TEST_START("Off-Screen Sprites");
+
+    reset_machine();
+    memory_write_byte(&test_memory, LCDC_REGISTER, 0x91 | LCDC_OBJ_ENABLE);
+    memory_write_byte(&test_memory, OBP0_REGISTER, 0xE4);
+    write_tile(1, 0xFF, 0xFF);   // solid color 3
+
+    // OAM X 167 leaves one column on screen
+    write_sprite(0, 20, 159, 0x01, 0);
+    render_frame();
+    if (test_ppu.framebuffer[20][159] != 3 || test_ppu.framebuffer[20][158] != 0) {
+        TEST_FAIL("Sprite at OAM X 167 should show its first column");
+    }
+
+    for (int x = 168; x <= 255; x++) {
+        write_sprite(0, 20, x - 8, 0x01, OAM_ATTR_FLIP_X);
+        render_frame();
+        for (int column = 0; column < SCREEN_WIDTH; column++) {
+            if (test_ppu.framebuffer[20][column] != 0) {
+                TEST_FAIL("Sprite past the right edge should not be drawn");
+            }
+        }
+    }
+
+    // Ten invisible sprites still fill the line
+    for (int i = 0; i < 10; i++) {
+        write_sprite(i, 40, 160 + i * 8, 0x01, 0);
+    }
+    write_sprite(10, 40, 0, 0x01, 0);
+    render_frame();
+    if (test_ppu.framebuffer[40][0] != 0) {
+        TEST_FAIL("Off-screen sprites should count toward the line limit");
+    }
+
+    TEST_PASS();
+}
+
+// Test that tile writes, and only tile writes, refresh the decoded tiles
+void test_tile_cache(void)
+{
+    TEST_START("Decoded Tile Cache");
+
+    reset_machine();
+    memory_write_byte(&test_memory, BGP_REGISTER, 0xE4);
+    write_tile(1, 0xFF, 0x00);
+    memory_write_byte(&test_memory, 0x9800, 0x01);
+    render_frame();
+
+    if (test_memory.vram_tile_dirty[1] || test_ppu.framebuffer[3][0] != 1) {
+        TEST_FAIL("Rendering should decode and clean the tile");
+    }
+
+    // Row 3 of tile 1 becomes color 3
+    memory_write_byte(&test_memory, VRAM_START + 16 + 3 * 2 + 1, 0xFF);
+    if (!test_memory.vram_tile_dirty[1] || test_memory.vram_tile_dirty[0]) {
+        TEST_FAIL("Write should mark only its own tile dirty");
+    }
+
+    // Map writes do not touch tile data
+    memory_write_byte(&test_memory, 0x9801, 0x01);
+    if (test_memory.vram_tile_dirty[0] || memory_read_byte(&test_memory, 0x9801) != 0x01) {
+        TEST_FAIL("Tile map should be plain memory");
+    }
+
+    render_frame();
+    if (test_ppu.framebuffer[3][0] != 3 || test_ppu.framebuffer[2][0] != 1 ||
+        test_ppu.framebuffer[3][8] != 3) {
+        TEST_FAIL("Modified tile not redrawn");
+    }
+
+    // Last tile of the 0x9000 block, used through signed addressing
+    write_tile(383, 0x00, 0xFF);
+    memory_write_byte(&test_memory, 0x9800, 0x7F);
+    memory_write_byte(&test_memory, LCDC_REGISTER, 0x81);
+    render_frame();
+    if (test_ppu.framebuffer[0][0] != 2) {
+        TEST_FAIL("Tile 383 not decoded");
+    }
+
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator PPU Test Suite ===\n\n");
+
+    test_ppu_init();
+    test_line_timing();
+    test_stat_interrupts();
+    test_background();
+    test_scroll_and_window();
+    test_sprites();
+    test_offscreen_sprites();
+    test_tile_cache();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your PPU is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
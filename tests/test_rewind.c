@@ -0,0 +1,262 @@
+#include "../include/rewind.h"
+#include "../include/savestate.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_FRAMES 1200
+
+// Function declarations
+void test_step_back(void);
+void test_resume_after_rewind(void);
+void test_frame_limit(void);
+void test_capacity_limit(void);
+
+static byte test_rom[4 * ROM_BANK_SIZE];
+static uint64_t recorded[TEST_FRAMES];
+static size_t state_size;
+
+static gameboy_t *start_machine(void)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, test_rom, sizeof(test_rom))) {
+        TEST_FAIL("Could not start machine");
+    }
+
+    return gb;
+}
+
+static void stop_machine(gameboy_t *gb)
+{
+    gameboy_cleanup(gb);
+    free(gb);
+}
+
+// FNV-1a of the machine's save state
+static uint64_t state_hash(gameboy_t *gb)
+{
+    byte *state = malloc(state_size);
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    if (state == NULL || savestate_save(gb, state, state_size) != state_size) {
+        TEST_FAIL("Could not save state");
+    }
+
+    for (size_t i = 0; i < state_size; i++) {
+        hash ^= state[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    free(state);
+    return hash;
+}
+
+static bool matches_recorded(gameboy_t *gb, int frame)
+{
+    return state_hash(gb) == recorded[frame];
+}
+
+// Plays TEST_FRAMES frames, keeping a hash of each state for comparison
+static void record_frames(gameboy_t *gb, rewind_t *rewind)
+{
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+        if (!rewind_capture(rewind, gb)) {
+            TEST_FAIL("Capture should succeed");
+        }
+
+        if (recorded[frame] == 0) {
+            recorded[frame] = state_hash(gb);
+        } else if (!matches_recorded(gb, frame)) {
+            TEST_FAIL("Test program should be deterministic");
+        }
+    }
+}
+
+// Test stepping back through every captured frame
+void test_step_back(void)
+{
+    TEST_START("Step Back");
+
+    gameboy_t *gb = start_machine();
+    rewind_t rewind;
+    if (!rewind_init(&rewind, gb, 0, 0)) {
+        TEST_FAIL("Rewind should initialize");
+    }
+    state_size = savestate_size(gb);
+
+    record_frames(gb, &rewind);
+    if (rewind_frames(&rewind) != TEST_FRAMES) {
+        TEST_FAIL("Every frame should be kept");
+    }
+
+    // One frame of this program touches little; deltas must reflect that
+    if (rewind_memory_used(&rewind) > state_size + TEST_FRAMES * 1024) {
+        TEST_FAIL("Deltas should be far smaller than full states");
+    }
+
+    for (int frame = TEST_FRAMES - 2; frame >= 0; frame--) {
+        if (!rewind_step_back(&rewind, gb) || !matches_recorded(gb, frame)) {
+            TEST_FAIL("Step back should restore the previous frame exactly");
+        }
+    }
+
+    if (rewind_step_back(&rewind, gb) || rewind_frames(&rewind) != 1) {
+        TEST_FAIL("Oldest frame should be the end of the history");
+    }
+
+    rewind_cleanup(&rewind);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test that play continues normally from a rewound state
+void test_resume_after_rewind(void)
+{
+    TEST_START("Resume After Rewind");
+
+    gameboy_t *gb = start_machine();
+    rewind_t rewind;
+    rewind_init(&rewind, gb, 0, 0);
+    record_frames(gb, &rewind);
+
+    for (int i = 0; i < TEST_FRAMES / 2; i++) {
+        rewind_step_back(&rewind, gb);
+    }
+
+    // Replaying the same frames rebuilds the same history
+    for (int frame = TEST_FRAMES / 2; frame < TEST_FRAMES; frame++) {
+        gameboy_run_frame(gb);
+        rewind_capture(&rewind, gb);
+        if (!matches_recorded(gb, frame)) {
+            TEST_FAIL("Machine should replay identically after a rewind");
+        }
+    }
+
+    for (int frame = TEST_FRAMES - 2; frame >= 0; frame--) {
+        if (!rewind_step_back(&rewind, gb) || !matches_recorded(gb, frame)) {
+            TEST_FAIL("History should stay intact across a rewind");
+        }
+    }
+
+    rewind_cleanup(&rewind);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test that the oldest frames go once the frame limit is reached
+void test_frame_limit(void)
+{
+    TEST_START("Frame Limit");
+
+    gameboy_t *gb = start_machine();
+    rewind_t rewind;
+    rewind_init(&rewind, gb, 0, 10);
+    record_frames(gb, &rewind);
+
+    if (rewind_frames(&rewind) != 11) {
+        TEST_FAIL("History should hold the limit plus the newest state");
+    }
+
+    for (int frame = TEST_FRAMES - 2; frame >= TEST_FRAMES - 11; frame--) {
+        if (!rewind_step_back(&rewind, gb) || !matches_recorded(gb, frame)) {
+            TEST_FAIL("Kept frames should restore exactly");
+        }
+    }
+
+    if (rewind_step_back(&rewind, gb)) {
+        TEST_FAIL("Dropped frames should not be reachable");
+    }
+
+    rewind_cleanup(&rewind);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test wrapping a byte ring that holds only part of the history
+void test_capacity_limit(void)
+{
+    TEST_START("Capacity Limit");
+
+    gameboy_t *gb = start_machine();
+    rewind_t rewind;
+    size_t capacity = state_size * 2;
+
+    if (!rewind_init(&rewind, gb, capacity, 0)) {
+        TEST_FAIL("Rewind should fit in two states");
+    }
+
+    record_frames(gb, &rewind);
+    int kept = rewind_frames(&rewind);
+    if (kept <= 1 || kept >= TEST_FRAMES || rewind.used > capacity) {
+        TEST_FAIL("Ring should hold some but not all frames");
+    }
+
+    for (int frame = TEST_FRAMES - 2; frame >= TEST_FRAMES - kept; frame--) {
+        if (!rewind_step_back(&rewind, gb) || !matches_recorded(gb, frame)) {
+            TEST_FAIL("Frames kept across ring wraps should restore exactly");
+        }
+    }
+
+    if (rewind_step_back(&rewind, gb) || rewind.used != 0) {
+        TEST_FAIL("Ring should be empty after the oldest kept frame");
+    }
+
+    rewind_cleanup(&rewind);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Rewind Test Suite ===\n\n");
+
+    test_rom_build_sampler(test_rom, sizeof(test_rom), TEST_ROM_CART_RAM);
+    test_step_back();
+    test_resume_after_rewind();
+    test_frame_limit();
+    test_capacity_limit();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your rewind buffer is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef TEST_ROM_H
+
+#define TEST_ROM_H
+
+#include "../include/common.h"
+#include "../include/memory.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/*
+ * Cartridge images the tests and benchmarks write their programs into.
+ * Every test and benchmark is a program of its own, so this is all static.
+ */
+
+// Where the entry point and the VBlank vector jump to
+#define TEST_ROM_MAIN 0x0150
+#define TEST_ROM_VBLANK_HANDLER 0x0200
+
+// Options of test_rom_build_sampler()
+#define TEST_ROM_CART_RAM 0x01
+#define TEST_ROM_RAM_BANK 0x02
+
+/*
+ * A blank cartridge of size bytes (two banks or more, a power of two)
+ * that starts at TEST_ROM_MAIN and takes VBlank interrupts at
+ * TEST_ROM_VBLANK_HANDLER. type and ram_size are the header codes.
+ */
+static inline void test_rom_init(byte *rom, size_t size, byte type, byte ram_size)
+{
+    byte size_code = 0;
+
+    while (((size_t)2 * ROM_BANK_SIZE << size_code) < size) {
+        size_code++;
+    }
+
+    memset(rom, 0, size);
+    rom[0x0040] = 0xC3;   // JP TEST_ROM_VBLANK_HANDLER
+    rom[0x0041] = TEST_ROM_VBLANK_HANDLER & 0xFF;
+    rom[0x0042] = TEST_ROM_VBLANK_HANDLER >> 8;
+    rom[0x0100] = 0xC3;   // JP TEST_ROM_MAIN
+    rom[0x0101] = TEST_ROM_MAIN & 0xFF;
+    rom[0x0102] = TEST_ROM_MAIN >> 8;
+    rom[CARTRIDGE_TYPE_ADDRESS] = type;
+    rom[CARTRIDGE_ROM_SIZE_ADDRESS] = size_code;
+    rom[CARTRIDGE_RAM_SIZE_ADDRESS] = ram_size;
+}
+
+// Copies code to addr and returns the address just after it
+static inline address test_rom_put(byte *rom, address addr, const byte *code,
+                                   size_t size)
+{
+    memcpy(rom + addr, code, size);
+    return (address)(addr + size);
+}
+
+/*
+ * Counts VBlank interrupts at 0xC000 and keeps sampling LY and STAT into
+ * 0xC100-0xC1FF, so anything the CPU can see of the PPU ends up in WRAM.
+ *
+ * With TEST_ROM_CART_RAM it is an MBC1 cartridge with 32 KiB of RAM,
+ * enabled at start, and the count is stored to 0xA000 and to VRAM at
+ * 0x8000 as well; TEST_ROM_RAM_BANK then also selects RAM bank 2 in
+ * banking mode 1.
+ */
+static inline void test_rom_build_sampler(byte *rom, size_t size, int options)
+{
+    static const byte count_frame[] = {
+        0xF5,               // PUSH AF
+        0xFA, 0x00, 0xC0,   // LD A, (0xC000)
+        0x3C,               // INC A
+        0xEA, 0x00, 0xC0,   // LD (0xC000), A
+    };
+    static const byte store_count[] = {
+        0xEA, 0x00, 0xA0,   // LD (0xA000), A
+        0xEA, 0x00, 0x80,   // LD (0x8000), A
+    };
+    static const byte return_from_handler[] = {
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+    static const byte enable_ram[] = {
+        0x3E, 0x0A,         // LD A, 0x0A
+        0xEA, 0x00, 0x00,   // LD (0x0000), A   RAM enable
+    };
+    static const byte select_ram_bank[] = {
+        0x3E, 0x01,         // LD A, 1
+        0xEA, 0x00, 0x60,   // LD (0x6000), A   banking mode 1
+        0x3E, 0x02,         // LD A, 2
+        0xEA, 0x00, 0x40,   // LD (0x4000), A   RAM bank 2
+    };
+    static const byte sample_ppu[] = {
+        0x3E, 0x01,         // LD A, VBLANK
+        0xE0, 0xFF,         // LDH (IE), A
+        0x11, 0x00, 0xC1,   // LD DE, 0xC100
+        0xFB,               // EI
+        0xF0, 0x44,         // LDH A, (LY)
+        0x12,               // LD (DE), A
+        0x1C,               // INC E
+        0xF0, 0x41,         // LDH A, (STAT)
+        0x12,               // LD (DE), A
+        0x1C,               // INC E
+        0x18, 0xF6,         // JR -10
+    };
+    bool cart_ram = (options & TEST_ROM_CART_RAM) != 0;
+    address at;
+
+    test_rom_init(rom, size, cart_ram ? 0x03 : 0x00, cart_ram ? 0x03 : 0x00);
+
+    at = test_rom_put(rom, TEST_ROM_VBLANK_HANDLER, count_frame, sizeof(count_frame));
+    if (cart_ram) {
+        at = test_rom_put(rom, at, store_count, sizeof(store_count));
+    }
+    test_rom_put(rom, at, return_from_handler, sizeof(return_from_handler));
+
+    at = TEST_ROM_MAIN;
+    if (cart_ram) {
+        at = test_rom_put(rom, at, enable_ram, sizeof(enable_ram));
+    }
+    if (options & TEST_ROM_RAM_BANK) {
+        at = test_rom_put(rom, at, select_ram_bank, sizeof(select_ram_bank));
+    }
+    test_rom_put(rom, at, sample_ppu, sizeof(sample_ppu));
+}
+
+#endif
@@ -0,0 +1,335 @@
+#include "../include/runahead.h"
+#include "../include/savestate.h"
+#include "../include/ring_buffer.h"
+#include "../include/gameboy.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+
+#define TEST_FRAMES 60
+#define TEST_PRESS_FRAME 20
+#define TEST_RELEASE_FRAME 40
+#define TEST_RING_SIZE (64 * 1024)
+
+// Function declarations
+void test_state_round_trip(void);
+void test_matches_plain_run(void);
+void test_hides_input_lag(void);
+
+static byte test_rom[2 * ROM_BANK_SIZE];
+
+/*
+ * MBC1 cartridge with RAM. The main loop runs from WRAM and rewrites its
+ * own immediate operand every pass, then sets BGP from the input the
+ * VBlank handler latched the frame before, so a key shows one frame after
+ * the one it is pressed in.
+ * The handler also counts frames in cartridge RAM and plays a note whose
+ * pitch follows the count.
+ */
+static void build_test_rom(void)
+{
+    const byte setup[] = {
+        0x3E, 0x0A,         // LD A, 0x0A
+        0xEA, 0x00, 0x00,   // LD (0x0000), A   RAM enable
+        0x3E, 0xF0,         // LD A, 0xF0
+        0xE0, 0x12,         // LDH (NR12), A
+        0x3E, 0xFF,         // LD A, 0xFF
+        0xE0, 0x25,         // LDH (NR51), A
+        0x21, 0x00, 0xC1,   // LD HL, 0xC100
+        0x11, 0x00, 0x03,   // LD DE, 0x0300
+        0x06, 0x0F,         // LD B, 15
+        0x1A,               // LD A, (DE)
+        0x22,               // LD (HL+), A
+        0x13,               // INC DE
+        0x05,               // DEC B
+        0x20, 0xFA,         // JR NZ, -6
+        0x3E, 0x01,         // LD A, VBLANK
+        0xE0, 0xFF,         // LDH (IE), A
+        0xFB,               // EI
+        0xC3, 0x00, 0xC1,   // JP 0xC100
+    };
+    const byte wram_loop[] = {
+        0x3E, 0x00,         // LD A, n
+        0x3C,               // INC A
+        0xEA, 0x01, 0xC1,   // LD (0xC101), A   the n above
+        0xE0, 0x43,         // LDH (SCX), A
+        0xFA, 0x01, 0xC0,   // LD A, (0xC001)
+        0xE0, 0x47,         // LDH (BGP), A
+        0x18, 0xF1,         // JR -15
+    };
+    const byte vblank_handler[] = {
+        0xF5,               // PUSH AF
+        0xFA, 0x00, 0xC0,   // LD A, (0xC000)
+        0xEA, 0x01, 0xC0,   // LD (0xC001), A
+        0x3E, 0x20,         // LD A, 0x20       select directions
+        0xE0, 0x00,         // LDH (P1), A
+        0xF0, 0x00,         // LDH A, (P1)
+        0xEA, 0x00, 0xC0,   // LD (0xC000), A
+        0xFA, 0x00, 0xA0,   // LD A, (0xA000)
+        0x3C,               // INC A
+        0xEA, 0x00, 0xA0,   // LD (0xA000), A
+        0xE0, 0x13,         // LDH (NR13), A
+        0x3E, 0x87,         // LD A, TRIGGER | 7
+        0xE0, 0x14,         // LDH (NR14), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+
+    test_rom_init(test_rom, sizeof(test_rom), 0x03, 0x02);
+    test_rom_put(test_rom, TEST_ROM_MAIN, setup, sizeof(setup));
+    test_rom_put(test_rom, TEST_ROM_VBLANK_HANDLER, vblank_handler, sizeof(vblank_handler));
+    test_rom_put(test_rom, 0x0300, wram_loop, sizeof(wram_loop));
+}
+
+static gameboy_t *start_machine(ring_buffer_t *output)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, test_rom, sizeof(test_rom))) {
+        TEST_FAIL("Could not start machine");
+    }
+
+    if (output != NULL) {
+        if (!ring_buffer_init(output, TEST_RING_SIZE)) {
+            TEST_FAIL("Could not allocate audio output");
+        }
+        apu_set_output(&gb->apu, output);
+    }
+    return gb;
+}
+
+static void stop_machine(gameboy_t *gb)
+{
+    gameboy_cleanup(gb);
+    free(gb);
+}
+
+static byte input_at(int frame)
+{
+    return frame >= TEST_PRESS_FRAME && frame < TEST_RELEASE_FRAME ?
+           JOYPAD_RIGHT : 0;
+}
+
+static byte *save_state(gameboy_t *gb, size_t *size)
+{
+    *size = savestate_size(gb);
+    byte *state = malloc(*size);
+
+    if (state == NULL || savestate_save(gb, state, *size) != *size) {
+        TEST_FAIL("Could not save state");
+    }
+
+    return state;
+}
+
+static bool same_state(gameboy_t *a, gameboy_t *b)
+{
+    size_t size_a, size_b;
+    byte *state_a = save_state(a, &size_a);
+    byte *state_b = save_state(b, &size_b);
+    bool same = size_a == size_b && memcmp(state_a, state_b, size_a) == 0;
+
+    free(state_a);
+    free(state_b);
+    return same;
+}
+
+// Test that a restored machine carries on exactly as it would have
+void test_state_round_trip(void)
+{
+    TEST_START("State Round Trip");
+
+    for (int cache = 0; cache < 2; cache++) {
+        gameboy_t *gb = start_machine(NULL);
+        gameboy_t *reference = start_machine(NULL);
+        gameboy_state_t state;
+
+        gb->use_block_cache = cache;
+        reference->use_block_cache = cache;
+        if (!gameboy_state_init(&state, gb)) {
+            TEST_FAIL("Could not allocate state");
+        }
+
+        for (int frame = 0; frame < 10; frame++) {
+            gameboy_run_frame(gb);
+            gameboy_run_frame(reference);
+        }
+        gameboy_save_state(gb, &state);
+
+        // Run off with a key held, then come back
+        joypad_set_buttons(&gb->joypad, JOYPAD_RIGHT);
+        for (int frame = 0; frame < 10; frame++) {
+            gameboy_run_frame(gb);
+        }
+        joypad_set_buttons(&gb->joypad, 0);
+        gameboy_restore_state(gb, &state);
+        if (!same_state(gb, reference)) {
+            TEST_FAIL("Restored state should match the saved one");
+        }
+
+        for (int frame = 0; frame < 10; frame++) {
+            gameboy_run_frame(gb);
+            gameboy_run_frame(reference);
+        }
+        if (!same_state(gb, reference) ||
+            gameboy_framebuffer_hash(gb) != gameboy_framebuffer_hash(reference)) {
+            TEST_FAIL("Restored machine should run on identically");
+        }
+
+        gameboy_state_cleanup(&state);
+        stop_machine(reference);
+        stop_machine(gb);
+    }
+
+    TEST_PASS();
+}
+
+// Test that run-ahead shows the next frame but otherwise changes nothing
+void test_matches_plain_run(void)
+{
+    TEST_START("Matches Plain Run");
+
+    static apu_frame_t samples[2][TEST_RING_SIZE / sizeof(apu_frame_t)];
+    ring_buffer_t outputs[2];
+    gameboy_t *ahead = start_machine(&outputs[0]);
+    gameboy_t *plain = start_machine(&outputs[1]);
+    runahead_t runahead;
+
+    if (!runahead_init(&runahead, ahead, 1)) {
+        TEST_FAIL("Could not set up run-ahead");
+    }
+
+    uint64_t shown = 0;
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        joypad_set_buttons(&ahead->joypad, input_at(frame));
+        joypad_set_buttons(&plain->joypad, input_at(frame));
+
+        if (runahead_run_frame(&runahead, ahead) != gameboy_run_frame(plain) ||
+            !same_state(ahead, plain)) {
+            TEST_FAIL("Run-ahead should not change the machine");
+        }
+
+        // What was shown last frame is on the plain machine's screen now
+        if (frame > 0 && input_at(frame) == input_at(frame - 1) &&
+            shown != gameboy_framebuffer_hash(plain)) {
+            TEST_FAIL("Run-ahead should show the next frame");
+        }
+        shown = gameboy_framebuffer_hash(ahead);
+
+        size_t sizes[2];
+        for (int i = 0; i < 2; i++) {
+            sizes[i] = ring_buffer_read(&outputs[i], samples[i],
+                                        sizeof(samples[i]));
+        }
+        if (sizes[0] != sizes[1] || sizes[0] == 0 ||
+            memcmp(samples[0], samples[1], sizes[0]) != 0) {
+            TEST_FAIL("Run-ahead should not change the audio");
+        }
+    }
+
+    runahead_cleanup(&runahead);
+    for (int i = 0; i < 2; i++) {
+        ring_buffer_cleanup(&outputs[i]);
+    }
+    stop_machine(ahead);
+    stop_machine(plain);
+    TEST_PASS();
+}
+
+static int first_frame_showing(gameboy_t *gb, runahead_t *runahead, byte shade)
+{
+    for (int frame = 0; frame < TEST_FRAMES; frame++) {
+        joypad_set_buttons(&gb->joypad, input_at(frame));
+        runahead_run_frame(runahead, gb);
+
+        if (gb->ppu.framebuffer[0][0] == shade) {
+            return frame;
+        }
+    }
+
+    return -1;
+}
+
+// Test that a key shows on screen one frame sooner
+void test_hides_input_lag(void)
+{
+    TEST_START("Hides Input Lag");
+
+    int shown[2];
+    for (int frames = 0; frames < 2; frames++) {
+        gameboy_t *gb = start_machine(NULL);
+        runahead_t runahead;
+
+        if (!runahead_init(&runahead, gb, frames)) {
+            TEST_FAIL("Could not set up run-ahead");
+        }
+
+        // Holding right makes P1 0xEE, so BGP maps color 0 to shade 2
+        shown[frames] = first_frame_showing(gb, &runahead, 2);
+        runahead_cleanup(&runahead);
+        stop_machine(gb);
+    }
+
+    if (shown[0] != TEST_PRESS_FRAME + 1 || shown[1] != TEST_PRESS_FRAME) {
+        TEST_FAIL("Run-ahead should show the key in the frame it is pressed");
+    }
+
+    if (runahead_init(NULL, NULL, 1)) {
+        TEST_FAIL("Run-ahead needs a machine");
+    }
+
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Run-Ahead Test Suite ===\n\n");
+
+    build_test_rom();
+    test_state_round_trip();
+    test_matches_plain_run();
+    test_hides_input_lag();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your run-ahead is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,361 @@
+#include "../include/savestate.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include "test_rom.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_FRAMES 5
+#define TEST_FAN_OUT 100
+#define TEST_STATE_PATH "/tmp/gameboy_test_savestate.state"
+
+// Function declarations
+void test_state_size(void);
+void test_round_trip(void);
+void test_fan_out(void);
+void test_rejects_bad_states(void);
+void test_rejects_corrupt_states(void);
+void test_file_round_trip(void);
+
+static byte test_rom[4 * ROM_BANK_SIZE];
+
+static gameboy_t *start_machine(const byte *rom, bool block_cache)
+{
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom, sizeof(test_rom))) {
+        TEST_FAIL("Could not start machine");
+    }
+
+    gb->use_block_cache = block_cache;
+    return gb;
+}
+
+static void stop_machine(gameboy_t *gb)
+{
+    gameboy_cleanup(gb);
+    free(gb);
+}
+
+static void run_frames(gameboy_t *gb, int frames)
+{
+    for (int frame = 0; frame < frames; frame++) {
+        gameboy_run_frame(gb);
+    }
+}
+
+static byte *save_state(gameboy_t *gb, size_t *size)
+{
+    *size = savestate_size(gb);
+    byte *state = malloc(*size);
+
+    if (state == NULL || savestate_save(gb, state, *size) != *size) {
+        TEST_FAIL("Could not save state");
+    }
+
+    return state;
+}
+
+static bool same_machine(const gameboy_t *a, const gameboy_t *b)
+{
+    return a->cpu.pc == b->cpu.pc && a->cpu.sp == b->cpu.sp &&
+           a->cpu.a == b->cpu.a && a->cpu.f == b->cpu.f &&
+           a->cpu.cycles == b->cpu.cycles && a->cpu.ime == b->cpu.ime &&
+           a->ppu.ly == b->ppu.ly && a->ppu.dot == b->ppu.dot &&
+           a->ppu.frames == b->ppu.frames &&
+           a->memory.mbc.ram_bank == b->memory.mbc.ram_bank &&
+           memcmp(a->memory.wram, b->memory.wram, WRAM_SIZE) == 0 &&
+           memcmp(a->memory.vram, b->memory.vram, VRAM_SIZE) == 0 &&
+           memcmp(a->memory.high_page, b->memory.high_page, MEMORY_PAGE_SIZE) == 0 &&
+           memcmp(a->memory.eram, b->memory.eram, a->memory.eram_size) == 0 &&
+           gameboy_framebuffer_hash(a) == gameboy_framebuffer_hash(b);
+}
+
+// Test state size and header
+void test_state_size(void)
+{
+    TEST_START("State Size");
+
+    gameboy_t *gb = start_machine(test_rom, true);
+    run_frames(gb, TEST_FRAMES);
+
+    size_t size;
+    byte *state = save_state(gb, &size);
+
+    // 32 KiB of cartridge RAM still leaves room under 64 KiB
+    if (size >= 64 * 1024 || size < gb->memory.eram_size + VRAM_SIZE + WRAM_SIZE) {
+        TEST_FAIL("State should hold RAM but not ROM");
+    }
+
+    if (memcmp(state, "GBSS", 4) != 0 || state[4] != SAVESTATE_VERSION) {
+        TEST_FAIL("State should start with magic and version");
+    }
+
+    byte small[16];
+    if (savestate_save(gb, small, sizeof(small)) != 0) {
+        TEST_FAIL("Save into a short buffer should fail");
+    }
+
+    free(state);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test that a restored machine continues exactly like the original
+void test_round_trip(void)
+{
+    TEST_START("Round Trip");
+
+    for (int mode = 0; mode < 2; mode++) {
+        gameboy_t *original = start_machine(test_rom, mode == 1);
+        run_frames(original, TEST_FRAMES);
+
+        size_t size;
+        byte *state = save_state(original, &size);
+
+        gameboy_t *restored = start_machine(test_rom, mode == 1);
+        // Run the copy somewhere else first so stale caches would show
+        run_frames(restored, TEST_FRAMES * 2 + 1);
+        if (!savestate_load(restored, state, size)) {
+            TEST_FAIL("State should load");
+        }
+
+        if (restored->memory.read_map[MEMORY_PAGE(ERAM_START)] !=
+            restored->memory.eram + 2 * RAM_BANK_SIZE) {
+            TEST_FAIL("Bank mapping should follow the restored MBC");
+        }
+
+        run_frames(original, TEST_FRAMES);
+        run_frames(restored, TEST_FRAMES);
+        if (!same_machine(original, restored)) {
+            TEST_FAIL("Restored machine diverged from the original");
+        }
+
+        free(state);
+        stop_machine(restored);
+        stop_machine(original);
+    }
+
+    TEST_PASS();
+}
+
+// Test booting once and fanning out many runs from one state
+void test_fan_out(void)
+{
+    TEST_START("Fan Out");
+
+    gameboy_t *reference = start_machine(test_rom, true);
+    run_frames(reference, TEST_FRAMES);
+
+    size_t size;
+    byte *state = save_state(reference, &size);
+    run_frames(reference, 2);
+
+    gameboy_t *gb = start_machine(test_rom, true);
+    for (int run = 0; run < TEST_FAN_OUT; run++) {
+        if (!savestate_load(gb, state, size)) {
+            TEST_FAIL("State should load repeatedly");
+        }
+
+        run_frames(gb, 2);
+        if (!same_machine(gb, reference)) {
+            TEST_FAIL("Every run from one state should be identical");
+        }
+
+        // Scribble over state the next load must restore
+        gb->memory.wram[0x200] ^= 0xFF;
+        gb->memory.eram[0] ^= 0xFF;
+    }
+
+    free(state);
+    stop_machine(gb);
+    stop_machine(reference);
+    TEST_PASS();
+}
+
+// Test that foreign, stale and truncated states are refused untouched
+void test_rejects_bad_states(void)
+{
+    TEST_START("Reject Bad States");
+
+    gameboy_t *gb = start_machine(test_rom, true);
+    run_frames(gb, TEST_FRAMES);
+
+    size_t size;
+    byte *state = save_state(gb, &size);
+
+    static byte other_rom[sizeof(test_rom)];
+    memcpy(other_rom, test_rom, sizeof(test_rom));
+    other_rom[0x3FFF] = 0x42;
+    gameboy_t *other = start_machine(other_rom, true);
+    word pc = other->cpu.pc;
+
+    if (savestate_load(other, state, size)) {
+        TEST_FAIL("State for another ROM should be rejected");
+    }
+
+    byte *stale = malloc(size);
+    memcpy(stale, state, size);
+    stale[4] = SAVESTATE_VERSION + 1;
+    if (savestate_load(gb, stale, size) || savestate_load(gb, state, size - 1) ||
+        savestate_load(gb, state, SAVESTATE_HEADER_SIZE - 1)) {
+        TEST_FAIL("Stale or truncated states should be rejected");
+    }
+
+    if (other->cpu.pc != pc || other->memory.wram[0] != 0) {
+        TEST_FAIL("Rejected load should leave the machine alone");
+    }
+
+    free(stale);
+    free(state);
+    stop_machine(other);
+    stop_machine(gb);
+    printf("\n    ");
+    TEST_PASS();
+}
+
+// Register offsets in the machine section, after the header, CPU and MBC
+#define TEST_PPU_OFFSET (SAVESTATE_HEADER_SIZE + 26 + 6 + 2 * MBC_RTC_REGISTER_COUNT)
+#define TEST_DMA_OFFSET (TEST_PPU_OFFSET + 17 + 2)
+#define TEST_APU_OFFSET (TEST_DMA_OFFSET + 2)
+
+static bool load_corrupted(gameboy_t *gb, const byte *state, size_t size,
+                           size_t offset, byte value)
+{
+    static byte corrupt[SAVESTATE_MACHINE_SIZE + 0x10000];
+    memcpy(corrupt, state, size);
+    corrupt[offset] = value;
+    return savestate_load(gb, corrupt, size);
+}
+
+// Test that states with impossible register values are refused untouched
+void test_rejects_corrupt_states(void)
+{
+    TEST_START("Reject Corrupt States");
+
+    gameboy_t *gb = start_machine(test_rom, true);
+    run_frames(gb, TEST_FRAMES);
+
+    size_t size;
+    byte *state = save_state(gb, &size);
+    gameboy_t *target = start_machine(test_rom, true);
+    word pc = target->cpu.pc;
+
+    if (size > SAVESTATE_MACHINE_SIZE + 0x10000) {
+        TEST_FAIL("State should fit the test buffer");
+    }
+
+    // Pixel transfer below the screen would draw past the framebuffer
+    if (gb->ppu.ly < SCREEN_HEIGHT) {
+        TEST_FAIL("Frames should end in VBlank");
+    }
+    if (load_corrupted(target, state, size, TEST_PPU_OFFSET, PPU_MODE_TRANSFER)) {
+        TEST_FAIL("Transfer mode in VBlank should be rejected");
+    }
+    if (load_corrupted(target, state, size, TEST_PPU_OFFSET, 4) ||
+        load_corrupted(target, state, size, TEST_PPU_OFFSET + 2, 0xFF) ||
+        load_corrupted(target, state, size, TEST_PPU_OFFSET + 3, 154)) {
+        TEST_FAIL("Impossible PPU mode, dot or line should be rejected");
+    }
+
+    if (load_corrupted(target, state, size, TEST_DMA_OFFSET + 1, 0xFF) ||
+        load_corrupted(target, state, size, TEST_APU_OFFSET + 9, 8) ||
+        load_corrupted(target, state, size, TEST_APU_OFFSET + 3, 16)) {
+        TEST_FAIL("Out of range DMA or APU counters should be rejected");
+    }
+
+    if (target->cpu.pc != pc || target->memory.wram[0] != 0) {
+        TEST_FAIL("Rejected load should leave the machine alone");
+    }
+
+    if (!savestate_load(target, state, size) || target->cpu.pc != gb->cpu.pc) {
+        TEST_FAIL("The intact state should still load");
+    }
+
+    free(state);
+    stop_machine(target);
+    stop_machine(gb);
+    TEST_PASS();
+}
+
+// Test saving to and loading from disk
+void test_file_round_trip(void)
+{
+    TEST_START("File Round Trip");
+
+    gameboy_t *original = start_machine(test_rom, true);
+    run_frames(original, TEST_FRAMES);
+    if (!savestate_save_file(original, TEST_STATE_PATH)) {
+        TEST_FAIL("State file should be written");
+    }
+
+    gameboy_t *restored = start_machine(test_rom, true);
+    if (!savestate_load_file(restored, TEST_STATE_PATH)) {
+        TEST_FAIL("State file should load");
+    }
+
+    run_frames(original, 1);
+    run_frames(restored, 1);
+    if (!same_machine(original, restored)) {
+        TEST_FAIL("State file did not restore the machine");
+    }
+
+    remove(TEST_STATE_PATH);
+    stop_machine(restored);
+    stop_machine(original);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Save State Test Suite ===\n\n");
+
+    // Every part of the state changes from frame to frame
+    test_rom_build_sampler(test_rom, sizeof(test_rom), TEST_ROM_CART_RAM | TEST_ROM_RAM_BANK);
+    test_state_size();
+    test_round_trip();
+    test_fan_out();
+    test_rejects_bad_states();
+    test_rejects_corrupt_states();
+    test_file_round_trip();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your save states are working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
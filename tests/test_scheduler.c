@@ -0,0 +1,266 @@
+#include "../include/scheduler.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_MAX_CALLS 64
+
+// Function declarations
+void test_dispatch_order(void);
+void test_reschedule_and_cancel(void);
+void test_callback_reschedules(void);
+void test_ppu_catches_up_on_read(void);
+
+static scheduler_t test_scheduler;
+static uint64_t test_clock;
+
+// Every callback run, in order
+static int call_types[TEST_MAX_CALLS];
+static uint64_t call_deadlines[TEST_MAX_CALLS];
+static int call_count;
+
+// Reschedules itself this far ahead when non-zero
+static uint64_t repeat_period;
+
+static void record_event(void *context, uint64_t deadline)
+{
+    int type = (int)(intptr_t)context;
+
+    if (call_count < TEST_MAX_CALLS) {
+        call_types[call_count] = type;
+        call_deadlines[call_count] = deadline;
+    }
+    call_count++;
+
+    if (repeat_period != 0) {
+        scheduler_schedule(&test_scheduler, type, deadline + repeat_period);
+    }
+}
+
+static void setup_scheduler(void)
+{
+    test_clock = 0;
+    call_count = 0;
+    repeat_period = 0;
+
+    if (!scheduler_init(&test_scheduler, &test_clock)) {
+        TEST_FAIL("Scheduler initialization failed");
+    }
+
+    for (int type = 0; type < SCHEDULER_EVENT_COUNT; type++) {
+        scheduler_register(&test_scheduler, type, record_event,
+                           (void *)(intptr_t)type);
+    }
+}
+
+// Test that due events run earliest first, ties in type order
+void test_dispatch_order(void)
+{
+    TEST_START("Dispatch Order");
+
+    setup_scheduler();
+    if (scheduler_next_deadline(&test_scheduler) != SCHEDULER_NEVER) {
+        TEST_FAIL("A new scheduler should have nothing pending");
+    }
+
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_SERIAL, 300);
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_TIMER, 100);
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_DMA, 100);
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_PPU, 200);
+
+    if (scheduler_next_deadline(&test_scheduler) != 100) {
+        TEST_FAIL("Next deadline should be the earliest one");
+    }
+
+    // Nothing is due yet
+    test_clock = 99;
+    scheduler_dispatch(&test_scheduler);
+    if (call_count != 0) {
+        TEST_FAIL("Events should not run before their deadline");
+    }
+
+    test_clock = 250;
+    scheduler_dispatch(&test_scheduler);
+    if (call_count != 3 || call_types[0] != SCHEDULER_EVENT_TIMER ||
+        call_types[1] != SCHEDULER_EVENT_DMA ||
+        call_types[2] != SCHEDULER_EVENT_PPU ||
+        call_deadlines[0] != 100 || call_deadlines[2] != 200) {
+        TEST_FAIL("Due events should run in deadline order");
+    }
+
+    if (scheduler_next_deadline(&test_scheduler) != 300 ||
+        scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_PPU) != SCHEDULER_NEVER) {
+        TEST_FAIL("Only the undue event should remain");
+    }
+
+    TEST_PASS();
+}
+
+// Test moving and removing pending events
+void test_reschedule_and_cancel(void)
+{
+    TEST_START("Reschedule and Cancel");
+
+    setup_scheduler();
+    for (int type = 0; type < SCHEDULER_EVENT_COUNT; type++) {
+        scheduler_schedule(&test_scheduler, type, 1000 + type * 100);
+    }
+
+    // Later, earlier, and gone
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_PPU, 5000);
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_SERIAL, 50);
+    scheduler_cancel(&test_scheduler, SCHEDULER_EVENT_TIMER);
+    scheduler_cancel(&test_scheduler, SCHEDULER_EVENT_TIMER);
+
+    if (scheduler_next_deadline(&test_scheduler) != 50 ||
+        scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_PPU) != 5000 ||
+        scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_TIMER) != SCHEDULER_NEVER) {
+        TEST_FAIL("Deadlines should follow rescheduling and cancels");
+    }
+
+    test_clock = 10000;
+    scheduler_dispatch(&test_scheduler);
+    if (call_count != 4 || call_types[0] != SCHEDULER_EVENT_SERIAL ||
+        call_types[1] != SCHEDULER_EVENT_DMA ||
+        call_types[2] != SCHEDULER_EVENT_APU ||
+        call_types[3] != SCHEDULER_EVENT_PPU) {
+        TEST_FAIL("Cancelled events should never run");
+    }
+
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_DMA, 20000);
+    scheduler_cancel_all(&test_scheduler);
+    if (scheduler_next_deadline(&test_scheduler) != SCHEDULER_NEVER) {
+        TEST_FAIL("Cancelling everything should leave nothing pending");
+    }
+
+    TEST_PASS();
+}
+
+// Test that an event a callback schedules in the past runs in the same dispatch
+void test_callback_reschedules(void)
+{
+    TEST_START("Callback Reschedules");
+
+    setup_scheduler();
+    repeat_period = 456;
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_PPU, 80);
+    scheduler_schedule(&test_scheduler, SCHEDULER_EVENT_TIMER, 1000);
+
+    // Catching up after a long instruction runs every missed period
+    test_clock = 80 + 456 * 3;
+    scheduler_dispatch(&test_scheduler);
+
+    if (call_count != 5 || call_deadlines[0] != 80 ||
+        call_deadlines[1] != 80 + 456 || call_deadlines[2] != 80 + 456 * 2 ||
+        call_types[3] != SCHEDULER_EVENT_TIMER || call_deadlines[3] != 1000 ||
+        call_types[4] != SCHEDULER_EVENT_PPU || call_deadlines[4] != 80 + 456 * 3) {
+        TEST_FAIL("Repeating events should run once per missed deadline");
+    }
+
+    if (scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_PPU) != 80 + 456 * 4 ||
+        scheduler_next_deadline(&test_scheduler) != 1000 + 456) {
+        TEST_FAIL("The next periods should be pending");
+    }
+
+    TEST_PASS();
+}
+
+// Test that LY and STAT reads see the current line between PPU events
+void test_ppu_catches_up_on_read(void)
+{
+    TEST_START("PPU Catches Up on Read");
+
+    static byte rom[2 * ROM_BANK_SIZE];
+    gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+    memset(rom, 0, sizeof(rom));
+    rom[0x0100] = 0x18;   // JR -2
+    rom[0x0101] = 0xFE;
+
+    if (gb == NULL || !gameboy_init(gb) ||
+        !gameboy_load_rom_data(gb, rom, sizeof(rom))) {
+        TEST_FAIL("Could not start machine");
+    }
+    gameboy_set_headless(gb, true);
+
+    // Headless with no STAT interrupts: the only PPU event left is VBlank
+    if (scheduler_deadline(&gb->scheduler, SCHEDULER_EVENT_PPU) !=
+        PPU_DOTS_PER_LINE * SCREEN_HEIGHT) {
+        TEST_FAIL("Headless PPU should only wake up for VBlank");
+    }
+
+    gameboy_run(gb, PPU_DOTS_PER_LINE * 10 + PPU_OAM_SCAN_DOTS + 4);
+    if (memory_read_byte(&gb->memory, LY_REGISTER) != 10 ||
+        (memory_read_byte(&gb->memory, STAT_REGISTER) & STAT_MODE_MASK) !=
+            PPU_MODE_TRANSFER) {
+        TEST_FAIL("LY/STAT should reflect the current line and mode");
+    }
+
+    // Enabling a STAT source brings back an event at every mode change
+    memory_write_byte(&gb->memory, STAT_REGISTER, STAT_HBLANK_INTERRUPT);
+    if (scheduler_deadline(&gb->scheduler, SCHEDULER_EVENT_PPU) !=
+        PPU_DOTS_PER_LINE * 10 + PPU_OAM_SCAN_DOTS + PPU_TRANSFER_DOTS) {
+        TEST_FAIL("STAT interrupts should schedule the next mode change");
+    }
+
+    // Switching the LCD off leaves nothing for the PPU to do
+    memory_write_byte(&gb->memory, LCDC_REGISTER, 0x00);
+    if (scheduler_deadline(&gb->scheduler, SCHEDULER_EVENT_PPU) != SCHEDULER_NEVER ||
+        memory_read_byte(&gb->memory, LY_REGISTER) != 0) {
+        TEST_FAIL("LCD off should cancel the PPU event");
+    }
+
+    gameboy_cleanup(gb);
+    free(gb);
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Scheduler Test Suite ===\n\n");
+
+    test_dispatch_order();
+    test_reschedule_and_cancel();
+    test_callback_reschedules();
+    test_ppu_catches_up_on_read();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your scheduler is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}
@@ -0,0 +1,290 @@
+#include "../include/timer.h"
+#include "../include/gameboy.h"
+#include "../include/common.h"
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test counter for tracking progress
+static int tests_run = 0;
+static int tests_passed = 0;
+
+// Macro for test reporting
+#define TEST_START(name) \
+    do { \
+        printf("Running test: %s... ", name); \
+        tests_run++; \
+    } while(0)
+
+#define TEST_PASS() \
+    do { \
+        printf("✅ PASSED\n"); \
+        tests_passed++; \
+    } while(0)
+
+#define TEST_FAIL(msg) \
+    do { \
+        printf("❌ FAILED: %s\n", msg); \
+        exit(1); \
+    } while(0)
+
+#define TEST_OVERFLOWS 50
+
+// Function declarations
+void test_div(void);
+void test_tima_rates(void);
+void test_overflow(void);
+void test_falling_edge_glitch(void);
+void test_timer_interrupts(void);
+
+static memory_system_t test_memory;
+static scheduler_t test_scheduler;
+static gb_timer_t test_timer;
+static uint64_t test_clock;
+
+static void setup_timer(void)
+{
+    test_clock = 0;
+    if (!memory_init(&test_memory) ||
+        !scheduler_init(&test_scheduler, &test_clock) ||
+        !timer_init(&test_timer, &test_memory, &test_scheduler)) {
+        TEST_FAIL("Timer initialization failed");
+    }
+}
+
+static void teardown_timer(void)
+{
+    memory_cleanup(&test_memory);
+}
+
+// Moves the clock the way a CPU run would, then runs due events
+static void run_cycles(uint64_t cycles)
+{
+    test_clock += cycles;
+    scheduler_dispatch(&test_scheduler);
+}
+
+// Test that DIV follows the clock and resets on write
+void test_div(void)
+{
+    TEST_START("DIV Register");
+
+    setup_timer();
+    if (memory_read_byte(&test_memory, DIV_REGISTER) != 0xAB) {
+        TEST_FAIL("DIV should start at its post-boot value");
+    }
+
+    // The counter starts 0x34 cycles short of the next DIV step
+    run_cycles(0x33);
+    if (memory_read_byte(&test_memory, DIV_REGISTER) != 0xAB) {
+        TEST_FAIL("DIV should not step early");
+    }
+    run_cycles(1);
+    if (memory_read_byte(&test_memory, DIV_REGISTER) != 0xAC) {
+        TEST_FAIL("DIV should step every 256 cycles");
+    }
+
+    memory_write_byte(&test_memory, DIV_REGISTER, 0x55);
+    run_cycles(255);
+    if (memory_read_byte(&test_memory, DIV_REGISTER) != 0x00) {
+        TEST_FAIL("Writing DIV should clear it");
+    }
+    run_cycles(256 * 300 + 1);
+    if (memory_read_byte(&test_memory, DIV_REGISTER) != (301 & 0xFF)) {
+        TEST_FAIL("DIV should wrap around");
+    }
+
+    if (scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_TIMER) != SCHEDULER_NEVER) {
+        TEST_FAIL("A stopped timer should have nothing scheduled");
+    }
+
+    teardown_timer();
+    TEST_PASS();
+}
+
+// Test the four TIMA clocks
+void test_tima_rates(void)
+{
+    TEST_START("TIMA Rates");
+
+    const int periods[4] = { 1024, 16, 64, 256 };
+
+    setup_timer();
+    for (int rate = 0; rate < 4; rate++) {
+        memory_write_byte(&test_memory, TAC_REGISTER, 0x00);
+        memory_write_byte(&test_memory, DIV_REGISTER, 0);
+        memory_write_byte(&test_memory, TIMA_REGISTER, 0);
+        memory_write_byte(&test_memory, TAC_REGISTER, TAC_ENABLE | rate);
+
+        run_cycles(periods[rate] * 10 - 1);
+        if (memory_read_byte(&test_memory, TIMA_REGISTER) != 9) {
+            TEST_FAIL("TIMA should not tick early");
+        }
+        run_cycles(1);
+        if (memory_read_byte(&test_memory, TIMA_REGISTER) != 10) {
+            TEST_FAIL("TIMA should tick once per period");
+        }
+    }
+
+    // Stopping the timer freezes TIMA
+    memory_write_byte(&test_memory, TAC_REGISTER, 0x00);
+    byte frozen = memory_read_byte(&test_memory, TIMA_REGISTER);
+    run_cycles(10000);
+    if (memory_read_byte(&test_memory, TIMA_REGISTER) != frozen ||
+        (memory_read_byte(&test_memory, TAC_REGISTER) & 0xF8) != 0xF8) {
+        TEST_FAIL("Disabled timer should hold TIMA");
+    }
+
+    teardown_timer();
+    TEST_PASS();
+}
+
+// Test that overflow reloads TMA and interrupts on the exact cycle
+void test_overflow(void)
+{
+    TEST_START("TIMA Overflow");
+
+    setup_timer();
+    memory_write_byte(&test_memory, DIV_REGISTER, 0);
+    memory_write_byte(&test_memory, TMA_REGISTER, 0xF0);
+    memory_write_byte(&test_memory, TIMA_REGISTER, 0xFE);
+    memory_write_byte(&test_memory, TAC_REGISTER, TAC_ENABLE | 0x01);
+
+    if (scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_TIMER) != 32) {
+        TEST_FAIL("Overflow should be scheduled two ticks ahead");
+    }
+
+    run_cycles(31);
+    if (memory_read_byte(&test_memory, IF_REGISTER) & INTERRUPT_TIMER) {
+        TEST_FAIL("Interrupt should not fire before overflow");
+    }
+
+    run_cycles(1);
+    if (!(memory_read_byte(&test_memory, IF_REGISTER) & INTERRUPT_TIMER) ||
+        memory_read_byte(&test_memory, TIMA_REGISTER) != 0xF0) {
+        TEST_FAIL("Overflow should reload TMA and request the interrupt");
+    }
+
+    // From TMA the next overflow is sixteen ticks away
+    if (scheduler_deadline(&test_scheduler, SCHEDULER_EVENT_TIMER) != 32 + 16 * 16) {
+        TEST_FAIL("Next overflow should be scheduled from TMA");
+    }
+
+    teardown_timer();
+    TEST_PASS();
+}
+
+// Test that writes making the selected counter bit fall tick TIMA
+void test_falling_edge_glitch(void)
+{
+    TEST_START("Falling Edge Glitch");
+
+    setup_timer();
+    memory_write_byte(&test_memory, DIV_REGISTER, 0);
+    memory_write_byte(&test_memory, TIMA_REGISTER, 0);
+    memory_write_byte(&test_memory, TAC_REGISTER, TAC_ENABLE | 0x01);
+
+    // Bit 3 is set halfway through a 16-cycle period
+    run_cycles(8);
+    memory_write_byte(&test_memory, DIV_REGISTER, 0);
+    if (memory_read_byte(&test_memory, TIMA_REGISTER) != 1) {
+        TEST_FAIL("Resetting DIV with the bit set should tick TIMA");
+    }
+
+    run_cycles(8);
+    memory_write_byte(&test_memory, TAC_REGISTER, 0x00);
+    if (memory_read_byte(&test_memory, TIMA_REGISTER) != 2) {
+        TEST_FAIL("Disabling the timer with the bit set should tick TIMA");
+    }
+
+    teardown_timer();
+    TEST_PASS();
+}
+
+// Test timer interrupts reaching a program, halted or not
+void test_timer_interrupts(void)
+{
+    TEST_START("Timer Interrupts");
+
+    static byte rom[2 * ROM_BANK_SIZE];
+    const byte timer_handler[] = {
+        0xF5,               // PUSH AF
+        0xFA, 0x00, 0xC0,   // LD A, (0xC000)
+        0x3C,               // INC A
+        0xEA, 0x00, 0xC0,   // LD (0xC000), A
+        0xF1,               // POP AF
+        0xD9,               // RETI
+    };
+    const byte main_loop[] = {
+        0x3E, 0x05,         // LD A, ENABLE | 262144 Hz
+        0xE0, 0x07,         // LDH (TAC), A
+        0x3E, 0x04,         // LD A, TIMER
+        0xE0, 0xFF,         // LDH (IE), A
+        0xFB,               // EI
+        0x76,               // HALT
+        0x18, 0xFD,         // JR -3
+    };
+
+    memset(rom, 0, sizeof(rom));
+    rom[0x0050] = 0xC3;     // JP 0x0200
+    rom[0x0051] = 0x00;
+    rom[0x0052] = 0x02;
+    rom[0x0100] = 0xC3;     // JP 0x0150
+    rom[0x0101] = 0x50;
+    rom[0x0102] = 0x01;
+    memcpy(rom + 0x0150, main_loop, sizeof(main_loop));
+    memcpy(rom + 0x0200, timer_handler, sizeof(timer_handler));
+
+    uint64_t cycles[2];
+    for (int mode = 0; mode < 2; mode++) {
+        gameboy_t *gb = malloc(sizeof(gameboy_t));
+
+        if (gb == NULL || !gameboy_init(gb) ||
+            !gameboy_load_rom_data(gb, rom, sizeof(rom))) {
+            TEST_FAIL("Could not start machine");
+        }
+        gb->use_block_cache = mode == 1;
+
+        // TIMA starts at 0 with TMA 0: 256 ticks of 16 cycles per overflow
+        gameboy_run(gb, 4096 * TEST_OVERFLOWS + 2048);
+        if (gb->memory.wram[0] != TEST_OVERFLOWS) {
+            TEST_FAIL("Handler should run once per overflow");
+        }
+        cycles[mode] = gb->cpu.cycles;
+
+        gameboy_cleanup(gb);
+        free(gb);
+    }
+
+    if (cycles[0] != cycles[1]) {
+        TEST_FAIL("Interpreter and block cache should agree");
+    }
+
+    TEST_PASS();
+}
+
+// Main test runner
+int main(void)
+{
+    printf("=== Game Boy Emulator Timer Test Suite ===\n\n");
+
+    test_div();
+    test_tima_rates();
+    test_overflow();
+    test_falling_edge_glitch();
+    test_timer_interrupts();
+
+    // Print summary
+    printf("\n=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+
+    if (tests_passed == tests_run) {
+        printf("🎉 All tests PASSED! Your timer is working correctly.\n");
+        return 0;
+    } else {
+        printf("❌ Some tests FAILED. Please review the output above.\n");
+        return 1;
+    }
+}